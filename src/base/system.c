@@ -24,9 +24,15 @@
 	#include <fcntl.h>
 	#include <pthread.h>
 	#include <arpa/inet.h>
+	#include <sys/mman.h>
 
 	#include <dirent.h>
 
+	#if defined(CONF_PLATFORM_LINUX)
+		#include <poll.h>
+		#include <sys/inotify.h>
+	#endif
+
 	#if defined(CONF_PLATFORM_MACOSX)
 		#include <Carbon/Carbon.h>
 	#endif
@@ -39,6 +45,7 @@
 	#include <fcntl.h>
 	#include <direct.h>
 	#include <errno.h>
+	#include <io.h>
 	#include <process.h>
 	#include <wincrypt.h>
 #else
@@ -441,6 +448,51 @@ int io_flush(IOHANDLE io)
 	return 0;
 }
 
+const void *io_map(IOHANDLE io, unsigned *size)
+{
+	long int length = io_length(io);
+	*size = 0;
+	if(length <= 0)
+		return 0;
+#if defined(CONF_FAMILY_UNIX)
+	{
+		void *data = mmap(0, length, PROT_READ, MAP_PRIVATE, fileno((FILE*)io), 0);
+		if(data == MAP_FAILED)
+			return 0;
+		*size = length;
+		return data;
+	}
+#elif defined(CONF_FAMILY_WINDOWS)
+	{
+		HANDLE mapping = CreateFileMappingA((HANDLE)_get_osfhandle(_fileno((FILE*)io)), NULL, PAGE_READONLY, 0, 0, NULL);
+		void *data;
+		if(!mapping)
+			return 0;
+		data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if(!data)
+			return 0;
+		*size = length;
+		return data;
+	}
+#else
+	#error not implemented
+#endif
+}
+
+void io_unmap(const void *data, unsigned size)
+{
+	if(!data)
+		return;
+#if defined(CONF_FAMILY_UNIX)
+	munmap((void *)data, size);
+#elif defined(CONF_FAMILY_WINDOWS)
+	UnmapViewOfFile(data);
+#else
+	#error not implemented
+#endif
+}
+
 struct THREAD_RUN
 {
 	void (*threadfunc)(void *);
@@ -1476,6 +1528,91 @@ void fs_listdir(const char *dir, FS_LISTDIR_CALLBACK cb, int type, void *user)
 #endif
 }
 
+void *fs_watch_create()
+{
+#if defined(CONF_PLATFORM_LINUX)
+	int fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+	if(fd < 0)
+		return 0;
+	return (void *)(long)(fd + 1);
+#else
+	return 0;
+#endif
+}
+
+int fs_watch_add(void *watch, const char *path)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	int fd = (int)(long)watch - 1;
+	return inotify_add_watch(fd, path, IN_CREATE|IN_DELETE|IN_MOVED_FROM|IN_MOVED_TO|IN_DELETE_SELF|IN_MOVE_SELF|IN_ONLYDIR);
+#else
+	return -1;
+#endif
+}
+
+void fs_watch_remove(void *watch, int id)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	int fd = (int)(long)watch - 1;
+	inotify_rm_watch(fd, id);
+#endif
+}
+
+int fs_watch_read(void *watch, int *ids, int max_ids, int timeout_ms)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	int fd = (int)(long)watch - 1;
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct pollfd pfd;
+	int num = 0;
+	ssize_t len;
+	char *p;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	if(poll(&pfd, 1, timeout_ms) <= 0)
+		return 0;
+
+	while((len = read(fd, buffer, sizeof(buffer))) > 0)
+	{
+		for(p = buffer; p < buffer + len; p += sizeof(struct inotify_event) + ((struct inotify_event *)p)->len)
+		{
+			const struct inotify_event *event = (const struct inotify_event *)p;
+			int id = (event->mask&IN_Q_OVERFLOW) ? -1 : event->wd;
+			int i;
+			/* the watch is gone, a deleted directory reported that already */
+			if(event->mask&IN_IGNORED)
+				continue;
+			for(i = 0; i < num; i++)
+				if(ids[i] == id)
+					break;
+			if(i < num)
+				continue;
+			if(num == max_ids)
+			{
+				/* out of room, so everything changed */
+				ids[max_ids-1] = -1;
+				continue;
+			}
+			ids[num++] = id;
+		}
+	}
+	if(len < 0 && errno != EAGAIN)
+		return -1;
+	return num;
+#else
+	return -1;
+#endif
+}
+
+void fs_watch_destroy(void *watch)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	if(watch)
+		close((int)(long)watch - 1);
+#endif
+}
+
 int fs_storage_path(const char *appname, char *path, int max)
 {
 #if defined(CONF_FAMILY_WINDOWS)
@@ -1681,36 +1818,49 @@ void swap_endian(void *data, unsigned elem_size, unsigned num)
 }
 
 int net_socket_read_wait(NETSOCKET sock, int time)
+{
+	return net_socket_read_wait_multi(&sock, 1, time);
+}
+
+int net_socket_read_wait_multi(const NETSOCKET *socks, int num, int time)
 {
 	struct timeval tv;
 	fd_set readfds;
 	int sockid;
+	int i;
 
 	tv.tv_sec = 0;
 	tv.tv_usec = 1000*time;
 	sockid = 0;
 
 	FD_ZERO(&readfds);
-	if(sock.ipv4sock >= 0)
-	{
-		FD_SET(sock.ipv4sock, &readfds);
-		sockid = sock.ipv4sock;
-	}
-	if(sock.ipv6sock >= 0)
+	for(i = 0; i < num; i++)
 	{
-		FD_SET(sock.ipv6sock, &readfds);
-		if(sock.ipv6sock > sockid)
-			sockid = sock.ipv6sock;
+		if(socks[i].ipv4sock >= 0)
+		{
+			FD_SET(socks[i].ipv4sock, &readfds);
+			if(socks[i].ipv4sock > sockid)
+				sockid = socks[i].ipv4sock;
+		}
+		if(socks[i].ipv6sock >= 0)
+		{
+			FD_SET(socks[i].ipv6sock, &readfds);
+			if(socks[i].ipv6sock > sockid)
+				sockid = socks[i].ipv6sock;
+		}
 	}
 
 	/* don't care about writefds and exceptfds */
 	select(sockid+1, &readfds, NULL, NULL, &tv);
 
-	if(sock.ipv4sock >= 0 && FD_ISSET(sock.ipv4sock, &readfds))
-		return 1;
+	for(i = 0; i < num; i++)
+	{
+		if(socks[i].ipv4sock >= 0 && FD_ISSET(socks[i].ipv4sock, &readfds))
+			return 1;
 
-	if(sock.ipv6sock >= 0 && FD_ISSET(sock.ipv6sock, &readfds))
-		return 1;
+		if(socks[i].ipv6sock >= 0 && FD_ISSET(socks[i].ipv6sock, &readfds))
+			return 1;
+	}
 
 	return 0;
 }
@@ -336,6 +336,33 @@ int io_close(IOHANDLE io);
 */
 int io_flush(IOHANDLE io);
 
+/*
+	Function: io_map
+		Maps the whole content of a file into memory, read only.
+
+	Parameters:
+		io - Handle to the file.
+		size - Pointer that receives the size of the mapping.
+
+	Returns:
+		Returns a pointer to the data, or 0 on error or if the file is empty.
+
+	Remarks:
+		- The mapping stays valid after the file is closed.
+		- The data has to be released with <io_unmap>.
+*/
+const void *io_map(IOHANDLE io, unsigned *size);
+
+/*
+	Function: io_unmap
+		Releases a mapping created with <io_map>.
+
+	Parameters:
+		data - Pointer returned by <io_map>.
+		size - Size of the mapping.
+*/
+void io_unmap(const void *data, unsigned size);
+
 
 /*
 	Function: io_stdin
@@ -1222,6 +1249,73 @@ GNUC_ATTRIBUTE((format(strftime, 4, 0)));
 typedef int (*FS_LISTDIR_CALLBACK)(const char *name, int is_dir, int dir_type, void *user);
 void fs_listdir(const char *dir, FS_LISTDIR_CALLBACK cb, int type, void *user);
 
+/*
+	Function: fs_watch_create
+		Creates a watcher for changes to the entries of directories.
+
+	Returns:
+		Returns a handle to the watcher, 0 if the platform has none.
+
+	Remarks:
+		- Only implemented on Linux, using inotify.
+*/
+void *fs_watch_create();
+
+/*
+	Function: fs_watch_add
+		Starts watching a directory for entries being added or removed.
+
+	Parameters:
+		watch - Watcher to add the directory to
+		path - Directory to watch
+
+	Returns:
+		Returns the id the changes of the directory are reported with,
+		the same directory always has the same id. Negative value on
+		failure.
+*/
+int fs_watch_add(void *watch, const char *path);
+
+/*
+	Function: fs_watch_remove
+		Stops watching a directory.
+
+	Parameters:
+		watch - Watcher the directory was added to
+		id - Id returned by fs_watch_add
+
+	Remarks:
+		- A directory can be added again later, it gets a new id then.
+*/
+void fs_watch_remove(void *watch, int id);
+
+/*
+	Function: fs_watch_read
+		Waits for changes of the watched directories.
+
+	Parameters:
+		watch - Watcher to read from
+		ids - Receives the ids of the changed directories
+		max_ids - Size of the ids array
+		timeout_ms - How long to wait at most
+
+	Returns:
+		Returns the number of ids, 0 if nothing changed before the
+		timeout and a negative value on failure. An id of -1 means
+		that changes got lost and every directory has to be assumed
+		to be changed.
+*/
+int fs_watch_read(void *watch, int *ids, int max_ids, int timeout_ms);
+
+/*
+	Function: fs_watch_destroy
+		Destroys a watcher.
+
+	Parameters:
+		watch - Watcher to destroy
+*/
+void fs_watch_destroy(void *watch);
+
 /*
 	Function: fs_makedir
 		Creates a directory
@@ -1380,6 +1474,21 @@ int net_would_block();
 
 int net_socket_read_wait(NETSOCKET sock, int time);
 
+/*
+	Function: net_socket_read_wait_multi
+		Waits until one of the sockets has data to read or the time
+		is up.
+
+	Parameters:
+		socks - The sockets to wait on.
+		num - Number of sockets.
+		time - Maximum time to wait in milliseconds, below one second.
+
+	Returns:
+		1 if one of the sockets can be read, 0 otherwise.
+*/
+int net_socket_read_wait_multi(const NETSOCKET *socks, int num, int time);
+
 void swap_endian(void *data, unsigned elem_size, unsigned num);
 
 
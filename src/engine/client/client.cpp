@@ -1996,6 +1996,9 @@ void CClient::Run()
 		//
 		VersionUpdate();
 
+		// results of background jobs
+		m_pEngine->JobPool()->RunMainThreadJobs();
+
 		// handle pending connects
 		if(m_aCmdConnect[0])
 		{
@@ -2693,6 +2696,7 @@ int main(int argc, const char **argv) // ignore_convention
 	pConfig->RestoreStrings();
 
 	pClient->Engine()->InitLogfile();
+	pClient->Engine()->InitJobPool();
 
 	// run the client
 	dbg_msg("client", "starting...");
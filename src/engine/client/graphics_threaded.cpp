@@ -18,6 +18,7 @@
 #include <math.h> // cosf, sinf
 
 #include "graphics_threaded.h"
+#include "image.h"
 
 static CVideoMode g_aFakeModes[] = {
 	{320,200,8,8,8}, {320,240,8,8,8}, {400,300,8,8,8},
@@ -389,65 +390,32 @@ IGraphics::CTextureHandle CGraphics_Threaded::LoadTexture(const char *pFilename,
 		return CTextureHandle();
 	if(LoadPNG(&Img, pFilename, StorageType))
 	{
-		if (StoreFormat == CImageInfo::FORMAT_AUTO)
-			StoreFormat = Img.m_Format;
-
-		ID = LoadTextureRaw(Img.m_Width, Img.m_Height, Img.m_Format, Img.m_pData, StoreFormat, Flags);
+		ID = LoadTextureImage(pFilename, &Img, StoreFormat, Flags);
 		mem_free(Img.m_pData);
-		if(ID.Id() != m_InvalidTexture.Id() && g_Config.m_Debug)
-			dbg_msg("graphics/texture", "loaded %s", pFilename);
 		return ID;
 	}
 
 	return m_InvalidTexture;
 }
 
-int CGraphics_Threaded::LoadPNG(CImageInfo *pImg, const char *pFilename, int StorageType)
+IGraphics::CTextureHandle CGraphics_Threaded::LoadTextureImage(const char *pFilename, const CImageInfo *pImg, int StoreFormat, int Flags)
 {
-	char aCompleteFilename[512];
-	unsigned char *pBuffer;
-	png_t Png; // ignore_convention
+	// don't waste memory on texture if we are stress testing
+	if(g_Config.m_DbgStress)
+		return m_InvalidTexture;
 
-	// open file for reading
-	png_init(0,0); // ignore_convention
+	if (StoreFormat == CImageInfo::FORMAT_AUTO)
+		StoreFormat = pImg->m_Format;
 
-	IOHANDLE File = m_pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType, aCompleteFilename, sizeof(aCompleteFilename));
-	if(File)
-		io_close(File);
-	else
-	{
-		dbg_msg("game/png", "failed to open file. filename='%s'", pFilename);
-		return 0;
-	}
-
-	int Error = png_open_file(&Png, aCompleteFilename); // ignore_convention
-	if(Error != PNG_NO_ERROR)
-	{
-		dbg_msg("game/png", "failed to open file. filename='%s'", aCompleteFilename);
-		if(Error != PNG_FILE_ERROR)
-			png_close_file(&Png); // ignore_convention
-		return 0;
-	}
-
-	if(Png.depth != 8 || (Png.color_type != PNG_TRUECOLOR && Png.color_type != PNG_TRUECOLOR_ALPHA) || Png.width > (2<<12) || Png.height > (2<<12)) // ignore_convention
-	{
-		dbg_msg("game/png", "invalid format. filename='%s'", aCompleteFilename);
-		png_close_file(&Png); // ignore_convention
-		return 0;
-	}
+	IGraphics::CTextureHandle ID = LoadTextureRaw(pImg->m_Width, pImg->m_Height, pImg->m_Format, pImg->m_pData, StoreFormat, Flags);
+	if(ID.Id() != m_InvalidTexture.Id() && g_Config.m_Debug)
+		dbg_msg("graphics/texture", "loaded %s", pFilename);
+	return ID;
+}
 
-	pBuffer = (unsigned char *)mem_alloc(Png.width * Png.height * Png.bpp, 1); // ignore_convention
-	png_get_data(&Png, pBuffer); // ignore_convention
-	png_close_file(&Png); // ignore_convention
-
-	pImg->m_Width = Png.width; // ignore_convention
-	pImg->m_Height = Png.height; // ignore_convention
-	if(Png.color_type == PNG_TRUECOLOR) // ignore_convention
-		pImg->m_Format = CImageInfo::FORMAT_RGB;
-	else if(Png.color_type == PNG_TRUECOLOR_ALPHA) // ignore_convention
-		pImg->m_Format = CImageInfo::FORMAT_RGBA;
-	pImg->m_pData = pBuffer;
-	return 1;
+int CGraphics_Threaded::LoadPNG(CImageInfo *pImg, const char *pFilename, int StorageType)
+{
+	return DecodePNG(pImg, m_pStorage, pFilename, StorageType);
 }
 
 void CGraphics_Threaded::KickCommandBuffer()
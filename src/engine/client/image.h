@@ -0,0 +1,12 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_CLIENT_IMAGE_H
+#define ENGINE_CLIENT_IMAGE_H
+
+#include <engine/graphics.h>
+
+// decodes a png into pImg, the caller frees pImg->m_pData. doesn't touch
+// the graphics, so it can run on any thread
+bool DecodePNG(CImageInfo *pImg, class IStorage *pStorage, const char *pFilename, int StorageType);
+
+#endif
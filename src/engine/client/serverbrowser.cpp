@@ -152,7 +152,7 @@ void CServerBrowser::Set(const NETADDR &Addr, int SetType, int Token, const CSer
 	}
 
 	if(pEntry)
-		m_ServerBrowserFilter.Sort(m_aServerlist[m_ActServerlistType].m_ppServerlist, m_aServerlist[m_ActServerlistType].m_NumServers, CServerBrowserFilter::RESORT_FLAG_FORCE);
+		Changed(pEntry);
 }
 
 void CServerBrowser::Update(bool ForceResort)
@@ -245,13 +245,15 @@ void CServerBrowser::Update(bool ForceResort)
 		{
 			CServerEntry *pEntry = Find(i, *pFavAddr);
 			if(pEntry)
+			{
 				pEntry->m_Info.m_Favorite = 1;
-
-			if(i == m_ActServerlistType)
-				ForceResort = true;
+				Changed(pEntry);
+			}
 		}
 	}
 
+	// the servers that changed since the last update are put in place, all
+	// at once, instead of sorting the whole list for every server info
 	m_ServerBrowserFilter.Sort(m_aServerlist[m_ActServerlistType].m_ppServerlist, m_aServerlist[m_ActServerlistType].m_NumServers, ForceResort ? CServerBrowserFilter::RESORT_FLAG_FORCE : 0);
 }
 
@@ -346,9 +348,8 @@ void CServerBrowser::AddFavorite(const CServerInfo *pInfo)
 			{
  				pEntry->m_Info.m_Favorite = 1;
 
-				// refresh servers in all filters where favorites are filtered
-				if(i == m_ActServerlistType)
-					m_ServerBrowserFilter.Sort(m_aServerlist[m_ActServerlistType].m_ppServerlist, m_aServerlist[m_ActServerlistType].m_NumServers, CServerBrowserFilter::RESORT_FLAG_FAV);
+				// refresh the server in all filters
+				Changed(pEntry);
 			}
 		}
 	}
@@ -365,9 +366,8 @@ void CServerBrowser::RemoveFavorite(const CServerInfo *pInfo)
 			{
  				pEntry->m_Info.m_Favorite = 0;
 
-				// refresh servers in all filters where favorites are filtered
-				if(i == m_ActServerlistType)
-					m_ServerBrowserFilter.Sort(m_aServerlist[m_ActServerlistType].m_ppServerlist, m_aServerlist[m_ActServerlistType].m_NumServers, CServerBrowserFilter::RESORT_FLAG_FAV);
+				// refresh the server in all filters
+				Changed(pEntry);
 			}
 		}
 	}
@@ -527,9 +527,19 @@ void CServerBrowser::RequestImpl(const NETADDR &Addr, CServerEntry *pEntry)
 	}
 }
 
+void CServerBrowser::Changed(CServerEntry *pEntry)
+{
+	// only the filters of the shown list are kept up to date
+	const CServerlist *pList = &m_aServerlist[m_ActServerlistType];
+	int Index = pEntry->m_Info.m_ServerIndex;
+	if(Index >= 0 && Index < pList->m_NumServers && pList->m_ppServerlist[Index] == pEntry)
+		m_ServerBrowserFilter.Changed(Index);
+}
+
 void CServerBrowser::SetInfo(int ServerlistType, CServerEntry *pEntry, const CServerInfo &Info)
 {
 	int Fav = pEntry->m_Info.m_Favorite;
+	int ServerIndex = pEntry->m_Info.m_ServerIndex;
 	pEntry->m_Info = Info;
 	pEntry->m_Info.m_Flags &= FLAG_PASSWORD|FLAG_TIMESCORE;
 	if(str_comp(pEntry->m_Info.m_aGameType, "DM") == 0 || str_comp(pEntry->m_Info.m_aGameType, "TDM") == 0 || str_comp(pEntry->m_Info.m_aGameType, "CTF") == 0 ||
@@ -545,6 +555,7 @@ void CServerBrowser::SetInfo(int ServerlistType, CServerEntry *pEntry, const CSe
 		str_comp(pEntry->m_Info.m_aMap, "lms1") == 0)
 		pEntry->m_Info.m_Flags |= FLAG_PUREMAP;
 	pEntry->m_Info.m_Favorite = Fav;
+	pEntry->m_Info.m_ServerIndex = ServerIndex;
 	pEntry->m_Info.m_NetAddr = pEntry->m_Addr;
 
 	m_aServerlist[ServerlistType].m_NumPlayers += pEntry->m_Info.m_NumPlayers;
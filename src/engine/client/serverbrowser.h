@@ -104,6 +104,7 @@ private:
 	void RemoveRequest(CServerEntry *pEntry);
 	void RequestImpl(const NETADDR &Addr, CServerEntry *pEntry);
 	void SetInfo(int ServerlistType, CServerEntry *pEntry, const CServerInfo &Info);
+	void Changed(CServerEntry *pEntry);
 };
 
 #endif
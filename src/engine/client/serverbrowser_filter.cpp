@@ -14,7 +14,7 @@
 
 class SortWrap
 {
-	typedef bool (CServerBrowserFilter::CServerFilter::*SortFunc)(int, int) const;
+	typedef CServerBrowserFilter::CServerFilter::SortFunc SortFunc;
 	SortFunc m_pfnSort;
 	CServerBrowserFilter::CServerFilter *m_pThis;
 public:
@@ -77,139 +77,160 @@ CServerBrowserFilter::CServerFilter& CServerBrowserFilter::CServerFilter::operat
 	return *this;
 }
 
-void CServerBrowserFilter::CServerFilter::Filter()
+void CServerBrowserFilter::CServerFilter::Reserve(int NumServers)
 {
-	int NumServers = m_pServerBrowserFilter->m_NumServers;
-	m_NumSortedServers = 0;
-	m_NumSortedPlayers = 0;
+	if(m_SortedServersCapacity >= NumServers)
+		return;
 
-	// allocate the sorted list
-	if(m_SortedServersCapacity < NumServers)
+	int *pOldServerlist = m_pSortedServerlist;
+	m_SortedServersCapacity = max(1000, NumServers+NumServers/2);
+	m_pSortedServerlist = (int *)mem_alloc(m_SortedServersCapacity*sizeof(int), 1);
+	if(pOldServerlist)
 	{
-		if(m_pSortedServerlist)
-			mem_free(m_pSortedServerlist);
-		m_SortedServersCapacity = max(1000, NumServers+NumServers/2);
-		m_pSortedServerlist = (int *)mem_alloc(m_SortedServersCapacity*sizeof(int), 1);
+		mem_copy(m_pSortedServerlist, pOldServerlist, m_NumSortedServers*sizeof(int));
+		mem_free(pOldServerlist);
 	}
+}
 
-	// filter the servers
-	for(int i = 0; i < NumServers; i++)
+int CServerBrowserFilter::CServerFilter::GetRelevantClientCount(int Index) const
+{
+	const CServerInfo *pInfo = &m_pServerBrowserFilter->m_ppServerlist[Index]->m_Info;
+	int Count = (m_FilterInfo.m_SortHash&IServerBrowser::FILTER_SPECTATORS) ? pInfo->m_NumPlayers : pInfo->m_NumClients;
+	if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_BOTS)
 	{
-		int Filtered = 0;
+		Count -= pInfo->m_NumBotPlayers;
+		if(!(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_SPECTATORS))
+			Count -= pInfo->m_NumBotSpectators;
+	}
+	return Count;
+}
 
-		int RelevantClientCount = (m_FilterInfo.m_SortHash&IServerBrowser::FILTER_SPECTATORS) ? m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumPlayers : m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumClients;
-		if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_BOTS)
+bool CServerBrowserFilter::CServerFilter::FilterServer(int i)
+{
+	int Filtered = 0;
+
+	if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_EMPTY && GetRelevantClientCount(i) == 0)
+		Filtered = 1;
+	else if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_FULL && ((m_FilterInfo.m_SortHash&IServerBrowser::FILTER_SPECTATORS && m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumPlayers == m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_MaxPlayers) ||
+			m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumClients == m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_MaxClients))
+		Filtered = 1;
+	else if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_PW && m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_Flags&IServerBrowser::FLAG_PASSWORD)
+		Filtered = 1;
+	else if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_FAVORITE && !m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_Favorite)
+		Filtered = 1;
+	else if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_PURE && !(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_Flags&IServerBrowser::FLAG_PURE))
+		Filtered = 1;
+	else if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_PURE_MAP &&  !(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_Flags&IServerBrowser::FLAG_PUREMAP))
+		Filtered = 1;
+	else if(m_FilterInfo.m_Ping < m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_Latency)
+		Filtered = 1;
+	else if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_COMPAT_VERSION && str_comp_num(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aVersion, m_pServerBrowserFilter->m_aNetVersion, 3) != 0)
+		Filtered = 1;
+	else if(m_FilterInfo.m_aAddress[0] && !str_find_nocase(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aAddress, m_FilterInfo.m_aAddress))
+		Filtered = 1;
+	else if(m_FilterInfo.IsLevelFiltered(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_ServerLevel))
+		Filtered = 1;
+	else
+	{
+		if(m_FilterInfo.m_aGametype[0][0])
 		{
-			RelevantClientCount -= m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumBotPlayers;
-			if(!(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_SPECTATORS))
-				RelevantClientCount -= m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumBotSpectators;
-		}
-
-		if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_EMPTY && RelevantClientCount == 0)
-			Filtered = 1;
-		else if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_FULL && ((m_FilterInfo.m_SortHash&IServerBrowser::FILTER_SPECTATORS && m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumPlayers == m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_MaxPlayers) ||
-				m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumClients == m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_MaxClients))
-			Filtered = 1;
-		else if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_PW && m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_Flags&IServerBrowser::FLAG_PASSWORD)
-			Filtered = 1;
-		else if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_FAVORITE && !m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_Favorite)
-			Filtered = 1;
-		else if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_PURE && !(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_Flags&IServerBrowser::FLAG_PURE))
-			Filtered = 1;
-		else if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_PURE_MAP &&  !(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_Flags&IServerBrowser::FLAG_PUREMAP))
 			Filtered = 1;
-		else if(m_FilterInfo.m_Ping < m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_Latency)
-			Filtered = 1;
-		else if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_COMPAT_VERSION && str_comp_num(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aVersion, m_pServerBrowserFilter->m_aNetVersion, 3) != 0)
-			Filtered = 1;
-		else if(m_FilterInfo.m_aAddress[0] && !str_find_nocase(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aAddress, m_FilterInfo.m_aAddress))
-			Filtered = 1;
-		else if(m_FilterInfo.IsLevelFiltered(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_ServerLevel))
-			Filtered = 1;
-		else
-		{
-			if(m_FilterInfo.m_aGametype[0][0])
+			for(int Index = 0; Index < CServerFilterInfo::MAX_GAMETYPES; ++Index)
 			{
-				Filtered = 1;
-				for(int Index = 0; Index < CServerFilterInfo::MAX_GAMETYPES; ++Index)
+				if(!m_FilterInfo.m_aGametype[Index][0])
+					break;
+				if(!str_comp_nocase(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aGameType, m_FilterInfo.m_aGametype[Index]))
 				{
-					if(!m_FilterInfo.m_aGametype[Index][0])
-						break;
-					if(!str_comp_nocase(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aGameType, m_FilterInfo.m_aGametype[Index]))
-					{
-						Filtered = 0;
-						break;
-					}
+					Filtered = 0;
+					break;
 				}
 			}
+		}
 
-			if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_COUNTRY)
+		if(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_COUNTRY)
+		{
+			Filtered = 1;
+			// match against player country
+			for(int p = 0; p < m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumClients; p++)
 			{
-				Filtered = 1;
-				// match against player country
-				for(int p = 0; p < m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumClients; p++)
+				if(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_Country == m_FilterInfo.m_Country)
 				{
-					if(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_Country == m_FilterInfo.m_Country)
-					{
-						Filtered = 0;
-						break;
-					}
+					Filtered = 0;
+					break;
 				}
 			}
+		}
 
-			if(!Filtered && g_Config.m_BrFilterString[0] != 0)
-			{
-				int MatchFound = 0;
-
-				m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_QuickSearchHit = 0;
+		if(!Filtered && g_Config.m_BrFilterString[0] != 0)
+		{
+			int MatchFound = 0;
 
-				// match against server name
-				if(str_find_nocase(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aName, g_Config.m_BrFilterString))
-				{
-					MatchFound = 1;
-					m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
-				}
+			m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_QuickSearchHit = 0;
 
-				// match against players
-				for(int p = 0; p < m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumClients; p++)
-				{
-					if(str_find_nocase(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_aName, g_Config.m_BrFilterString) ||
-						str_find_nocase(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_aClan, g_Config.m_BrFilterString))
-					{
-						MatchFound = 1;
-						m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
-						break;
-					}
-				}
+			// match against server name
+			if(str_find_nocase(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aName, g_Config.m_BrFilterString))
+			{
+				MatchFound = 1;
+				m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_SERVERNAME;
+			}
 
-				// match against map
-				if(str_find_nocase(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aMap, g_Config.m_BrFilterString))
+			// match against players
+			for(int p = 0; p < m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumClients; p++)
+			{
+				if(str_find_nocase(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_aName, g_Config.m_BrFilterString) ||
+					str_find_nocase(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_aClan, g_Config.m_BrFilterString))
 				{
 					MatchFound = 1;
-					m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
+					m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_PLAYER;
+					break;
 				}
+			}
 
-				if(!MatchFound)
-					Filtered = 1;
+			// match against map
+			if(str_find_nocase(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aMap, g_Config.m_BrFilterString))
+			{
+				MatchFound = 1;
+				m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_QuickSearchHit |= IServerBrowser::QUICK_MAPNAME;
 			}
+
+			if(!MatchFound)
+				Filtered = 1;
 		}
+	}
 
-		if(Filtered == 0)
+	if(Filtered == 0)
+	{
+		// check for friend
+		m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_FriendState = CContactInfo::CONTACT_NO;
+		for(int p = 0; p < m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumClients; p++)
 		{
-			// check for friend
-			m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_FriendState = CContactInfo::CONTACT_NO;
-			for(int p = 0; p < m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_NumClients; p++)
-			{
-				m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_FriendState = m_pServerBrowserFilter->m_pFriends->GetFriendState(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_aName,
-					m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_aClan);
-				m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_FriendState = max(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_FriendState, m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_FriendState);
-			}
+			m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_FriendState = m_pServerBrowserFilter->m_pFriends->GetFriendState(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_aName,
+				m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_aClan);
+			m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_FriendState = max(m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_FriendState, m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_aClients[p].m_FriendState);
+		}
 
-			if(!(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_FRIENDS) || m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_FriendState != CContactInfo::CONTACT_NO)
-			{
-				m_pSortedServerlist[m_NumSortedServers++] = i;
-				m_NumSortedPlayers += RelevantClientCount;
-			}
+		if(!(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_FRIENDS) || m_pServerBrowserFilter->m_ppServerlist[i]->m_Info.m_FriendState != CContactInfo::CONTACT_NO)
+			return true;
+	}
+	return false;
+}
+
+void CServerBrowserFilter::CServerFilter::Filter()
+{
+	int NumServers = m_pServerBrowserFilter->m_NumServers;
+	m_NumSortedServers = 0;
+	m_NumSortedPlayers = 0;
+
+	// allocate the sorted list
+	Reserve(NumServers);
+
+	// filter the servers
+	for(int i = 0; i < NumServers; i++)
+	{
+		if(FilterServer(i))
+		{
+			m_pSortedServerlist[m_NumSortedServers++] = i;
+			m_NumSortedPlayers += GetRelevantClientCount(i);
 		}
 	}
 }
@@ -232,38 +253,79 @@ int CServerBrowserFilter::CServerFilter::GetSortHash() const
 	return i;
 }
 
-void CServerBrowserFilter::CServerFilter::Sort()
+CServerBrowserFilter::CServerFilter::SortFunc CServerBrowserFilter::CServerFilter::GetSortFunc() const
 {
-	// create filtered list
-	Filter();
-
-	// sort
 	switch(g_Config.m_BrSort)
 	{
-	case IServerBrowser::SORT_NAME:
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, &CServerBrowserFilter::CServerFilter::SortCompareName));
-		break;
 	case IServerBrowser::SORT_PING:
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, &CServerBrowserFilter::CServerFilter::SortComparePing));
-		break;
+		return &CServerBrowserFilter::CServerFilter::SortComparePing;
 	case IServerBrowser::SORT_MAP:
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, &CServerBrowserFilter::CServerFilter::SortCompareMap));
-		break;
+		return &CServerBrowserFilter::CServerFilter::SortCompareMap;
 	case IServerBrowser::SORT_NUMPLAYERS:
 		if(!(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_BOTS))
-			std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this,
-						(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_SPECTATORS) ? &CServerBrowserFilter::CServerFilter::SortCompareNumPlayers : &CServerBrowserFilter::CServerFilter::SortCompareNumClients));
-		else
-			std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this,
-						(m_FilterInfo.m_SortHash&IServerBrowser::FILTER_SPECTATORS) ? &CServerBrowserFilter::CServerFilter::SortCompareNumRealPlayers : &CServerBrowserFilter::CServerFilter::SortCompareNumRealClients));
-		break;
+			return (m_FilterInfo.m_SortHash&IServerBrowser::FILTER_SPECTATORS) ? &CServerBrowserFilter::CServerFilter::SortCompareNumPlayers : &CServerBrowserFilter::CServerFilter::SortCompareNumClients;
+		return (m_FilterInfo.m_SortHash&IServerBrowser::FILTER_SPECTATORS) ? &CServerBrowserFilter::CServerFilter::SortCompareNumRealPlayers : &CServerBrowserFilter::CServerFilter::SortCompareNumRealClients;
 	case IServerBrowser::SORT_GAMETYPE:
-		std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, &CServerBrowserFilter::CServerFilter::SortCompareGametype));
+		return &CServerBrowserFilter::CServerFilter::SortCompareGametype;
+	default:
+		return &CServerBrowserFilter::CServerFilter::SortCompareName;
 	}
+}
+
+void CServerBrowserFilter::CServerFilter::Sort()
+{
+	// create filtered list
+	Filter();
+
+	// sort
+	std::stable_sort(m_pSortedServerlist, m_pSortedServerlist+m_NumSortedServers, SortWrap(this, GetSortFunc()));
 
 	m_FilterInfo.m_SortHash = GetSortHash();
 }
 
+void CServerBrowserFilter::CServerFilter::Update(const int *pIndices, int Num)
+{
+	Reserve(m_pServerBrowserFilter->m_NumServers);
+	SortWrap Compare(this, GetSortFunc());
+
+	// take all changed servers out first, their old places no longer fit the sort
+	// order and would throw off the search below (the indices come sorted)
+	int NumKept = 0;
+	for(int i = 0; i < m_NumSortedServers; i++)
+	{
+		if(!std::binary_search(pIndices, pIndices+Num, m_pSortedServerlist[i]))
+			m_pSortedServerlist[NumKept++] = m_pSortedServerlist[i];
+	}
+	m_NumSortedServers = NumKept;
+
+	for(int k = 0; k < Num; k++)
+	{
+		int Index = pIndices[k];
+		if(!FilterServer(Index))
+			continue;
+
+		// equal servers stay in the order of their index, like with the stable sort
+		int Low = 0;
+		int High = m_NumSortedServers;
+		while(Low < High)
+		{
+			int Mid = (Low+High)/2;
+			int Other = m_pSortedServerlist[Mid];
+			if(Compare(Other, Index) || (!Compare(Index, Other) && Other < Index))
+				Low = Mid+1;
+			else
+				High = Mid;
+		}
+		mem_move(&m_pSortedServerlist[Low+1], &m_pSortedServerlist[Low], (m_NumSortedServers-Low)*sizeof(int));
+		m_pSortedServerlist[Low] = Index;
+		m_NumSortedServers++;
+	}
+
+	m_NumSortedPlayers = 0;
+	for(int i = 0; i < m_NumSortedServers; i++)
+		m_NumSortedPlayers += GetRelevantClientCount(m_pSortedServerlist[i]);
+}
+
 bool CServerBrowserFilter::CServerFilter::SortCompareName(int Index1, int Index2) const
 {
 	CServerEntry *a = m_pServerBrowserFilter->m_ppServerlist[Index1];
@@ -342,19 +404,32 @@ void CServerBrowserFilter::Clear()
 		m_lFilters[i].m_NumSortedServers = 0;
 		m_lFilters[i].m_NumSortedPlayers = 0;
 	}
+	m_lChangedServers.set_size(0);
 }
 
 void CServerBrowserFilter::Sort(CServerEntry **ppServerlist, int NumServers, int ResortFlags)
 {
 	m_ppServerlist = ppServerlist;
 	m_NumServers = NumServers;
+
+	// a server can change several times between two sorts
+	std::sort(m_lChangedServers.base_ptr(), m_lChangedServers.base_ptr()+m_lChangedServers.size());
+	int NumChanged = std::unique(m_lChangedServers.base_ptr(), m_lChangedServers.base_ptr()+m_lChangedServers.size())-m_lChangedServers.base_ptr();
+
+	// with many changes at once sorting everything is quicker
+	if(NumChanged > 16 && NumChanged > NumServers/8)
+		ResortFlags |= RESORT_FLAG_FORCE;
+
 	for(int i = 0; i < m_lFilters.size(); i++)
 	{
 		// check if we need to resort
 		CServerFilter *pFilter = &m_lFilters[i];
-		if((ResortFlags&RESORT_FLAG_FORCE) || ((ResortFlags&RESORT_FLAG_FAV) && pFilter->m_FilterInfo.m_SortHash&IServerBrowser::FILTER_FAVORITE) || pFilter->m_FilterInfo.m_SortHash != pFilter->GetSortHash())
+		if((ResortFlags&RESORT_FLAG_FORCE) || pFilter->m_FilterInfo.m_SortHash != pFilter->GetSortHash())
 			pFilter->Sort();
+		else if(NumChanged)
+			pFilter->Update(m_lChangedServers.base_ptr(), NumChanged);
 	}
+	m_lChangedServers.set_size(0);
 }
 
 int CServerBrowserFilter::AddFilter(const CServerFilterInfo *pFilterInfo)
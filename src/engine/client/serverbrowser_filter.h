@@ -11,7 +11,6 @@ public:
 	enum
 	{
 		RESORT_FLAG_FORCE=1,
-		RESORT_FLAG_FAV=2,
 	};
 
 	class CServerFilter
@@ -32,9 +31,17 @@ public:
 		~CServerFilter();
 		CServerFilter& operator=(const CServerFilter& Other);
 
+		typedef bool (CServerFilter::*SortFunc)(int, int) const;
+
+		void Reserve(int NumServers);
+		int GetRelevantClientCount(int Index) const;
+		bool FilterServer(int Index);
 		void Filter();
 		int GetSortHash() const;
+		SortFunc GetSortFunc() const;
 		void Sort();
+		// takes the changed servers (sorted, unique) out and puts them back in at their new place
+		void Update(const int *pIndices, int Num);
 
 		// sorting criterions
 		bool SortCompareName(int Index1, int Index2) const;
@@ -50,6 +57,8 @@ public:
 	//
 	void Init(class IFriends *pFriends, const char *pNetVersion);
 	void Clear();
+	// the server's info changed, it gets updated on the next sort
+	void Changed(int Index) { m_lChangedServers.add(Index); }
 	void Sort(class CServerEntry **ppServerlist, int NumServers, int ResortFlags);
 
 	// filter
@@ -68,6 +77,7 @@ private:
 	class IFriends *m_pFriends;
 	char m_aNetVersion[128];
 	array<CServerFilter> m_lFilters;
+	array<int> m_lChangedServers;
 
 	// get updated on sort
 	class CServerEntry **m_ppServerlist;
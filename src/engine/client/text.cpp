@@ -4,6 +4,10 @@
 #include <base/math.h>
 #include <engine/graphics.h>
 #include <engine/textrender.h>
+#include <engine/shared/textlayout.h>
+
+#include <unordered_map>
+#include <vector>
 
 #ifdef CONF_FAMILY_WINDOWS
 	#include <windows.h>
@@ -33,10 +37,13 @@ struct CFontChar
 	float m_Height;
 	float m_OffsetX;
 	float m_OffsetY;
-	float m_AdvanceX;
 
 	float m_aUvs[4];
 	int64 m_TouchTime;
+
+	// neighbours in the order the slots were used
+	int m_NewerSlot;
+	int m_OlderSlot;
 };
 
 struct CFontSizeData
@@ -57,6 +64,31 @@ struct CFontSizeData
 	CFontChar m_aCharacters[MAX_CHARACTERS*MAX_CHARACTERS];
 
 	int m_CurrentCharacter;
+
+	// the used slots from the last touched one to the one to kick out next
+	int m_NewestSlot;
+	int m_OldestSlot;
+	std::unordered_map<int, int> m_CharSlots;
+	int m_Generation; // changes when the texture gets recreated and all slots are lost
+
+	// known without rendering the glyph, negative if it can't be loaded
+	std::unordered_map<int, float> m_Advances;
+
+	CFontSizeData()
+	{
+		m_FontSize = -1;
+		m_pFace = 0;
+		m_TextureWidth = 0;
+		m_TextureHeight = 0;
+		m_NumXChars = 0;
+		m_NumYChars = 0;
+		m_CharMaxWidth = 0;
+		m_CharMaxHeight = 0;
+		m_CurrentCharacter = 0;
+		m_NewestSlot = -1;
+		m_OldestSlot = -1;
+		m_Generation = 0;
+	}
 };
 
 class CFont
@@ -64,7 +96,15 @@ class CFont
 public:
 	char m_aFilename[512];
 	FT_Face m_FtFace;
+	int m_FaceSize; // the pixel size the face is set to
 	CFontSizeData m_aSizes[NUM_FONT_SIZES];
+
+	CFont()
+	{
+		m_aFilename[0] = 0;
+		m_FtFace = 0;
+		m_FaceSize = -1;
+	}
 };
 
 struct CQuadChar
@@ -78,19 +118,20 @@ class CTextRender : public IEngineTextRender
 	IGraphics *m_pGraphics;
 	IGraphics *Graphics() { return m_pGraphics; }
 
-	int WordLength(const char *pText)
+	class CGlyphMetrics : public ITextGlyphMetrics
 	{
-		int s = 1;
-		while(1)
-		{
-			if(*pText == 0)
-				return s-1;
-			if(*pText == '\n' || *pText == '\t' || *pText == ' ')
-				return s;
-			pText++;
-			s++;
-		}
-	}
+		CTextRender *m_pTextRender;
+		CFont *m_pFont;
+		CFontSizeData *m_pSizeData;
+
+	public:
+		CGlyphMetrics(CTextRender *pTextRender, CFont *pFont, CFontSizeData *pSizeData)
+		: m_pTextRender(pTextRender), m_pFont(pFont), m_pSizeData(pSizeData)
+		{}
+
+		virtual bool Advance(int Chr, float *pAdvance) { return m_pTextRender->GlyphAdvance(m_pFont, m_pSizeData, Chr, pAdvance); }
+		virtual float Kerning(int Left, int Right) { return m_pTextRender->Kerning(m_pFont, m_pSizeData, Left, Right); }
+	};
 
 	float m_TextR;
 	float m_TextG;
@@ -108,6 +149,10 @@ class CTextRender : public IEngineTextRender
 
 	FT_Library m_FTLibrary;
 
+	CTextLayoutCache m_LayoutCache;
+	std::vector<int> m_aGlyphSlots; // the texture slots of the layout being drawn
+	int64 m_TouchTime; // taken once per text
+
 	int GetFontSizeIndex(int Pixelsize)
 	{
 		for(unsigned i = 0; i < NUM_FONT_SIZES; i++)
@@ -170,6 +215,10 @@ class CTextRender : public IEngineTextRender
 		pSizeData->m_TextureWidth = Width;
 		pSizeData->m_TextureHeight = Height;
 		pSizeData->m_CurrentCharacter = 0;
+		pSizeData->m_NewestSlot = -1;
+		pSizeData->m_OldestSlot = -1;
+		pSizeData->m_CharSlots.clear();
+		pSizeData->m_Generation++;
 
 		dbg_msg("", "pFont memory usage: %d", FontMemoryUsage);
 
@@ -195,13 +244,22 @@ class CTextRender : public IEngineTextRender
 	}
 
 
+	void SetFaceSize(CFont *pFont, int Size)
+	{
+		if(pFont->m_FaceSize != Size)
+		{
+			FT_Set_Pixel_Sizes(pFont->m_FtFace, 0, Size);
+			pFont->m_FaceSize = Size;
+		}
+	}
+
 	// TODO: Refactor: move this into a pFont class
 	void InitIndex(CFont *pFont, int Index)
 	{
 		CFontSizeData *pSizeData = &pFont->m_aSizes[Index];
 
 		pSizeData->m_FontSize = aFontSizes[Index];
-		FT_Set_Pixel_Sizes(pFont->m_FtFace, 0, pSizeData->m_FontSize);
+		SetFaceSize(pFont, pSizeData->m_FontSize);
 
 		int OutlineThickness = AdjustOutlineThicknessToFontSize(1, pSizeData->m_FontSize);
 
@@ -263,6 +321,42 @@ class CTextRender : public IEngineTextRender
 	unsigned char ms_aGlyphData[(1024/8) * (1024/8)];
 	unsigned char ms_aGlyphDataOutlined[(1024/8) * (1024/8)];
 
+	void UnlinkSlot(CFontSizeData *pSizeData, int SlotID)
+	{
+		CFontChar *pFontchr = &pSizeData->m_aCharacters[SlotID];
+		if(pFontchr->m_NewerSlot >= 0)
+			pSizeData->m_aCharacters[pFontchr->m_NewerSlot].m_OlderSlot = pFontchr->m_OlderSlot;
+		else
+			pSizeData->m_NewestSlot = pFontchr->m_OlderSlot;
+		if(pFontchr->m_OlderSlot >= 0)
+			pSizeData->m_aCharacters[pFontchr->m_OlderSlot].m_NewerSlot = pFontchr->m_NewerSlot;
+		else
+			pSizeData->m_OldestSlot = pFontchr->m_NewerSlot;
+	}
+
+	void LinkSlot(CFontSizeData *pSizeData, int SlotID)
+	{
+		CFontChar *pFontchr = &pSizeData->m_aCharacters[SlotID];
+		pFontchr->m_NewerSlot = -1;
+		pFontchr->m_OlderSlot = pSizeData->m_NewestSlot;
+		if(pSizeData->m_NewestSlot >= 0)
+			pSizeData->m_aCharacters[pSizeData->m_NewestSlot].m_NewerSlot = SlotID;
+		else
+			pSizeData->m_OldestSlot = SlotID;
+		pSizeData->m_NewestSlot = SlotID;
+	}
+
+	void TouchSlot(CFontSizeData *pSizeData, int SlotID)
+	{
+		pSizeData->m_aCharacters[SlotID].m_TouchTime = m_TouchTime;
+		if(pSizeData->m_NewestSlot != SlotID)
+		{
+			UnlinkSlot(pSizeData, SlotID);
+			LinkSlot(pSizeData, SlotID);
+		}
+	}
+
+	// the returned slot is free and not linked
 	int GetSlot(CFontSizeData *pSizeData)
 	{
 		int CharCount = pSizeData->m_NumXChars*pSizeData->m_NumYChars;
@@ -274,24 +368,17 @@ class CTextRender : public IEngineTextRender
 		}
 
 		// kick out the oldest
-		// TODO: remove this linear search
+		int Oldest = pSizeData->m_OldestSlot;
+		if(m_TouchTime-pSizeData->m_aCharacters[Oldest].m_TouchTime < time_freq() &&
+			(pSizeData->m_NumXChars < MAX_CHARACTERS || pSizeData->m_NumYChars < MAX_CHARACTERS))
 		{
-			int Oldest = 0;
-			for(int i = 1; i < CharCount; i++)
-			{
-				if(pSizeData->m_aCharacters[i].m_TouchTime < pSizeData->m_aCharacters[Oldest].m_TouchTime)
-					Oldest = i;
-			}
-
-			if(time_get()-pSizeData->m_aCharacters[Oldest].m_TouchTime < time_freq() &&
-				(pSizeData->m_NumXChars < MAX_CHARACTERS || pSizeData->m_NumYChars < MAX_CHARACTERS))
-			{
-				IncreaseTextureSize(pSizeData);
-				return GetSlot(pSizeData);
-			}
-
-			return Oldest;
+			IncreaseTextureSize(pSizeData);
+			return GetSlot(pSizeData);
 		}
+
+		pSizeData->m_CharSlots.erase(pSizeData->m_aCharacters[Oldest].m_ID);
+		UnlinkSlot(pSizeData, Oldest);
+		return Oldest;
 	}
 
 	int RenderGlyph(CFont *pFont, CFontSizeData *pSizeData, int Chr)
@@ -305,7 +392,7 @@ class CTextRender : public IEngineTextRender
 		int y = 1;
 		unsigned int px, py;
 
-		FT_Set_Pixel_Sizes(pFont->m_FtFace, 0, pSizeData->m_FontSize);
+		SetFaceSize(pFont, pSizeData->m_FontSize);
 
 		if(FT_Load_Char(pFont->m_FtFace, Chr, FT_LOAD_RENDER|FT_LOAD_NO_BITMAP))
 		{
@@ -380,7 +467,6 @@ class CTextRender : public IEngineTextRender
 			pFontchr->m_Width = Width * Scale;
 			pFontchr->m_OffsetX = (pFont->m_FtFace->glyph->bitmap_left-2) * Scale; // ignore_convention
 			pFontchr->m_OffsetY = (pSizeData->m_FontSize - pFont->m_FtFace->glyph->bitmap_top) * Scale; // ignore_convention
-			pFontchr->m_AdvanceX = (pFont->m_FtFace->glyph->advance.x>>6) * Scale; // ignore_convention
 
 			pFontchr->m_aUvs[0] = (SlotID%pSizeData->m_NumXChars) / (float)(pSizeData->m_NumXChars);
 			pFontchr->m_aUvs[1] = (SlotID/pSizeData->m_NumXChars) / (float)(pSizeData->m_NumYChars);
@@ -388,52 +474,134 @@ class CTextRender : public IEngineTextRender
 			pFontchr->m_aUvs[3] = pFontchr->m_aUvs[1] + Height*Vscale;
 		}
 
+		pSizeData->m_CharSlots[Chr] = SlotID;
+		LinkSlot(pSizeData, SlotID);
 		return SlotID;
 	}
 
-	CFontChar *GetChar(CFont *pFont, CFontSizeData *pSizeData, int Chr)
+	// returns the slot of the character, -1 if it can't be rendered
+	int GetChar(CFont *pFont, CFontSizeData *pSizeData, int Chr)
 	{
-		CFontChar *pFontchr = NULL;
+		int SlotID;
+		std::unordered_map<int, int>::const_iterator Found = pSizeData->m_CharSlots.find(Chr);
+		if(Found != pSizeData->m_CharSlots.end())
+			SlotID = Found->second;
+		else
+		{
+			// render the character
+			SlotID = RenderGlyph(pFont, pSizeData, Chr);
+			if(SlotID < 0)
+				return -1;
+		}
 
-		// search for the character
-		// TODO: remove this linear search
-		int i;
-		for(i = 0; i < pSizeData->m_CurrentCharacter; i++)
+		TouchSlot(pSizeData, SlotID);
+		return SlotID;
+	}
+
+	// puts all glyphs of the layout into the texture before anything gets drawn.
+	// when the texture has to grow on the way, the slots fetched before are lost
+	void FetchGlyphs(CFont *pFont, CFontSizeData *pSizeData, const CTextLayout *pLayout)
+	{
+		m_aGlyphSlots.resize(pLayout->m_aGlyphs.size());
+		int Generation;
+		do
 		{
-			if(pSizeData->m_aCharacters[i].m_ID == Chr)
-			{
-				pFontchr = &pSizeData->m_aCharacters[i];
-				break;
-			}
+			Generation = pSizeData->m_Generation;
+			for(unsigned i = 0; i < pLayout->m_aGlyphs.size(); i++)
+				m_aGlyphSlots[i] = GetChar(pFont, pSizeData, pLayout->m_aGlyphs[i].m_Chr);
 		}
+		while(Generation != pSizeData->m_Generation);
+	}
 
-		// check if we need to render the character
-		if(!pFontchr)
+	bool GlyphAdvance(CFont *pFont, CFontSizeData *pSizeData, int Chr, float *pAdvance)
+	{
+		std::unordered_map<int, float>::const_iterator Found = pSizeData->m_Advances.find(Chr);
+		if(Found == pSizeData->m_Advances.end())
 		{
-			int Index = RenderGlyph(pFont, pSizeData, Chr);
-			if(Index >= 0)
-				pFontchr = &pSizeData->m_aCharacters[Index];
+			float Advance = -1.0f;
+			SetFaceSize(pFont, pSizeData->m_FontSize);
+			if(FT_Load_Char(pFont->m_FtFace, Chr, FT_LOAD_NO_BITMAP) == 0)
+				Advance = (pFont->m_FtFace->glyph->advance.x>>6) / (float)pSizeData->m_FontSize; // ignore_convention
+			else
+				dbg_msg("pFont", "error loading glyph %d", Chr);
+			Found = pSizeData->m_Advances.insert(std::make_pair(Chr, Advance)).first;
 		}
 
-		// touch the character
-		// TODO: don't call time_get here
-		if(pFontchr)
-			pFontchr->m_TouchTime = time_get();
+		*pAdvance = Found->second;
+		return Found->second >= 0.0f;
+	}
 
-		return pFontchr;
+	float Kerning(CFont *pFont, CFontSizeData *pSizeData, int Left, int Right)
+	{
+		FT_Vector Kerning = {0,0};
+		SetFaceSize(pFont, pSizeData->m_FontSize);
+		FT_Get_Kerning(pFont->m_FtFace, Left, Right, FT_KERNING_DEFAULT, &Kerning);
+		return (Kerning.x>>6) / (float)pSizeData->m_FontSize;
 	}
 
-	// must only be called from the rendering function as the pFont must be set to the correct size
-	void RenderSetup(CFont *pFont, int size)
+	// lays the text out at the cursor, the cursor and the size snapped to screen pixels
+	const CTextLayout *LayoutText(const CTextCursor *pCursor, const char *pText, int Length,
+		CFont **ppFont, CFontSizeData **ppSizeData, float *pCursorX, float *pCursorY, float *pSize)
 	{
-		FT_Set_Pixel_Sizes(pFont->m_FtFace, 0, size);
+		float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
+		float FakeToScreenX, FakeToScreenY;
+
+		// to correct coords, convert to screen coords, round, and convert back
+		Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
+
+		FakeToScreenX = (Graphics()->ScreenWidth()/(ScreenX1-ScreenX0));
+		FakeToScreenY = (Graphics()->ScreenHeight()/(ScreenY1-ScreenY0));
+		int ActualX = (int)(pCursor->m_X * FakeToScreenX);
+		int ActualY = (int)(pCursor->m_Y * FakeToScreenY);
+
+		*pCursorX = ActualX / FakeToScreenX;
+		*pCursorY = ActualY / FakeToScreenY;
+
+		// same with size
+		int ActualSize = (int)(pCursor->m_FontSize * FakeToScreenY);
+		*pSize = ActualSize / FakeToScreenY;
+
+		// fetch pFont data
+		CFont *pFont = pCursor->m_pFont;
+		if(!pFont)
+			pFont = m_pDefaultFont;
+
+		if(!pFont)
+			return 0;
+
+		CFontSizeData *pSizeData = GetSize(pFont, ActualSize);
+
+		// set length
+		if(Length < 0)
+			Length = str_length(pText);
+
+		CTextLayoutSettings Settings;
+		Settings.m_pFont = pFont;
+		Settings.m_FontSize = pSizeData->m_FontSize;
+		Settings.m_Size = *pSize;
+		Settings.m_ScaleX = FakeToScreenX;
+		Settings.m_ScaleY = FakeToScreenY;
+		Settings.m_StartX = pCursor->m_StartX - *pCursorX;
+		Settings.m_LineWidth = pCursor->m_LineWidth;
+		Settings.m_MaxLines = pCursor->m_MaxLines;
+		Settings.m_LineCount = pCursor->m_LineCount;
+		Settings.m_Flags = pCursor->m_Flags&TEXTFLAG_STOP_AT_END; // measuring and drawing share the layout
+
+		*ppFont = pFont;
+		*ppSizeData = pSizeData;
+		CGlyphMetrics Metrics(this, pFont, pSizeData);
+		return m_LayoutCache.Get(&Metrics, &Settings, pText, Length);
 	}
 
-	float Kerning(CFont *pFont, int Left, int Right)
+	void MoveCursor(CTextCursor *pCursor, const CTextLayout *pLayout, float CursorX, float CursorY, bool NewLine)
 	{
-		FT_Vector Kerning = {0,0};
-		FT_Get_Kerning(pFont->m_FtFace, Left, Right, FT_KERNING_DEFAULT, &Kerning);
-		return (Kerning.x>>6);
+		pCursor->m_X = CursorX + pLayout->m_EndX;
+		pCursor->m_LineCount = pLayout->m_LineCount;
+		pCursor->m_GlyphCount += pLayout->m_GlyphCount;
+		pCursor->m_CharCount += pLayout->m_CharCount;
+
+		if(NewLine)
+			pCursor->m_Y = CursorY + pLayout->m_EndY;
 	}
 
 
@@ -452,6 +620,7 @@ public:
 		m_TextOutlineA = 0.3f;
 
 		m_pDefaultFont = 0;
+		m_TouchTime = 0;
 
 		// GL_LUMINANCE can be good for debugging
 		//m_FontTextureFormat = GL_ALPHA;
@@ -466,22 +635,19 @@ public:
 
 	virtual int LoadFont(const char *pFilename)
 	{
-		CFont *pFont = (CFont *)mem_alloc(sizeof(CFont), 1);
+		CFont *pFont = new CFont;
 
-		mem_zero(pFont, sizeof(*pFont));
 		str_copy(pFont->m_aFilename, pFilename, sizeof(pFont->m_aFilename));
 
 		if(FT_New_Face(m_FTLibrary, pFont->m_aFilename, 0, &pFont->m_FtFace))
 		{
-			mem_free(pFont);
+			delete pFont;
 			return -1;
 		}
 
-		for(unsigned i = 0; i < NUM_FONT_SIZES; i++)
-			pFont->m_aSizes[i].m_FontSize = -1;
-
 		dbg_msg("textrender", "loaded pFont from '%s'", pFilename);
 		m_pDefaultFont = pFont;
+		m_LayoutCache.Clear();
 
 		return 0;
 	}
@@ -603,356 +769,93 @@ public:
 									  CQuadChar* aQuadChar, int QuadCharMaxCount, int* pQuadCharCount,
 									  IGraphics::CTextureHandle* pFontTexture)
 	{
-		CFont *pFont = pCursor->m_pFont;
-		CFontSizeData *pSizeData = NULL;
-
-		float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
-		float FakeToScreenX, FakeToScreenY;
-		int ActualX, ActualY;
-
-		int ActualSize;
-		int GotNewLine = 0;
-		float DrawX = 0.0f, DrawY = 0.0f;
-		int LineCount = 0;
-		float CursorX, CursorY;
-
-		float Size = pCursor->m_FontSize;
-
-		// to correct coords, convert to screen coords, round, and convert back
-		Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
-
-		FakeToScreenX = (Graphics()->ScreenWidth()/(ScreenX1-ScreenX0));
-		FakeToScreenY = (Graphics()->ScreenHeight()/(ScreenY1-ScreenY0));
-		ActualX = (int)(pCursor->m_X * FakeToScreenX);
-		ActualY = (int)(pCursor->m_Y * FakeToScreenY);
-
-		CursorX = ActualX / FakeToScreenX;
-		CursorY = ActualY / FakeToScreenY;
+		CFont *pFont;
+		CFontSizeData *pSizeData;
+		float CursorX, CursorY, Size;
 
-		// same with size
-		ActualSize = (int)(Size * FakeToScreenY);
-		Size = ActualSize / FakeToScreenY;
-
-		// fetch pFont data
-		if(!pFont)
-			pFont = m_pDefaultFont;
-
-		if(!pFont)
+		m_TouchTime = time_get();
+		const CTextLayout *pLayout = LayoutText(pCursor, pText, Length, &pFont, &pSizeData, &CursorX, &CursorY, &Size);
+		if(!pLayout)
 			return;
 
-		pSizeData = GetSize(pFont, ActualSize);
-		RenderSetup(pFont, ActualSize);
-		*pFontTexture = pSizeData->m_aTextures[0];
-
-		float Scale = 1.0f/pSizeData->m_FontSize;
-
-		// set length
-		if(Length < 0)
-			Length = str_length(pText);
-
-
-		const char *pCurrent = (char *)pText;
-		const char *pEnd = pCurrent+Length;
-		DrawX = CursorX;
-		DrawY = CursorY;
-		LineCount = pCursor->m_LineCount;
-
-		while(pCurrent < pEnd && (pCursor->m_MaxLines < 1 || LineCount <= pCursor->m_MaxLines))
+		if(pCursor->m_Flags&TEXTFLAG_RENDER)
 		{
-			int NewLine = 0;
-			const char *pBatchEnd = pEnd;
-			if(pCursor->m_LineWidth > 0 && !(pCursor->m_Flags&TEXTFLAG_STOP_AT_END))
-			{
-				int Wlen = min(WordLength((char *)pCurrent), (int)(pEnd-pCurrent));
-				CTextCursor Compare = *pCursor;
-				Compare.m_X = DrawX;
-				Compare.m_Y = DrawY;
-				Compare.m_Flags &= ~TEXTFLAG_RENDER;
-				Compare.m_LineWidth = -1;
-				TextDeferredRenderEx(&Compare, pCurrent, Wlen, aQuadChar, QuadCharMaxCount, pQuadCharCount,
-									 pFontTexture);
-
-				if(Compare.m_X-DrawX > pCursor->m_LineWidth)
-				{
-					// word can't be fitted in one line, cut it
-					CTextCursor Cutter = *pCursor;
-					Cutter.m_GlyphCount = 0;
-					Cutter.m_X = DrawX;
-					Cutter.m_Y = DrawY;
-					Cutter.m_Flags &= ~TEXTFLAG_RENDER;
-					Cutter.m_Flags |= TEXTFLAG_STOP_AT_END;
-
-					TextDeferredRenderEx(&Cutter, (const char *)pCurrent, Wlen, aQuadChar, QuadCharMaxCount,
-										 pQuadCharCount, pFontTexture);
-					Wlen = Cutter.m_GlyphCount;
-					NewLine = 1;
-
-					if(Wlen <= 3) // if we can't place 3 chars of the word on this line, take the next
-						Wlen = 0;
-				}
-				else if(Compare.m_X-pCursor->m_StartX > pCursor->m_LineWidth)
-				{
-					NewLine = 1;
-					Wlen = 0;
-				}
-
-				pBatchEnd = pCurrent + Wlen;
-			}
-
-			const char *pTmp = pCurrent;
-			int NextCharacter = str_utf8_decode(&pTmp);
-			while(pCurrent < pBatchEnd)
+			FetchGlyphs(pFont, pSizeData, pLayout);
+			for(unsigned i = 0; i < pLayout->m_aGlyphs.size(); i++)
 			{
-				pCursor->m_CharCount += pTmp-pCurrent;
-				int Character = NextCharacter;
-				pCurrent = pTmp;
-				NextCharacter = str_utf8_decode(&pTmp);
-
-				if(Character == '\n')
-				{
-					DrawX = pCursor->m_StartX;
-					DrawY += Size;
-					DrawX = (int)(DrawX * FakeToScreenX) / FakeToScreenX; // realign
-					DrawY = (int)(DrawY * FakeToScreenY) / FakeToScreenY;
-					++LineCount;
-					if(pCursor->m_MaxLines > 0 && LineCount > pCursor->m_MaxLines)
-						break;
+				if(m_aGlyphSlots[i] < 0)
 					continue;
-				}
 
-				CFontChar *pChr = GetChar(pFont, pSizeData, Character);
-				if(pChr)
-				{
-					float Advance = pChr->m_AdvanceX + Kerning(pFont, Character, NextCharacter)*Scale;
-					if(pCursor->m_Flags&TEXTFLAG_STOP_AT_END && DrawX+Advance*Size-pCursor->m_StartX > pCursor->m_LineWidth)
-					{
-						// we hit the end of the line, no more to render or count
-						pCurrent = pEnd;
-						break;
-					}
+				dbg_assert(*pQuadCharCount < QuadCharMaxCount, "aQuadChar size is too small");
 
-					if(pCursor->m_Flags&TEXTFLAG_RENDER)
-					{
-						dbg_assert(*pQuadCharCount < QuadCharMaxCount, "aQuadChar size is too small");
-
-						CQuadChar QuadChar;
-						memmove(QuadChar.m_aUvs, pChr->m_aUvs, sizeof(pChr->m_aUvs));
-
-						IGraphics::CQuadItem QuadItem(DrawX+pChr->m_OffsetX*Size,
-													  DrawY+pChr->m_OffsetY*Size,
-													  pChr->m_Width*Size,
-													  pChr->m_Height*Size);
-						QuadChar.m_QuadItem = QuadItem;
-						aQuadChar[(*pQuadCharCount)++] = QuadChar;
-					}
-
-					DrawX += Advance*Size;
-					pCursor->m_GlyphCount++;
-				}
-			}
+				const CTextLayout::CGlyph *pGlyph = &pLayout->m_aGlyphs[i];
+				const CFontChar *pChr = &pSizeData->m_aCharacters[m_aGlyphSlots[i]];
+				CQuadChar QuadChar;
+				memmove(QuadChar.m_aUvs, pChr->m_aUvs, sizeof(pChr->m_aUvs));
 
-			if(NewLine)
-			{
-				DrawX = pCursor->m_StartX;
-				DrawY += Size;
-				GotNewLine = 1;
-				DrawX = (int)(DrawX * FakeToScreenX) / FakeToScreenX; // realign
-				DrawY = (int)(DrawY * FakeToScreenY) / FakeToScreenY;
-				++LineCount;
+				IGraphics::CQuadItem QuadItem(CursorX+pGlyph->m_X+pChr->m_OffsetX*Size,
+											  CursorY+pGlyph->m_Y+pChr->m_OffsetY*Size,
+											  pChr->m_Width*Size,
+											  pChr->m_Height*Size);
+				QuadChar.m_QuadItem = QuadItem;
+				aQuadChar[(*pQuadCharCount)++] = QuadChar;
 			}
 		}
+		*pFontTexture = pSizeData->m_aTextures[0];
 
-		pCursor->m_X = DrawX;
-		pCursor->m_LineCount = LineCount;
-
-		if(GotNewLine)
-			pCursor->m_Y = DrawY;
+		// line breaks in the text never moved this cursor down, only wrapped lines do
+		MoveCursor(pCursor, pLayout, CursorX, CursorY, pLayout->m_Wrapped);
 	}
 
 	virtual void TextEx(CTextCursor *pCursor, const char *pText, int Length)
 	{
-		CFont *pFont = pCursor->m_pFont;
-		CFontSizeData *pSizeData = NULL;
+		CFont *pFont;
+		CFontSizeData *pSizeData;
+		float CursorX, CursorY, Size;
 
 		//dbg_msg("textrender", "rendering text '%s'", text);
 
-		float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
-		float FakeToScreenX, FakeToScreenY;
-		int ActualX, ActualY;
-
-		int ActualSize;
-		int i;
-		int GotNewLine = 0;
-		float DrawX = 0.0f, DrawY = 0.0f;
-		int LineCount = 0;
-		float CursorX, CursorY;
-
-		float Size = pCursor->m_FontSize;
-
-		// to correct coords, convert to screen coords, round, and convert back
-		Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
-
-		FakeToScreenX = (Graphics()->ScreenWidth()/(ScreenX1-ScreenX0));
-		FakeToScreenY = (Graphics()->ScreenHeight()/(ScreenY1-ScreenY0));
-		ActualX = (int)(pCursor->m_X * FakeToScreenX);
-		ActualY = (int)(pCursor->m_Y * FakeToScreenY);
-
-		CursorX = ActualX / FakeToScreenX;
-		CursorY = ActualY / FakeToScreenY;
-
-		// same with size
-		ActualSize = (int)(Size * FakeToScreenY);
-		Size = ActualSize / FakeToScreenY;
-
-		// fetch pFont data
-		if(!pFont)
-			pFont = m_pDefaultFont;
-
-		if(!pFont)
+		m_TouchTime = time_get();
+		const CTextLayout *pLayout = LayoutText(pCursor, pText, Length, &pFont, &pSizeData, &CursorX, &CursorY, &Size);
+		if(!pLayout)
 			return;
 
-		pSizeData = GetSize(pFont, ActualSize);
-		RenderSetup(pFont, ActualSize);
-
-		float Scale = 1.0f/pSizeData->m_FontSize;
-
-		// set length
-		if(Length < 0)
-			Length = str_length(pText);
-
-		// if we don't want to render, we can just skip the first outline pass
-		i = 1;
-		if(pCursor->m_Flags&TEXTFLAG_RENDER)
-			i = 0;
-
-		for(;i < 2; i++)
+		if(pCursor->m_Flags&TEXTFLAG_RENDER && !pLayout->m_aGlyphs.empty())
 		{
-			const char *pCurrent = (char *)pText;
-			const char *pEnd = pCurrent+Length;
-			DrawX = CursorX;
-			DrawY = CursorY;
-			LineCount = pCursor->m_LineCount;
+			FetchGlyphs(pFont, pSizeData, pLayout);
 
-			if(pCursor->m_Flags&TEXTFLAG_RENDER)
+			// outline first, then the text
+			for(int Pass = 0; Pass < 2; Pass++)
 			{
 				// TODO: Make this better
-				if (i == 0)
+				if(Pass == 0)
 					Graphics()->TextureSet(pSizeData->m_aTextures[1]);
 				else
 					Graphics()->TextureSet(pSizeData->m_aTextures[0]);
 
 				Graphics()->QuadsBegin();
-				if (i == 0)
+				if(Pass == 0)
 					Graphics()->SetColor(m_TextOutlineR, m_TextOutlineG, m_TextOutlineB, m_TextOutlineA*m_TextA);
 				else
 					Graphics()->SetColor(m_TextR, m_TextG, m_TextB, m_TextA);
-			}
 
-			while(pCurrent < pEnd && (pCursor->m_MaxLines < 1 || LineCount <= pCursor->m_MaxLines))
-			{
-				int NewLine = 0;
-				const char *pBatchEnd = pEnd;
-				if(pCursor->m_LineWidth > 0 && !(pCursor->m_Flags&TEXTFLAG_STOP_AT_END))
+				for(unsigned i = 0; i < pLayout->m_aGlyphs.size(); i++)
 				{
-					int Wlen = min(WordLength((char *)pCurrent), (int)(pEnd-pCurrent));
-					CTextCursor Compare = *pCursor;
-					Compare.m_X = DrawX;
-					Compare.m_Y = DrawY;
-					Compare.m_Flags &= ~TEXTFLAG_RENDER;
-					Compare.m_LineWidth = -1;
-					TextEx(&Compare, pCurrent, Wlen);
-
-					if(Compare.m_X-DrawX > pCursor->m_LineWidth)
-					{
-						// word can't be fitted in one line, cut it
-						CTextCursor Cutter = *pCursor;
-						Cutter.m_GlyphCount = 0;
-						Cutter.m_X = DrawX;
-						Cutter.m_Y = DrawY;
-						Cutter.m_Flags &= ~TEXTFLAG_RENDER;
-						Cutter.m_Flags |= TEXTFLAG_STOP_AT_END;
-
-						TextEx(&Cutter, (const char *)pCurrent, Wlen);
-						Wlen = Cutter.m_GlyphCount;
-						NewLine = 1;
-
-						if(Wlen <= 3) // if we can't place 3 chars of the word on this line, take the next
-							Wlen = 0;
-					}
-					else if(Compare.m_X-pCursor->m_StartX > pCursor->m_LineWidth)
-					{
-						NewLine = 1;
-						Wlen = 0;
-					}
-
-					pBatchEnd = pCurrent + Wlen;
-				}
-
-				const char *pTmp = pCurrent;
-				int NextCharacter = str_utf8_decode(&pTmp);
-				while(pCurrent < pBatchEnd)
-				{
-					pCursor->m_CharCount += pTmp-pCurrent;
-					int Character = NextCharacter;
-					pCurrent = pTmp;
-					NextCharacter = str_utf8_decode(&pTmp);
-
-					if(Character == '\n')
-					{
-						DrawX = pCursor->m_StartX;
-						DrawY += Size;
-						GotNewLine = 1;
-						DrawX = (int)(DrawX * FakeToScreenX) / FakeToScreenX; // realign
-						DrawY = (int)(DrawY * FakeToScreenY) / FakeToScreenY;
-						++LineCount;
-						if(pCursor->m_MaxLines > 0 && LineCount > pCursor->m_MaxLines)
-							break;
+					if(m_aGlyphSlots[i] < 0)
 						continue;
-					}
 
-					CFontChar *pChr = GetChar(pFont, pSizeData, Character);
-					if(pChr)
-					{
-						float Advance = pChr->m_AdvanceX + Kerning(pFont, Character, NextCharacter)*Scale;
-						if(pCursor->m_Flags&TEXTFLAG_STOP_AT_END && DrawX+Advance*Size-pCursor->m_StartX > pCursor->m_LineWidth)
-						{
-							// we hit the end of the line, no more to render or count
-							pCurrent = pEnd;
-							break;
-						}
-
-						if(pCursor->m_Flags&TEXTFLAG_RENDER)
-						{
-							Graphics()->QuadsSetSubset(pChr->m_aUvs[0], pChr->m_aUvs[1], pChr->m_aUvs[2], pChr->m_aUvs[3]);
-							IGraphics::CQuadItem QuadItem(DrawX+pChr->m_OffsetX*Size, DrawY+pChr->m_OffsetY*Size, pChr->m_Width*Size, pChr->m_Height*Size);
-							Graphics()->QuadsDrawTL(&QuadItem, 1);
-						}
-
-						DrawX += Advance*Size;
-						pCursor->m_GlyphCount++;
-					}
-				}
-
-				if(NewLine)
-				{
-					DrawX = pCursor->m_StartX;
-					DrawY += Size;
-					GotNewLine = 1;
-					DrawX = (int)(DrawX * FakeToScreenX) / FakeToScreenX; // realign
-					DrawY = (int)(DrawY * FakeToScreenY) / FakeToScreenY;
-					++LineCount;
+					const CTextLayout::CGlyph *pGlyph = &pLayout->m_aGlyphs[i];
+					const CFontChar *pChr = &pSizeData->m_aCharacters[m_aGlyphSlots[i]];
+					Graphics()->QuadsSetSubset(pChr->m_aUvs[0], pChr->m_aUvs[1], pChr->m_aUvs[2], pChr->m_aUvs[3]);
+					IGraphics::CQuadItem QuadItem(CursorX+pGlyph->m_X+pChr->m_OffsetX*Size, CursorY+pGlyph->m_Y+pChr->m_OffsetY*Size, pChr->m_Width*Size, pChr->m_Height*Size);
+					Graphics()->QuadsDrawTL(&QuadItem, 1);
 				}
-			}
 
-			if(pCursor->m_Flags&TEXTFLAG_RENDER)
 				Graphics()->QuadsEnd();
+			}
 		}
 
-		pCursor->m_X = DrawX;
-		pCursor->m_LineCount = LineCount;
-
-		if(GotNewLine)
-			pCursor->m_Y = DrawY;
+		MoveCursor(pCursor, pLayout, CursorX, CursorY, pLayout->m_GotNewLine);
 	}
 
 	float TextGetLineBaseY(const CTextCursor *pCursor)
@@ -982,8 +885,11 @@ public:
 			return 0;
 
 		pSizeData = GetSize(pFont, ActualSize);
-		RenderSetup(pFont, ActualSize);
-		CFontChar *pChr = GetChar(pFont, pSizeData, ' ');
+		m_TouchTime = time_get();
+		int SlotID = GetChar(pFont, pSizeData, ' ');
+		if(SlotID < 0)
+			return CursorY;
+		const CFontChar *pChr = &pSizeData->m_aCharacters[SlotID];
 		return CursorY + pChr->m_OffsetY*Size + pChr->m_Height*Size;
 	}
 
@@ -25,6 +25,15 @@ struct CDemoHeader
 	char m_aTimelineMarkers[MAX_TIMELINE_MARKERS][4];
 };
 
+// round metadata in the index at the end of a demo
+struct CDemoRound
+{
+	int m_StartTick;
+	int m_EndTick;
+	int m_Catches;
+	char m_aWinner[16];
+};
+
 class IDemoPlayer : public IInterface
 {
 	MACRO_INTERFACE("demoplayer", 0)
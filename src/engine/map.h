@@ -12,6 +12,8 @@ class IMap : public IInterface
 public:
 	virtual void *GetData(int Index) = 0;
 	virtual void *GetDataSwapped(int Index) = 0;
+	// loads several data items at once, so that they can be decompressed in parallel
+	virtual void LoadData(const int *pIndices, int Num) = 0;
 	virtual void UnloadData(int Index) = 0;
 	virtual void *GetItem(int Index, int *Type, int *pID) = 0;
 	virtual void GetType(int Type, int *pStart, int *pNum) = 0;
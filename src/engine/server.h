@@ -33,6 +33,7 @@ public:
 	virtual bool ClientIngame(int ClientID) const = 0;
 	virtual int GetClientInfo(int ClientID, CClientInfo *pInfo) const = 0;
 	virtual void GetClientAddr(int ClientID, char *pAddrStr, int Size, bool Port = false) const = 0;
+	virtual bool GetClientAddr(int ClientID, NETADDR *pAddr) const = 0;
 	virtual int GetClientVersion(int ClientID) const = 0;
 
 	virtual int SendMsg(CMsgPacker *pMsg, int Flags, int ClientID) = 0;
@@ -72,6 +73,7 @@ public:
 
 	virtual void DemoRecorder_HandleAutoStart() = 0;
 	virtual bool DemoRecorder_IsRecording() = 0;
+	virtual void DemoRecorder_HandleRoundEnd(int StartTick, const char *pWinner, int Catches) = 0;
 
 	// zCatch keep track of last map change;
 	int m_LastMapChangeTick;
@@ -20,6 +20,7 @@
 #include <engine/shared/demo.h>
 #include <engine/shared/econ.h>
 #include <engine/shared/filecollection.h>
+#include <engine/shared/inputrecord.h>
 #include <engine/shared/mapchecker.h>
 #include <engine/shared/netban.h>
 #include <engine/shared/network.h>
@@ -209,9 +210,8 @@ int CServerBan::BanExt(T *pBanPool, const typename T::CDataType *pData, int Seco
 
 		if(NetMatch(&Data, Server()->m_NetServer.ClientAddr(i)))
 		{
-			CNetHash NetHash(&Data);
 			char aBuf[256];
-			MakeBanInfo(pBanPool->Find(&Data, &NetHash), aBuf, sizeof(aBuf), MSGTYPE_PLAYER);
+			MakeBanInfo(pBanPool->Find(&Data), aBuf, sizeof(aBuf), MSGTYPE_PLAYER);
 			Server()->m_NetServer.Drop(i, aBuf);
 		}
 	}
@@ -288,6 +288,7 @@ CServer::CServer() : m_DemoRecorder(&m_SnapshotDelta)
 
 	m_MapReload = 0;
 	m_LastMapChangeTick = 0;
+	m_aInputRecordFilename[0] = 0;
 	
 	m_RconClientID = IServer::RCON_CID_SERV;
 	m_RconAuthLevel = AUTHED_ADMIN;
@@ -478,6 +479,16 @@ void CServer::GetClientAddr(int ClientID, char *pAddrStr, int Size, bool Port) c
 	}	
 }
 
+bool CServer::GetClientAddr(int ClientID, NETADDR *pAddr) const
+{
+	if(ClientID >= 0 && ClientID < MAX_CLIENTS && m_aClients[ClientID].m_State == CClient::STATE_INGAME)
+	{
+		*pAddr = *m_NetServer.ClientAddr(ClientID);
+		return true;
+	}
+	return false;
+}
+
 int CServer::GetClientVersion(int ClientID) const
 {
 	if(ClientID >= 0 && ClientID < MAX_CLIENTS && m_aClients[ClientID].m_State == CClient::STATE_INGAME)
@@ -584,14 +595,14 @@ int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID)
 	{
 		if(ClientID == -1)
 		{
-			// broadcast
-			int i;
-			for(i = 0; i < MAX_CLIENTS; i++)
+			// broadcast, the connections share the payload
+			int aClientIDs[MAX_CLIENTS];
+			int NumClients = 0;
+			for(int i = 0; i < MAX_CLIENTS; i++)
 				if(m_aClients[i].m_State == CClient::STATE_INGAME && !m_aClients[i].m_Quitting)
-				{
-					Packet.m_ClientID = i;
-					m_NetServer.Send(&Packet);
-				}
+					aClientIDs[NumClients++] = i;
+			if(NumClients)
+				m_NetServer.SendMulticast(&Packet, aClientIDs, NumClients);
 		}
 		else
 			m_NetServer.Send(&Packet);
@@ -601,6 +612,9 @@ int CServer::SendMsg(CMsgPacker *pMsg, int Flags, int ClientID)
 
 void CServer::DoSnapshot()
 {
+	if(m_InputRecorder.IsRecording())
+		m_InputRecorder.RecordSnap();
+
 	GameServer()->OnPreSnap();
 
 	// create snapshot for demo recording
@@ -762,6 +776,8 @@ int CServer::DelClientCallback(int ClientID, const char *pReason, void *pUser)
 	// notify the mod about the drop
 	if(pThis->m_aClients[ClientID].m_State >= CClient::STATE_READY)
 	{
+		if(pThis->m_InputRecorder.IsRecording())
+			pThis->m_InputRecorder.RecordDrop(ClientID, pReason);
 		pThis->m_aClients[ClientID].m_Quitting = true;
 		pThis->GameServer()->OnClientDrop(ClientID, pReason);
 	}
@@ -977,6 +993,8 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 
 				bool ConnectAsSpec = m_aClients[ClientID].m_State == CClient::STATE_CONNECTING_AS_SPEC;
 				m_aClients[ClientID].m_State = CClient::STATE_READY;
+				if(m_InputRecorder.IsRecording())
+					m_InputRecorder.RecordConnect(ClientID, ConnectAsSpec, m_aClients[ClientID].m_Version);
 				GameServer()->OnClientConnected(ClientID, ConnectAsSpec);
 				SendConnectionReady(ClientID);
 			}
@@ -987,6 +1005,8 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 			{
 				m_aClients[ClientID].m_State = CClient::STATE_INGAME;
 				SendServerInfo(ClientID);
+				if(m_InputRecorder.IsRecording())
+					m_InputRecorder.RecordEnter(ClientID);
 				GameServer()->OnClientEnter(ClientID);
 
 				char aAddrStr[NETADDR_MAXSTRSIZE];
@@ -1052,7 +1072,11 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 
 			// call the mod with the fresh input data
 			if(m_aClients[ClientID].m_State == CClient::STATE_INGAME)
+			{
+				if(m_InputRecorder.IsRecording())
+					m_InputRecorder.RecordDirectInput(ClientID, m_aClients[ClientID].m_LatestInput.m_aData);
 				GameServer()->OnClientDirectInput(ClientID, m_aClients[ClientID].m_LatestInput.m_aData);
+			}
 		}
 		else if(Msg == NETMSG_RCON_CMD)
 		{
@@ -1166,7 +1190,11 @@ void CServer::ProcessClientPacket(CNetChunk *pPacket)
 	{
 		// game message
 		if((pPacket->m_Flags&NET_CHUNKFLAG_VITAL) != 0 && m_aClients[ClientID].m_State >= CClient::STATE_READY)
+		{
+			if(m_InputRecorder.IsRecording())
+				m_InputRecorder.RecordMessage(ClientID, pPacket->m_pData, pPacket->m_DataSize);
 			GameServer()->OnMessage(Msg, &Unpacker, ClientID);
+		}
 	}
 }
 
@@ -1451,6 +1479,8 @@ int CServer::Run()
 					for(int c = 0; c < MAX_CLIENTS; c++)
 						aSpecs[c] = GameServer()->IsClientSpectator(c);
 
+					// a recording covers a single map
+					StopInputRecording();
 					GameServer()->OnShutdown();
 
 					for(int c = 0; c < MAX_CLIENTS; c++)
@@ -1473,6 +1503,12 @@ int CServer::Run()
 
 					Kernel()->ReregisterInterface(GameServer());
 					GameServer()->OnInit();
+
+					if(m_aInputRecordFilename[0])
+					{
+						m_InputRecorder.Start(Storage(), m_aInputRecordFilename, GameServer()->NetVersion(), m_aCurrentMap, m_CurrentMapSha256, m_CurrentMapCrc);
+						m_aInputRecordFilename[0] = 0;
+					}
 				}
 				else
 				{
@@ -1492,17 +1528,28 @@ int CServer::Run()
 				{
 					if(m_aClients[c].m_State == CClient::STATE_EMPTY)
 						continue;
+					if(m_InputRecorder.IsRecording())
+						m_InputRecorder.RecordLatency(c, m_aClients[c].m_Latency);
 					for(int i = 0; i < 200; i++)
 					{
 						if(m_aClients[c].m_aInputs[i].m_GameTick == Tick())
 						{
 							if(m_aClients[c].m_State == CClient::STATE_INGAME)
+							{
+								if(m_InputRecorder.IsRecording())
+									m_InputRecorder.RecordInput(c, m_aClients[c].m_aInputs[i].m_aData);
 								GameServer()->OnClientPredictedInput(c, m_aClients[c].m_aInputs[i].m_aData);
+							}
 							break;
 						}
 					}
 				}
 
+				// results of background jobs
+				m_pEngine->JobPool()->RunMainThreadJobs();
+
+				if(m_InputRecorder.IsRecording())
+					m_InputRecorder.RecordTick();
 				GameServer()->OnTick();
 			}
 
@@ -1550,6 +1597,8 @@ int CServer::Run()
 			net_socket_read_wait(m_NetServer.Socket(), 5);
 		}
 	}
+	StopInputRecording();
+
 	// disconnect all clients on shutdown
 	for(int i = 0; i < MAX_CLIENTS; ++i)
 	{
@@ -1674,11 +1723,43 @@ void CServer::DemoRecorder_HandleAutoStart()
 	}
 }
 
+unsigned CServer::GameStateHash()
+{
+	char aData[CSnapshot::MAX_SIZE];
+	m_SnapshotBuilder.Init();
+	GameServer()->OnSnap(-1);
+	m_SnapshotBuilder.Finish(aData);
+	return CInputRecord::StateHash((CSnapshot *)aData);
+}
+
+void CServer::StopInputRecording()
+{
+	if(m_InputRecorder.IsRecording())
+		m_InputRecorder.Stop(GameStateHash());
+}
+
 bool CServer::DemoRecorder_IsRecording()
 {
 	return m_DemoRecorder.IsRecording();
 }
 
+void CServer::DemoRecorder_HandleRoundEnd(int StartTick, const char *pWinner, int Catches)
+{
+	if(!m_DemoRecorder.IsRecording())
+		return;
+
+	CDemoRound Round;
+	Round.m_StartTick = StartTick;
+	Round.m_EndTick = Tick();
+	Round.m_Catches = Catches;
+	str_copy(Round.m_aWinner, pWinner, sizeof(Round.m_aWinner));
+	m_DemoRecorder.AddRound(&Round);
+
+	// cut the auto recorded demo into one segment per round
+	if(g_Config.m_SvAutoDemoRecord && g_Config.m_SvAutoDemoRounds)
+		DemoRecorder_HandleAutoStart();
+}
+
 void CServer::ConRecord(IConsole::IResult *pResult, void *pUser)
 {
 	CServer* pServer = (CServer *)pUser;
@@ -1699,6 +1780,28 @@ void CServer::ConStopRecord(IConsole::IResult *pResult, void *pUser)
 	((CServer *)pUser)->m_DemoRecorder.Stop();
 }
 
+void CServer::ConRecordInputs(IConsole::IResult *pResult, void *pUser)
+{
+	CServer* pServer = (CServer *)pUser;
+	if(pResult->NumArguments())
+		str_format(pServer->m_aInputRecordFilename, sizeof(pServer->m_aInputRecordFilename), "inputs/%s.inputs", pResult->GetString(0));
+	else
+	{
+		char aDate[20];
+		str_timestamp(aDate, sizeof(aDate));
+		str_format(pServer->m_aInputRecordFilename, sizeof(pServer->m_aInputRecordFilename), "inputs/inputs_%s.inputs", aDate);
+	}
+
+	// a replay starts with a fresh game, so the recording does too
+	pServer->m_MapReload = 1;
+	pServer->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "recording inputs after reloading the map");
+}
+
+void CServer::ConStopRecordInputs(IConsole::IResult *pResult, void *pUser)
+{
+	((CServer *)pUser)->StopInputRecording();
+}
+
 void CServer::ConMapReload(IConsole::IResult *pResult, void *pUser)
 {
 	((CServer *)pUser)->m_MapReload = 1;
@@ -1795,6 +1898,7 @@ void CServer::RegisterCommands()
 	m_pConsole = Kernel()->RequestInterface<IConsole>();
 	m_pGameServer = Kernel()->RequestInterface<IGameServer>();
 	m_pMap = Kernel()->RequestInterface<IEngineMap>();
+	m_pEngine = Kernel()->RequestInterface<IEngine>();
 	m_pStorage = Kernel()->RequestInterface<IStorage>();
 
 	// register console commands
@@ -1805,6 +1909,8 @@ void CServer::RegisterCommands()
 
 	Console()->Register("record", "?s", CFGFLAG_SERVER|CFGFLAG_STORE, ConRecord, this, "Record to a file");
 	Console()->Register("stoprecord", "", CFGFLAG_SERVER, ConStopRecord, this, "Stop recording");
+	Console()->Register("record_inputs", "?s", CFGFLAG_SERVER, ConRecordInputs, this, "Reload the map and record all client inputs to a file for replays");
+	Console()->Register("stoprecord_inputs", "", CFGFLAG_SERVER, ConStopRecordInputs, this, "Stop recording inputs");
 
 	Console()->Register("reload", "", CFGFLAG_SERVER, ConMapReload, this, "Reload the map");
 
@@ -1959,6 +2065,7 @@ int main(int argc, const char **argv) // ignore_convention
 	pConfig->RestoreStrings();
 
 	pEngine->InitLogfile();
+	pEngine->InitJobPool();
 
 	pServer->InitRconPasswordIfUnset();
 
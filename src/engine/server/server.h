@@ -165,6 +165,7 @@ public:
 	CServerBan m_ServerBan;
 
 	IEngineMap *m_pMap;
+	class IEngine *m_pEngine;
 
 	int64 m_GameStartTime;
 	int m_RunServer;
@@ -210,6 +211,8 @@ public:
 	int m_GeneratedRconPassword;
 
 	CDemoRecorder m_DemoRecorder;
+	CInputRecorder m_InputRecorder;
+	char m_aInputRecordFilename[128];
 	CRegister m_Register;
 	CMapChecker m_MapChecker;
 
@@ -226,6 +229,10 @@ public:
 
 	void DemoRecorder_HandleAutoStart();
 	bool DemoRecorder_IsRecording();
+	void DemoRecorder_HandleRoundEnd(int StartTick, const char *pWinner, int Catches);
+
+	unsigned GameStateHash();
+	void StopInputRecording();
 
 	int64 TickStartTime(int Tick);
 
@@ -238,6 +245,7 @@ public:
 	bool IsBanned(int ClientID);
 	int GetClientInfo(int ClientID, CClientInfo *pInfo) const;
 	void GetClientAddr(int ClientID, char *pAddrStr, int Size, bool Port) const;
+	bool GetClientAddr(int ClientID, NETADDR *pAddr) const;
 	int GetClientVersion(int ClientID) const;
 	const char *ClientName(int ClientID) const;
 	const char *ClientClan(int ClientID) const;
@@ -284,6 +292,8 @@ public:
 	static void ConShutdown(IConsole::IResult *pResult, void *pUser);
 	static void ConRecord(IConsole::IResult *pResult, void *pUser);
 	static void ConStopRecord(IConsole::IResult *pResult, void *pUser);
+	static void ConRecordInputs(IConsole::IResult *pResult, void *pUser);
+	static void ConStopRecordInputs(IConsole::IResult *pResult, void *pUser);
 	static void ConMapReload(IConsole::IResult *pResult, void *pUser);
 	static void ConSaveConfig(IConsole::IResult *pResult, void *pUser);
 	static void ConLogout(IConsole::IResult *pResult, void *pUser);
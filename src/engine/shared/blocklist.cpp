@@ -0,0 +1,197 @@
+#include <engine/console.h>
+#include <engine/storage.h>
+
+#include "blocklist.h"
+#include "netban.h"
+
+#include <algorithm>
+#include <vector>
+
+static const char s_aBlocklistID[4] = {'T', 'W', 'B', 'L'};
+
+static int ReadInt(const unsigned char *pData)
+{
+	return (pData[0]<<24)|(pData[1]<<16)|(pData[2]<<8)|pData[3];
+}
+
+static void WriteInt(unsigned char *pData, int Value)
+{
+	pData[0] = (Value>>24)&0xff;
+	pData[1] = (Value>>16)&0xff;
+	pData[2] = (Value>>8)&0xff;
+	pData[3] = Value&0xff;
+}
+
+// ranges have to be sorted and must neither be empty nor overlap
+static bool CheckRanges(const unsigned char *pRanges, int NumRanges, int AddrSize)
+{
+	for(int i = 0; i < NumRanges; i++)
+	{
+		const unsigned char *pRange = pRanges+i*2*AddrSize;
+		if(mem_comp(pRange, pRange+AddrSize, AddrSize) > 0)
+			return false;
+		if(i > 0 && mem_comp(pRange-AddrSize, pRange, AddrSize) >= 0)
+			return false;
+	}
+	return true;
+}
+
+CBlocklist::CBlocklist()
+{
+	m_pData = 0;
+	m_DataSize = 0;
+	m_pRangesIPv4 = 0;
+	m_pRangesIPv6 = 0;
+	m_NumRangesIPv4 = 0;
+	m_NumRangesIPv6 = 0;
+}
+
+CBlocklist::~CBlocklist()
+{
+	Close();
+}
+
+bool CBlocklist::Open(IStorage *pStorage, const char *pFilename, char *pError, int ErrorSize)
+{
+	Close();
+
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
+	{
+		str_copy(pError, "could not open file", ErrorSize);
+		return false;
+	}
+	unsigned Size;
+	const void *pData = io_map(File, &Size);
+	io_close(File);
+	if(!pData)
+	{
+		str_copy(pError, "could not map file", ErrorSize);
+		return false;
+	}
+
+	const CHeader *pHeader = static_cast<const CHeader *>(pData);
+	const unsigned char *pRanges = static_cast<const unsigned char *>(pData)+sizeof(CHeader);
+	int NumRangesIPv4 = Size >= sizeof(CHeader) ? ReadInt(pHeader->m_aNumRangesIPv4) : -1;
+	int NumRangesIPv6 = Size >= sizeof(CHeader) ? ReadInt(pHeader->m_aNumRangesIPv6) : -1;
+	if(Size < sizeof(CHeader) || mem_comp(pHeader->m_aID, s_aBlocklistID, sizeof(s_aBlocklistID)) != 0)
+		str_copy(pError, "not a blocklist file", ErrorSize);
+	else if(ReadInt(pHeader->m_aVersion) != VERSION)
+		str_copy(pError, "unsupported version", ErrorSize);
+	else if(NumRangesIPv4 < 0 || NumRangesIPv6 < 0 || NumRangesIPv4 > (1<<26) || NumRangesIPv6 > (1<<24) ||
+		Size != sizeof(CHeader)+NumRangesIPv4*8u+NumRangesIPv6*32u)
+		str_copy(pError, "invalid size", ErrorSize);
+	else if(!CheckRanges(pRanges, NumRangesIPv4, 4) || !CheckRanges(pRanges+NumRangesIPv4*8, NumRangesIPv6, 16))
+		str_copy(pError, "ranges are not sorted", ErrorSize);
+	else
+	{
+		m_pData = pData;
+		m_DataSize = Size;
+		m_pRangesIPv4 = pRanges;
+		m_pRangesIPv6 = pRanges+NumRangesIPv4*8;
+		m_NumRangesIPv4 = NumRangesIPv4;
+		m_NumRangesIPv6 = NumRangesIPv6;
+		return true;
+	}
+
+	io_unmap(pData, Size);
+	return false;
+}
+
+void CBlocklist::Close()
+{
+	io_unmap(m_pData, m_DataSize);
+	m_pData = 0;
+	m_DataSize = 0;
+	m_pRangesIPv4 = 0;
+	m_pRangesIPv6 = 0;
+	m_NumRangesIPv4 = 0;
+	m_NumRangesIPv6 = 0;
+}
+
+bool CBlocklist::Contains(const NETADDR *pAddr) const
+{
+	const unsigned char *pRanges;
+	int NumRanges, AddrSize;
+	if(pAddr->type == NETTYPE_IPV4)
+	{
+		pRanges = m_pRangesIPv4;
+		NumRanges = m_NumRangesIPv4;
+		AddrSize = 4;
+	}
+	else if(pAddr->type == NETTYPE_IPV6)
+	{
+		pRanges = m_pRangesIPv6;
+		NumRanges = m_NumRangesIPv6;
+		AddrSize = 16;
+	}
+	else
+		return false;
+
+	// find the last range that starts at or before the address
+	int Low = 0, High = NumRanges;
+	while(Low < High)
+	{
+		int Mid = (Low+High)/2;
+		if(mem_comp(pRanges+Mid*2*AddrSize, pAddr->ip, AddrSize) <= 0)
+			Low = Mid+1;
+		else
+			High = Mid;
+	}
+	return Low > 0 && mem_comp(pAddr->ip, pRanges+(Low-1)*2*AddrSize+AddrSize, AddrSize) <= 0;
+}
+
+bool CBlocklist::Write(IOHANDLE File, CNetRange *pRanges, int NumRanges)
+{
+	std::vector<unsigned char> aData[2];
+	int aNumRanges[2] = { 0, 0 };
+	for(int Type = 0; Type < 2; Type++)
+	{
+		unsigned NetType = Type == 0 ? NETTYPE_IPV4 : NETTYPE_IPV6;
+		int AddrSize = Type == 0 ? 4 : 16;
+		std::vector<CNetRange> Ranges;
+		for(int i = 0; i < NumRanges; i++)
+		{
+			if(pRanges[i].m_LB.type == NetType && pRanges[i].m_UB.type == NetType && mem_comp(pRanges[i].m_LB.ip, pRanges[i].m_UB.ip, AddrSize) <= 0)
+				Ranges.push_back(pRanges[i]);
+		}
+		std::sort(Ranges.begin(), Ranges.end(), [AddrSize](const CNetRange &a, const CNetRange &b) { return mem_comp(a.m_LB.ip, b.m_LB.ip, AddrSize) < 0; });
+
+		// merge overlapping and adjacent ranges
+		for(unsigned i = 0; i < Ranges.size(); )
+		{
+			CNetRange Merged = Ranges[i++];
+			while(i < Ranges.size())
+			{
+				// the address right after the range, wraps to zero at the end of the address space
+				unsigned char aNext[16];
+				mem_copy(aNext, Merged.m_UB.ip, AddrSize);
+				bool End = true;
+				for(int b = AddrSize-1; b >= 0 && End; b--)
+					End = ++aNext[b] == 0;
+				if(!End && mem_comp(Ranges[i].m_LB.ip, aNext, AddrSize) > 0)
+					break;
+				if(mem_comp(Ranges[i].m_UB.ip, Merged.m_UB.ip, AddrSize) > 0)
+					Merged.m_UB = Ranges[i].m_UB;
+				i++;
+			}
+			aData[Type].insert(aData[Type].end(), Merged.m_LB.ip, Merged.m_LB.ip+AddrSize);
+			aData[Type].insert(aData[Type].end(), Merged.m_UB.ip, Merged.m_UB.ip+AddrSize);
+			aNumRanges[Type]++;
+		}
+	}
+
+	CHeader Header;
+	mem_copy(Header.m_aID, s_aBlocklistID, sizeof(Header.m_aID));
+	WriteInt(Header.m_aVersion, VERSION);
+	WriteInt(Header.m_aNumRangesIPv4, aNumRanges[0]);
+	WriteInt(Header.m_aNumRangesIPv6, aNumRanges[1]);
+
+	bool Success = io_write(File, &Header, sizeof(Header)) == sizeof(Header);
+	for(int Type = 0; Type < 2; Type++)
+	{
+		if(!aData[Type].empty())
+			Success &= io_write(File, &aData[Type][0], aData[Type].size()) == (unsigned)aData[Type].size();
+	}
+	return Success;
+}
@@ -0,0 +1,52 @@
+#ifndef ENGINE_SHARED_BLOCKLIST_H
+#define ENGINE_SHARED_BLOCKLIST_H
+
+#include <base/system.h>
+
+/*
+	Class: Blocklist
+		Read-only table of banned address ranges, compiled offline by
+		the blocklist_compile tool. The file is mapped into memory as
+		is: a header followed by the IPv4 and then the IPv6 ranges,
+		each list sorted and free of overlaps, so that a lookup is a
+		binary search over the mapped data.
+*/
+class CBlocklist
+{
+public:
+	enum
+	{
+		VERSION=1,
+	};
+
+	struct CHeader
+	{
+		char m_aID[4];
+		unsigned char m_aVersion[4];
+		unsigned char m_aNumRangesIPv4[4];
+		unsigned char m_aNumRangesIPv6[4];
+	};
+
+	CBlocklist();
+	~CBlocklist();
+
+	bool Open(class IStorage *pStorage, const char *pFilename, char *pError, int ErrorSize);
+	void Close();
+
+	bool IsOpen() const { return m_pData != 0; }
+	int NumRanges() const { return m_NumRangesIPv4+m_NumRangesIPv6; }
+	bool Contains(const NETADDR *pAddr) const;
+
+	// sorts and merges the ranges and writes them in the blocklist format
+	static bool Write(IOHANDLE File, class CNetRange *pRanges, int NumRanges);
+
+private:
+	const void *m_pData;
+	unsigned m_DataSize;
+	const unsigned char *m_pRangesIPv4;
+	const unsigned char *m_pRangesIPv6;
+	int m_NumRangesIPv4;
+	int m_NumRangesIPv6;
+};
+
+#endif
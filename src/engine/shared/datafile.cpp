@@ -5,8 +5,12 @@
 #include <base/system.h>
 #include <engine/storage.h>
 #include "datafile.h"
+#include "jobs.h"
 #include <zlib.h>
 
+#include <algorithm>
+#include <vector>
+
 static const int DEBUG=0;
 
 struct CDatafileItemType
@@ -251,6 +255,16 @@ int CDataFileReader::GetDataSize(int Index) const
 	return m_pDataFile->m_Info.m_pDataOffsets[Index+1]-m_pDataFile->m_Info.m_pDataOffsets[Index];
 }
 
+int CDataFileReader::GetUncompressedDataSize(int Index) const
+{
+	if(!m_pDataFile || Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData) { return 0; }
+
+	// only v4 has compressed data
+	if(m_pDataFile->m_Header.m_Version == 4)
+		return m_pDataFile->m_Info.m_pDataSizes[Index];
+	return GetDataSize(Index);
+}
+
 void *CDataFileReader::GetDataImpl(int Index, int Swap)
 {
 	if(!m_pDataFile) { return 0; }
@@ -281,9 +295,11 @@ void *CDataFileReader::GetDataImpl(int Index, int Swap)
 			io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset+m_pDataFile->m_Info.m_pDataOffsets[Index], IOSEEK_START);
 			io_read(m_pDataFile->m_File, pTemp, DataSize);
 
-			// decompress the data, TODO: check for errors
+			// decompress the data
 			s = UncompressedSize;
-			uncompress((Bytef*)m_pDataFile->m_ppDataPtrs[Index], &s, (Bytef*)pTemp, DataSize); // ignore_convention
+			int Result = uncompress((Bytef*)m_pDataFile->m_ppDataPtrs[Index], &s, (Bytef*)pTemp, DataSize); // ignore_convention
+			if(Result != Z_OK)
+				dbg_msg("datafile", "decompression error %d index=%d", Result, Index);
 #if defined(CONF_ARCH_ENDIAN_BIG)
 			SwapSize = s;
 #endif
@@ -319,6 +335,114 @@ void *CDataFileReader::GetDataSwapped(int Index)
 	return GetDataImpl(Index, 1);
 }
 
+struct CDataLoad
+{
+	int m_Index;
+	int m_Offset;
+	int m_DataSize;
+	unsigned long m_UncompressedSize;
+	void *m_pCompressed;
+	char *m_pData;
+	int m_Result;
+};
+
+static void DecompressData(CDataLoad *pLoad)
+{
+	unsigned long s = pLoad->m_UncompressedSize;
+	pLoad->m_Result = uncompress((Bytef*)pLoad->m_pData, &s, (Bytef*)pLoad->m_pCompressed, pLoad->m_DataSize); // ignore_convention
+}
+
+static bool CompareDataOffset(const CDataLoad &a, const CDataLoad &b)
+{
+	return a.m_Offset < b.m_Offset;
+}
+
+void CDataFileReader::LoadData(const int *pIndices, int Num, CJobPool *pPool)
+{
+	if(!m_pDataFile)
+		return;
+
+	// uncompressed data is just read
+	if(m_pDataFile->m_Header.m_Version != 4)
+	{
+		for(int i = 0; i < Num; i++)
+			GetDataImpl(pIndices[i], 0);
+		return;
+	}
+
+	std::vector<CDataLoad> aLoads;
+	aLoads.reserve(Num);
+	for(int i = 0; i < Num; i++)
+	{
+		int Index = pIndices[i];
+		if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData || m_pDataFile->m_ppDataPtrs[Index])
+			continue;
+
+		// the same index twice would leak
+		bool Duplicate = false;
+		for(unsigned k = 0; k < aLoads.size() && !Duplicate; k++)
+			Duplicate = aLoads[k].m_Index == Index;
+		if(Duplicate)
+			continue;
+
+		CDataLoad Load;
+		Load.m_Index = Index;
+		Load.m_Offset = m_pDataFile->m_Info.m_pDataOffsets[Index];
+		Load.m_DataSize = GetDataSize(Index);
+		Load.m_UncompressedSize = m_pDataFile->m_Info.m_pDataSizes[Index];
+		Load.m_Result = Z_OK;
+		aLoads.push_back(Load);
+	}
+	if(aLoads.empty())
+		return;
+
+	// read the compressed data in file order, only the decompression runs in parallel
+	std::sort(aLoads.begin(), aLoads.end(), CompareDataOffset);
+	for(unsigned i = 0; i < aLoads.size(); i++)
+	{
+		CDataLoad *pLoad = &aLoads[i];
+		pLoad->m_pCompressed = mem_alloc(pLoad->m_DataSize, 1);
+		pLoad->m_pData = (char *)mem_alloc(pLoad->m_UncompressedSize, 1);
+		io_seek(m_pDataFile->m_File, m_pDataFile->m_DataStartOffset+pLoad->m_Offset, IOSEEK_START);
+		io_read(m_pDataFile->m_File, pLoad->m_pCompressed, pLoad->m_DataSize);
+	}
+
+	if(DEBUG)
+		dbg_msg("datafile", "loading %d data items", (int)aLoads.size());
+	bool Parallel = pPool && pPool->NumThreads() > 0 && aLoads.size() > 1;
+	std::vector<CJobPool::CFuture<void> > aJobs(aLoads.size());
+	if(Parallel)
+	{
+		for(unsigned i = 0; i < aLoads.size(); i++)
+		{
+			CDataLoad *pLoad = &aLoads[i];
+			aJobs[i] = pPool->Submit([pLoad]() { DecompressData(pLoad); }, CJob::PRIORITY_HIGH);
+		}
+	}
+
+	// help out from the back, doing every job that the pool didn't start yet
+	for(int i = aLoads.size()-1; i >= 0; i--)
+	{
+		if(!Parallel || aJobs[i].Cancel())
+			DecompressData(&aLoads[i]);
+	}
+	// then block on the ones that are running
+	for(unsigned i = 0; i < aJobs.size(); i++)
+	{
+		if(aJobs[i].Valid() && !aJobs[i].Cancelled())
+			aJobs[i].Get();
+	}
+
+	for(unsigned i = 0; i < aLoads.size(); i++)
+	{
+		CDataLoad *pLoad = &aLoads[i];
+		if(pLoad->m_Result != Z_OK)
+			dbg_msg("datafile", "decompression error %d index=%d", pLoad->m_Result, pLoad->m_Index);
+		mem_free(pLoad->m_pCompressed);
+		m_pDataFile->m_ppDataPtrs[pLoad->m_Index] = pLoad->m_pData;
+	}
+}
+
 void CDataFileReader::ReplaceData(int Index, char *pData)
 {
 	if(Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData)
@@ -343,9 +467,10 @@ void CDataFileReader::UnloadData(int Index)
 int CDataFileReader::GetItemSize(int Index) const
 {
 	if(!m_pDataFile) { return 0; }
+	// the offsets include the item header
 	if(Index == m_pDataFile->m_Header.m_NumItems-1)
-		return m_pDataFile->m_Header.m_ItemSize-m_pDataFile->m_Info.m_pItemOffsets[Index];
-	return m_pDataFile->m_Info.m_pItemOffsets[Index+1]-m_pDataFile->m_Info.m_pItemOffsets[Index];
+		return m_pDataFile->m_Header.m_ItemSize-m_pDataFile->m_Info.m_pItemOffsets[Index]-sizeof(CDatafileItem);
+	return m_pDataFile->m_Info.m_pItemOffsets[Index+1]-m_pDataFile->m_Info.m_pItemOffsets[Index]-sizeof(CDatafileItem);
 }
 
 void *CDataFileReader::GetItem(int Index, int *pType, int *pID)
@@ -462,6 +587,8 @@ bool CDataFileReader::CheckSha256(IOHANDLE Handle, const void *pSha256)
 CDataFileWriter::CDataFileWriter()
 {
 	m_File = 0;
+	m_Compression = COMPRESSION_DEFAULT;
+	m_pPool = 0;
 	m_pItemTypes = static_cast<CItemTypeInfo *>(mem_alloc(sizeof(CItemTypeInfo) * MAX_ITEM_TYPES, 1));
 	m_pItems = static_cast<CItemInfo *>(mem_alloc(sizeof(CItemInfo) * MAX_ITEMS, 1));
 	m_pDatas = static_cast<CDataInfo *>(mem_alloc(sizeof(CDataInfo) * MAX_DATAS, 1));
@@ -469,6 +596,10 @@ CDataFileWriter::CDataFileWriter()
 
 CDataFileWriter::~CDataFileWriter()
 {
+	// the pool must not write into freed data
+	if(m_File)
+		WaitForData();
+
 	mem_free(m_pItemTypes);
 	m_pItemTypes = 0;
 	mem_free(m_pItems);
@@ -477,13 +608,15 @@ CDataFileWriter::~CDataFileWriter()
 	m_pDatas = 0;
 }
 
-bool CDataFileWriter::Open(class IStorage *pStorage, const char *pFilename)
+bool CDataFileWriter::Open(class IStorage *pStorage, const char *pFilename, int Compression, CJobPool *pPool)
 {
 	dbg_assert(!m_File, "a file already exists");
 	m_File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
 	if(!m_File)
 		return false;
 
+	m_Compression = Compression;
+	m_pPool = pPool && pPool->NumThreads() > 0 ? pPool : 0;
 	m_NumItems = 0;
 	m_NumDatas = 0;
 	m_NumItemTypes = 0;
@@ -534,28 +667,76 @@ int CDataFileWriter::AddItem(int Type, int ID, int Size, void *pData)
 	return m_NumItems-1;
 }
 
-int CDataFileWriter::AddData(int Size, void *pData)
+void CDataFileWriter::CompressData(CDataInfo *pInfo)
 {
-	if(!m_File) return 0;
-
-	dbg_assert(m_NumDatas < 1024, "too much data");
-
-	CDataInfo *pInfo = &m_pDatas[m_NumDatas];
-	unsigned long s = compressBound(Size);
+	const void *pData = pInfo->m_pUncompressedData;
+	unsigned long s = compressBound(pInfo->m_UncompressedSize);
 	void *pCompData = mem_alloc(s, 1); // temporary buffer that we use during compression
 
-	int Result = compress((Bytef*)pCompData, &s, (Bytef*)pData, Size); // ignore_convention
+	int Result = compress2((Bytef*)pCompData, &s, (Bytef*)pData, pInfo->m_UncompressedSize, pInfo->m_Level); // ignore_convention
 	if(Result != Z_OK)
 	{
 		dbg_msg("datafile", "compression error %d", Result);
 		dbg_assert(0, "zlib error");
 	}
 
-	pInfo->m_UncompressedSize = Size;
 	pInfo->m_CompressedSize = (int)s;
 	pInfo->m_pCompressedData = mem_alloc(pInfo->m_CompressedSize, 1);
 	mem_copy(pInfo->m_pCompressedData, pCompData, pInfo->m_CompressedSize);
 	mem_free(pCompData);
+}
+
+void CDataFileWriter::WaitForData()
+{
+	// help out from the back, doing every job that the pool didn't start yet
+	for(int i = m_aJobs.size()-1; i >= 0; i--)
+	{
+		if(m_aJobs[i].Valid() && m_aJobs[i].Cancel())
+			CompressData(&m_pDatas[i]);
+	}
+	// then block on the ones that are running
+	for(unsigned i = 0; i < m_aJobs.size(); i++)
+	{
+		if(!m_aJobs[i].Valid())
+			continue;
+		if(!m_aJobs[i].Cancelled())
+			m_aJobs[i].Get();
+		mem_free(m_pDatas[i].m_pUncompressedData);
+		m_pDatas[i].m_pUncompressedData = 0;
+	}
+	m_aJobs.clear();
+}
+
+int CDataFileWriter::AddData(int Size, void *pData)
+{
+	if(!m_File) return 0;
+
+	dbg_assert(m_NumDatas < 1024, "too much data");
+
+	CDataInfo *pInfo = &m_pDatas[m_NumDatas];
+	pInfo->m_UncompressedSize = Size;
+	pInfo->m_CompressedSize = 0;
+	pInfo->m_pCompressedData = 0;
+	pInfo->m_Level = Z_DEFAULT_COMPRESSION;
+	if(m_Compression == COMPRESSION_FAST)
+		pInfo->m_Level = Z_BEST_SPEED;
+	else if(m_Compression == COMPRESSION_NONE)
+		pInfo->m_Level = Z_NO_COMPRESSION;
+	m_aJobs.resize(m_NumDatas+1);
+
+	// every data is compressed on its own, so the order the jobs finish in doesn't matter
+	if(m_pPool)
+	{
+		pInfo->m_pUncompressedData = mem_alloc(Size, 1);
+		mem_copy(pInfo->m_pUncompressedData, pData, Size);
+		m_aJobs[m_NumDatas] = m_pPool->Submit([pInfo]() { CompressData(pInfo); });
+	}
+	else
+	{
+		pInfo->m_pUncompressedData = pData;
+		CompressData(pInfo);
+		pInfo->m_pUncompressedData = 0;
+	}
 
 	m_NumDatas++;
 	return m_NumDatas-1;
@@ -582,6 +763,8 @@ int CDataFileWriter::Finish()
 {
 	if(!m_File) return 1;
 
+	WaitForData();
+
 	int ItemSize = 0;
 	int TypesSize, HeaderSize, OffsetSize, FileSize, SwapSize;
 	int DataSize = 0;
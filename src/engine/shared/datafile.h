@@ -5,6 +5,10 @@
 
 #include <base/hash.h>
 
+#include "jobs.h"
+
+#include <vector>
+
 // raw datafile access
 class CDataFileReader
 {
@@ -21,7 +25,10 @@ public:
 
 	void *GetData(int Index);
 	void *GetDataSwapped(int Index); // makes sure that the data is 32bit LE ints when saved
-	int GetDataSize(int Index) const;
+	// loads the given data up front, decompressing it on the pool's threads if there is one
+	void LoadData(const int *pIndices, int Num, class CJobPool *pPool);
+	int GetDataSize(int Index) const; // the size in the file, compressed for v4
+	int GetUncompressedDataSize(int Index) const;
 	void ReplaceData(int Index, char *pData);
 	void UnloadData(int Index);
 	void *GetItem(int Index, int *pType, int *pID);
@@ -46,6 +53,9 @@ class CDataFileWriter
 		int m_UncompressedSize;
 		int m_CompressedSize;
 		void *m_pCompressedData;
+		int m_Level;
+		// only set while the data is compressed on the pool
+		void *m_pUncompressedData;
 	};
 
 	struct CItemInfo
@@ -73,17 +83,35 @@ class CDataFileWriter
 	};
 
 	IOHANDLE m_File;
+	int m_Compression;
+	class CJobPool *m_pPool;
 	int m_NumItems;
 	int m_NumDatas;
 	int m_NumItemTypes;
 	CItemTypeInfo *m_pItemTypes;
 	CItemInfo *m_pItems;
 	CDataInfo *m_pDatas;
+	// the compression of each data on the pool, invalid if it was compressed right away
+	std::vector<CJobPool::CFuture<void> > m_aJobs;
+
+	static void CompressData(CDataInfo *pInfo);
+	void WaitForData();
 
 public:
+	enum
+	{
+		COMPRESSION_DEFAULT=0,
+		// quicker to write, about as quick to load
+		COMPRESSION_FAST,
+		// stored zlib blocks, much quicker to load but as large as the data
+		COMPRESSION_NONE,
+	};
+
 	CDataFileWriter();
 	~CDataFileWriter();
-	bool Open(class IStorage *pStorage, const char *Filename);
+	// every compression can be read by any reader, also older ones. with a
+	// pool the data is compressed on its threads, the file stays the same
+	bool Open(class IStorage *pStorage, const char *Filename, int Compression = COMPRESSION_DEFAULT, class CJobPool *pPool = 0);
 	int AddData(int Size, void *pData);
 	int AddDataSwapped(int Size, void *pData);
 	int AddItem(int Type, int ID, int Size, void *pData);
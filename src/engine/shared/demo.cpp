@@ -7,6 +7,7 @@
 #include <engine/storage.h>
 
 #include "compression.h"
+#include "config.h"
 #include "datafile.h"
 #include "demo.h"
 #include "memheap.h"
@@ -18,11 +19,22 @@ static const unsigned char gs_ActVersion = 4;
 static const int gs_LengthOffset = 152;
 static const int gs_NumMarkersOffset = 176;
 
+// the index is stored in chunks of a type older players skip
+static const int gs_IndexMagic = 0x54574449; // "TWDI"
+static const int gs_IndexLocatorMagic = 0x5457444c; // "TWDL"
+static const int gs_IndexVersion = 1;
+static const int gs_MaxIndexKeyFrames = 4096;
+
 
 CDemoRecorder::CDemoRecorder(class CSnapshotDelta *pSnapshotDelta)
 {
 	m_File = 0;
 	m_LastTickMarker = -1;
+	m_pQueue = 0;
+	m_QueueSize = 0;
+	m_pWriterThread = 0;
+	m_pKeyFrames = 0;
+	m_KeyFramesCapacity = 0;
 	m_pSnapshotDelta = pSnapshotDelta;
 }
 
@@ -116,14 +128,30 @@ int CDemoRecorder::Start(class IStorage *pStorage, class IConsole *pConsole, con
 
 	m_LastKeyFrame = -1;
 	m_LastTickMarker = -1;
+	m_LastWrittenTickMarker = -1;
 	m_FirstTick = -1;
 	m_NumTimelineMarkers = 0;
+	m_NumRounds = 0;
+	m_NumKeyFrames = 0;
+	m_NumWriteErrors = 0;
 
 	char aBuf[256];
 	str_format(aBuf, sizeof(aBuf), "Recording to '%s'", pFilename);
 	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", aBuf);
 	m_File = DemoFile;
 
+	// encoding and writing happens on the writer thread
+	m_QueueSize = g_Config.m_DemoQueueSize;
+	if(m_QueueSize > 0)
+	{
+		m_pQueue = (CQueueEntry *)mem_alloc(m_QueueSize*sizeof(CQueueEntry), sizeof(void*));
+		mem_zero(m_pQueue, m_QueueSize*sizeof(CQueueEntry));
+		m_QueueRead = 0;
+		m_QueueWrite = 0;
+		m_StopWriter = false;
+		m_pWriterThread = thread_init(WriterThread, this);
+	}
+
 	return 0;
 }
 
@@ -148,6 +176,7 @@ enum
 	CHUNKMASK_TYPE = 0x60,
 	CHUNKMASK_SIZE = 0x1f,
 
+	CHUNKTYPE_INDEX = 0,
 	CHUNKTYPE_SNAPSHOT = 1,
 	CHUNKTYPE_MESSAGE = 2,
 	CHUNKTYPE_DELTA = 3,
@@ -157,7 +186,7 @@ enum
 
 void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 {
-	if(m_LastTickMarker == -1 || Tick-m_LastTickMarker > 63 || Keyframe)
+	if(m_LastWrittenTickMarker == -1 || Tick-m_LastWrittenTickMarker > 63 || Keyframe)
 	{
 		unsigned char aChunk[5];
 		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER;
@@ -174,39 +203,29 @@ void CDemoRecorder::WriteTickMarker(int Tick, int Keyframe)
 	else
 	{
 		unsigned char aChunk[1];
-		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | (Tick-m_LastTickMarker);
+		aChunk[0] = CHUNKTYPEFLAG_TICKMARKER | (Tick-m_LastWrittenTickMarker);
 		io_write(m_File, aChunk, sizeof(aChunk));
 	}
 
-	m_LastTickMarker = Tick;
-	if(m_FirstTick < 0)
-		m_FirstTick = Tick;
+	m_LastWrittenTickMarker = Tick;
 }
 
 void CDemoRecorder::Write(int Type, const void *pData, int Size)
 {
-	char aBuffer[64*1024];
-	char aBuffer2[64*1024];
 	unsigned char aChunk[3];
 
-	if(!m_File)
-		return;
-
 	/* pad the data with 0 so we get an alignment of 4,
 	else the compression won't work and miss some bytes */
-	mem_copy(aBuffer2, pData, Size);
+	mem_copy(m_aBuffer2, pData, Size);
 	while(Size&3)
-		aBuffer2[Size++] = 0;
-	Size = CVariableInt::Compress(aBuffer2, Size, aBuffer, sizeof(aBuffer)); // buffer2 -> buffer
+		m_aBuffer2[Size++] = 0;
+	Size = CVariableInt::Compress(m_aBuffer2, Size, m_aBuffer, sizeof(m_aBuffer)); // buffer2 -> buffer
+	if(Size >= 0)
+		Size = CNetBase::Compress(m_aBuffer, Size, m_aBuffer2, sizeof(m_aBuffer2)); // buffer -> buffer2
 	if(Size < 0)
 	{
-		m_pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "demo_recorder", "error during intpack compression");
-		return;
-	}
-	Size = CNetBase::Compress(aBuffer, Size, aBuffer2, sizeof(aBuffer2)); // buffer -> buffer2
-	if(Size < 0)
-	{
-		m_pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "demo_recorder", "error during network compression");
+		// the console belongs to the main thread, this is reported on stop
+		m_NumWriteErrors++;
 		return;
 	}
 
@@ -233,21 +252,36 @@ void CDemoRecorder::Write(int Type, const void *pData, int Size)
 		}
 	}
 
-	io_write(m_File, aBuffer2, Size);
+	io_write(m_File, m_aBuffer2, Size);
 }
 
-void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
+void CDemoRecorder::WriteSnapshot(int Tick, const void *pData, int Size)
 {
-	char aTmpData[CSnapshot::MAX_SIZE];
-
 	if(m_LastKeyFrame == -1 || (Tick-m_LastKeyFrame) > SERVER_TICK_SPEED*5)
 	{
+		// remember the position for the index
+		if(m_NumKeyFrames < gs_MaxIndexKeyFrames)
+		{
+			if(m_NumKeyFrames == m_KeyFramesCapacity)
+			{
+				m_KeyFramesCapacity = m_KeyFramesCapacity ? m_KeyFramesCapacity*2 : 64;
+				CIndexKeyFrame *pKeyFrames = (CIndexKeyFrame *)mem_alloc(m_KeyFramesCapacity*sizeof(CIndexKeyFrame), 1);
+				if(m_pKeyFrames)
+					mem_copy(pKeyFrames, m_pKeyFrames, m_NumKeyFrames*sizeof(CIndexKeyFrame));
+				mem_free(m_pKeyFrames);
+				m_pKeyFrames = pKeyFrames;
+			}
+			m_pKeyFrames[m_NumKeyFrames].m_Tick = Tick;
+			m_pKeyFrames[m_NumKeyFrames].m_Filepos = io_tell(m_File);
+		}
+		m_NumKeyFrames++;
+
 		// write full tickmarker
 		WriteTickMarker(Tick, 1);
 
 		// write snapshot
-		int SnapSize = ((CSnapshot*)pData)->Serialize(aTmpData);
-		Write(CHUNKTYPE_SNAPSHOT, aTmpData, SnapSize);
+		int SnapSize = ((CSnapshot*)pData)->Serialize(m_aTmpData);
+		Write(CHUNKTYPE_SNAPSHOT, m_aTmpData, SnapSize);
 
 		m_LastKeyFrame = Tick;
 		mem_copy(m_aLastSnapshotData, pData, Size);
@@ -257,20 +291,148 @@ void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
 		// write tickmarker
 		WriteTickMarker(Tick, 0);
 
-		// create delta
-		int DeltaSize = m_pSnapshotDelta->CreateDelta((CSnapshot*)m_aLastSnapshotData, (CSnapshot*)pData, &aTmpData);
+		// create delta, this only reads the static item sizes of the shared delta object
+		int DeltaSize = m_pSnapshotDelta->CreateDelta((CSnapshot*)m_aLastSnapshotData, (CSnapshot*)pData, &m_aTmpData);
 		if(DeltaSize)
 		{
 			// record delta
-			Write(CHUNKTYPE_DELTA, aTmpData, DeltaSize);
+			Write(CHUNKTYPE_DELTA, m_aTmpData, DeltaSize);
 			mem_copy(m_aLastSnapshotData, pData, Size);
 		}
 	}
 }
 
+/*
+	Index
+		The index chunk holds the first and last tick, the position of
+		every keyframe and the rounds. It is followed by a small locator
+		chunk that holds the position of the index, so players can find
+		it by looking at the last bytes of the file.
+*/
+void CDemoRecorder::WriteIndex()
+{
+	if(m_NumKeyFrames > gs_MaxIndexKeyFrames)
+		return;
+
+	int *pData = (int *)m_aTmpData;
+	int Num = 0;
+	pData[Num++] = gs_IndexMagic;
+	pData[Num++] = gs_IndexVersion;
+	pData[Num++] = m_FirstTick;
+	pData[Num++] = m_LastTickMarker;
+	pData[Num++] = m_NumKeyFrames;
+	for(int i = 0; i < m_NumKeyFrames; i++)
+	{
+		pData[Num++] = m_pKeyFrames[i].m_Tick;
+		pData[Num++] = m_pKeyFrames[i].m_Filepos;
+	}
+	pData[Num++] = m_NumRounds;
+	for(int i = 0; i < m_NumRounds; i++)
+	{
+		const CDemoRound *pRound = &m_aRounds[i];
+		pData[Num++] = pRound->m_StartTick;
+		pData[Num++] = pRound->m_EndTick;
+		pData[Num++] = pRound->m_Catches;
+		for(int c = 0; c < (int)sizeof(pRound->m_aWinner); c += 4)
+		{
+			const unsigned char *pWinner = (const unsigned char *)pRound->m_aWinner+c;
+			pData[Num++] = (pWinner[0]<<24)|(pWinner[1]<<16)|(pWinner[2]<<8)|pWinner[3];
+		}
+	}
+
+	int NumErrors = m_NumWriteErrors;
+	int IndexPos = io_tell(m_File);
+	Write(CHUNKTYPE_INDEX, pData, Num*sizeof(int));
+	if(m_NumWriteErrors != NumErrors)
+		return;
+
+	int aLocator[2] = { gs_IndexLocatorMagic, IndexPos };
+	Write(CHUNKTYPE_INDEX, aLocator, sizeof(aLocator));
+}
+
+void CDemoRecorder::Queue(int Type, int Tick, const void *pData, int Size)
+{
+	// wait for the writer if it fell too far behind, the demo must not lose anything
+	{
+		std::unique_lock<std::mutex> Lock(m_QueueMutex);
+		m_QueueSpace.wait(Lock, [this]() { return m_QueueWrite - m_QueueRead < (unsigned)m_QueueSize; });
+	}
+
+	// the writer doesn't touch the free entries
+	CQueueEntry *pEntry = &m_pQueue[m_QueueWrite % m_QueueSize];
+	if(pEntry->m_Capacity < Size)
+	{
+		mem_free(pEntry->m_pData);
+		pEntry->m_Capacity = max(Size, 1024);
+		pEntry->m_pData = (unsigned char *)mem_alloc(pEntry->m_Capacity, 1);
+	}
+	pEntry->m_Type = Type;
+	pEntry->m_Tick = Tick;
+	pEntry->m_Size = Size;
+	mem_copy(pEntry->m_pData, pData, Size);
+
+	{
+		std::lock_guard<std::mutex> Lock(m_QueueMutex);
+		m_QueueWrite++;
+	}
+	m_QueueFilled.notify_one();
+}
+
+void CDemoRecorder::WriterThread(void *pUser)
+{
+	CDemoRecorder *pSelf = (CDemoRecorder *)pUser;
+
+	while(1)
+	{
+		unsigned Read;
+		{
+			std::unique_lock<std::mutex> Lock(pSelf->m_QueueMutex);
+			pSelf->m_QueueFilled.wait(Lock, [pSelf]() { return pSelf->m_QueueRead != pSelf->m_QueueWrite || pSelf->m_StopWriter; });
+
+			// everything queued before the stop request has been written
+			if(pSelf->m_QueueRead == pSelf->m_QueueWrite)
+				break;
+			Read = pSelf->m_QueueRead;
+		}
+
+		const CQueueEntry *pEntry = &pSelf->m_pQueue[Read % pSelf->m_QueueSize];
+		if(pEntry->m_Type == QUEUEENTRY_SNAPSHOT)
+			pSelf->WriteSnapshot(pEntry->m_Tick, pEntry->m_pData, pEntry->m_Size);
+		else
+			pSelf->Write(CHUNKTYPE_MESSAGE, pEntry->m_pData, pEntry->m_Size);
+
+		{
+			std::lock_guard<std::mutex> Lock(pSelf->m_QueueMutex);
+			pSelf->m_QueueRead = Read+1;
+		}
+		pSelf->m_QueueSpace.notify_one();
+	}
+}
+
+void CDemoRecorder::RecordSnapshot(int Tick, const void *pData, int Size)
+{
+	if(!m_File)
+		return;
+
+	m_LastTickMarker = Tick;
+	if(m_FirstTick < 0)
+		m_FirstTick = Tick;
+
+	if(m_pWriterThread)
+		Queue(QUEUEENTRY_SNAPSHOT, Tick, pData, Size);
+	else
+		WriteSnapshot(Tick, pData, Size);
+}
+
 void CDemoRecorder::RecordMessage(const void *pData, int Size)
 {
-	Write(CHUNKTYPE_MESSAGE, pData, Size);
+	if(!m_File)
+		return;
+
+	if(m_pWriterThread)
+		Queue(QUEUEENTRY_MESSAGE, 0, pData, Size);
+	else
+		Write(CHUNKTYPE_MESSAGE, pData, Size);
 }
 
 int CDemoRecorder::Stop()
@@ -278,6 +440,37 @@ int CDemoRecorder::Stop()
 	if(!m_File)
 		return -1;
 
+	// let the writer catch up
+	if(m_pWriterThread)
+	{
+		{
+			std::lock_guard<std::mutex> Lock(m_QueueMutex);
+			m_StopWriter = true;
+		}
+		m_QueueFilled.notify_one();
+		thread_wait(m_pWriterThread);
+		thread_destroy(m_pWriterThread);
+		m_pWriterThread = 0;
+
+		for(int i = 0; i < m_QueueSize; i++)
+			mem_free(m_pQueue[i].m_pData);
+		mem_free(m_pQueue);
+		m_pQueue = 0;
+		m_QueueSize = 0;
+	}
+
+	WriteIndex();
+	mem_free(m_pKeyFrames);
+	m_pKeyFrames = 0;
+	m_KeyFramesCapacity = 0;
+
+	if(m_NumWriteErrors)
+	{
+		char aBuf[128];
+		str_format(aBuf, sizeof(aBuf), "%d chunks got lost due to compression errors", m_NumWriteErrors.load());
+		m_pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "demo_recorder", aBuf);
+	}
+
 	// add the demo length to the header
 	io_seek(m_File, gs_LengthOffset, IOSEEK_START);
 	int DemoLength = Length();
@@ -332,6 +525,16 @@ void CDemoRecorder::AddDemoMarker()
 	m_pConsole->Print(IConsole::OUTPUT_LEVEL_STANDARD, "demo_recorder", "Added timeline marker");
 }
 
+void CDemoRecorder::AddRound(const CDemoRound *pRound)
+{
+	if(!m_File || m_NumRounds >= MAX_ROUNDS)
+		return;
+
+	m_aRounds[m_NumRounds] = *pRound;
+	m_aRounds[m_NumRounds].m_aWinner[sizeof(pRound->m_aWinner)-1] = 0;
+	m_NumRounds++;
+}
+
 
 
 CDemoPlayer::CDemoPlayer(class CSnapshotDelta *pSnapshotDelta)
@@ -339,6 +542,8 @@ CDemoPlayer::CDemoPlayer(class CSnapshotDelta *pSnapshotDelta)
 	m_File = 0;
 	m_aErrorMsg[0] = 0;
 	m_pKeyFrames = 0;
+	m_pRounds = 0;
+	m_NumRounds = 0;
 
 	m_pSnapshotDelta = pSnapshotDelta;
 	m_LastSnapshotDataSize = -1;
@@ -405,6 +610,105 @@ int CDemoPlayer::ReadChunkHeader(int *pType, int *pSize, int *pTick)
 	return 0;
 }
 
+bool CDemoPlayer::ReadIndex()
+{
+	long StartPos = io_tell(m_File);
+	io_seek(m_File, 0, IOSEEK_END);
+	long EndPos = io_tell(m_File);
+
+	// the locator is the last chunk, a small one with a single byte header
+	unsigned char aTail[32];
+	int TailSize = min(EndPos-StartPos, (long)sizeof(aTail));
+	io_seek(m_File, EndPos-TailSize, IOSEEK_START);
+	if(TailSize <= 0 || io_read(m_File, aTail, TailSize) != (unsigned)TailSize)
+	{
+		io_seek(m_File, StartPos, IOSEEK_START);
+		return false;
+	}
+
+	int *pIndexData = (int *)m_aChunkData;
+	long IndexPos = -1;
+	long LocatorPos = -1;
+	for(int Size = 1; Size < 30 && Size < TailSize; Size++)
+	{
+		if(aTail[TailSize-Size-1] != ((CHUNKTYPE_INDEX<<5)|Size))
+			continue;
+		int DataSize = CNetBase::Decompress(aTail+TailSize-Size, Size, m_aDecompressedData, sizeof(m_aDecompressedData));
+		if(DataSize >= 0)
+			DataSize = CVariableInt::Decompress(m_aDecompressedData, DataSize, pIndexData, sizeof(m_aChunkData));
+		if(DataSize == 2*(int)sizeof(int) && pIndexData[0] == gs_IndexLocatorMagic)
+		{
+			IndexPos = pIndexData[1];
+			LocatorPos = EndPos-Size-1;
+			break;
+		}
+	}
+
+	// the index chunk has to end right where the locator starts
+	int ChunkType, ChunkSize, ChunkTick = 0;
+	int Num = -1;
+	if(IndexPos >= StartPos && IndexPos < LocatorPos)
+	{
+		io_seek(m_File, IndexPos, IOSEEK_START);
+		if(ReadChunkHeader(&ChunkType, &ChunkSize, &ChunkTick) == 0 && ChunkType == CHUNKTYPE_INDEX &&
+			io_tell(m_File)+ChunkSize == LocatorPos &&
+			io_read(m_File, m_aCompressedData, ChunkSize) == (unsigned)ChunkSize)
+		{
+			int DataSize = CNetBase::Decompress(m_aCompressedData, ChunkSize, m_aDecompressedData, sizeof(m_aDecompressedData));
+			if(DataSize >= 0)
+				DataSize = CVariableInt::Decompress(m_aDecompressedData, DataSize, pIndexData, sizeof(m_aChunkData));
+			if(DataSize >= 0)
+				Num = DataSize/sizeof(int);
+		}
+	}
+	io_seek(m_File, StartPos, IOSEEK_START);
+
+	const int *pData = pIndexData;
+	const int *pEnd = pIndexData+max(Num, 0);
+	if(pEnd-pData < 5 || pData[0] != gs_IndexMagic || pData[1] != gs_IndexVersion)
+		return false;
+	int FirstTick = pData[2];
+	int LastTick = pData[3];
+	int NumKeyFrames = pData[4];
+	pData += 5;
+	if(NumKeyFrames < 0 || NumKeyFrames > gs_MaxIndexKeyFrames || pEnd-pData < NumKeyFrames*2+1)
+		return false;
+	const int *pKeyFrames = pData;
+	pData += NumKeyFrames*2;
+	int NumRounds = *pData++;
+	if(NumRounds < 0 || pEnd-pData < NumRounds*7)
+		return false;
+
+	m_Info.m_Info.m_FirstTick = FirstTick;
+	m_Info.m_Info.m_LastTick = LastTick;
+	m_Info.m_SeekablePoints = NumKeyFrames;
+	m_pKeyFrames = (CKeyFrame*)mem_alloc(max(NumKeyFrames, 1)*sizeof(CKeyFrame), 1);
+	for(int i = 0; i < NumKeyFrames; i++)
+	{
+		m_pKeyFrames[i].m_Tick = pKeyFrames[i*2];
+		m_pKeyFrames[i].m_Filepos = pKeyFrames[i*2+1];
+	}
+	m_NumRounds = NumRounds;
+	m_pRounds = (CDemoRound*)mem_alloc(max(NumRounds, 1)*sizeof(CDemoRound), 1);
+	for(int i = 0; i < NumRounds; i++)
+	{
+		CDemoRound *pRound = &m_pRounds[i];
+		pRound->m_StartTick = *pData++;
+		pRound->m_EndTick = *pData++;
+		pRound->m_Catches = *pData++;
+		for(int c = 0; c < (int)sizeof(pRound->m_aWinner); c += 4)
+		{
+			int Chars = *pData++;
+			pRound->m_aWinner[c] = (Chars>>24)&0xff;
+			pRound->m_aWinner[c+1] = (Chars>>16)&0xff;
+			pRound->m_aWinner[c+2] = (Chars>>8)&0xff;
+			pRound->m_aWinner[c+3] = Chars&0xff;
+		}
+		pRound->m_aWinner[sizeof(pRound->m_aWinner)-1] = 0;
+	}
+	return true;
+}
+
 void CDemoPlayer::ScanFile()
 {
 	long StartPos;
@@ -415,9 +719,14 @@ void CDemoPlayer::ScanFile()
 	int ChunkSize, ChunkType, ChunkTick = 0;
 	int i;
 
-	StartPos = io_tell(m_File);
 	m_Info.m_SeekablePoints = 0;
 
+	// demos with an index don't have to be walked through
+	if(ReadIndex())
+		return;
+
+	StartPos = io_tell(m_File);
+
 	while(1)
 	{
 		long CurrentPos = io_tell(m_File);
@@ -465,10 +774,6 @@ void CDemoPlayer::ScanFile()
 
 void CDemoPlayer::DoTick()
 {
-	static char aCompresseddata[CSnapshot::MAX_SIZE];
-	static char aDecompressed[CSnapshot::MAX_SIZE];
-	static char aData[CSnapshot::MAX_SIZE];
-	static char aNewsnap[CSnapshot::MAX_SIZE];
 	int ChunkType, ChunkTick, ChunkSize;
 	int DataSize = 0;
 	int GotSnapshot = 0;
@@ -498,7 +803,7 @@ void CDemoPlayer::DoTick()
 		// read the chunk
 		if(ChunkSize)
 		{
-			if(io_read(m_File, aCompresseddata, ChunkSize) != (unsigned)ChunkSize)
+			if(io_read(m_File, m_aCompressedData, ChunkSize) != (unsigned)ChunkSize)
 			{
 				// stop on error or eof
 				m_pConsole->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "demo_player", "error reading chunk");
@@ -506,7 +811,7 @@ void CDemoPlayer::DoTick()
 				break;
 			}
 
-			DataSize = CNetBase::Decompress(aCompresseddata, ChunkSize, aDecompressed, sizeof(aDecompressed));
+			DataSize = CNetBase::Decompress(m_aCompressedData, ChunkSize, m_aDecompressedData, sizeof(m_aDecompressedData));
 			if(DataSize < 0)
 			{
 				// stop on error or eof
@@ -515,7 +820,7 @@ void CDemoPlayer::DoTick()
 				break;
 			}
 
-			DataSize = CVariableInt::Decompress(aDecompressed, DataSize, aData, sizeof(aData));
+			DataSize = CVariableInt::Decompress(m_aDecompressedData, DataSize, m_aChunkData, sizeof(m_aChunkData));
 
 			if(DataSize < 0)
 			{
@@ -525,7 +830,12 @@ void CDemoPlayer::DoTick()
 			}
 		}
 
-		if(ChunkType == CHUNKTYPE_DELTA)
+		if(ChunkType == CHUNKTYPE_INDEX)
+		{
+			// only used when loading the demo
+			continue;
+		}
+		else if(ChunkType == CHUNKTYPE_DELTA)
 		{
 			// process delta snapshot
 			GotSnapshot = 1;
@@ -534,15 +844,15 @@ void CDemoPlayer::DoTick()
 			if(m_LastSnapshotDataSize == -1)
 				continue;
 
-			DataSize = m_pSnapshotDelta->UnpackDelta((CSnapshot*)m_aLastSnapshotData, (CSnapshot*)aNewsnap, aData, DataSize);
+			DataSize = m_pSnapshotDelta->UnpackDelta((CSnapshot*)m_aLastSnapshotData, (CSnapshot*)m_aNewSnapshotData, m_aChunkData, DataSize);
 
 			if(DataSize >= 0)
 			{
 				if(m_pListner)
-					m_pListner->OnDemoPlayerSnapshot(aNewsnap, DataSize);
+					m_pListner->OnDemoPlayerSnapshot(m_aNewSnapshotData, DataSize);
 
 				m_LastSnapshotDataSize = DataSize;
-				mem_copy(m_aLastSnapshotData, aNewsnap, DataSize);
+				mem_copy(m_aLastSnapshotData, m_aNewSnapshotData, DataSize);
 			}
 			else
 			{
@@ -557,17 +867,17 @@ void CDemoPlayer::DoTick()
 			CSnapshotBuilder Builder;
 			GotSnapshot = 1;
 
-			if(Builder.UnserializeSnap(aData, DataSize))
-				DataSize = Builder.Finish(aNewsnap);
+			if(Builder.UnserializeSnap(m_aChunkData, DataSize))
+				DataSize = Builder.Finish(m_aNewSnapshotData);
 			else
 				DataSize = -1;
 			
 			if(DataSize >= 0)
 			{
 				m_LastSnapshotDataSize = DataSize;
-				mem_copy(m_aLastSnapshotData, aNewsnap, DataSize);
+				mem_copy(m_aLastSnapshotData, m_aNewSnapshotData, DataSize);
 				if(m_pListner)
-					m_pListner->OnDemoPlayerSnapshot(aNewsnap, DataSize);
+					m_pListner->OnDemoPlayerSnapshot(m_aNewSnapshotData, DataSize);
 			}
 			else
 			{
@@ -594,7 +904,7 @@ void CDemoPlayer::DoTick()
 			else if(ChunkType == CHUNKTYPE_MESSAGE)
 			{
 				if(m_pListner)
-					m_pListner->OnDemoPlayerMessage(aData, DataSize);
+					m_pListner->OnDemoPlayerMessage(m_aChunkData, DataSize);
 			}
 		}
 	}
@@ -701,8 +1011,11 @@ const char *CDemoPlayer::Load(class IStorage *pStorage, class IConsole *pConsole
 
 		// save map
 		MapFile = pStorage->OpenFile(aMapFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
-		io_write(MapFile, pMapData, MapSize);
-		io_close(MapFile);
+		if(MapFile)
+		{
+			io_write(MapFile, pMapData, MapSize);
+			io_close(MapFile);
+		}
 
 		// free data
 		mem_free(pMapData);
@@ -855,6 +1168,9 @@ int CDemoPlayer::Stop()
 	m_File = 0;
 	mem_free(m_pKeyFrames);
 	m_pKeyFrames = 0;
+	mem_free(m_pRounds);
+	m_pRounds = 0;
+	m_NumRounds = 0;
 	str_copy(m_aFilename, "", sizeof(m_aFilename));
 	return 0;
 }
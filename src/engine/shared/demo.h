@@ -8,26 +8,82 @@
 
 #include "snapshot.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 class CDemoRecorder : public IDemoRecorder
 {
+	// snapshots and messages on their way to the writer thread
+	struct CQueueEntry
+	{
+		int m_Type;
+		int m_Tick;
+		int m_Size;
+		int m_Capacity;
+		unsigned char *m_pData;
+	};
+
+	enum
+	{
+		QUEUEENTRY_SNAPSHOT=0,
+		QUEUEENTRY_MESSAGE,
+
+		MAX_ROUNDS=256,
+	};
+
+	struct CIndexKeyFrame
+	{
+		int m_Tick;
+		int m_Filepos;
+	};
+
 	class IConsole *m_pConsole;
 	IOHANDLE m_File;
 	int m_LastTickMarker;
-	int m_LastKeyFrame;
 	int m_FirstTick;
-	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
-	class CSnapshotDelta *m_pSnapshotDelta;
 	int m_NumTimelineMarkers;
 	int m_aTimelineMarkers[MAX_TIMELINE_MARKERS];
+	int m_NumRounds;
+	CDemoRound m_aRounds[MAX_ROUNDS];
+
+	CQueueEntry *m_pQueue;
+	int m_QueueSize;
+	std::mutex m_QueueMutex; // guards the positions and the stop request
+	std::condition_variable m_QueueFilled;
+	std::condition_variable m_QueueSpace;
+	unsigned m_QueueRead;
+	unsigned m_QueueWrite;
+	bool m_StopWriter;
+	std::atomic<int> m_NumWriteErrors;
+	void *m_pWriterThread;
+
+	// only touched by the writer
+	int m_LastWrittenTickMarker;
+	int m_LastKeyFrame;
+	CIndexKeyFrame *m_pKeyFrames;
+	int m_NumKeyFrames;
+	int m_KeyFramesCapacity;
+	unsigned char m_aLastSnapshotData[CSnapshot::MAX_SIZE];
+	char m_aTmpData[CSnapshot::MAX_SIZE];
+	char m_aBuffer[64*1024];
+	char m_aBuffer2[64*1024];
+	class CSnapshotDelta *m_pSnapshotDelta;
+
+	void Queue(int Type, int Tick, const void *pData, int Size);
+	static void WriterThread(void *pUser);
 
+	void WriteSnapshot(int Tick, const void *pData, int Size);
 	void WriteTickMarker(int Tick, int Keyframe);
 	void Write(int Type, const void *pData, int Size);
+	void WriteIndex();
 public:
 	CDemoRecorder(class CSnapshotDelta *pSnapshotDelta);
 
 	int Start(class IStorage *pStorage, class IConsole *pConsole, const char *pFilename, const char *pNetversion, const char *pMap, SHA256_DIGEST MapSha256, unsigned MapCrc, const char *pType);
 	int Stop();
 	void AddDemoMarker();
+	void AddRound(const CDemoRound *pRound);
 
 	void RecordSnapshot(int Tick, const void *pData, int Size);
 	void RecordMessage(const void *pData, int Size);
@@ -88,6 +144,8 @@ private:
 	char m_aFilename[256];
 	char m_aErrorMsg[256];
 	CKeyFrame *m_pKeyFrames;
+	CDemoRound *m_pRounds;
+	int m_NumRounds;
 
 	CPlaybackInfo m_Info;
 	int m_DemoType;
@@ -95,10 +153,16 @@ private:
 	int m_LastSnapshotDataSize;
 	class CSnapshotDelta *m_pSnapshotDelta;
 
+	// chunk decoding, kept per player so several can run in parallel
+	char m_aCompressedData[CSnapshot::MAX_SIZE];
+	char m_aDecompressedData[CSnapshot::MAX_SIZE];
+	char m_aChunkData[CSnapshot::MAX_SIZE];
+	char m_aNewSnapshotData[CSnapshot::MAX_SIZE];
+
 	int ReadChunkHeader(int *pType, int *pSize, int *pTick);
 	void DoTick();
+	bool ReadIndex();
 	void ScanFile();
-	int NextFrame();
 
 public:
 
@@ -119,8 +183,12 @@ public:
 	int GetDemoType() const;
 
 	int Update();
+	// plays the next tick right away, for processing demos without real time playback
+	int NextFrame();
 
 	const CPlaybackInfo *Info() const { return &m_Info; }
+	int NumRounds() const { return m_NumRounds; }
+	const CDemoRound *GetRound(int Index) const { return &m_pRounds[Index]; }
 	int IsPlaying() const { return m_File != 0; }
 };
 
@@ -9,32 +9,86 @@ int CEcon::NewClientCallback(int ClientID, void *pUser)
 {
 	CEcon *pThis = (CEcon *)pUser;
 
-	char aAddrStr[NETADDR_MAXSTRSIZE];
-	net_addr_str(pThis->m_NetConsole.ClientAddr(ClientID), aAddrStr, sizeof(aAddrStr), true);
-	char aBuf[128];
-	str_format(aBuf, sizeof(aBuf), "client accepted. cid=%d addr=%s'", ClientID, aAddrStr);
-	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "econ", aBuf);
+	pThis->m_aNetSlots[ClientID].m_Authed = false;
+	pThis->m_InQueue.Push(IN_CONNECTED, ClientID, pThis->m_aNetSlots[ClientID].m_Generation, pThis->m_NetConsole.ClientAddr(ClientID), sizeof(NETADDR));
+	return 0;
+}
 
-	pThis->m_aClients[ClientID].m_State = CClient::STATE_CONNECTED;
-	pThis->m_aClients[ClientID].m_TimeConnected = time_get();
-	pThis->m_aClients[ClientID].m_AuthTries = 0;
+int CEcon::DelClientCallback(int ClientID, const char *pReason, void *pUser)
+{
+	CEcon *pThis = (CEcon *)pUser;
 
-	pThis->m_NetConsole.Send(ClientID, "Enter password:");
+	// everything still queued for the connection is outdated from now on
+	pThis->m_InQueue.PushString(IN_DROPPED, ClientID, pThis->m_aNetSlots[ClientID].m_Generation, pReason);
+	pThis->m_aNetSlots[ClientID].m_Generation++;
+	pThis->m_aNetSlots[ClientID].m_Authed = false;
 	return 0;
 }
 
-int CEcon::DelClientCallback(int ClientID, const char *pReason, void *pUser)
+void CEcon::NetThread(void *pUser)
 {
 	CEcon *pThis = (CEcon *)pUser;
 
-	char aAddrStr[NETADDR_MAXSTRSIZE];
-	net_addr_str(pThis->m_NetConsole.ClientAddr(ClientID), aAddrStr, sizeof(aAddrStr), true);
-	char aBuf[256];
-	str_format(aBuf, sizeof(aBuf), "client dropped. cid=%d addr=%s reason='%s'", ClientID, aAddrStr, pReason);
-	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "econ", aBuf);
+	while(!pThis->m_Shutdown)
+	{
+		if(pThis->NetUpdate())
+			continue;
 
-	pThis->m_aClients[ClientID].m_State = CClient::STATE_EMPTY;
-	return 0;
+		// input wakes the thread right away. with a full queue the game thread has to catch up first,
+		// the sockets would stay readable then
+		if(pThis->m_InQueue.HasSpace(NET_MAX_PACKETSIZE+QUEUE_RESERVE))
+			pThis->m_NetConsole.WaitForInput(NET_WAIT_TIME);
+		else
+			thread_sleep(NET_WAIT_TIME);
+	}
+
+	// get out what the game thread sent last
+	pThis->NetUpdate();
+}
+
+bool CEcon::NetUpdate()
+{
+	bool Busy = false;
+	m_NetConsole.SetOverflowPolicy(g_Config.m_EcOutputOverflow);
+
+	while(const CLineQueue::CItem *pItem = m_OutQueue.Front())
+	{
+		int ClientID = pItem->m_ClientID;
+		const char *pData = static_cast<const char *>(pItem->Data());
+		if(pItem->m_Type == OUT_LINE && ClientID == -1)
+		{
+			for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS; i++)
+			{
+				if(m_aNetSlots[i].m_Authed)
+					m_NetConsole.Send(i, pData);
+			}
+		}
+		else if(m_aNetSlots[ClientID].m_Generation == pItem->m_Generation)
+		{
+			if(pItem->m_Type == OUT_LINE)
+				m_NetConsole.Send(ClientID, pData);
+			else if(pItem->m_Type == OUT_AUTHED)
+				m_aNetSlots[ClientID].m_Authed = true;
+			else if(pItem->m_Type == OUT_DROP)
+				m_NetConsole.Drop(ClientID, pData);
+		}
+		m_OutQueue.Pop();
+		Busy = true;
+	}
+
+	// accepts, receives and sends what fits into the sockets
+	m_NetConsole.Update();
+
+	// lines stay in the connection buffer while the game thread is behind
+	char aBuf[NET_MAX_PACKETSIZE];
+	int ClientID;
+	while(m_InQueue.HasSpace(sizeof(aBuf)+QUEUE_RESERVE) && m_NetConsole.Recv(aBuf, (int)(sizeof(aBuf))-1, &ClientID))
+	{
+		m_InQueue.PushString(IN_LINE, ClientID, m_aNetSlots[ClientID].m_Generation, aBuf);
+		Busy = true;
+	}
+
+	return Busy;
 }
 
 void CEcon::SendLineCB(const char *pLine, void *pUserData, bool Highlighted)
@@ -57,18 +111,26 @@ void CEcon::ConLogout(IConsole::IResult *pResult, void *pUserData)
 	CEcon *pThis = static_cast<CEcon *>(pUserData);
 
 	if(pThis->m_UserClientID >= 0 && pThis->m_UserClientID < NET_MAX_CONSOLE_CLIENTS && pThis->m_aClients[pThis->m_UserClientID].m_State != CClient::STATE_EMPTY)
-		pThis->m_NetConsole.Drop(pThis->m_UserClientID, "Logout");
+		pThis->Drop(pThis->m_UserClientID, "Logout");
 }
 
 void CEcon::Init(IConsole *pConsole, CNetBan *pNetBan)
 {
 	m_pConsole = pConsole;
+	m_pNetBan = pNetBan;
 
 	for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS; i++)
+	{
 		m_aClients[i].m_State = CClient::STATE_EMPTY;
+		m_aNetSlots[i].m_Generation = 0;
+		m_aNetSlots[i].m_Authed = false;
+	}
 
 	m_Ready = false;
 	m_UserClientID = -1;
+	m_NumDroppedLines = 0;
+	m_pThread = 0;
+	m_Shutdown = false;
 
 	if(g_Config.m_EcPort == 0 || g_Config.m_EcPassword[0] == 0)
 		return;
@@ -87,9 +149,16 @@ void CEcon::Init(IConsole *pConsole, CNetBan *pNetBan)
 		BindAddr.port = g_Config.m_EcPort;
 	}
 
-	if(m_NetConsole.Open(BindAddr, pNetBan, 0))
+	// bans are checked on the game thread, the network thread doesn't touch them
+	if(m_NetConsole.Open(BindAddr, 0, 0))
 	{
 		m_NetConsole.SetCallbacks(NewClientCallback, DelClientCallback, this);
+		if(!m_OutQueue.IsInitialized())
+		{
+			m_OutQueue.Init(OUT_QUEUE_SIZE);
+			m_InQueue.Init(IN_QUEUE_SIZE);
+		}
+		m_pThread = thread_init(NetThread, this);
 		m_Ready = true;
 		char aBuf[128];
 		str_format(aBuf, sizeof(aBuf), "bound to %s:%d", g_Config.m_EcBindaddr, g_Config.m_EcPort);
@@ -104,77 +173,152 @@ void CEcon::Init(IConsole *pConsole, CNetBan *pNetBan)
 		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD,"econ", "couldn't open socket. port might already be in use");
 }
 
-void CEcon::Update()
+void CEcon::OnConnected(int ClientID, int Generation, const NETADDR *pAddr)
 {
-	if(!m_Ready)
+	m_aClients[ClientID].m_Generation = Generation;
+	m_aClients[ClientID].m_Addr = *pAddr;
+
+	char aBuf[128];
+	int LastInfoQuery;
+	if(m_pNetBan && m_pNetBan->IsBanned(pAddr, aBuf, sizeof(aBuf), &LastInfoQuery))
+	{
+		// banned, reply with a message (5 second cooldown) and drop
+		m_aClients[ClientID].m_State = CClient::STATE_EMPTY;
+		if(LastInfoQuery + 5 >= time_timestamp())
+			aBuf[0] = 0;
+		m_OutQueue.PushString(OUT_DROP, ClientID, Generation, aBuf);
 		return;
+	}
 
-	m_NetConsole.Update();
+	char aAddrStr[NETADDR_MAXSTRSIZE];
+	net_addr_str(pAddr, aAddrStr, sizeof(aAddrStr), true);
+	str_format(aBuf, sizeof(aBuf), "client accepted. cid=%d addr=%s'", ClientID, aAddrStr);
+	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "econ", aBuf);
 
-	char aBuf[NET_MAX_PACKETSIZE];
-	int ClientID;
+	m_aClients[ClientID].m_State = CClient::STATE_CONNECTED;
+	m_aClients[ClientID].m_TimeConnected = time_get();
+	m_aClients[ClientID].m_AuthTries = 0;
+	m_aClients[ClientID].m_NumDroppedLines = 0;
+
+	SendTo(ClientID, "Enter password:");
+}
 
-	while(m_NetConsole.Recv(aBuf, (int)(sizeof(aBuf))-1, &ClientID))
+void CEcon::OnLine(int ClientID, const char *pLine)
+{
+	if(m_aClients[ClientID].m_State == CClient::STATE_CONNECTED)
 	{
-		dbg_assert(m_aClients[ClientID].m_State != CClient::STATE_EMPTY, "got message from empty slot");
-		if(m_aClients[ClientID].m_State == CClient::STATE_CONNECTED)
+		if(str_comp(pLine, g_Config.m_EcPassword) == 0)
 		{
-			if(str_comp(aBuf, g_Config.m_EcPassword) == 0)
-			{
-				m_aClients[ClientID].m_State = CClient::STATE_AUTHED;
-				m_NetConsole.Send(ClientID, "Authentication successful. External console access granted.");
+			m_aClients[ClientID].m_State = CClient::STATE_AUTHED;
+			m_OutQueue.Push(OUT_AUTHED, ClientID, m_aClients[ClientID].m_Generation, 0, 0);
+			SendTo(ClientID, "Authentication successful. External console access granted.");
 
-				str_format(aBuf, sizeof(aBuf), "cid=%d authed", ClientID);
-				Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "econ", aBuf);
-			}
-			else
+			char aBuf[128];
+			str_format(aBuf, sizeof(aBuf), "cid=%d authed", ClientID);
+			Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "econ", aBuf);
+		}
+		else
+		{
+			m_aClients[ClientID].m_AuthTries++;
+			char aMsg[128];
+			str_format(aMsg, sizeof(aMsg), "Wrong password %d/%d.", m_aClients[ClientID].m_AuthTries, MAX_AUTH_TRIES);
+			SendTo(ClientID, aMsg);
+			if(m_aClients[ClientID].m_AuthTries >= MAX_AUTH_TRIES)
 			{
-				m_aClients[ClientID].m_AuthTries++;
-				char aMsg[128];
-				str_format(aMsg, sizeof(aMsg), "Wrong password %d/%d.", m_aClients[ClientID].m_AuthTries, MAX_AUTH_TRIES);
-				m_NetConsole.Send(ClientID, aMsg);
-				if(m_aClients[ClientID].m_AuthTries >= MAX_AUTH_TRIES)
-				{
-					if(g_Config.m_EcBantime)
-						m_NetConsole.NetBan()->BanAddr(m_NetConsole.ClientAddr(ClientID), g_Config.m_EcBantime*60, "Too many authentication tries");
-					m_NetConsole.Drop(ClientID, "Too many authentication tries");
-				}
+				if(g_Config.m_EcBantime && m_pNetBan)
+					m_pNetBan->BanAddr(&m_aClients[ClientID].m_Addr, g_Config.m_EcBantime*60, "Too many authentication tries");
+				Drop(ClientID, "Too many authentication tries");
 			}
 		}
-		else if(m_aClients[ClientID].m_State == CClient::STATE_AUTHED)
+	}
+	else if(m_aClients[ClientID].m_State == CClient::STATE_AUTHED)
+	{
+		char aFormatted[256];
+		str_format(aFormatted, sizeof(aFormatted), "cid=%d cmd='%s'", ClientID, pLine);
+		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aFormatted);
+		m_UserClientID = ClientID;
+		Console()->ExecuteLine(pLine);
+		m_UserClientID = -1;
+	}
+}
+
+void CEcon::OnDropped(int ClientID, const char *pReason)
+{
+	char aAddrStr[NETADDR_MAXSTRSIZE];
+	net_addr_str(&m_aClients[ClientID].m_Addr, aAddrStr, sizeof(aAddrStr), true);
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "client dropped. cid=%d addr=%s reason='%s'", ClientID, aAddrStr, pReason);
+	Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "econ", aBuf);
+
+	m_aClients[ClientID].m_State = CClient::STATE_EMPTY;
+}
+
+void CEcon::Drop(int ClientID, const char *pReason)
+{
+	m_OutQueue.PushString(OUT_DROP, ClientID, m_aClients[ClientID].m_Generation, pReason);
+	OnDropped(ClientID, pReason);
+}
+
+void CEcon::Update()
+{
+	if(!m_Ready)
+		return;
+
+	// everything that happened on the network thread since the last tick
+	while(const CLineQueue::CItem *pItem = m_InQueue.Front())
+	{
+		int ClientID = pItem->m_ClientID;
+		if(pItem->m_Type == IN_CONNECTED)
+			OnConnected(ClientID, pItem->m_Generation, static_cast<const NETADDR *>(pItem->Data()));
+		else if(m_aClients[ClientID].m_State != CClient::STATE_EMPTY && m_aClients[ClientID].m_Generation == pItem->m_Generation)
 		{
-			char aFormatted[256];
-			str_format(aFormatted, sizeof(aFormatted), "cid=%d cmd='%s'", ClientID, aBuf);
-			Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "server", aFormatted);
-			m_UserClientID = ClientID;
-			Console()->ExecuteLine(aBuf);
-			m_UserClientID = -1;
+			if(pItem->m_Type == IN_LINE)
+				OnLine(ClientID, static_cast<const char *>(pItem->Data()));
+			else if(pItem->m_Type == IN_DROPPED)
+				OnDropped(ClientID, static_cast<const char *>(pItem->Data()));
 		}
+		m_InQueue.Pop();
 	}
 
 	for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS; ++i)
 	{
 		if(m_aClients[i].m_State == CClient::STATE_CONNECTED &&
 			time_get() > m_aClients[i].m_TimeConnected + g_Config.m_EcAuthTimeout * time_freq())
-			m_NetConsole.Drop(i, "authentication timeout");
+			Drop(i, "authentication timeout");
 	}
 }
 
+void CEcon::SendTo(int ClientID, const char *pLine)
+{
+	int Generation = ClientID == -1 ? 0 : m_aClients[ClientID].m_Generation;
+	// lines to everyone are missing for everyone, others only for their client
+	int *pNumDroppedLines = ClientID == -1 ? &m_NumDroppedLines : &m_aClients[ClientID].m_NumDroppedLines;
+
+	// never wait for the network thread, rather lose lines
+	if(!m_OutQueue.HasSpace(str_length(pLine)+1+QUEUE_RESERVE))
+	{
+		(*pNumDroppedLines)++;
+		return;
+	}
+	if(*pNumDroppedLines)
+	{
+		char aBuf[64];
+		str_format(aBuf, sizeof(aBuf), "[%d lines dropped]", *pNumDroppedLines);
+		m_OutQueue.PushString(OUT_LINE, ClientID, Generation, aBuf);
+		*pNumDroppedLines = 0;
+	}
+	m_OutQueue.PushString(OUT_LINE, ClientID, Generation, pLine);
+}
+
 void CEcon::Send(int ClientID, const char *pLine)
 {
 	if(!m_Ready)
 		return;
 
 	if(ClientID == -1)
-	{
-		for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS; i++)
-		{
-			if(m_aClients[i].m_State == CClient::STATE_AUTHED)
-				m_NetConsole.Send(i, pLine);
-		}
-	}
+		SendTo(-1, pLine);
 	else if(ClientID >= 0 && ClientID < NET_MAX_CONSOLE_CLIENTS && m_aClients[ClientID].m_State == CClient::STATE_AUTHED)
-		m_NetConsole.Send(ClientID, pLine);
+		SendTo(ClientID, pLine);
 }
 
 void CEcon::Shutdown()
@@ -182,5 +326,11 @@ void CEcon::Shutdown()
 	if(!m_Ready)
 		return;
 
+	m_Shutdown = true;
+	thread_wait(m_pThread);
+	thread_destroy(m_pThread);
+	m_pThread = 0;
+
 	m_NetConsole.Close();
+	m_Ready = false;
 }
@@ -1,14 +1,43 @@
 #ifndef ENGINE_SHARED_ECON_H
 #define ENGINE_SHARED_ECON_H
 
+#include "linequeue.h"
 #include "network.h"
 
 
+/*
+	Class: External Console
+		The sockets of the external console are handled by a thread of
+		its own, so that slow clients can't stall the server. The game
+		thread passes the lines to send through a queue and gets the
+		events of the clients back through another one, which it works
+		off once per tick. Slots are tagged with a generation, so that
+		neither side acts on events of a connection the other side
+		already dropped.
+*/
 class CEcon
 {
 	enum
 	{
 		MAX_AUTH_TRIES=3,
+
+		// game thread to network thread
+		OUT_LINE=0,
+		OUT_AUTHED,
+		OUT_DROP,
+
+		// network thread to game thread
+		IN_CONNECTED=0,
+		IN_LINE,
+		IN_DROPPED,
+
+		OUT_QUEUE_SIZE=256*1024,
+		IN_QUEUE_SIZE=64*1024,
+		// room kept free for the slot events, lines are dropped before them
+		QUEUE_RESERVE=NET_MAX_CONSOLE_CLIENTS*1024,
+
+		// the lines of the game thread are picked up after at most this many milliseconds
+		NET_WAIT_TIME=10,
 	};
 
 	class CClient
@@ -22,14 +51,35 @@ class CEcon
 		};
 
 		int m_State;
+		int m_Generation;
+		NETADDR m_Addr;
 		int64 m_TimeConnected;
 		int m_AuthTries;
+		int m_NumDroppedLines;
 	};
 	CClient m_aClients[NET_MAX_CONSOLE_CLIENTS];
 
+	// only used by the network thread
+	class CNetSlot
+	{
+	public:
+		int m_Generation;
+		bool m_Authed;
+	};
+	CNetSlot m_aNetSlots[NET_MAX_CONSOLE_CLIENTS];
+
 	IConsole *m_pConsole;
+	class CNetBan *m_pNetBan;
 	CNetConsole m_NetConsole;
 
+	CLineQueue m_OutQueue;
+	CLineQueue m_InQueue;
+	// lines to everyone the queue had no room for, the clients count their own
+	int m_NumDroppedLines;
+
+	void *m_pThread;
+	volatile bool m_Shutdown;
+
 	bool m_Ready;
 	int m_PrintCBIndex;
 	int m_UserClientID;
@@ -38,9 +88,19 @@ class CEcon
 	static void ConchainEconOutputLevelUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConLogout(IConsole::IResult *pResult, void *pUserData);
 
+	// network thread
+	static void NetThread(void *pUser);
+	bool NetUpdate();
 	static int NewClientCallback(int ClientID, void *pUser);
 	static int DelClientCallback(int ClientID, const char *pReason, void *pUser);
 
+	// game thread
+	void OnConnected(int ClientID, int Generation, const NETADDR *pAddr);
+	void OnLine(int ClientID, const char *pLine);
+	void OnDropped(int ClientID, const char *pReason);
+	void SendTo(int ClientID, const char *pLine);
+	void Drop(int ClientID, const char *pReason);
+
 public:
 	IConsole *Console() { return m_pConsole; }
 
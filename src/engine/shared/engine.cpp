@@ -66,8 +66,6 @@ public:
 		net_init();
 		CNetBase::Init();
 
-		m_JobPool.Init(1);
-
 		m_Logging = false;
 	}
 
@@ -102,6 +100,12 @@ public:
 		}
 	}
 
+	void InitJobPool()
+	{
+		m_JobPool.Init(g_Config.m_JobThreads);
+		dbg_msg("engine", "running %d job threads", m_JobPool.NumThreads());
+	}
+
 	void HostLookup(CHostLookup *pLookup, const char *pHostname, int Nettype)
 	{
 		str_copy(pLookup->m_aHostname, pHostname, sizeof(pLookup->m_aHostname));
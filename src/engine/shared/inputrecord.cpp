@@ -0,0 +1,420 @@
+#include <base/system.h>
+
+#include <engine/storage.h>
+
+#include "compression.h"
+#include "config.h"
+#include "inputrecord.h"
+#include "snapshot.h"
+
+#include <zlib.h>
+
+static const unsigned char gs_aHeaderMarker[8] = {'T', 'W', 'I', 'N', 'P', 'U', 'T', 0};
+static const int gs_ActVersion = 1;
+
+unsigned CInputRecord::StateHash(const CSnapshot *pSnap)
+{
+	// the items are sorted by their ids, so the order mustn't matter
+	unsigned Hash = 0;
+	for(int i = 0; i < pSnap->NumItems(); i++)
+	{
+		const CSnapshotItem *pItem = pSnap->GetItem(i);
+		int Type = pItem->Type();
+		unsigned ItemHash = crc32(0, (const Bytef *)&Type, sizeof(Type)); // ignore_convention
+		Hash += crc32(ItemHash, (const Bytef *)pItem->Data(), pSnap->GetItemSize(i)); // ignore_convention
+	}
+	return Hash;
+}
+
+CInputRecorder::CInputRecorder()
+{
+	m_File = 0;
+	m_BufferSize = 0;
+}
+
+CInputRecorder::~CInputRecorder()
+{
+	if(m_File)
+		io_close(m_File);
+}
+
+void CInputRecorder::Flush()
+{
+	if(m_BufferSize)
+		io_write(m_File, m_aBuffer, m_BufferSize);
+	m_BufferSize = 0;
+}
+
+void CInputRecorder::AddInt(int Value)
+{
+	if(!m_File)
+		return;
+	if(m_BufferSize > (int)sizeof(m_aBuffer)-16)
+		Flush();
+	m_BufferSize = CVariableInt::Pack(m_aBuffer+m_BufferSize, Value) - m_aBuffer;
+}
+
+void CInputRecorder::AddRaw(const void *pData, int Size)
+{
+	if(!m_File)
+		return;
+	AddInt(Size);
+	if(m_BufferSize+Size > (int)sizeof(m_aBuffer))
+	{
+		Flush();
+		if(Size > (int)sizeof(m_aBuffer))
+		{
+			io_write(m_File, pData, Size);
+			return;
+		}
+	}
+	mem_copy(m_aBuffer+m_BufferSize, pData, Size);
+	m_BufferSize += Size;
+}
+
+void CInputRecorder::AddString(const char *pStr)
+{
+	// with the terminator, so that the player can hand it out as is
+	AddRaw(pStr, str_length(pStr)+1);
+}
+
+void CInputRecorder::WriteConfig()
+{
+	static char s_aConfig[64*1024];
+	char aLine[1024];
+	char aEscaped[512];
+	s_aConfig[0] = 0;
+
+	#define MACRO_CONFIG_INT(Name,ScriptName,def,min,max,flags,desc) \
+		if(((flags)&CFGFLAG_SERVER) && g_Config.m_##Name != int(def)) \
+		{ \
+			str_format(aLine, sizeof(aLine), "%s %i\n", #ScriptName, g_Config.m_##Name); \
+			str_append(s_aConfig, aLine, sizeof(s_aConfig)); \
+		}
+	#define MACRO_CONFIG_STR(Name,ScriptName,len,def,flags,desc) \
+		if(((flags)&CFGFLAG_SERVER) && str_comp(g_Config.m_##Name, def) != 0 && !str_find(#ScriptName, "password")) \
+		{ \
+			char *pDst = aEscaped; \
+			for(const char *pSrc = g_Config.m_##Name; *pSrc && pDst < aEscaped+sizeof(aEscaped)-2; ) \
+			{ \
+				if(*pSrc == '"' || *pSrc == '\\') \
+					*pDst++ = '\\'; \
+				*pDst++ = *pSrc++; \
+			} \
+			*pDst = 0; \
+			str_format(aLine, sizeof(aLine), "%s \"%s\"\n", #ScriptName, aEscaped); \
+			str_append(s_aConfig, aLine, sizeof(s_aConfig)); \
+		}
+
+	#include "config_variables.h"
+
+	#undef MACRO_CONFIG_INT
+	#undef MACRO_CONFIG_STR
+
+	AddString(s_aConfig);
+}
+
+int CInputRecorder::Start(class IStorage *pStorage, const char *pFilename, const char *pNetVersion, const char *pMap, SHA256_DIGEST Sha256, unsigned Crc)
+{
+	if(m_File)
+		return -1;
+
+	m_File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!m_File)
+	{
+		dbg_msg("input_recorder", "unable to open '%s' for recording", pFilename);
+		return -1;
+	}
+
+	m_BufferSize = 0;
+	mem_zero(m_aaaLastInput, sizeof(m_aaaLastInput));
+	for(int i = 0; i < MAX_CLIENTS; i++)
+		m_aLastLatency[i] = 0;
+
+	mem_copy(m_aBuffer, gs_aHeaderMarker, sizeof(gs_aHeaderMarker));
+	m_BufferSize = sizeof(gs_aHeaderMarker);
+	AddInt(gs_ActVersion);
+	AddString(pNetVersion);
+	AddString(pMap);
+	AddInt((int)Crc);
+	AddRaw(Sha256.data, sizeof(Sha256.data));
+	WriteConfig();
+	Flush();
+
+	dbg_msg("input_recorder", "recording inputs to '%s'", pFilename);
+	return 0;
+}
+
+int CInputRecorder::Stop(unsigned StateHash)
+{
+	if(!m_File)
+		return -1;
+
+	AddInt(RECORD_END);
+	AddInt((int)StateHash);
+	Flush();
+	io_close(m_File);
+	m_File = 0;
+	dbg_msg("input_recorder", "recording stopped, state hash %08x", StateHash);
+	return 0;
+}
+
+void CInputRecorder::RecordConnect(int ClientID, bool AsSpec, int Version)
+{
+	AddInt(RECORD_CONNECT);
+	AddInt(ClientID);
+	AddInt(AsSpec);
+	AddInt(Version);
+
+	// a new client starts without any input
+	for(int i = 0; i < NUM_INPUTS; i++)
+		mem_zero(m_aaaLastInput[i][ClientID], sizeof(m_aaaLastInput[i][ClientID]));
+	m_aLastLatency[ClientID] = 0;
+}
+
+void CInputRecorder::RecordEnter(int ClientID)
+{
+	AddInt(RECORD_ENTER);
+	AddInt(ClientID);
+}
+
+void CInputRecorder::RecordDrop(int ClientID, const char *pReason)
+{
+	AddInt(RECORD_DROP);
+	AddInt(ClientID);
+	AddString(pReason);
+}
+
+void CInputRecorder::RecordMessage(int ClientID, const void *pData, int Size)
+{
+	AddInt(RECORD_MESSAGE);
+	AddInt(ClientID);
+	AddRaw(pData, Size);
+}
+
+void CInputRecorder::AddInput(int Type, int ClientID, const int *pInput)
+{
+	int *pLast = m_aaaLastInput[Type == RECORD_INPUT ? INPUT_PREDICTED : INPUT_DIRECT][ClientID];
+	unsigned Changed = 0;
+	for(int i = 0; i < INPUTRECORD_MAX_INPUT_SIZE; i++)
+	{
+		if(pInput[i] != pLast[i])
+			Changed |= 1u<<i;
+	}
+
+	AddInt(Type);
+	AddInt(ClientID);
+	AddInt((int)Changed);
+	for(int i = 0; i < INPUTRECORD_MAX_INPUT_SIZE; i++)
+	{
+		if(Changed&(1u<<i))
+		{
+			AddInt(pInput[i]);
+			pLast[i] = pInput[i];
+		}
+	}
+}
+
+void CInputRecorder::RecordLatency(int ClientID, int Latency)
+{
+	if(Latency == m_aLastLatency[ClientID])
+		return;
+	AddInt(RECORD_LATENCY);
+	AddInt(ClientID);
+	AddInt(Latency);
+	m_aLastLatency[ClientID] = Latency;
+}
+
+CInputPlayer::CInputPlayer()
+{
+	m_pData = 0;
+	m_DataSize = 0;
+	m_pStart = 0;
+	m_pCurrent = 0;
+	m_Error = false;
+	mem_zero(&m_Header, sizeof(m_Header));
+}
+
+CInputPlayer::~CInputPlayer()
+{
+	Unload();
+}
+
+int CInputPlayer::GetInt()
+{
+	// the data is padded, so unpacking can't read past it
+	if(m_pCurrent >= m_pData+m_DataSize)
+	{
+		m_Error = true;
+		return 0;
+	}
+	int Value;
+	m_pCurrent = CVariableInt::Unpack(m_pCurrent, &Value);
+	if(m_pCurrent > m_pData+m_DataSize)
+		m_Error = true;
+	return Value;
+}
+
+const void *CInputPlayer::GetRaw(int Size)
+{
+	if(Size < 0 || Size > m_pData+m_DataSize-m_pCurrent)
+	{
+		m_Error = true;
+		return 0;
+	}
+	const void *pData = m_pCurrent;
+	m_pCurrent += Size;
+	return pData;
+}
+
+const char *CInputPlayer::GetString()
+{
+	int Size = GetInt();
+	const char *pStr = (const char *)GetRaw(Size);
+	if(!pStr || Size < 1 || pStr[Size-1] != 0)
+	{
+		m_Error = true;
+		return "";
+	}
+	return pStr;
+}
+
+int CInputPlayer::Load(class IStorage *pStorage, const char *pFilename, int StorageType)
+{
+	Unload();
+
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
+	if(!File)
+	{
+		dbg_msg("input_player", "could not open '%s'", pFilename);
+		return -1;
+	}
+	m_DataSize = io_length(File);
+	m_pData = (unsigned char *)mem_alloc(m_DataSize+8, 1);
+	mem_zero(m_pData+m_DataSize, 8);
+	bool ReadFailed = m_DataSize < 0 || io_read(File, m_pData, m_DataSize) != (unsigned)m_DataSize;
+	io_close(File);
+
+	if(ReadFailed || m_DataSize < (int)sizeof(gs_aHeaderMarker) || mem_comp(m_pData, gs_aHeaderMarker, sizeof(gs_aHeaderMarker)) != 0)
+	{
+		dbg_msg("input_player", "'%s' is not an input recording", pFilename);
+		Unload();
+		return -1;
+	}
+
+	m_Error = false;
+	m_pCurrent = m_pData+sizeof(gs_aHeaderMarker);
+	int Version = GetInt();
+	if(Version != gs_ActVersion)
+	{
+		dbg_msg("input_player", "input recording version %d is not supported", Version);
+		Unload();
+		return -1;
+	}
+	str_copy(m_Header.m_aNetVersion, GetString(), sizeof(m_Header.m_aNetVersion));
+	str_copy(m_Header.m_aMap, GetString(), sizeof(m_Header.m_aMap));
+	m_Header.m_MapCrc = (unsigned)GetInt();
+	const void *pSha256 = GetRaw(GetInt() == (int)sizeof(m_Header.m_MapSha256.data) ? sizeof(m_Header.m_MapSha256.data) : -1);
+	if(pSha256)
+		mem_copy(m_Header.m_MapSha256.data, pSha256, sizeof(m_Header.m_MapSha256.data));
+	m_Header.m_pConfig = (char *)GetString();
+	if(m_Error)
+	{
+		dbg_msg("input_player", "'%s' has a broken header", pFilename);
+		Unload();
+		return -1;
+	}
+
+	m_pStart = m_pCurrent;
+	Rewind();
+	return 0;
+}
+
+void CInputPlayer::Unload()
+{
+	if(m_pData)
+		mem_free(m_pData);
+	m_pData = 0;
+	m_DataSize = 0;
+	m_pStart = 0;
+	m_pCurrent = 0;
+	mem_zero(&m_Header, sizeof(m_Header));
+}
+
+void CInputPlayer::Rewind()
+{
+	m_pCurrent = m_pStart;
+	m_Error = false;
+	mem_zero(m_aaaInput, sizeof(m_aaaInput));
+}
+
+int CInputPlayer::NextRecord(CRecord *pRecord)
+{
+	if(!m_pData || m_Error)
+		return -1;
+	if(m_pCurrent >= m_pData+m_DataSize)
+		return 0;
+
+	mem_zero(pRecord, sizeof(*pRecord));
+	pRecord->m_Type = GetInt();
+	switch(pRecord->m_Type)
+	{
+	case RECORD_TICK:
+	case RECORD_SNAP:
+		break;
+	case RECORD_CONNECT:
+		pRecord->m_ClientID = GetInt();
+		pRecord->m_Value = GetInt();
+		pRecord->m_Version = GetInt();
+		if(pRecord->m_ClientID >= 0 && pRecord->m_ClientID < MAX_CLIENTS)
+		{
+			for(int i = 0; i < NUM_INPUTS; i++)
+				mem_zero(m_aaaInput[i][pRecord->m_ClientID], sizeof(m_aaaInput[i][pRecord->m_ClientID]));
+		}
+		break;
+	case RECORD_ENTER:
+		pRecord->m_ClientID = GetInt();
+		break;
+	case RECORD_DROP:
+		pRecord->m_ClientID = GetInt();
+		pRecord->m_pData = GetString();
+		break;
+	case RECORD_MESSAGE:
+		pRecord->m_ClientID = GetInt();
+		pRecord->m_DataSize = GetInt();
+		pRecord->m_pData = GetRaw(pRecord->m_DataSize);
+		break;
+	case RECORD_INPUT:
+	case RECORD_DIRECT_INPUT:
+	{
+		pRecord->m_ClientID = GetInt();
+		unsigned Changed = (unsigned)GetInt();
+		if(pRecord->m_ClientID < 0 || pRecord->m_ClientID >= MAX_CLIENTS)
+		{
+			m_Error = true;
+			break;
+		}
+		int *pInput = m_aaaInput[pRecord->m_Type == RECORD_INPUT ? INPUT_PREDICTED : INPUT_DIRECT][pRecord->m_ClientID];
+		for(int i = 0; i < INPUTRECORD_MAX_INPUT_SIZE; i++)
+		{
+			if(Changed&(1u<<i))
+				pInput[i] = GetInt();
+		}
+		pRecord->m_pInput = pInput;
+		break;
+	}
+	case RECORD_LATENCY:
+		pRecord->m_ClientID = GetInt();
+		pRecord->m_Value = GetInt();
+		break;
+	case RECORD_END:
+		pRecord->m_Value = GetInt();
+		break;
+	default:
+		m_Error = true;
+	}
+
+	if(pRecord->m_ClientID < 0 || pRecord->m_ClientID >= MAX_CLIENTS)
+		m_Error = true;
+	return m_Error ? -1 : 1;
+}
@@ -0,0 +1,138 @@
+#ifndef ENGINE_SHARED_INPUTRECORD_H
+#define ENGINE_SHARED_INPUTRECORD_H
+
+#include <base/hash.h>
+#include <base/system.h>
+
+#include "protocol.h"
+
+/*
+	Input recordings hold everything the game server got from its
+	clients since a map was loaded, in the order the engine passed it
+	on: connects, drops, game messages, direct and predicted inputs and
+	the ticks and snapshots in between. Replaying them into a fresh
+	game server reproduces the same game without any networking.
+
+	The file is a stream of variable length ints. Inputs only store
+	the fields that changed since the previous input of the client.
+*/
+enum
+{
+	INPUTRECORD_MAX_INPUT_SIZE=32,
+};
+
+class CInputRecord
+{
+public:
+	enum
+	{
+		RECORD_TICK=0,
+		RECORD_SNAP,
+		RECORD_CONNECT,
+		RECORD_ENTER,
+		RECORD_DROP,
+		RECORD_MESSAGE,
+		RECORD_INPUT,
+		RECORD_DIRECT_INPUT,
+		RECORD_LATENCY,
+		RECORD_END,
+		NUM_RECORDS,
+
+		INPUT_PREDICTED=0,
+		INPUT_DIRECT,
+		NUM_INPUTS,
+	};
+
+	struct CHeader
+	{
+		char m_aNetVersion[64];
+		char m_aMap[64];
+		unsigned m_MapCrc;
+		SHA256_DIGEST m_MapSha256;
+		// non-default server settings, one per line
+		char *m_pConfig;
+	};
+
+	struct CRecord
+	{
+		int m_Type;
+		int m_ClientID;
+		// spectator flag of connects, latency, state hash at the end
+		int m_Value;
+		// client version of connects
+		int m_Version;
+		const int *m_pInput;
+		const void *m_pData;
+		int m_DataSize;
+	};
+
+	// hash of a snapshot of the whole game as built for demos, leaving
+	// out the snap ids that depend on timing
+	static unsigned StateHash(const class CSnapshot *pSnap);
+};
+
+class CInputRecorder : public CInputRecord
+{
+	IOHANDLE m_File;
+	unsigned char m_aBuffer[64*1024];
+	int m_BufferSize;
+	int m_aaaLastInput[NUM_INPUTS][MAX_CLIENTS][INPUTRECORD_MAX_INPUT_SIZE];
+	int m_aLastLatency[MAX_CLIENTS];
+
+	void Flush();
+	void AddInt(int Value);
+	void AddRaw(const void *pData, int Size);
+	void AddString(const char *pStr);
+	void AddInput(int Type, int ClientID, const int *pInput);
+	void WriteConfig();
+
+public:
+	CInputRecorder();
+	~CInputRecorder();
+
+	int Start(class IStorage *pStorage, const char *pFilename, const char *pNetVersion, const char *pMap, SHA256_DIGEST Sha256, unsigned Crc);
+	// the state hash lets a replay verify that it ended up in the same game
+	int Stop(unsigned StateHash);
+
+	void RecordTick() { AddInt(RECORD_TICK); }
+	void RecordSnap() { AddInt(RECORD_SNAP); }
+	void RecordConnect(int ClientID, bool AsSpec, int Version);
+	void RecordEnter(int ClientID);
+	void RecordDrop(int ClientID, const char *pReason);
+	void RecordMessage(int ClientID, const void *pData, int Size);
+	void RecordInput(int ClientID, const int *pInput) { AddInput(RECORD_INPUT, ClientID, pInput); }
+	void RecordDirectInput(int ClientID, const int *pInput) { AddInput(RECORD_DIRECT_INPUT, ClientID, pInput); }
+	void RecordLatency(int ClientID, int Latency);
+
+	bool IsRecording() const { return m_File != 0; }
+};
+
+class CInputPlayer : public CInputRecord
+{
+	unsigned char *m_pData;
+	int m_DataSize;
+	const unsigned char *m_pStart;
+	const unsigned char *m_pCurrent;
+	CHeader m_Header;
+	int m_aaaInput[NUM_INPUTS][MAX_CLIENTS][MAX_INPUT_SIZE];
+	bool m_Error;
+
+	int GetInt();
+	const void *GetRaw(int Size);
+	const char *GetString();
+
+public:
+	CInputPlayer();
+	~CInputPlayer();
+
+	int Load(class IStorage *pStorage, const char *pFilename, int StorageType);
+	void Unload();
+	const CHeader *Header() const { return &m_Header; }
+
+	// starts over with the first record
+	void Rewind();
+	// returns 1 for a record, 0 at the end and -1 for a broken file
+	int NextRecord(CRecord *pRecord);
+};
+
+#endif
@@ -1,89 +1,247 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
 #include "jobs.h"
 
+#include <thread>
+
+class CJobQueue
+{
+public:
+	std::mutex m_Mutex;
+	CJob *m_apFirst[CJob::NUM_PRIORITIES];
+	CJob *m_apLast[CJob::NUM_PRIORITIES];
+
+	CJobQueue()
+	{
+		for(int i = 0; i < CJob::NUM_PRIORITIES; i++)
+		{
+			m_apFirst[i] = 0;
+			m_apLast[i] = 0;
+		}
+	}
+
+	void Unlink(CJob *pJob);
+};
+
+void CJobQueue::Unlink(CJob *pJob)
+{
+	if(pJob->m_pPrev)
+		pJob->m_pPrev->m_pNext = pJob->m_pNext;
+	else
+		m_apFirst[pJob->m_Priority] = pJob->m_pNext;
+	if(pJob->m_pNext)
+		pJob->m_pNext->m_pPrev = pJob->m_pPrev;
+	else
+		m_apLast[pJob->m_Priority] = pJob->m_pPrev;
+	pJob->m_pPrev = 0;
+	pJob->m_pNext = 0;
+}
+
+// the worker of the current thread, so that jobs added by jobs stay on the same worker
+static thread_local const void *gs_pCurrentPool = 0;
+static thread_local int gs_CurrentWorker = -1;
+
 CJobPool::CJobPool()
 {
 	// empty the pool
 	m_NumThreads = 0;
+	m_pQueues = new CJobQueue[MAX_THREADS];
+	m_NextQueue = 0;
 	m_Shutdown = false;
-	m_Lock = lock_create();
-	m_pFirstJob = 0;
-	m_pLastJob = 0;
+	m_NumWakeups = 0;
 }
 
 CJobPool::~CJobPool()
 {
-	m_Shutdown = true;
+	{
+		std::lock_guard<std::mutex> Lock(m_WakeMutex);
+		m_Shutdown = true;
+	}
+	m_WakeCondition.notify_all();
 	for(int i = 0; i < m_NumThreads; i++)
 	{
 		thread_wait(m_apThreads[i]);
 		thread_destroy(m_apThreads[i]);
 	}
-	lock_destroy(m_Lock);
+
+	// jobs that never ran count as cancelled
+	for(int i = 0; i < MAX_THREADS; i++)
+	{
+		for(int p = 0; p < CJob::NUM_PRIORITIES; p++)
+		{
+			while(CJob *pJob = m_pQueues[i].m_apFirst[p])
+			{
+				m_pQueues[i].Unlink(pJob);
+				std::shared_ptr<CJob> pSelf;
+				pSelf.swap(pJob->m_pSelf);
+				pJob->m_Cancelled = true;
+				pJob->m_Status = CJob::STATE_DONE;
+			}
+		}
+	}
+	delete[] m_pQueues;
 }
 
 void CJobPool::WorkerThread(void *pUser)
 {
-	CJobPool *pPool = (CJobPool *)pUser;
+	CWorker *pWorker = (CWorker *)pUser;
+	CJobPool *pPool = pWorker->m_pPool;
+	gs_pCurrentPool = pPool;
+	gs_CurrentWorker = pWorker->m_Index;
 
-	while(!pPool->m_Shutdown)
+	while(1)
 	{
-		CJob *pJob = 0;
-
-		// fetch job from queue
-		lock_wait(pPool->m_Lock);
-		if(pPool->m_pFirstJob)
+		// every added job wakes up one worker, which might find it taken by
+		// another one already, but then that one used up a wakeup too
 		{
-			pJob = pPool->m_pFirstJob;
-			pPool->m_pFirstJob = pPool->m_pFirstJob->m_pNext;
-			if(pPool->m_pFirstJob)
-				pPool->m_pFirstJob->m_pPrev = 0;
-			else
-				pPool->m_pLastJob = 0;
+			std::unique_lock<std::mutex> Lock(pPool->m_WakeMutex);
+			pPool->m_WakeCondition.wait(Lock, [pPool]() { return pPool->m_NumWakeups > 0 || pPool->m_Shutdown; });
+			if(pPool->m_Shutdown)
+				break;
+			pPool->m_NumWakeups--;
 		}
-		lock_unlock(pPool->m_Lock);
 
-		// do the job if we have one
+		CJob *pJob = pPool->TakeJob(pWorker->m_Index);
 		if(pJob)
+			pPool->RunJob(pJob);
+	}
+}
+
+CJob *CJobPool::TakeJob(int Index)
+{
+	int NumQueues = max(m_NumThreads, 1);
+	for(int p = 0; p < CJob::NUM_PRIORITIES; p++)
+	{
+		// own queue first, then steal from the others
+		for(int i = 0; i < NumQueues; i++)
 		{
-			pJob->m_Status = CJob::STATE_RUNNING;
-			pJob->m_Result = pJob->m_pfnFunc(pJob->m_pFuncData);
-			pJob->m_Status = CJob::STATE_DONE;
+			CJobQueue *pQueue = &m_pQueues[(Index+i)%NumQueues];
+			std::lock_guard<std::mutex> Lock(pQueue->m_Mutex);
+			CJob *pJob = pQueue->m_apFirst[p];
+			if(pJob)
+			{
+				pQueue->Unlink(pJob);
+				pJob->m_Status = CJob::STATE_RUNNING;
+				return pJob;
+			}
 		}
+	}
+	return 0;
+}
+
+void CJobPool::RunJob(CJob *pJob)
+{
+	// the job might be gone as soon as it is done
+	std::shared_ptr<CJob> pSelf;
+	pSelf.swap(pJob->m_pSelf);
+	pJob->m_Result = pJob->m_pfnFunc(pJob->m_pFuncData);
+	pJob->m_Status = CJob::STATE_DONE;
+}
+
+void CJobPool::Queue(CJob *pJob, int Priority)
+{
+	int NumQueues = max(m_NumThreads, 1);
+	int Index;
+	if(gs_pCurrentPool == this)
+		Index = gs_CurrentWorker;
+	else
+		Index = m_NextQueue++%NumQueues;
+
+	CJobQueue *pQueue = &m_pQueues[Index];
+	pJob->m_pQueue = pQueue;
+	pJob->m_Priority = Priority;
+
+	{
+		std::lock_guard<std::mutex> Lock(pQueue->m_Mutex);
+		pJob->m_pPrev = pQueue->m_apLast[Priority];
+		pJob->m_pNext = 0;
+		if(pQueue->m_apLast[Priority])
+			pQueue->m_apLast[Priority]->m_pNext = pJob;
 		else
-			thread_sleep(10);
+			pQueue->m_apFirst[Priority] = pJob;
+		pQueue->m_apLast[Priority] = pJob;
 	}
 
+	{
+		std::lock_guard<std::mutex> Lock(m_WakeMutex);
+		m_NumWakeups++;
+	}
+	m_WakeCondition.notify_one();
 }
 
 int CJobPool::Init(int NumThreads)
 {
+	dbg_assert(m_NumThreads == 0, "job pool already started");
+
+	if(NumThreads <= 0)
+		NumThreads = max((int)std::thread::hardware_concurrency()-1, 1);
+
 	// start threads
 	m_NumThreads = NumThreads > MAX_THREADS ? MAX_THREADS : NumThreads;
 	for(int i = 0; i < m_NumThreads; i++)
-		m_apThreads[i] = thread_init(WorkerThread, this);
+	{
+		m_aWorkers[i].m_pPool = this;
+		m_aWorkers[i].m_Index = i;
+		m_apThreads[i] = thread_init(WorkerThread, &m_aWorkers[i]);
+	}
 	return 0;
 }
 
-int CJobPool::Add(CJob *pJob, JOBFUNC pfnFunc, void *pData)
+int CJobPool::Add(CJob *pJob, JOBFUNC pfnFunc, void *pData, int Priority)
 {
-	mem_zero(pJob, sizeof(CJob));
+	if(Priority < 0 || Priority >= CJob::NUM_PRIORITIES)
+		Priority = CJob::PRIORITY_NORMAL;
+
 	pJob->m_pfnFunc = pfnFunc;
 	pJob->m_pFuncData = pData;
+	pJob->m_Result = 0;
+	pJob->m_Cancelled = false;
+	pJob->m_Status = CJob::STATE_PENDING;
 
-	lock_wait(m_Lock);
+	Queue(pJob, Priority);
+	return 0;
+}
 
-	// add job to queue
-	pJob->m_pPrev = m_pLastJob;
-	if(m_pLastJob)
-		m_pLastJob->m_pNext = pJob;
-	m_pLastJob = pJob;
-	if(!m_pFirstJob)
-		m_pFirstJob = pJob;
+bool CJobPool::Cancel(CJob *pJob)
+{
+	CJobQueue *pQueue = pJob->m_pQueue;
+	if(!pQueue)
+		return false;
 
-	lock_unlock(m_Lock);
-	return 0;
+	std::shared_ptr<CJob> pSelf;
+	{
+		std::lock_guard<std::mutex> Lock(pQueue->m_Mutex);
+		if(pJob->m_Status != CJob::STATE_PENDING)
+			return false;
+
+		pQueue->Unlink(pJob);
+		pSelf.swap(pJob->m_pSelf);
+		pJob->m_Cancelled = true;
+		pJob->m_Status = CJob::STATE_DONE;
+	}
+	return true;
+}
+
+void CJobPool::RunOnMainThread(std::function<void()> Func)
+{
+	std::lock_guard<std::mutex> Lock(m_MainThreadMutex);
+	m_aMainThreadJobs.push_back(std::move(Func));
 }
 
+int CJobPool::RunMainThreadJobs()
+{
+	// functions queued by these run next time
+	std::vector<std::function<void()> > aJobs;
+	{
+		std::lock_guard<std::mutex> Lock(m_MainThreadMutex);
+		if(m_aMainThreadJobs.empty())
+			return 0;
+		aJobs.swap(m_aMainThreadJobs);
+	}
+
+	for(unsigned i = 0; i < aJobs.size(); i++)
+		aJobs[i]();
+	return aJobs.size();
+}
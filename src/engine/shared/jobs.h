@@ -2,6 +2,18 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #ifndef ENGINE_SHARED_JOBS_H
 #define ENGINE_SHARED_JOBS_H
+
+#include <base/system.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
 typedef int (*JOBFUNC)(void *pData);
 
 class CJobPool;
@@ -9,22 +21,47 @@ class CJobPool;
 class CJob
 {
 	friend class CJobPool;
+	friend class CJobQueue;
 
 	CJob *m_pPrev;
 	CJob *m_pNext;
+	class CJobQueue *m_pQueue;
+	int m_Priority;
 
-	volatile int m_Status;
-	volatile int m_Result;
+	std::atomic<int> m_Status;
+	std::atomic<bool> m_Cancelled;
+	int m_Result;
 
 	JOBFUNC m_pfnFunc;
 	void *m_pFuncData;
+
+	// jobs owned by the pool, released when they are done or cancelled
+	std::shared_ptr<CJob> m_pSelf;
+
 public:
 	CJob()
 	{
+		m_pPrev = 0;
+		m_pNext = 0;
+		m_pQueue = 0;
+		m_Priority = PRIORITY_NORMAL;
 		m_Status = STATE_DONE;
+		m_Cancelled = false;
+		m_Result = 0;
+		m_pfnFunc = 0;
 		m_pFuncData = 0;
 	}
 
+	// a copy has the outcome of the job, but it isn't queued itself
+	CJob(const CJob &Other) : CJob() { *this = Other; }
+	CJob &operator=(const CJob &Other)
+	{
+		m_Status = Other.m_Status.load();
+		m_Cancelled = Other.m_Cancelled.load();
+		m_Result = Other.m_Result;
+		return *this;
+	}
+
 	enum
 	{
 		STATE_PENDING=0,
@@ -32,10 +69,34 @@ public:
 		STATE_DONE
 	};
 
+	enum
+	{
+		PRIORITY_HIGH=0,
+		PRIORITY_NORMAL,
+		PRIORITY_LOW,
+		NUM_PRIORITIES
+	};
+
 	int Status() const { return m_Status; }
-	int Result() const {return m_Result; }
+	int Result() const { return m_Result; }
+	// the job was cancelled before it started, it is done without having run
+	bool Cancelled() const { return m_Cancelled; }
 };
 
+/*
+	Class: Job Pool
+		Runs jobs on a number of worker threads. Every worker has its
+		own queue with one list per priority. Jobs added by a worker go
+		to its own queue, other jobs are spread over the queues. A
+		worker without work takes the most important job of any queue,
+		looking at its own queue first.
+
+		Besides the plain C style jobs, Submit runs any callable and
+		returns a future for its result, and RunOnMainThread queues
+		work for the thread calling RunMainThreadJobs, which the server
+		does every tick and the client every frame. Workers use it to
+		hand results back to the game.
+*/
 class CJobPool
 {
 	enum
@@ -44,19 +105,92 @@ class CJobPool
 	};
 	int m_NumThreads;
 	void *m_apThreads[MAX_THREADS];
-	volatile bool m_Shutdown;
+	class CJobQueue *m_pQueues;
+	std::atomic<unsigned> m_NextQueue;
+	bool m_Shutdown;
+
+	// one wakeup per added job
+	std::mutex m_WakeMutex;
+	std::condition_variable m_WakeCondition;
+	int m_NumWakeups;
+
+	std::mutex m_MainThreadMutex;
+	std::vector<std::function<void()> > m_aMainThreadJobs;
+
+	template<typename T>
+	class CTask : public CJob
+	{
+	public:
+		std::packaged_task<T()> m_Task;
+		std::shared_future<T> m_Future;
+
+		template<typename F>
+		CTask(F &&Func) : m_Task(std::forward<F>(Func)), m_Future(m_Task.get_future()) {}
+
+		static int Run(void *pUser)
+		{
+			((CTask *)pUser)->m_Task();
+			return 0;
+		}
+	};
 
-	LOCK m_Lock;
-	CJob *m_pFirstJob;
-	CJob *m_pLastJob;
+	struct CWorker
+	{
+		CJobPool *m_pPool;
+		int m_Index;
+	};
+	CWorker m_aWorkers[MAX_THREADS];
 
 	static void WorkerThread(void *pUser);
+	CJob *TakeJob(int Index);
+	void RunJob(CJob *pJob);
+	void Queue(CJob *pJob, int Priority);
 
 public:
 	CJobPool();
 	~CJobPool();
 
+	// starts the workers, 0 picks one less than the number of cpu cores
 	int Init(int NumThreads);
-	int Add(CJob *pJob, JOBFUNC pfnFunc, void *pData);
+	int NumThreads() const { return m_NumThreads; }
+
+	int Add(CJob *pJob, JOBFUNC pfnFunc, void *pData, int Priority = CJob::PRIORITY_NORMAL);
+	// takes a job out of its queue if it didn't start yet, returns true if it won't run
+	bool Cancel(CJob *pJob);
+
+	template<typename T>
+	class CFuture
+	{
+		friend class CJobPool;
+		CJobPool *m_pPool;
+		std::shared_ptr<CTask<T> > m_pTask;
+
+	public:
+		CFuture() : m_pPool(0) {}
+
+		bool Valid() const { return m_pTask != 0; }
+		bool Done() const { return m_pTask->Status() == CJob::STATE_DONE; }
+		bool Cancelled() const { return m_pTask->Cancelled(); }
+		bool Cancel() { return m_pPool->Cancel(m_pTask.get()); }
+		// waits for the result, must not be called after a successful cancel
+		decltype(auto) Get() const { return m_pTask->m_Future.get(); }
+	};
+
+	template<typename F>
+	CFuture<typename std::invoke_result<F>::type> Submit(F &&Func, int Priority = CJob::PRIORITY_NORMAL)
+	{
+		typedef typename std::invoke_result<F>::type T;
+		CFuture<T> Future;
+		Future.m_pPool = this;
+		Future.m_pTask = std::make_shared<CTask<T> >(std::forward<F>(Func));
+		Future.m_pTask->m_pSelf = Future.m_pTask;
+		Add(Future.m_pTask.get(), CTask<T>::Run, Future.m_pTask.get(), Priority);
+		return Future;
+	}
+
+	// the function runs on the next call of RunMainThreadJobs, can be called from any thread
+	void RunOnMainThread(std::function<void()> Func);
+	// runs the functions queued so far, returns how many ran
+	int RunMainThreadJobs();
 };
 #endif
@@ -0,0 +1,106 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/system.h>
+
+#include "linequeue.h"
+
+// every record starts with its header, so records are padded to a size that
+// leaves room for a padding header at the end of the ring
+static const unsigned s_RecordAlignment = 32;
+
+CLineQueue::CLineQueue()
+{
+	m_pBuffer = 0;
+	m_Size = 0;
+	m_ReadPos = 0;
+	m_WritePos = 0;
+}
+
+CLineQueue::~CLineQueue()
+{
+	mem_free(m_pBuffer);
+}
+
+void CLineQueue::Init(int Size)
+{
+	dbg_assert(m_pBuffer == 0, "line queue already initialized");
+	m_Size = s_RecordAlignment;
+	while(m_Size < (unsigned)Size)
+		m_Size *= 2;
+	m_pBuffer = static_cast<unsigned char *>(mem_alloc(m_Size, sizeof(void*)));
+	m_ReadPos = 0;
+	m_WritePos = 0;
+}
+
+unsigned CLineQueue::RecordSize(int DataSize)
+{
+	return (sizeof(CItem)+DataSize+s_RecordAlignment-1) & ~(s_RecordAlignment-1);
+}
+
+bool CLineQueue::HasSpace(int DataSize) const
+{
+	unsigned Used = m_WritePos.load(std::memory_order_relaxed) - m_ReadPos.load(std::memory_order_acquire);
+	// the record might have to be preceded by a padding record of nearly the same size
+	return m_Size-Used >= 2*RecordSize(DataSize);
+}
+
+bool CLineQueue::Push(int Type, int ClientID, int Generation, const void *pData, int DataSize)
+{
+	unsigned Need = RecordSize(DataSize);
+	unsigned Write = m_WritePos.load(std::memory_order_relaxed);
+	unsigned Free = m_Size - (Write - m_ReadPos.load(std::memory_order_acquire));
+	unsigned Offset = Write & (m_Size-1);
+	unsigned Padding = m_Size-Offset < Need ? m_Size-Offset : 0;
+	if(Free < Padding+Need)
+		return false;
+
+	// records never wrap around, skip the rest of the ring instead
+	if(Padding)
+	{
+		CItem *pPadding = reinterpret_cast<CItem *>(m_pBuffer+Offset);
+		pPadding->m_RecordSize = Padding;
+		pPadding->m_Type = ITEM_PADDING;
+		Write += Padding;
+		Offset = 0;
+	}
+
+	CItem *pItem = reinterpret_cast<CItem *>(m_pBuffer+Offset);
+	pItem->m_RecordSize = Need;
+	pItem->m_Type = Type;
+	pItem->m_ClientID = ClientID;
+	pItem->m_Generation = Generation;
+	pItem->m_DataSize = DataSize;
+	if(DataSize)
+		mem_copy(pItem+1, pData, DataSize);
+
+	m_WritePos.store(Write+Need, std::memory_order_release);
+	return true;
+}
+
+bool CLineQueue::PushString(int Type, int ClientID, int Generation, const char *pStr)
+{
+	return Push(Type, ClientID, Generation, pStr, str_length(pStr)+1);
+}
+
+const CLineQueue::CItem *CLineQueue::Front()
+{
+	unsigned Read = m_ReadPos.load(std::memory_order_relaxed);
+	while(Read != m_WritePos.load(std::memory_order_acquire))
+	{
+		const CItem *pItem = reinterpret_cast<const CItem *>(m_pBuffer+(Read&(m_Size-1)));
+		if(pItem->m_Type != ITEM_PADDING)
+			return pItem;
+		Read += pItem->m_RecordSize;
+		m_ReadPos.store(Read, std::memory_order_release);
+	}
+	return 0;
+}
+
+void CLineQueue::Pop()
+{
+	if(!Front())
+		return;
+	unsigned Read = m_ReadPos.load(std::memory_order_relaxed);
+	const CItem *pItem = reinterpret_cast<const CItem *>(m_pBuffer+(Read&(m_Size-1)));
+	m_ReadPos.store(Read+pItem->m_RecordSize, std::memory_order_release);
+}
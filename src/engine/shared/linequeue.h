@@ -0,0 +1,64 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SHARED_LINEQUEUE_H
+#define ENGINE_SHARED_LINEQUEUE_H
+
+#include <atomic>
+
+/*
+	Class: Line Queue
+		Bounded lock-free queue of variable sized items between exactly
+		one producer and one consumer thread. Items are copied into a
+		ring buffer and never block the producer, <Push> fails instead
+		when the queue is full.
+*/
+class CLineQueue
+{
+public:
+	class CItem
+	{
+		friend class CLineQueue;
+		int m_RecordSize;
+	public:
+		int m_Type;
+		int m_ClientID;
+		int m_Generation;
+		int m_DataSize;
+
+		const void *Data() const { return this+1; }
+	};
+
+private:
+	enum
+	{
+		ITEM_PADDING=-1,
+	};
+
+	unsigned char *m_pBuffer;
+	unsigned m_Size;
+
+	// both only ever grow, the ring position is taken modulo m_Size
+	std::atomic<unsigned> m_ReadPos;
+	std::atomic<unsigned> m_WritePos;
+
+	static unsigned RecordSize(int DataSize);
+
+public:
+	CLineQueue();
+	~CLineQueue();
+
+	// Size is rounded up to a power of two
+	void Init(int Size);
+	bool IsInitialized() const { return m_pBuffer != 0; }
+
+	// producer side
+	bool HasSpace(int DataSize) const;
+	bool Push(int Type, int ClientID, int Generation, const void *pData, int DataSize);
+	bool PushString(int Type, int ClientID, int Generation, const char *pStr);
+
+	// consumer side, the item stays valid until it is popped
+	const CItem *Front();
+	void Pop();
+};
+
+#endif
@@ -3,7 +3,9 @@
 #include <engine/console.h>
 #include <engine/storage.h>
 #include <engine/shared/config.h>
+#include <engine/shared/linereader.h>
 
+#include "blocklist.h"
 #include "netban.h"
 
 
@@ -18,55 +20,106 @@ bool CNetBan::StrAllnum(const char *pStr)
 	return true;
 }
 
-
-CNetBan::CNetHash::CNetHash(const NETADDR *pAddr)
+int NetRangeFromStr(const char *pEntry, CNetRange *pRange)
 {
-	if(pAddr->type==NETTYPE_IPV4)
-		m_Hash = (pAddr->ip[0]+pAddr->ip[1]+pAddr->ip[2]+pAddr->ip[3])&0xFF;
-	else
-		m_Hash = (pAddr->ip[0]+pAddr->ip[1]+pAddr->ip[2]+pAddr->ip[3]+pAddr->ip[4]+pAddr->ip[5]+pAddr->ip[6]+pAddr->ip[7]+
-			pAddr->ip[8]+pAddr->ip[9]+pAddr->ip[10]+pAddr->ip[11]+pAddr->ip[12]+pAddr->ip[13]+pAddr->ip[14]+pAddr->ip[15])&0xFF;
-	m_HashIndex = 0;
-}
+	char aLB[128], aUB[128];
+	const char *pSeparator = str_find(pEntry, "-");
+	const char *pSlash = str_find(pEntry, "/");
+	const char *pEnd = pSeparator ? pSeparator : pSlash ? pSlash : pEntry+str_length(pEntry);
+	str_copy(aLB, pEntry, min((int)sizeof(aLB), (int)(pEnd-pEntry)+1));
+	str_copy(aUB, pSeparator ? pSeparator+1 : "", sizeof(aUB));
+
+	// addresses with more than one colon are IPv6, which needs brackets
+	char *apAddr[2] = { aLB, aUB };
+	for(int i = 0; i < 2; i++)
+	{
+		const char *pColon = str_find(apAddr[i], ":");
+		if(apAddr[i][0] != '[' && pColon && str_find(pColon+1, ":"))
+		{
+			char aBuf[128];
+			str_format(aBuf, sizeof(aBuf), "[%s]", apAddr[i]);
+			str_copy(apAddr[i], aBuf, sizeof(aLB));
+		}
+	}
 
-CNetBan::CNetHash::CNetHash(const CNetRange *pRange)
-{
-	m_Hash = 0;
-	m_HashIndex = 0;
-	for(int i = 0; pRange->m_LB.ip[i] == pRange->m_UB.ip[i]; ++i)
+	if(net_addr_from_str(&pRange->m_LB, aLB) != 0)
+		return 0;
+	int AddrBits = pRange->m_LB.type == NETTYPE_IPV4 ? 32 : 128;
+
+	if(pSeparator)
 	{
-		m_Hash += pRange->m_LB.ip[i];
-		++m_HashIndex;
+		if(net_addr_from_str(&pRange->m_UB, aUB) != 0 || !pRange->IsValid())
+			return 0;
+		return 2;
 	}
-	m_Hash &= 0xFF;
-}
 
-int CNetBan::CNetHash::MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17])
-{
-	int Length = pAddr->type==NETTYPE_IPV4 ? 4 : 16;
-	aHash[0].m_Hash = 0;
-	aHash[0].m_HashIndex = 0;
-	for(int i = 1, Sum = 0; i <= Length; ++i)
+	pRange->m_UB = pRange->m_LB;
+	int Bits = AddrBits;
+	if(pSlash)
+	{
+		for(const char *p = pSlash+1; *p; p++)
+		{
+			if(*p < '0' || *p > '9')
+				return 0;
+		}
+		if(!pSlash[1])
+			return 0;
+		Bits = str_toint(pSlash+1);
+		if(Bits < 0 || Bits > AddrBits)
+			return 0;
+	}
+	if(Bits == AddrBits)
+		return 1;
+
+	for(int i = Bits; i < AddrBits; i++)
 	{
-		Sum += pAddr->ip[i-1];
-		aHash[i].m_Hash = Sum&0xFF;
-		aHash[i].m_HashIndex = i%Length;
+		pRange->m_LB.ip[i/8] &= ~(0x80>>(i%8));
+		pRange->m_UB.ip[i/8] |= 0x80>>(i%8);
 	}
-	return Length;
+	return 2;
 }
 
 
-template<class T, int HashCount>
-typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData, const CBanInfo *pInfo,  const CNetHash *pNetHash)
+template<class T>
+CNetBan::CBanPool<T>::CBanPool()
+{
+	m_pFirstChunk = 0;
+	m_pFirstFree = 0;
+	m_pFirstUsed = 0;
+	m_CountUsed = 0;
+}
+
+template<class T>
+CNetBan::CBanPool<T>::~CBanPool()
+{
+	Reset();
+}
+
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Add(const T *pData, const CBanInfo *pInfo)
 {
 	if(!m_pFirstFree)
-		return 0;
+	{
+		// allocate another chunk of bans, the ones in use never move
+		CChunk *pChunk = static_cast<CChunk *>(mem_alloc(sizeof(CChunk), sizeof(void*)));
+		if(!pChunk)
+			return 0;
+		mem_zero(pChunk, sizeof(CChunk));
+		pChunk->m_pNext = m_pFirstChunk;
+		m_pFirstChunk = pChunk;
+
+		for(int i = 0; i < CHUNK_SIZE; ++i)
+		{
+			pChunk->m_aBans[i].m_pNext = i < CHUNK_SIZE-1 ? &pChunk->m_aBans[i+1] : 0;
+			pChunk->m_aBans[i].m_pPrev = i > 0 ? &pChunk->m_aBans[i-1] : 0;
+		}
+		m_pFirstFree = &pChunk->m_aBans[0];
+	}
 
 	// create new ban
 	CBan<T> *pBan = m_pFirstFree;
 	pBan->m_Data = *pData;
 	pBan->m_Info = *pInfo;
-	pBan->m_NetHash = *pNetHash;
 	if(pBan->m_pNext)
 		pBan->m_pNext->m_pPrev = pBan->m_pPrev;
 	if(pBan->m_pPrev)
@@ -74,12 +127,8 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData,
 	else
 		m_pFirstFree = pBan->m_pNext;
 
-	// add it to the hash list
-	if(m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash])
-		m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]->m_pHashPrev = pBan;
-	pBan->m_pHashPrev = 0;
-	pBan->m_pHashNext = m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash];
-	m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash] = pBan;
+	// add it to the lookup trie
+	m_Trie.InsertRange(NetLB(pData), NetUB(pData), pBan);
 
 	// insert it into the used list
 	if(m_pFirstUsed)
@@ -121,20 +170,14 @@ typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Add(const T *pData,
 	return pBan;
 }
 
-template<class T, int HashCount>
-int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
+template<class T>
+int CNetBan::CBanPool<T>::Remove(CBan<T> *pBan)
 {
 	if(pBan == 0)
 		return -1;
 
-	// remove from hash list
-	if(pBan->m_pHashNext)
-		pBan->m_pHashNext->m_pHashPrev = pBan->m_pHashPrev;
-	if(pBan->m_pHashPrev)
-		pBan->m_pHashPrev->m_pHashNext = pBan->m_pHashNext;
-	else
-		m_paaHashList[pBan->m_NetHash.m_HashIndex][pBan->m_NetHash.m_Hash] = pBan->m_pHashNext;
-	pBan->m_pHashNext = pBan->m_pHashPrev = 0;
+	// remove from lookup trie
+	m_Trie.RemoveRange(NetLB(&pBan->m_Data), NetUB(&pBan->m_Data), pBan);
 
 	// remove from used list
 	if(pBan->m_pNext)
@@ -157,8 +200,8 @@ int CNetBan::CBanPool<T, HashCount>::Remove(CBan<T> *pBan)
 	return 0;
 }
 
-template<class T, int HashCount>
-void CNetBan::CBanPool<T, HashCount>::Update(CBan<CDataType> *pBan, const CBanInfo *pInfo)
+template<class T>
+void CNetBan::CBanPool<T>::Update(CBan<CDataType> *pBan, const CBanInfo *pInfo)
 {
 	pBan->m_Info = *pInfo;
 
@@ -205,27 +248,23 @@ void CNetBan::CBanPool<T, HashCount>::Update(CBan<CDataType> *pBan, const CBanIn
 	}
 }
 
-template<class T, int HashCount>
-void CNetBan::CBanPool<T, HashCount>::Reset()
+template<class T>
+void CNetBan::CBanPool<T>::Reset()
 {
-	mem_zero(m_paaHashList, sizeof(m_paaHashList));
-	mem_zero(m_aBans, sizeof(m_aBans));
-	m_pFirstUsed = 0;
-	m_CountUsed = 0;
-
-	for(int i = 1; i < MAX_BANS-1; ++i)
+	while(m_pFirstChunk)
 	{
-		m_aBans[i].m_pNext = &m_aBans[i+1];
-		m_aBans[i].m_pPrev = &m_aBans[i-1];
+		CChunk *pNext = m_pFirstChunk->m_pNext;
+		mem_free(m_pFirstChunk);
+		m_pFirstChunk = pNext;
 	}
-
-	m_aBans[0].m_pNext = &m_aBans[1];
-	m_aBans[MAX_BANS-1].m_pPrev = &m_aBans[MAX_BANS-2];
-	m_pFirstFree = &m_aBans[0];
+	m_Trie.Clear();
+	m_pFirstFree = 0;
+	m_pFirstUsed = 0;
+	m_CountUsed = 0;
 }
 
-template<class T, int HashCount>
-typename CNetBan::CBan<T> *CNetBan::CBanPool<T, HashCount>::Get(int Index) const
+template<class T>
+typename CNetBan::CBan<T> *CNetBan::CBanPool<T>::Get(int Index) const
 {
 	if(Index < 0 || Index >= Num())
 		return 0;
@@ -310,37 +349,41 @@ int CNetBan::Ban(T *pBanPool, const typename T::CDataType *pData, int Seconds, c
 	str_copy(Info.m_aReason, pReason, sizeof(Info.m_aReason));
 
 	// check if it already exists
-	CNetHash NetHash(pData);
-	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData, &NetHash);
+	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData);
 	if(pBan)
 	{
 		// adjust the ban
 		pBanPool->Update(pBan, &Info);
-		char aBuf[128];
-		MakeBanInfo(pBan, aBuf, sizeof(aBuf), MSGTYPE_LIST);
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		if(!m_Quiet)
+		{
+			char aBuf[128];
+			MakeBanInfo(pBan, aBuf, sizeof(aBuf), MSGTYPE_LIST);
+			Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		}
 		return 1;
 	}
 
 	// add ban and print result
-	pBan = pBanPool->Add(pData, &Info, &NetHash);
+	pBan = pBanPool->Add(pData, &Info);
 	if(pBan)
 	{
-		char aBuf[128];
-		MakeBanInfo(pBan, aBuf, sizeof(aBuf), MSGTYPE_BANADD);
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		if(!m_Quiet)
+		{
+			char aBuf[128];
+			MakeBanInfo(pBan, aBuf, sizeof(aBuf), MSGTYPE_BANADD);
+			Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		}
 		return 0;
 	}
 	else
-		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", "ban failed (full banlist)");
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", "ban failed (out of memory)");
 	return -1;
 }
 
 template<class T>
 int CNetBan::Unban(T *pBanPool, const typename T::CDataType *pData)
 {
-	CNetHash NetHash(pData);
-	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData, &NetHash);
+	CBan<typename T::CDataType> *pBan = pBanPool->Find(pData);
 	if(pBan)
 	{
 		char aBuf[256];
@@ -354,10 +397,31 @@ int CNetBan::Unban(T *pBanPool, const typename T::CDataType *pData)
 	return -1;
 }
 
+CNetBan::CNetBan()
+{
+	m_pBlocklist = 0;
+	m_pNewBlocklist = 0;
+	m_aBlocklistFile[0] = 0;
+	m_aBlocklistLoadFile[0] = 0;
+	m_aBlocklistError[0] = 0;
+	m_BlocklistLastInfoQuery = 0;
+	m_pBlocklistThread = 0;
+	m_BlocklistState = BLOCKLIST_IDLE;
+}
+
+CNetBan::~CNetBan()
+{
+	if(m_pBlocklistThread)
+		thread_wait(m_pBlocklistThread);
+	delete m_pBlocklist;
+	delete m_pNewBlocklist;
+}
+
 void CNetBan::Init(IConsole *pConsole, IStorage *pStorage)
 {
 	m_pConsole = pConsole;
 	m_pStorage = pStorage;
+	m_Quiet = false;
 	m_BanAddrPool.Reset();
 	m_BanRangePool.Reset();
 
@@ -369,12 +433,73 @@ void CNetBan::Init(IConsole *pConsole, IStorage *pStorage)
 	Console()->Register("unban_all", "", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConUnbanAll, this, "Unban all entries");
 	Console()->Register("bans", "", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConBans, this, "Show banlist");
 	Console()->Register("bans_save", "s", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConBansSave, this, "Save banlist in a file");
+	Console()->Register("bans_load", "s?ir", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConBansLoad, this, "Ban all addresses, CIDR blocks and ranges listed in a file for x minutes (0 = forever)");
+	Console()->Register("blocklist", "?s", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConBlocklist, this, "Attach a compiled blocklist file (empty to detach)");
+	Console()->Register("blocklist_reload", "", CFGFLAG_SERVER|CFGFLAG_MASTER|CFGFLAG_STORE, ConBlocklistReload, this, "Reload the attached blocklist file");
+}
+
+void CNetBan::LoadBlocklistThread(void *pUser)
+{
+	CNetBan *pThis = static_cast<CNetBan *>(pUser);
+
+	CBlocklist *pBlocklist = new CBlocklist();
+	if(!pBlocklist->Open(pThis->Storage(), pThis->m_aBlocklistLoadFile, pThis->m_aBlocklistError, sizeof(pThis->m_aBlocklistError)))
+	{
+		delete pBlocklist;
+		pBlocklist = 0;
+	}
+	pThis->m_pNewBlocklist = pBlocklist;
+	pThis->m_BlocklistState.store(BLOCKLIST_LOADED, std::memory_order_release);
+}
+
+void CNetBan::LoadBlocklist(const char *pFilename)
+{
+	if(m_BlocklistState.load(std::memory_order_acquire) != BLOCKLIST_IDLE)
+	{
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", "blocklist failed (already loading)");
+		return;
+	}
+
+	if(!pFilename[0])
+	{
+		delete m_pBlocklist;
+		m_pBlocklist = 0;
+		m_aBlocklistFile[0] = 0;
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", "blocklist detached");
+		return;
+	}
+
+	// the current blocklist stays in use until the new one is ready
+	str_copy(m_aBlocklistLoadFile, pFilename, sizeof(m_aBlocklistLoadFile));
+	m_BlocklistState.store(BLOCKLIST_LOADING, std::memory_order_relaxed);
+	m_pBlocklistThread = thread_init(LoadBlocklistThread, this);
 }
 
 void CNetBan::Update()
 {
 	int Now = time_timestamp();
 
+	// swap in a freshly loaded blocklist
+	if(m_BlocklistState.load(std::memory_order_acquire) == BLOCKLIST_LOADED)
+	{
+		thread_wait(m_pBlocklistThread);
+		m_pBlocklistThread = 0;
+
+		char aBuf[256];
+		if(m_pNewBlocklist)
+		{
+			delete m_pBlocklist;
+			m_pBlocklist = m_pNewBlocklist;
+			m_pNewBlocklist = 0;
+			str_copy(m_aBlocklistFile, m_aBlocklistLoadFile, sizeof(m_aBlocklistFile));
+			str_format(aBuf, sizeof(aBuf), "attached blocklist '%s' (%d ranges)", m_aBlocklistFile, m_pBlocklist->NumRanges());
+		}
+		else
+			str_format(aBuf, sizeof(aBuf), "failed to load blocklist '%s' (%s)", m_aBlocklistLoadFile, m_aBlocklistError);
+		Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		m_BlocklistState.store(BLOCKLIST_IDLE, std::memory_order_relaxed);
+	}
+
 	// remove expired bans
 	char aBuf[256], aNetStr[256];
 	while(m_BanAddrPool.First() && m_BanAddrPool.First()->m_Info.m_Expires != CBanInfo::EXPIRES_NEVER && m_BanAddrPool.First()->m_Info.m_Expires < Now)
@@ -469,11 +594,8 @@ bool CNetBan::IsBannable(const T *pData)
 
 bool CNetBan::IsBanned(const NETADDR *pAddr, char *pBuf, unsigned BufferSize, int *pLastInfoQuery)
 {
-	CNetHash aHash[17];
-	int Length = CNetHash::MakeHashArray(pAddr, aHash);
-
 	// check ban adresses
-	CBanAddr *pBan = m_BanAddrPool.Find(pAddr, &aHash[Length]);
+	CBanAddr *pBan = m_BanAddrPool.Match(pAddr);
 	if(pBan)
 	{
 		MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER, pLastInfoQuery);
@@ -481,18 +603,26 @@ bool CNetBan::IsBanned(const NETADDR *pAddr, char *pBuf, unsigned BufferSize, in
 	}
 
 	// check ban ranges
-	for(int i = Length-1; i >= 0; --i)
+	CBanRange *pBanRange = m_BanRangePool.Match(pAddr);
+	if(pBanRange)
+	{
+		MakeBanInfo(pBanRange, pBuf, BufferSize, MSGTYPE_PLAYER, pLastInfoQuery);
+		return true;
+	}
+
+	// check the blocklist, its entries share one info cooldown
+	if(m_pBlocklist && m_pBlocklist->Contains(pAddr))
 	{
-		for(CBanRange *pBan = m_BanRangePool.First(&aHash[i]); pBan; pBan = pBan->m_pHashNext)
+		if(pBuf)
+			str_copy(pBuf, "You have been banned for life (blocklisted)", BufferSize);
+		if(pLastInfoQuery)
 		{
-			if(NetMatch(&pBan->m_Data, pAddr, i, Length))
-			{
-				MakeBanInfo(pBan, pBuf, BufferSize, MSGTYPE_PLAYER, pLastInfoQuery);
-				return true;
-			}
+			*pLastInfoQuery = m_BlocklistLastInfoQuery;
+			m_BlocklistLastInfoQuery = time_timestamp();
 		}
+		return true;
 	}
-	
+
 	return false;
 }
 
@@ -587,6 +717,11 @@ void CNetBan::ConBans(IConsole::IResult *pResult, void *pUser)
 	}
 	str_format(aMsg, sizeof(aMsg), "%d %s", Count, Count==1?"ban":"bans");
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aMsg);
+	if(pThis->m_pBlocklist)
+	{
+		str_format(aMsg, sizeof(aMsg), "blocklist '%s' with %d ranges", pThis->m_aBlocklistFile, pThis->m_pBlocklist->NumRanges());
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aMsg);
+	}
 }
 
 void CNetBan::ConBansSave(IConsole::IResult *pResult, void *pUser)
@@ -628,10 +763,95 @@ void CNetBan::ConBansSave(IConsole::IResult *pResult, void *pUser)
 	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
 }
 
-// explicitly instantiate template for src/engine/server/server.cpp
+void CNetBan::ConBansLoad(IConsole::IResult *pResult, void *pUser)
+{
+	CNetBan *pThis = static_cast<CNetBan *>(pUser);
+	char aBuf[256];
+	const char *pFilename = pResult->GetString(0);
+	const int Minutes = pResult->NumArguments() > 1 ? clamp(pResult->GetInteger(1), 0, 31*24*60) : 0;
+	const char *pDefaultReason = pResult->NumArguments() > 2 ? pResult->GetString(2) : "No reason given";
+
+	IOHANDLE File = pThis->Storage()->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
+	{
+		str_format(aBuf, sizeof(aBuf), "failed to load banlist from '%s'", pFilename);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+		return;
+	}
+
+	// one entry per line, optionally followed by a reason, '#' starts a comment
+	int NumAdded = 0, NumUpdated = 0, NumFailed = 0, NumInvalid = 0;
+	CLineReader LineReader;
+	LineReader.Init(File);
+	pThis->m_Quiet = true;
+	while(char *pLine = LineReader.Get())
+	{
+		char *pComment = (char *)str_find(pLine, "#");
+		if(pComment)
+			*pComment = 0;
+		char *pEntry = str_skip_whitespaces(pLine);
+		str_clean_whitespaces(pEntry);
+		if(!pEntry[0])
+			continue;
+
+		const char *pReason = pDefaultReason;
+		char *pEnd = str_skip_to_whitespace(pEntry);
+		if(*pEnd)
+		{
+			*pEnd = 0;
+			pReason = pEnd+1;
+		}
+
+		CNetRange Range;
+		int Result;
+		switch(NetRangeFromStr(pEntry, &Range))
+		{
+		case 1:
+			Result = pThis->BanAddr(&Range.m_LB, Minutes*60, pReason);
+			break;
+		case 2:
+			Result = pThis->BanRange(&Range, Minutes*60, pReason);
+			break;
+		default:
+			NumInvalid++;
+			continue;
+		}
+
+		if(Result == 0)
+			NumAdded++;
+		else if(Result == 1)
+			NumUpdated++;
+		else
+			NumFailed++;
+	}
+	pThis->m_Quiet = false;
+	io_close(File);
+
+	str_format(aBuf, sizeof(aBuf), "loaded banlist from '%s' (%d new, %d updated, %d failed, %d invalid lines)", pFilename, NumAdded, NumUpdated, NumFailed, NumInvalid);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", aBuf);
+}
+
+void CNetBan::ConBlocklist(IConsole::IResult *pResult, void *pUser)
+{
+	CNetBan *pThis = static_cast<CNetBan *>(pUser);
+	pThis->LoadBlocklist(pResult->NumArguments() ? pResult->GetString(0) : "");
+}
+
+void CNetBan::ConBlocklistReload(IConsole::IResult *pResult, void *pUser)
+{
+	CNetBan *pThis = static_cast<CNetBan *>(pUser);
+	if(pThis->m_aBlocklistFile[0])
+		pThis->LoadBlocklist(pThis->m_aBlocklistFile);
+	else
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "net_ban", "no blocklist attached");
+}
+
+// explicitly instantiate template for src/engine/server/server.cpp and src/mastersrv/mastersrv.cpp
+template class CNetBan::CBanPool<NETADDR>;
+template class CNetBan::CBanPool<CNetRange>;
 template void CNetBan::MakeBanInfo<CNetRange>(CBan<CNetRange> *pBan, char *pBuf, unsigned BufferSize, int Type, int *pLastInfoQuery);
 template void CNetBan::MakeBanInfo<NETADDR>(CBan<NETADDR> *pBan, char *pBuf, unsigned BufferSize, int Type, int *pLastInfoQuery);
-template int CNetBan::Ban<CNetBan::CBanPool<NETADDR, 1> >(CNetBan::CBanPool<NETADDR, 1> *pBanPool, const NETADDR *pData, int Seconds, const char *pReason);
-template int CNetBan::Ban<CNetBan::CBanPool<CNetRange, 16> >(CNetBan::CBanPool<CNetRange, 16> *pBanPool, const CNetRange *pData, int Seconds, const char *pReason);
+template int CNetBan::Ban<CNetBan::CBanPool<NETADDR> >(CNetBan::CBanPool<NETADDR> *pBanPool, const NETADDR *pData, int Seconds, const char *pReason);
+template int CNetBan::Ban<CNetBan::CBanPool<CNetRange> >(CNetBan::CBanPool<CNetRange> *pBanPool, const CNetRange *pData, int Seconds, const char *pReason);
 template bool CNetBan::IsBannable<NETADDR>(const NETADDR *pData);
 template bool CNetBan::IsBannable<CNetRange>(const CNetRange *pData);
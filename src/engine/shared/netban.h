@@ -3,6 +3,9 @@
 
 #include <base/system.h>
 
+#include "nettrie.h"
+
+#include <atomic>
 
 inline int NetComp(const NETADDR *pAddr1, const NETADDR *pAddr2)
 {
@@ -23,6 +26,16 @@ inline int NetComp(const CNetRange *pRange1, const CNetRange *pRange2)
 	return NetComp(&pRange1->m_LB, &pRange2->m_LB) || NetComp(&pRange1->m_UB, &pRange2->m_UB);
 }
 
+// bounds of the addresses covered by a ban
+inline const NETADDR *NetLB(const NETADDR *pAddr) { return pAddr; }
+inline const NETADDR *NetUB(const NETADDR *pAddr) { return pAddr; }
+inline const NETADDR *NetLB(const CNetRange *pRange) { return &pRange->m_LB; }
+inline const NETADDR *NetUB(const CNetRange *pRange) { return &pRange->m_UB; }
+
+// parses an address, a CIDR block (addr/bits) or a range (addr-addr) of a ban list file,
+// returns 1 for a single address (stored in m_LB), 2 for a range and 0 if the entry is invalid
+int NetRangeFromStr(const char *pEntry, CNetRange *pRange);
+
 
 class CNetBan
 {
@@ -63,19 +76,6 @@ protected:
 	// todo: move?
 	static bool StrAllnum(const char *pStr);
 
-	class CNetHash
-	{
-	public:
-		int m_Hash;
-		int m_HashIndex;	// matching parts for ranges, 0 for addr
-
-		CNetHash() {}	
-		CNetHash(const NETADDR *pAddr);
-		CNetHash(const CNetRange *pRange);
-
-		static int MakeHashArray(const NETADDR *pAddr, CNetHash aHash[17]);
-	};
-
 	struct CBanInfo
 	{
 		enum
@@ -92,59 +92,57 @@ protected:
 	{
 		T m_Data;
 		CBanInfo m_Info;
-		CNetHash m_NetHash;
-
-		// hash list
-		CBan *m_pHashNext;
-		CBan *m_pHashPrev;
 
 		// used or free list
 		CBan *m_pNext;
 		CBan *m_pPrev;
 	};
 
-	template<class T, int HashCount> class CBanPool
+	template<class T> class CBanPool
 	{
 	public:
 		typedef T CDataType;
 
-		CBan<CDataType> *Add(const CDataType *pData, const CBanInfo *pInfo, const CNetHash *pNetHash);
+		CBanPool();
+		~CBanPool();
+
+		CBan<CDataType> *Add(const CDataType *pData, const CBanInfo *pInfo);
 		int Remove(CBan<CDataType> *pBan);
 		void Update(CBan<CDataType> *pBan, const CBanInfo *pInfo);
 		void Reset();
-	
+
 		int Num() const { return m_CountUsed; }
-		bool IsFull() const { return m_CountUsed == MAX_BANS; }
 
 		CBan<CDataType> *First() const { return m_pFirstUsed; }
-		CBan<CDataType> *First(const CNetHash *pNetHash) const { return m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; }
-		CBan<CDataType> *Find(const CDataType *pData, const CNetHash *pNetHash) const
+		CBan<CDataType> *Find(const CDataType *pData) const
 		{
-			for(CBan<CDataType> *pBan = m_paaHashList[pNetHash->m_HashIndex][pNetHash->m_Hash]; pBan; pBan = pBan->m_pHashNext)
-			{
-				if(NetComp(&pBan->m_Data, pData) == 0)
-					return pBan;
-			}
-
-			return 0;
+			return m_Trie.FindRange(NetLB(pData), NetUB(pData), [pData](const CBan<CDataType> *pBan) { return NetComp(&pBan->m_Data, pData) == 0; });
 		}
+		// the most specific ban covering the address
+		CBan<CDataType> *Match(const NETADDR *pAddr) const { return m_Trie.Lookup(pAddr); }
 		CBan<CDataType> *Get(int Index) const;
 
 	private:
 		enum
 		{
-			MAX_BANS=1024,
+			CHUNK_SIZE=1024,
+		};
+
+		struct CChunk
+		{
+			CChunk *m_pNext;
+			CBan<CDataType> m_aBans[CHUNK_SIZE];
 		};
 
-		CBan<CDataType> *m_paaHashList[HashCount][256];
-		CBan<CDataType> m_aBans[MAX_BANS];
+		CChunk *m_pFirstChunk;
+		CNetTrie<CBan<CDataType> > m_Trie;
 		CBan<CDataType> *m_pFirstFree;
 		CBan<CDataType> *m_pFirstUsed;
 		int m_CountUsed;
 	};
 
-	typedef CBanPool<NETADDR, 1> CBanAddrPool;
-	typedef CBanPool<CNetRange, 16> CBanRangePool;
+	typedef CBanPool<NETADDR> CBanAddrPool;
+	typedef CBanPool<CNetRange> CBanRangePool;
 	typedef CBan<NETADDR> CBanAddr;
 	typedef CBan<CNetRange> CBanRange;
 	
@@ -157,6 +155,26 @@ protected:
 	CBanAddrPool m_BanAddrPool;
 	CBanRangePool m_BanRangePool;
 	NETADDR m_LocalhostIPV4, m_LocalhostIPV6;
+	bool m_Quiet;
+
+	// the blocklist file is opened by a thread and swapped in by Update
+	enum
+	{
+		BLOCKLIST_IDLE=0,
+		BLOCKLIST_LOADING,
+		BLOCKLIST_LOADED,
+	};
+	class CBlocklist *m_pBlocklist;
+	class CBlocklist *m_pNewBlocklist;
+	char m_aBlocklistFile[128];
+	char m_aBlocklistLoadFile[128];
+	char m_aBlocklistError[64];
+	int m_BlocklistLastInfoQuery;
+	void *m_pBlocklistThread;
+	std::atomic<int> m_BlocklistState;
+
+	static void LoadBlocklistThread(void *pUser);
+	void LoadBlocklist(const char *pFilename);
 
 public:
 	enum
@@ -170,7 +188,8 @@ public:
 	class IConsole *Console() const { return m_pConsole; }
 	class IStorage *Storage() const { return m_pStorage; }
 
-	virtual ~CNetBan() {}
+	CNetBan();
+	virtual ~CNetBan();
 	void Init(class IConsole *pConsole, class IStorage *pStorage);
 	void Update();
 
@@ -188,6 +207,9 @@ public:
 	static void ConUnbanAll(class IConsole::IResult *pResult, void *pUser);
 	static void ConBans(class IConsole::IResult *pResult, void *pUser);
 	static void ConBansSave(class IConsole::IResult *pResult, void *pUser);
+	static void ConBansLoad(class IConsole::IResult *pResult, void *pUser);
+	static void ConBlocklist(class IConsole::IResult *pResult, void *pUser);
+	static void ConBlocklistReload(class IConsole::IResult *pResult, void *pUser);
 };
 
 #endif
@@ -0,0 +1,368 @@
+#ifndef ENGINE_SHARED_NETTRIE_H
+#define ENGINE_SHARED_NETTRIE_H
+
+#include <base/math.h>
+#include <base/system.h>
+
+/*
+	Class: Net Trie
+		Compressed binary trie (patricia trie) over IPv4 and IPv6
+		prefixes. Values are stored at the node of their prefix, so
+		looking up the most specific prefix covering an address takes
+		at most one node per bit of the address.
+
+		Address ranges are stored as the smallest set of prefixes that
+		covers exactly the range.
+*/
+template<class T>
+class CNetTrie
+{
+	struct CNode
+	{
+		unsigned char m_aKey[16];
+		int m_Bits;
+		int m_aChild[2];
+		int m_FirstValue;
+	};
+
+	struct CValue
+	{
+		T *m_pValue;
+		int m_Next;
+	};
+
+	CNode *m_pNodes;
+	int m_NumNodes;
+	int m_NodesCapacity;
+	int m_FirstFreeNode;
+
+	CValue *m_pValues;
+	int m_NumValues;
+	int m_ValuesCapacity;
+	int m_FirstFreeValue;
+
+	int m_aRoot[2];
+
+	static int RootIndex(int Type) { return Type == NETTYPE_IPV4 ? 0 : 1; }
+	static int KeyBits(int Type) { return Type == NETTYPE_IPV4 ? 32 : 128; }
+	static int Bit(const unsigned char *pKey, int Index) { return (pKey[Index>>3]>>(7-(Index&7)))&1; }
+
+	// number of leading bits both keys have in common, at most MaxBits
+	static int CommonBits(const unsigned char *pKey1, const unsigned char *pKey2, int MaxBits)
+	{
+		int Bits = 0;
+		for(int i = 0; Bits < MaxBits; i++, Bits += 8)
+		{
+			int Diff = pKey1[i]^pKey2[i];
+			if(Diff)
+			{
+				while(!(Diff&0x80))
+				{
+					Diff <<= 1;
+					Bits++;
+				}
+				break;
+			}
+		}
+		return Bits < MaxBits ? Bits : MaxBits;
+	}
+
+	template<class TItem>
+	static void Grow(TItem **ppItems, int *pCapacity)
+	{
+		int NewCapacity = *pCapacity ? *pCapacity*2 : 64;
+		TItem *pNewItems = static_cast<TItem *>(mem_alloc(NewCapacity*sizeof(TItem), sizeof(void*)));
+		if(*ppItems)
+		{
+			mem_copy(pNewItems, *ppItems, *pCapacity*sizeof(TItem));
+			mem_free(*ppItems);
+		}
+		*ppItems = pNewItems;
+		*pCapacity = NewCapacity;
+	}
+
+	int NewNode(const unsigned char *pKey, int Bits)
+	{
+		int Index;
+		if(m_FirstFreeNode != -1)
+		{
+			Index = m_FirstFreeNode;
+			m_FirstFreeNode = m_pNodes[Index].m_aChild[0];
+		}
+		else
+		{
+			if(m_NumNodes == m_NodesCapacity)
+				Grow(&m_pNodes, &m_NodesCapacity);
+			Index = m_NumNodes++;
+		}
+
+		CNode *pNode = &m_pNodes[Index];
+		mem_zero(pNode->m_aKey, sizeof(pNode->m_aKey));
+		mem_copy(pNode->m_aKey, pKey, (Bits+7)/8);
+		if(Bits&7)
+			pNode->m_aKey[Bits/8] &= 0xff<<(8-(Bits&7));
+		pNode->m_Bits = Bits;
+		pNode->m_aChild[0] = pNode->m_aChild[1] = -1;
+		pNode->m_FirstValue = -1;
+		return Index;
+	}
+
+	void FreeNode(int Index)
+	{
+		m_pNodes[Index].m_aChild[0] = m_FirstFreeNode;
+		m_FirstFreeNode = Index;
+	}
+
+	void AddValue(int Node, T *pValue)
+	{
+		int Index;
+		if(m_FirstFreeValue != -1)
+		{
+			Index = m_FirstFreeValue;
+			m_FirstFreeValue = m_pValues[Index].m_Next;
+		}
+		else
+		{
+			if(m_NumValues == m_ValuesCapacity)
+				Grow(&m_pValues, &m_ValuesCapacity);
+			Index = m_NumValues++;
+		}
+		m_pValues[Index].m_pValue = pValue;
+		m_pValues[Index].m_Next = m_pNodes[Node].m_FirstValue;
+		m_pNodes[Node].m_FirstValue = Index;
+	}
+
+	// calls Func(pKey, Bits) for every prefix of the range, in ascending order
+	template<class F>
+	static void ForEachPrefix(const NETADDR *pLB, const NETADDR *pUB, F Func)
+	{
+		int Bytes = pLB->type == NETTYPE_IPV4 ? 4 : 16;
+		unsigned char aStart[16];
+		mem_copy(aStart, pLB->ip, Bytes);
+		while(true)
+		{
+			// largest aligned block starting at aStart that doesn't go beyond the upper bound
+			int Free = 0;
+			while(Free < Bytes*8 && !Bit(aStart, Bytes*8-1-Free))
+				Free++;
+			unsigned char aEnd[16];
+			while(true)
+			{
+				mem_copy(aEnd, aStart, Bytes);
+				for(int i = 0; i < Free; i++)
+					aEnd[Bytes-1-i/8] |= 1<<(i%8);
+				if(Free == 0 || mem_comp(aEnd, pUB->ip, Bytes) <= 0)
+					break;
+				Free--;
+			}
+			Func(aStart, Bytes*8-Free);
+
+			if(mem_comp(aEnd, pUB->ip, Bytes) >= 0)
+				break;
+
+			// aStart = aEnd+1
+			mem_copy(aStart, aEnd, Bytes);
+			for(int i = Bytes-1; i >= 0 && ++aStart[i] == 0; i--)
+				;
+		}
+	}
+
+	int FindNode(int Type, const unsigned char *pKey, int Bits, int *pPath, int *pPathLength) const
+	{
+		int Length = 0;
+		for(int Node = m_aRoot[RootIndex(Type)]; Node != -1; )
+		{
+			const CNode *pNode = &m_pNodes[Node];
+			if(pNode->m_Bits > Bits || CommonBits(pNode->m_aKey, pKey, pNode->m_Bits) != pNode->m_Bits)
+				return -1;
+			if(pPath)
+				pPath[Length++] = Node;
+			if(pNode->m_Bits == Bits)
+			{
+				if(pPathLength)
+					*pPathLength = Length;
+				return Node;
+			}
+			Node = pNode->m_aChild[Bit(pKey, pNode->m_Bits)];
+		}
+		return -1;
+	}
+
+	void Insert(int Type, const unsigned char *pKey, int Bits, T *pValue)
+	{
+		int Parent = -1;
+		int Side = 0;
+		int Node = m_aRoot[RootIndex(Type)];
+		while(Node != -1)
+		{
+			int NodeBits = m_pNodes[Node].m_Bits;
+			int Common = CommonBits(m_pNodes[Node].m_aKey, pKey, min(NodeBits, Bits));
+			if(Common == NodeBits)
+			{
+				if(NodeBits == Bits)
+				{
+					AddValue(Node, pValue);
+					return;
+				}
+				Parent = Node;
+				Side = Bit(pKey, NodeBits);
+				Node = m_pNodes[Node].m_aChild[Side];
+				continue;
+			}
+
+			// the prefixes split up before the end of the node
+			int Split = NewNode(pKey, Common);
+			m_pNodes[Split].m_aChild[Bit(m_pNodes[Node].m_aKey, Common)] = Node;
+			if(Common == Bits)
+				AddValue(Split, pValue);
+			else
+			{
+				int Leaf = NewNode(pKey, Bits);
+				m_pNodes[Split].m_aChild[Bit(pKey, Common)] = Leaf;
+				AddValue(Leaf, pValue);
+			}
+			if(Parent == -1)
+				m_aRoot[RootIndex(Type)] = Split;
+			else
+				m_pNodes[Parent].m_aChild[Side] = Split;
+			return;
+		}
+
+		int Leaf = NewNode(pKey, Bits);
+		AddValue(Leaf, pValue);
+		if(Parent == -1)
+			m_aRoot[RootIndex(Type)] = Leaf;
+		else
+			m_pNodes[Parent].m_aChild[Side] = Leaf;
+	}
+
+	void Remove(int Type, const unsigned char *pKey, int Bits, T *pValue)
+	{
+		int aPath[129+1];
+		int PathLength = 0;
+		int Node = FindNode(Type, pKey, Bits, aPath, &PathLength);
+		if(Node == -1)
+			return;
+
+		for(int *pLink = &m_pNodes[Node].m_FirstValue; *pLink != -1; pLink = &m_pValues[*pLink].m_Next)
+		{
+			if(m_pValues[*pLink].m_pValue == pValue)
+			{
+				int Value = *pLink;
+				*pLink = m_pValues[Value].m_Next;
+				m_pValues[Value].m_Next = m_FirstFreeValue;
+				m_FirstFreeValue = Value;
+				break;
+			}
+		}
+
+		// drop nodes that don't hold values or separate two subtrees anymore
+		for(int i = PathLength-1; i >= 0; i--)
+		{
+			CNode *pNode = &m_pNodes[aPath[i]];
+			if(pNode->m_FirstValue != -1 || (pNode->m_aChild[0] != -1 && pNode->m_aChild[1] != -1))
+				break;
+
+			int Replacement = pNode->m_aChild[0] != -1 ? pNode->m_aChild[0] : pNode->m_aChild[1];
+			if(i == 0)
+				m_aRoot[RootIndex(Type)] = Replacement;
+			else
+			{
+				CNode *pParent = &m_pNodes[aPath[i-1]];
+				pParent->m_aChild[pParent->m_aChild[0] == aPath[i] ? 0 : 1] = Replacement;
+			}
+			FreeNode(aPath[i]);
+			if(Replacement != -1)
+				break;
+		}
+	}
+
+public:
+	CNetTrie()
+	{
+		m_pNodes = 0;
+		m_NodesCapacity = 0;
+		m_pValues = 0;
+		m_ValuesCapacity = 0;
+		Clear();
+	}
+
+	~CNetTrie()
+	{
+		mem_free(m_pNodes);
+		mem_free(m_pValues);
+	}
+
+	void Clear()
+	{
+		m_NumNodes = 0;
+		m_FirstFreeNode = -1;
+		m_NumValues = 0;
+		m_FirstFreeValue = -1;
+		m_aRoot[0] = m_aRoot[1] = -1;
+	}
+
+	void InsertRange(const NETADDR *pLB, const NETADDR *pUB, T *pValue)
+	{
+		ForEachPrefix(pLB, pUB, [this, pLB, pValue](const unsigned char *pKey, int Bits) { Insert(pLB->type, pKey, Bits, pValue); });
+	}
+
+	void RemoveRange(const NETADDR *pLB, const NETADDR *pUB, T *pValue)
+	{
+		ForEachPrefix(pLB, pUB, [this, pLB, pValue](const unsigned char *pKey, int Bits) { Remove(pLB->type, pKey, Bits, pValue); });
+	}
+
+	// returns the first value stored for the range that Match accepts
+	template<class F>
+	T *FindRange(const NETADDR *pLB, const NETADDR *pUB, F Match) const
+	{
+		// every value of the range is stored at the first prefix of it
+		int Node = -1;
+		bool First = true;
+		ForEachPrefix(pLB, pUB, [this, pLB, &Node, &First](const unsigned char *pKey, int Bits) {
+			if(First)
+				Node = FindNode(pLB->type, pKey, Bits, 0, 0);
+			First = false;
+		});
+		if(Node == -1)
+			return 0;
+		for(int Value = m_pNodes[Node].m_FirstValue; Value != -1; Value = m_pValues[Value].m_Next)
+		{
+			if(Match(m_pValues[Value].m_pValue))
+				return m_pValues[Value].m_pValue;
+		}
+		return 0;
+	}
+
+	// returns a value of the most specific prefix containing the address
+	T *Lookup(const NETADDR *pAddr) const
+	{
+		if(pAddr->type != NETTYPE_IPV4 && pAddr->type != NETTYPE_IPV6)
+			return 0;
+
+		int AddrBits = KeyBits(pAddr->type);
+		T *pFound = 0;
+		int Matched = 0;
+		for(int Node = m_aRoot[RootIndex(pAddr->type)]; Node != -1; )
+		{
+			const CNode *pNode = &m_pNodes[Node];
+			if(pNode->m_Bits > AddrBits)
+				break;
+
+			// the bits above the parent node are known to match already
+			int Byte = Matched/8;
+			if(CommonBits(pNode->m_aKey+Byte, pAddr->ip+Byte, pNode->m_Bits-Byte*8) != pNode->m_Bits-Byte*8)
+				break;
+			Matched = pNode->m_Bits;
+
+			if(pNode->m_FirstValue != -1)
+				pFound = m_pValues[pNode->m_FirstValue].m_pValue;
+			if(pNode->m_Bits == AddrBits)
+				break;
+			Node = pNode->m_aChild[Bit(pAddr->ip, pNode->m_Bits)];
+		}
+		return pFound;
+	}
+};
+
+#endif
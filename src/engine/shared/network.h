@@ -131,6 +131,10 @@ enum
 
 	NET_CONN_BUFFERSIZE=1024*32,
 
+	NET_CONSOLE_SEND_BUFFER_SIZE=1024*64,
+	NET_CONSOLE_OVERFLOW_DROPLINES=0,
+	NET_CONSOLE_OVERFLOW_DISCONNECT,
+
 	NET_ENUM_TERMINATOR
 };
 
@@ -162,12 +166,29 @@ public:
 	unsigned char *Unpack(unsigned char *pData);
 };
 
+// payload of a chunk that is sent to several connections, their resend
+// buffers reference it instead of holding a copy each
+class CNetSharedChunk
+{
+	int m_RefCount;
+	int m_DataSize;
+
+public:
+	static CNetSharedChunk *Create(const void *pData, int DataSize);
+	void Retain() { m_RefCount++; }
+	void Release();
+
+	int DataSize() const { return m_DataSize; }
+	unsigned char *Data() { return (unsigned char *)(this+1); }
+};
+
 class CNetChunkResend
 {
 public:
 	int m_Flags;
 	int m_DataSize;
 	unsigned char *m_pData;
+	CNetSharedChunk *m_pShared;
 
 	int m_Sequence;
 	int64 m_LastSendTime;
@@ -311,7 +332,8 @@ private:
 	void SetError(const char *pString);
 	void AckChunks(int Ack);
 
-	int QueueChunkEx(int Flags, int DataSize, const void *pData, int Sequence);
+	int QueueChunkEx(int Flags, int DataSize, const void *pData, int Sequence, CNetSharedChunk *pShared = 0);
+	void ClearResendBuffer();
 	void SendControl(int ControlMsg, const void *pExtra, int ExtraSize);
 	void SendControlWithToken(int ControlMsg);
 	void ResendChunk(CNetChunkResend *pResend);
@@ -335,6 +357,7 @@ public:
 
 	int Feed(CNetPacketConstruct *pPacket, NETADDR *pAddr);
 	int QueueChunk(int Flags, int DataSize, const void *pData);
+	int QueueSharedChunk(int Flags, CNetSharedChunk *pChunk);
 	void SendPacketConnless(const char *pData, int DataSize);
 
 	const char *ErrorString();
@@ -363,11 +386,19 @@ private:
 	char m_aBuffer[NET_MAX_PACKETSIZE];
 	int m_BufferOffset;
 
+	// lines that couldn't be sent yet, the socket is never waited for
+	char m_aSendBuffer[NET_CONSOLE_SEND_BUFFER_SIZE];
+	int m_SendStart;
+	int m_SendEnd;
+	int m_NumDroppedLines;
+
 	char m_aErrorString[256];
 
 	bool m_LineEndingDetected;
 	char m_aLineEnding[3];
 
+	bool AppendLine(const char *pLine);
+
 public:
 	void Init(NETSOCKET Socket, const NETADDR *pAddr);
 	void Disconnect(const char *pReason);
@@ -375,10 +406,13 @@ public:
 	int State() const { return m_State; }
 	const NETADDR *PeerAddress() const { return &m_PeerAddr; }
 	const char *ErrorString() const { return m_aErrorString; }
+	bool HasPendingOutput() const { return m_SendEnd > m_SendStart; }
+	NETSOCKET Socket() const { return m_Socket; }
 
 	void Reset();
 	int Update();
-	int Send(const char *pLine);
+	int Flush();
+	int Send(const char *pLine, int OverflowPolicy);
 	int Recv(char *pLine, int MaxLength);
 };
 
@@ -435,6 +469,8 @@ public:
 	// the token parameter is only used for connless packets
 	int Recv(CNetChunk *pChunk, TOKEN *pResponseToken = 0);
 	int Send(CNetChunk *pChunk, TOKEN Token = NET_TOKEN_NONE);
+	// sends the chunk to all the clients, vital chunks are stored only once for all of them
+	void SendMulticast(CNetChunk *pChunk, const int *pClientIDs, int NumClients);
 	int Update();
 	void AddToken(const NETADDR *pAddr, TOKEN Token) { m_TokenCache.AddToken(pAddr, Token, 0); };
 
@@ -462,6 +498,7 @@ class CNetConsole
 	NETSOCKET m_Socket;
 	class CNetBan *m_pNetBan;
 	CSlot m_aSlots[NET_MAX_CONSOLE_CLIENTS];
+	int m_OverflowPolicy;
 
 	NETFUNC_NEWCLIENT m_pfnNewClient;
 	NETFUNC_DELCLIENT m_pfnDelClient;
@@ -471,6 +508,7 @@ class CNetConsole
 
 public:
 	void SetCallbacks(NETFUNC_NEWCLIENT pfnNewClient, NETFUNC_DELCLIENT pfnDelClient, void *pUser);
+	void SetOverflowPolicy(int Policy) { m_OverflowPolicy = Policy; }
 
 	//
 	bool Open(NETADDR BindAddr, class CNetBan *pNetBan, int Flags);
@@ -480,6 +518,8 @@ public:
 	int Recv(char *pLine, int MaxLength, int *pClientID = 0);
 	int Send(int ClientID, const char *pLine);
 	int Update();
+	// returns 1 when a connection or the listening socket has data to read
+	int WaitForInput(int Time);
 
 	//
 	int AcceptClient(NETSOCKET Socket, const NETADDR *pAddr);
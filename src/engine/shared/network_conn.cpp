@@ -6,6 +6,21 @@
 #include "network.h"
 
 
+CNetSharedChunk *CNetSharedChunk::Create(const void *pData, int DataSize)
+{
+	CNetSharedChunk *pChunk = (CNetSharedChunk *)mem_alloc(sizeof(CNetSharedChunk)+DataSize, sizeof(void*));
+	pChunk->m_RefCount = 1;
+	pChunk->m_DataSize = DataSize;
+	mem_copy(pChunk->Data(), pData, DataSize);
+	return pChunk;
+}
+
+void CNetSharedChunk::Release()
+{
+	if(--m_RefCount == 0)
+		mem_free(this);
+}
+
 void CNetConnection::ResetStats()
 {
 	mem_zero(&m_Stats, sizeof(m_Stats));
@@ -26,7 +41,7 @@ void CNetConnection::Reset()
 	m_PeerToken = NET_TOKEN_NONE;
 	mem_zero(&m_PeerAddr, sizeof(m_PeerAddr));
 
-	m_Buffer.Init();
+	ClearResendBuffer();
 
 	mem_zero(&m_Construct, sizeof(m_Construct));
 }
@@ -56,6 +71,8 @@ void CNetConnection::SetError(const char *pString)
 
 void CNetConnection::Init(NETSOCKET Socket, bool BlockCloseMsg)
 {
+	// the owner might have zeroed the memory, don't walk the old buffer
+	m_Buffer.Init();
 	Reset();
 	ResetStats();
 
@@ -64,6 +81,16 @@ void CNetConnection::Init(NETSOCKET Socket, bool BlockCloseMsg)
 	mem_zero(m_ErrorString, sizeof(m_ErrorString));
 }
 
+void CNetConnection::ClearResendBuffer()
+{
+	for(CNetChunkResend *pResend = m_Buffer.First(); pResend; pResend = m_Buffer.Next(pResend))
+	{
+		if(pResend->m_pShared)
+			pResend->m_pShared->Release();
+	}
+	m_Buffer.Init();
+}
+
 void CNetConnection::AckChunks(int Ack)
 {
 	while(1)
@@ -73,7 +100,11 @@ void CNetConnection::AckChunks(int Ack)
 			break;
 
 		if(CNetBase::IsSeqInBackroom(pResend->m_Sequence, Ack))
+		{
+			if(pResend->m_pShared)
+				pResend->m_pShared->Release();
 			m_Buffer.PopFirst();
+		}
 		else
 			break;
 	}
@@ -103,7 +134,7 @@ int CNetConnection::Flush()
 	return NumChunks;
 }
 
-int CNetConnection::QueueChunkEx(int Flags, int DataSize, const void *pData, int Sequence)
+int CNetConnection::QueueChunkEx(int Flags, int DataSize, const void *pData, int Sequence, CNetSharedChunk *pShared)
 {
 	unsigned char *pChunkData;
 
@@ -129,17 +160,26 @@ int CNetConnection::QueueChunkEx(int Flags, int DataSize, const void *pData, int
 
 	if(Flags&NET_CHUNKFLAG_VITAL && !(Flags&NET_CHUNKFLAG_RESEND))
 	{
-		// save packet if we need to resend
-		CNetChunkResend *pResend = m_Buffer.Allocate(sizeof(CNetChunkResend)+DataSize);
+		// save packet if we need to resend, shared payloads are only referenced
+		CNetChunkResend *pResend = m_Buffer.Allocate(sizeof(CNetChunkResend)+(pShared ? 0 : DataSize));
 		if(pResend)
 		{
 			pResend->m_Sequence = Sequence;
 			pResend->m_Flags = Flags;
 			pResend->m_DataSize = DataSize;
-			pResend->m_pData = (unsigned char *)(pResend+1);
+			pResend->m_pShared = pShared;
 			pResend->m_FirstSendTime = time_get();
 			pResend->m_LastSendTime = pResend->m_FirstSendTime;
-			mem_copy(pResend->m_pData, pData, DataSize);
+			if(pShared)
+			{
+				pShared->Retain();
+				pResend->m_pData = pShared->Data();
+			}
+			else
+			{
+				pResend->m_pData = (unsigned char *)(pResend+1);
+				mem_copy(pResend->m_pData, pData, DataSize);
+			}
 		}
 		else
 		{
@@ -159,6 +199,13 @@ int CNetConnection::QueueChunk(int Flags, int DataSize, const void *pData)
 	return QueueChunkEx(Flags, DataSize, pData, m_Sequence);
 }
 
+int CNetConnection::QueueSharedChunk(int Flags, CNetSharedChunk *pChunk)
+{
+	if(Flags&NET_CHUNKFLAG_VITAL)
+		m_Sequence = (m_Sequence+1)%NET_MAX_SEQUENCE;
+	return QueueChunkEx(Flags, pChunk->DataSize(), pChunk->Data(), m_Sequence, Flags&NET_CHUNKFLAG_VITAL ? pChunk : 0);
+}
+
 void CNetConnection::SendControl(int ControlMsg, const void *pExtra, int ExtraSize)
 {
 	// send the control message
@@ -132,6 +132,19 @@ int CNetConsole::Update()
 	return 0;
 }
 
+int CNetConsole::WaitForInput(int Time)
+{
+	NETSOCKET aSockets[NET_MAX_CONSOLE_CLIENTS+1];
+	int NumSockets = 0;
+	aSockets[NumSockets++] = m_Socket;
+	for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS; i++)
+	{
+		if(m_aSlots[i].m_Connection.State() == NET_CONNSTATE_ONLINE)
+			aSockets[NumSockets++] = m_aSlots[i].m_Connection.Socket();
+	}
+	return net_socket_read_wait_multi(aSockets, NumSockets, Time);
+}
+
 int CNetConsole::Recv(char *pLine, int MaxLength, int *pClientID)
 {
 	for(int i = 0; i < NET_MAX_CONSOLE_CLIENTS; i++)
@@ -149,7 +162,7 @@ int CNetConsole::Recv(char *pLine, int MaxLength, int *pClientID)
 int CNetConsole::Send(int ClientID, const char *pLine)
 {
 	if(m_aSlots[ClientID].m_Connection.State() == NET_CONNSTATE_ONLINE)
-		return m_aSlots[ClientID].m_Connection.Send(pLine);
+		return m_aSlots[ClientID].m_Connection.Send(pLine, m_OverflowPolicy);
 	else
 		return -1;
 }
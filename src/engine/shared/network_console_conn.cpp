@@ -1,5 +1,6 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
 #include <base/system.h>
 #include "network.h"
 
@@ -14,6 +15,9 @@ void CConsoleNetConnection::Reset()
 	m_Socket.ipv6sock = -1;
 	m_aBuffer[0] = 0;
 	m_BufferOffset = 0;
+	m_SendStart = 0;
+	m_SendEnd = 0;
+	m_NumDroppedLines = 0;
 
 	m_LineEndingDetected = false;
 	#if defined(CONF_FAMILY_WINDOWS)
@@ -43,8 +47,10 @@ void CConsoleNetConnection::Disconnect(const char *pReason)
 	if(State() == NET_CONNSTATE_OFFLINE)
 		return;
 
+	// last chance to get the pending lines and the reason out
 	if(pReason && pReason[0])
-		Send(pReason);
+		AppendLine(pReason);
+	Flush();
 
 	net_tcp_close(m_Socket);
 
@@ -85,6 +91,31 @@ int CConsoleNetConnection::Update()
 		}
 	}
 
+	return Flush();
+}
+
+int CConsoleNetConnection::Flush()
+{
+	if(State() != NET_CONNSTATE_ONLINE)
+		return 0;
+
+	while(m_SendStart < m_SendEnd)
+	{
+		int Sent = net_tcp_send(m_Socket, m_aSendBuffer+m_SendStart, m_SendEnd-m_SendStart);
+		if(Sent < 0)
+		{
+			if(net_would_block()) // try again on the next update
+				return 0;
+
+			m_State = NET_CONNSTATE_ERROR;
+			str_copy(m_aErrorString, "failed to send packet", sizeof(m_aErrorString));
+			return -1;
+		}
+		m_SendStart += Sent;
+	}
+
+	m_SendStart = 0;
+	m_SendEnd = 0;
 	return 0;
 }
 
@@ -151,36 +182,59 @@ int CConsoleNetConnection::Recv(char *pLine, int MaxLength)
 	return 0;
 }
 
-int CConsoleNetConnection::Send(const char *pLine)
+bool CConsoleNetConnection::AppendLine(const char *pLine)
+{
+	char aDropped[64] = { 0 };
+	if(m_NumDroppedLines)
+		str_format(aDropped, sizeof(aDropped), "[%d lines dropped]", m_NumDroppedLines);
+
+	char aBuf[1024];
+	int Length = 0;
+	for(int i = 0; i < 2; i++)
+	{
+		const char *pStr = i == 0 ? aDropped : pLine;
+		if(!pStr[0] && i == 0)
+			continue;
+		int StrLength = min(str_length(pStr), (int)(sizeof(aBuf))-3-Length);
+		mem_copy(aBuf+Length, pStr, StrLength);
+		Length += StrLength;
+		aBuf[Length++] = m_aLineEnding[0];
+		aBuf[Length++] = m_aLineEnding[1];
+		aBuf[Length++] = m_aLineEnding[2];
+	}
+
+	if(m_SendEnd+Length > (int)(sizeof(m_aSendBuffer)))
+	{
+		if(m_SendEnd-m_SendStart+Length > (int)(sizeof(m_aSendBuffer)))
+			return false;
+		mem_move(m_aSendBuffer, m_aSendBuffer+m_SendStart, m_SendEnd-m_SendStart);
+		m_SendEnd -= m_SendStart;
+		m_SendStart = 0;
+	}
+
+	mem_copy(m_aSendBuffer+m_SendEnd, aBuf, Length);
+	m_SendEnd += Length;
+	m_NumDroppedLines = 0;
+	return true;
+}
+
+int CConsoleNetConnection::Send(const char *pLine, int OverflowPolicy)
 {
 	if(State() != NET_CONNSTATE_ONLINE)
 		return -1;
 
-	char aBuf[1024];
-	str_copy(aBuf, pLine, (int)(sizeof(aBuf))-2);
-	int Length = str_length(aBuf);
-	aBuf[Length] = m_aLineEnding[0];
-	aBuf[Length+1] = m_aLineEnding[1];
-	aBuf[Length+2] = m_aLineEnding[2];
-	Length += 3;
-	const char *pData = aBuf;
-
-	while(true)
+	if(!AppendLine(pLine))
 	{
-		int Send = net_tcp_send(m_Socket, pData, Length);
-		if(Send < 0)
+		if(OverflowPolicy == NET_CONSOLE_OVERFLOW_DISCONNECT)
 		{
 			m_State = NET_CONNSTATE_ERROR;
-			str_copy(m_aErrorString, "failed to send packet", sizeof(m_aErrorString));
-			return -1;
+			str_copy(m_aErrorString, "too slow connection (out of send buffer)", sizeof(m_aErrorString));
 		}
-
-		if(Send >= Length)
-			break;
-
-		pData += Send;
-		Length -= Send;
+		else
+			m_NumDroppedLines++;
+		return -1;
 	}
 
-	return 0;
+	// don't wait for the next update if the socket takes it right away
+	return Flush();
 }
@@ -301,6 +301,32 @@ int CNetServer::Send(CNetChunk *pChunk, TOKEN Token)
 	return 0;
 }
 
+void CNetServer::SendMulticast(CNetChunk *pChunk, const int *pClientIDs, int NumClients)
+{
+	if(pChunk->m_DataSize+NET_MAX_CHUNKHEADERSIZE >= NET_MAX_PAYLOAD)
+	{
+		dbg_msg("netserver", "chunk payload too big. %d. dropping chunk", pChunk->m_DataSize);
+		return;
+	}
+
+	int Flags = pChunk->m_Flags&NETSENDFLAG_VITAL ? NET_CHUNKFLAG_VITAL : 0;
+	CNetSharedChunk *pShared = CNetSharedChunk::Create(pChunk->m_pData, pChunk->m_DataSize);
+	for(int i = 0; i < NumClients; i++)
+	{
+		int ClientID = pClientIDs[i];
+		dbg_assert(ClientID >= 0 && ClientID < MaxClients(), "errornous client id");
+
+		if(m_aSlots[ClientID].m_Connection.QueueSharedChunk(Flags, pShared) == 0)
+		{
+			if(pChunk->m_Flags&NETSENDFLAG_FLUSH)
+				m_aSlots[ClientID].m_Connection.Flush();
+		}
+		else
+			Drop(ClientID, "Error sending data");
+	}
+	pShared->Release();
+}
+
 void CNetServer::SetMaxClientsPerIP(int Max)
 {
 	// clamp
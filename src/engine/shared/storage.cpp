@@ -6,6 +6,15 @@
 #include "linereader.h"
 #include <zlib.h>
 
+#include <ctype.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 // compiled-in data-dir path
 #define DATA_DIR "data"
 
@@ -15,7 +24,12 @@ public:
 	enum
 	{
 		MAX_PATHS = 16,
-		MAX_PATH_LENGTH = 512
+		MAX_PATH_LENGTH = 512,
+
+		// in ms. how often the watched directories are checked for changes
+		WATCH_INTERVAL = 100,
+		// in seconds. how long a directory that can't be watched is cached
+		CACHE_TIMEOUT = 2,
 	};
 
 	char m_aaStoragePaths[MAX_PATHS][MAX_PATH_LENGTH];
@@ -24,7 +38,34 @@ public:
 	char m_aUserDir[MAX_PATH_LENGTH];
 	char m_aCurrentDir[MAX_PATH_LENGTH];
 	char m_aAppDir[MAX_PATH_LENGTH];
-	
+
+	// the entries of a directory, a listing never changes once it is cached
+	struct CDirectory
+	{
+		struct CEntry
+		{
+			std::string m_Name;
+			int m_IsDir;
+		};
+		std::vector<CEntry> m_aEntries;
+		std::unordered_map<std::string, int> m_Names;
+		// -1 if it isn't watched
+		int m_WatchID;
+		int64 m_Time;
+	};
+
+	// directory listings by their full path, files are looked up in them
+	// instead of trying to open them in every storage path
+	std::mutex m_CacheMutex;
+	std::unordered_map<std::string, std::shared_ptr<const CDirectory> > m_Cache;
+	// changes of a watched directory invalidate these listings
+	std::unordered_map<int, std::vector<std::string> > m_WatchedDirectories;
+	// watches of listings that are being made, they must not be removed yet
+	std::unordered_map<int, int> m_PendingWatches;
+	unsigned m_CacheGeneration;
+	void *m_pWatch;
+	int64 m_LastWatchRead;
+
 	CStorage()
 	{
 		mem_zero(m_aaStoragePaths, sizeof(m_aaStoragePaths));
@@ -33,6 +74,15 @@ public:
 		m_aUserDir[0] = 0;
 		m_aCurrentDir[0] = 0;
 		m_aAppDir[0] = 0;
+
+		m_CacheGeneration = 0;
+		m_pWatch = fs_watch_create();
+		m_LastWatchRead = 0;
+	}
+
+	~CStorage()
+	{
+		fs_watch_destroy(m_pWatch);
 	}
 
 	int Init(const char *pApplicationName, int StorageType, int NumArgs, const char **ppArguments)
@@ -77,6 +127,8 @@ public:
 				fs_makedir(GetPath(TYPE_SAVE, "demos", aPath, sizeof(aPath)));
 				fs_makedir(GetPath(TYPE_SAVE, "demos/auto", aPath, sizeof(aPath)));
 				fs_makedir(GetPath(TYPE_SAVE, "configs", aPath, sizeof(aPath)));
+				if(StorageType == STORAGETYPE_SERVER)
+					fs_makedir(GetPath(TYPE_SAVE, "inputs", aPath, sizeof(aPath)));
 			}
 			else
 			{
@@ -292,6 +344,255 @@ public:
 		dbg_msg("storage", "warning no data directory found");
 	}
 
+	static bool IsSeparator(char c)
+	{
+#if defined(CONF_FAMILY_WINDOWS)
+		return c == '/' || c == '\\';
+#else
+		return c == '/';
+#endif
+	}
+
+	static std::string NameKey(const char *pName)
+	{
+		std::string Key = pName;
+#if defined(CONF_FAMILY_WINDOWS) || defined(CONF_PLATFORM_MACOSX)
+		// the file systems ignore the case
+		for(unsigned i = 0; i < Key.size(); i++)
+			Key[i] = tolower((unsigned char)Key[i]);
+#endif
+		return Key;
+	}
+
+	static int AddEntryCallback(const char *pName, int IsDir, int Type, void *pUser)
+	{
+		CDirectory *pDirectory = (CDirectory *)pUser;
+		CDirectory::CEntry Entry;
+		Entry.m_Name = pName;
+		Entry.m_IsDir = IsDir;
+		pDirectory->m_Names[NameKey(pName)] = pDirectory->m_aEntries.size();
+		pDirectory->m_aEntries.push_back(Entry);
+		return 0;
+	}
+
+	// needs the cache lock
+	void ReadWatch()
+	{
+		if(!m_pWatch)
+			return;
+
+		int64 Now = time_get();
+		if(Now < m_LastWatchRead + time_freq()*WATCH_INTERVAL/1000)
+			return;
+		m_LastWatchRead = Now;
+
+		int aIDs[64];
+		int Num = fs_watch_read(m_pWatch, aIDs, 64, 0);
+		if(Num < 0)
+		{
+			dbg_msg("storage", "watching directories failed, caching them for %d seconds", (int)CACHE_TIMEOUT);
+			fs_watch_destroy(m_pWatch);
+			m_pWatch = 0;
+			ClearCache();
+			return;
+		}
+		for(int i = 0; i < Num; i++)
+		{
+			if(aIDs[i] < 0)
+			{
+				ClearCache();
+				return;
+			}
+
+			std::unordered_map<int, std::vector<std::string> >::iterator Watched = m_WatchedDirectories.find(aIDs[i]);
+			if(Watched == m_WatchedDirectories.end())
+				continue;
+			for(unsigned k = 0; k < Watched->second.size(); k++)
+				m_Cache.erase(Watched->second[k]);
+			m_WatchedDirectories.erase(Watched);
+			ReleaseWatch(aIDs[i]);
+			m_CacheGeneration++;
+		}
+	}
+
+	// needs the cache lock. a missing directory is watched through the
+	// closest parent, that's where it shows up
+	int WatchDirectory(const std::string &Path)
+	{
+		if(!m_pWatch)
+			return -1;
+
+		std::string Watched = Path;
+		while(!Watched.empty())
+		{
+			int ID = fs_watch_add(m_pWatch, Watched.c_str());
+			if(ID >= 0)
+				return ID;
+			// it exists but can't be watched, out of watches for example
+			if(fs_is_dir(Watched.c_str()))
+				return -1;
+
+			int Length = Watched.size();
+			while(Length > 0 && !IsSeparator(Watched[Length-1]))
+				Length--;
+			while(Length > 0 && IsSeparator(Watched[Length-1]))
+				Length--;
+			Watched.resize(Length);
+		}
+		return -1;
+	}
+
+	// needs the cache lock. removes a watch no listing uses anymore
+	void ReleaseWatch(int ID)
+	{
+		if(m_pWatch && m_WatchedDirectories.find(ID) == m_WatchedDirectories.end() && m_PendingWatches.find(ID) == m_PendingWatches.end())
+			fs_watch_remove(m_pWatch, ID);
+	}
+
+	// needs the cache lock
+	void DropDirectory(std::unordered_map<std::string, std::shared_ptr<const CDirectory> >::iterator Cached)
+	{
+		int ID = Cached->second->m_WatchID;
+		if(ID >= 0)
+		{
+			std::unordered_map<int, std::vector<std::string> >::iterator Watched = m_WatchedDirectories.find(ID);
+			if(Watched != m_WatchedDirectories.end())
+			{
+				std::vector<std::string>::iterator Key = std::find(Watched->second.begin(), Watched->second.end(), Cached->first);
+				if(Key != Watched->second.end())
+					Watched->second.erase(Key);
+				if(Watched->second.empty())
+					m_WatchedDirectories.erase(Watched);
+			}
+			ReleaseWatch(ID);
+		}
+		m_Cache.erase(Cached);
+	}
+
+	// needs the cache lock
+	void ClearCache()
+	{
+		std::vector<int> aIDs;
+		for(std::unordered_map<int, std::vector<std::string> >::iterator it = m_WatchedDirectories.begin(); it != m_WatchedDirectories.end(); ++it)
+			aIDs.push_back(it->first);
+		m_Cache.clear();
+		m_WatchedDirectories.clear();
+		for(unsigned i = 0; i < aIDs.size(); i++)
+			ReleaseWatch(aIDs[i]);
+		m_CacheGeneration++;
+	}
+
+	std::shared_ptr<const CDirectory> GetDirectory(const char *pPath)
+	{
+		std::string Key = pPath;
+		while(Key.size() > 1 && IsSeparator(Key[Key.size()-1]))
+			Key.resize(Key.size()-1);
+
+		unsigned Generation;
+		int WatchID;
+		{
+			std::lock_guard<std::mutex> Lock(m_CacheMutex);
+			ReadWatch();
+			std::unordered_map<std::string, std::shared_ptr<const CDirectory> >::iterator Cached = m_Cache.find(Key);
+			if(Cached != m_Cache.end())
+			{
+				const CDirectory *pDirectory = Cached->second.get();
+				if(pDirectory->m_WatchID >= 0 || time_get() < pDirectory->m_Time + time_freq()*CACHE_TIMEOUT)
+					return Cached->second;
+				DropDirectory(Cached);
+			}
+
+			// watch before listing, so no change gets lost
+			Generation = m_CacheGeneration;
+			WatchID = WatchDirectory(Key);
+			if(WatchID >= 0)
+				m_PendingWatches[WatchID]++;
+		}
+
+		std::shared_ptr<CDirectory> pDirectory = std::make_shared<CDirectory>();
+		pDirectory->m_WatchID = WatchID;
+		pDirectory->m_Time = time_get();
+		fs_listdir(Key.c_str(), AddEntryCallback, 0, pDirectory.get());
+
+		{
+			std::lock_guard<std::mutex> Lock(m_CacheMutex);
+			// something got invalidated meanwhile, the listing might be too old already
+			if(Generation == m_CacheGeneration)
+			{
+				std::unordered_map<std::string, std::shared_ptr<const CDirectory> >::iterator Cached = m_Cache.find(Key);
+				if(Cached != m_Cache.end())
+					DropDirectory(Cached);
+				m_Cache[Key] = pDirectory;
+				if(WatchID >= 0)
+					m_WatchedDirectories[WatchID].push_back(Key);
+			}
+
+			if(WatchID >= 0)
+			{
+				std::unordered_map<int, int>::iterator Pending = m_PendingWatches.find(WatchID);
+				if(--Pending->second == 0)
+					m_PendingWatches.erase(Pending);
+				ReleaseWatch(WatchID);
+			}
+		}
+		return pDirectory;
+	}
+
+	void ListDirectoryPath(const char *pPath, FS_LISTDIR_CALLBACK pfnCallback, int Type, void *pUser)
+	{
+		std::shared_ptr<const CDirectory> pDirectory = GetDirectory(pPath);
+		for(unsigned i = 0; i < pDirectory->m_aEntries.size(); i++)
+		{
+			if(pfnCallback(pDirectory->m_aEntries[i].m_Name.c_str(), pDirectory->m_aEntries[i].m_IsDir, Type, pUser))
+				break;
+		}
+	}
+
+	// checks the listing of its directory, that costs no syscalls when it is cached
+	bool FileExists(int Type, const char *pFilename)
+	{
+		char aPath[MAX_PATH_LENGTH];
+		GetPath(Type, pFilename, aPath, sizeof(aPath));
+		int Length = str_length(aPath);
+		int NameStart = Length;
+		while(NameStart > 0 && !IsSeparator(aPath[NameStart-1]))
+			NameStart--;
+		if(NameStart == Length)
+			return false;
+
+		std::string Name = NameKey(aPath+NameStart);
+		if(NameStart == 0)
+			str_copy(aPath, ".", sizeof(aPath));
+		else
+			aPath[NameStart-1] = 0;
+		std::shared_ptr<const CDirectory> pDirectory = GetDirectory(aPath[0] ? aPath : "/");
+		return pDirectory->m_Names.find(Name) != pDirectory->m_Names.end();
+	}
+
+	virtual void InvalidateCache()
+	{
+		std::lock_guard<std::mutex> Lock(m_CacheMutex);
+		ClearCache();
+	}
+
+	void InvalidateDirectory(int Type, const char *pFilename)
+	{
+		char aPath[MAX_PATH_LENGTH];
+		GetPath(Type, pFilename, aPath, sizeof(aPath));
+		int Length = str_length(aPath);
+		while(Length > 0 && !IsSeparator(aPath[Length-1]))
+			Length--;
+		while(Length > 1 && IsSeparator(aPath[Length-1]))
+			Length--;
+		aPath[Length] = 0;
+
+		std::lock_guard<std::mutex> Lock(m_CacheMutex);
+		std::unordered_map<std::string, std::shared_ptr<const CDirectory> >::iterator Cached = m_Cache.find(Length ? aPath : ".");
+		if(Cached != m_Cache.end())
+			DropDirectory(Cached);
+		m_CacheGeneration++;
+	}
+
 	virtual void ListDirectory(int Type, const char *pPath, FS_LISTDIR_CALLBACK pfnCallback, void *pUser)
 	{
 		char aBuffer[MAX_PATH_LENGTH];
@@ -299,12 +600,12 @@ public:
 		{
 			// list all available directories
 			for(int i = 0; i < m_NumPaths; ++i)
-				fs_listdir(GetPath(i, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, i, pUser);
+				ListDirectoryPath(GetPath(i, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, i, pUser);
 		}
 		else if(Type >= 0 && Type < m_NumPaths)
 		{
 			// list wanted directory
-			fs_listdir(GetPath(Type, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, Type, pUser);
+			ListDirectoryPath(GetPath(Type, pPath, aBuffer, sizeof(aBuffer)), pfnCallback, Type, pUser);
 		}
 	}
 
@@ -342,7 +643,10 @@ public:
 		// open file
 		if(Flags&IOFLAG_WRITE)
 		{
-			return io_open(GetPath(TYPE_SAVE, pFilename, pBuffer, BufferSize), Flags);
+			IOHANDLE Handle = io_open(GetPath(TYPE_SAVE, pFilename, pBuffer, BufferSize), Flags);
+			if(Handle)
+				InvalidateDirectory(TYPE_SAVE, pFilename);
+			return Handle;
 		}
 		else
 		{
@@ -359,6 +663,8 @@ public:
 
 			for(int i = LB; i < UB; ++i)
 			{
+				if(!FileExists(i, pFilename))
+					continue;
 				Handle = io_open(GetPath(i, pFilename, pBuffer, BufferSize), Flags);
 				if(Handle)
 				{
@@ -404,7 +710,7 @@ public:
 			char aPath[MAX_PATH_LENGTH];
 			str_format(aPath, sizeof(aPath), "%s/%s", Data.m_pPath, pName);
 			Data.m_pPath = aPath;
-			fs_listdir(Data.m_pStorage->GetPath(Type, aPath, aBuf, sizeof(aBuf)), FindFileCallback, Type, &Data);
+			Data.m_pStorage->ListDirectoryPath(Data.m_pStorage->GetPath(Type, aPath, aBuf, sizeof(aBuf)), FindFileCallback, Type, &Data);
 			if(Data.m_pBuffer[0])
 				return 1;
 		}
@@ -446,7 +752,7 @@ public:
 			// search within all available directories
 			for(int i = 0; i < m_NumPaths; ++i)
 			{
-				fs_listdir(GetPath(i, pCBData->m_pPath, aBuf, sizeof(aBuf)), FindFileCallback, i, pCBData);
+				ListDirectoryPath(GetPath(i, pCBData->m_pPath, aBuf, sizeof(aBuf)), FindFileCallback, i, pCBData);
 				if(pCBData->m_pBuffer[0])
 					return true;
 			}
@@ -454,7 +760,7 @@ public:
 		else if(Type >= 0 && Type < m_NumPaths)
 		{
 			// search within wanted directory
-			fs_listdir(GetPath(Type, pCBData->m_pPath, aBuf, sizeof(aBuf)), FindFileCallback, Type, pCBData);
+			ListDirectoryPath(GetPath(Type, pCBData->m_pPath, aBuf, sizeof(aBuf)), FindFileCallback, Type, pCBData);
 		}
 
 		return pCBData->m_pBuffer[0] != 0;
@@ -496,7 +802,9 @@ public:
 			return false;
 
 		char aBuffer[MAX_PATH_LENGTH];
-		return !fs_remove(GetPath(Type, pFilename, aBuffer, sizeof(aBuffer)));
+		bool Success = !fs_remove(GetPath(Type, pFilename, aBuffer, sizeof(aBuffer)));
+		InvalidateCache();
+		return Success;
 	}
 
 	virtual bool RenameFile(const char* pOldFilename, const char* pNewFilename, int Type)
@@ -505,7 +813,9 @@ public:
 			return false;
 		char aOldBuffer[MAX_PATH_LENGTH];
 		char aNewBuffer[MAX_PATH_LENGTH];
-		return !fs_rename(GetPath(Type, pOldFilename, aOldBuffer, sizeof(aOldBuffer)), GetPath(Type, pNewFilename, aNewBuffer, sizeof (aNewBuffer)));
+		bool Success = !fs_rename(GetPath(Type, pOldFilename, aOldBuffer, sizeof(aOldBuffer)), GetPath(Type, pNewFilename, aNewBuffer, sizeof (aNewBuffer)));
+		InvalidateCache();
+		return Success;
 	}
 
 	virtual bool CreateFolder(const char *pFoldername, int Type)
@@ -514,7 +824,9 @@ public:
 			return false;
 
 		char aBuffer[MAX_PATH_LENGTH];
-		return !fs_makedir(GetPath(Type, pFoldername, aBuffer, sizeof(aBuffer)));
+		bool Success = !fs_makedir(GetPath(Type, pFoldername, aBuffer, sizeof(aBuffer)));
+		InvalidateCache();
+		return Success;
 	}
 
 	virtual void GetCompletePath(int Type, const char *pDir, char *pBuffer, unsigned BufferSize)
@@ -0,0 +1,284 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <engine/textrender.h>
+
+#include <math.h>
+
+#include "textlayout.h"
+
+// the part of a text cursor that changes while laying out
+struct CLayoutCursor
+{
+	float m_X;
+	float m_Y;
+	int m_LineCount;
+	int m_GlyphCount;
+	int m_CharCount;
+	int m_Flags;
+	float m_LineWidth;
+};
+
+static int WordLength(const char *pText)
+{
+	int s = 1;
+	while(1)
+	{
+		if(*pText == 0)
+			return s-1;
+		if(*pText == '\n' || *pText == '\t' || *pText == ' ')
+			return s;
+		pText++;
+		s++;
+	}
+}
+
+// the same steps as the renderer always did, measuring the words with itself.
+// only the outermost call records the glyphs
+static void LayoutRun(ITextGlyphMetrics *pMetrics, const CTextLayoutSettings *pSettings, CLayoutCursor *pCursor,
+	const char *pText, int Length, CTextLayout *pLayout)
+{
+	const float ScaleX = pSettings->m_ScaleX;
+	const float ScaleY = pSettings->m_ScaleY;
+	const float Size = pSettings->m_Size;
+	const float StartX = floorf(pSettings->m_StartX * ScaleX) / ScaleX;
+	const int MaxLines = pSettings->m_MaxLines;
+
+	// every run starts on a whole pixel
+	float DrawX = floorf(pCursor->m_X * ScaleX) / ScaleX;
+	float DrawY = floorf(pCursor->m_Y * ScaleY) / ScaleY;
+	int LineCount = pCursor->m_LineCount;
+	bool GotNewLine = false;
+	bool Wrapped = false;
+
+	const char *pCurrent = pText;
+	const char *pEnd = pCurrent+Length;
+
+	while(pCurrent < pEnd && (MaxLines < 1 || LineCount <= MaxLines))
+	{
+		int NewLine = 0;
+		const char *pBatchEnd = pEnd;
+		if(pCursor->m_LineWidth > 0 && !(pCursor->m_Flags&TEXTFLAG_STOP_AT_END))
+		{
+			int Wlen = min(WordLength(pCurrent), (int)(pEnd-pCurrent));
+			CLayoutCursor Compare = *pCursor;
+			Compare.m_X = DrawX;
+			Compare.m_Y = DrawY;
+			Compare.m_LineWidth = -1;
+			LayoutRun(pMetrics, pSettings, &Compare, pCurrent, Wlen, 0);
+
+			if(Compare.m_X-DrawX > pCursor->m_LineWidth)
+			{
+				// word can't be fitted in one line, cut it
+				CLayoutCursor Cutter = *pCursor;
+				Cutter.m_GlyphCount = 0;
+				Cutter.m_X = DrawX;
+				Cutter.m_Y = DrawY;
+				Cutter.m_Flags |= TEXTFLAG_STOP_AT_END;
+
+				LayoutRun(pMetrics, pSettings, &Cutter, pCurrent, Wlen, 0);
+				Wlen = Cutter.m_GlyphCount;
+				NewLine = 1;
+
+				if(Wlen <= 3) // if we can't place 3 chars of the word on this line, take the next
+					Wlen = 0;
+			}
+			else if(Compare.m_X-pSettings->m_StartX > pCursor->m_LineWidth)
+			{
+				NewLine = 1;
+				Wlen = 0;
+			}
+
+			pBatchEnd = pCurrent + Wlen;
+		}
+
+		const char *pTmp = pCurrent;
+		int NextCharacter = str_utf8_decode(&pTmp);
+		while(pCurrent < pBatchEnd)
+		{
+			pCursor->m_CharCount += pTmp-pCurrent;
+			int Character = NextCharacter;
+			pCurrent = pTmp;
+			NextCharacter = str_utf8_decode(&pTmp);
+
+			if(Character == '\n')
+			{
+				DrawX = StartX;
+				DrawY = floorf((DrawY + Size) * ScaleY) / ScaleY;
+				GotNewLine = true;
+				++LineCount;
+				if(MaxLines > 0 && LineCount > MaxLines)
+					break;
+				continue;
+			}
+
+			float Advance;
+			if(!pMetrics->Advance(Character, &Advance))
+				continue;
+			Advance += pMetrics->Kerning(Character, NextCharacter);
+			if(pCursor->m_Flags&TEXTFLAG_STOP_AT_END && DrawX+Advance*Size-pSettings->m_StartX > pCursor->m_LineWidth)
+			{
+				// we hit the end of the line, no more to render or count
+				pCurrent = pEnd;
+				break;
+			}
+
+			if(pLayout)
+			{
+				CTextLayout::CGlyph Glyph;
+				Glyph.m_Chr = Character;
+				Glyph.m_X = DrawX;
+				Glyph.m_Y = DrawY;
+				pLayout->m_aGlyphs.push_back(Glyph);
+			}
+
+			DrawX += Advance*Size;
+			pCursor->m_GlyphCount++;
+		}
+
+		if(NewLine)
+		{
+			DrawX = StartX;
+			DrawY = floorf((DrawY + Size) * ScaleY) / ScaleY;
+			GotNewLine = true;
+			Wrapped = true;
+			++LineCount;
+		}
+	}
+
+	pCursor->m_X = DrawX;
+	pCursor->m_LineCount = LineCount;
+	if(GotNewLine)
+		pCursor->m_Y = DrawY;
+
+	if(pLayout)
+	{
+		pLayout->m_GotNewLine = GotNewLine;
+		pLayout->m_Wrapped = Wrapped;
+	}
+}
+
+void CTextLayout::Layout(ITextGlyphMetrics *pMetrics, const CTextLayoutSettings *pSettings, const char *pText, int Length)
+{
+	m_aGlyphs.clear();
+
+	CLayoutCursor Cursor;
+	Cursor.m_X = 0.0f;
+	Cursor.m_Y = 0.0f;
+	Cursor.m_LineCount = pSettings->m_LineCount;
+	Cursor.m_GlyphCount = 0;
+	Cursor.m_CharCount = 0;
+	Cursor.m_Flags = pSettings->m_Flags;
+	Cursor.m_LineWidth = pSettings->m_LineWidth;
+	LayoutRun(pMetrics, pSettings, &Cursor, pText, Length, this);
+
+	m_EndX = Cursor.m_X;
+	m_EndY = Cursor.m_Y;
+	m_LineCount = Cursor.m_LineCount;
+	m_GlyphCount = Cursor.m_GlyphCount;
+	m_CharCount = Cursor.m_CharCount;
+}
+
+static unsigned HashBytes(unsigned Hash, const void *pData, int Size)
+{
+	const unsigned char *pBytes = (const unsigned char *)pData;
+	for(int i = 0; i < Size; i++)
+		Hash = (Hash ^ pBytes[i]) * 16777619u; // FNV-1a
+	return Hash;
+}
+
+static unsigned HashSettings(const CTextLayoutSettings *pSettings)
+{
+	unsigned Hash = 2166136261u;
+	Hash = HashBytes(Hash, &pSettings->m_pFont, sizeof(pSettings->m_pFont));
+	Hash = HashBytes(Hash, &pSettings->m_FontSize, sizeof(pSettings->m_FontSize));
+	Hash = HashBytes(Hash, &pSettings->m_Size, sizeof(pSettings->m_Size));
+	Hash = HashBytes(Hash, &pSettings->m_ScaleX, sizeof(pSettings->m_ScaleX));
+	Hash = HashBytes(Hash, &pSettings->m_ScaleY, sizeof(pSettings->m_ScaleY));
+	Hash = HashBytes(Hash, &pSettings->m_StartX, sizeof(pSettings->m_StartX));
+	Hash = HashBytes(Hash, &pSettings->m_LineWidth, sizeof(pSettings->m_LineWidth));
+	Hash = HashBytes(Hash, &pSettings->m_MaxLines, sizeof(pSettings->m_MaxLines));
+	Hash = HashBytes(Hash, &pSettings->m_LineCount, sizeof(pSettings->m_LineCount));
+	Hash = HashBytes(Hash, &pSettings->m_Flags, sizeof(pSettings->m_Flags));
+	return Hash;
+}
+
+static bool SameSettings(const CTextLayoutSettings *pA, const CTextLayoutSettings *pB)
+{
+	return pA->m_pFont == pB->m_pFont && pA->m_FontSize == pB->m_FontSize && pA->m_Size == pB->m_Size &&
+		pA->m_ScaleX == pB->m_ScaleX && pA->m_ScaleY == pB->m_ScaleY && pA->m_StartX == pB->m_StartX &&
+		pA->m_LineWidth == pB->m_LineWidth && pA->m_MaxLines == pB->m_MaxLines &&
+		pA->m_LineCount == pB->m_LineCount && pA->m_Flags == pB->m_Flags;
+}
+
+CTextLayoutCache::CTextLayoutCache(int MaxEntries)
+{
+	m_MaxEntries = max(MaxEntries, 1);
+	m_NumHits = 0;
+	m_NumMisses = 0;
+}
+
+static bool HasNewLine(const char *pText, int Length)
+{
+	for(int i = 0; i < Length; i++)
+		if(pText[i] == '\n')
+			return true;
+	return false;
+}
+
+const CTextLayout *CTextLayoutCache::Get(ITextGlyphMetrics *pMetrics, const CTextLayoutSettings *pSettings, const char *pText, int Length)
+{
+	const char *pNext = pText+Length;
+	int NextChr = str_utf8_decode(&pNext);
+
+	// the line start only matters for line breaks and the line width.
+	// leave it out otherwise, it moves with the text
+	CTextLayoutSettings Settings = *pSettings;
+	if(Settings.m_LineWidth <= 0 && !(Settings.m_Flags&TEXTFLAG_STOP_AT_END) && !HasNewLine(pText, Length))
+		Settings.m_StartX = 0.0f;
+	pSettings = &Settings;
+
+	unsigned Hash = HashSettings(pSettings);
+	Hash = HashBytes(Hash, &NextChr, sizeof(NextChr));
+	Hash = HashBytes(Hash, pText, Length);
+
+	std::unordered_map<unsigned, std::list<CEntry>::iterator>::iterator Found = m_Lookup.find(Hash);
+	if(Found != m_Lookup.end())
+	{
+		CEntry *pEntry = &*Found->second;
+		if(pEntry->m_NextChr == NextChr && SameSettings(&pEntry->m_Settings, pSettings) &&
+			(int)pEntry->m_Text.size() == Length && mem_comp(pEntry->m_Text.data(), pText, Length) == 0)
+		{
+			m_lEntries.splice(m_lEntries.begin(), m_lEntries, Found->second);
+			m_NumHits++;
+			return &pEntry->m_Layout;
+		}
+
+		// same hash, other text. the new one takes its place
+		m_lEntries.erase(Found->second);
+		m_Lookup.erase(Found);
+	}
+
+	m_NumMisses++;
+	if((int)m_lEntries.size() >= m_MaxEntries)
+	{
+		m_Lookup.erase(m_lEntries.back().m_Hash);
+		m_lEntries.pop_back();
+	}
+
+	m_lEntries.push_front(CEntry());
+	CEntry *pEntry = &m_lEntries.front();
+	pEntry->m_Hash = Hash;
+	pEntry->m_Settings = *pSettings;
+	pEntry->m_NextChr = NextChr;
+	pEntry->m_Text.assign(pText, Length);
+	pEntry->m_Layout.Layout(pMetrics, pSettings, pText, Length);
+	m_Lookup[Hash] = m_lEntries.begin();
+	return &pEntry->m_Layout;
+}
+
+void CTextLayoutCache::Clear()
+{
+	m_lEntries.clear();
+	m_Lookup.clear();
+}
@@ -0,0 +1,111 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef ENGINE_SHARED_TEXTLAYOUT_H
+#define ENGINE_SHARED_TEXTLAYOUT_H
+
+#include <base/system.h>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// glyph metrics of one font size, in units of the font size
+class ITextGlyphMetrics
+{
+public:
+	virtual ~ITextGlyphMetrics() {}
+
+	// false if the font can't give the glyph, it is skipped then
+	virtual bool Advance(int Chr, float *pAdvance) = 0;
+	virtual float Kerning(int Left, int Right) = 0;
+};
+
+// everything besides the text that the layout depends on
+class CTextLayoutSettings
+{
+public:
+	// only tell layouts of different fonts apart
+	const void *m_pFont;
+	int m_FontSize;
+
+	float m_Size; // already snapped to whole pixels
+	float m_ScaleX; // screen pixels per unit
+	float m_ScaleY;
+	float m_StartX; // relative to the cursor
+	float m_LineWidth;
+	int m_MaxLines;
+	int m_LineCount;
+	int m_Flags;
+};
+
+/*
+	Class: Text Layout
+		The positioned glyphs of a text, laid out the way the text
+		renderer draws it: words that don't fit the line width go to
+		the next line, too long words get cut. Positions are relative
+		to the cursor the text starts at, the glyph's own offsets
+		aren't applied.
+*/
+class CTextLayout
+{
+public:
+	struct CGlyph
+	{
+		int m_Chr;
+		float m_X;
+		float m_Y;
+	};
+
+	std::vector<CGlyph> m_aGlyphs;
+
+	// the cursor after the text, relative like the glyphs
+	float m_EndX;
+	float m_EndY;
+	int m_LineCount;
+	int m_GlyphCount;
+	int m_CharCount;
+	bool m_GotNewLine; // any line break
+	bool m_Wrapped; // a line break that wasn't in the text
+
+	void Layout(ITextGlyphMetrics *pMetrics, const CTextLayoutSettings *pSettings, const char *pText, int Length);
+};
+
+/*
+	Class: Text Layout Cache
+		Keeps the layouts of the most recently drawn texts, so text
+		that doesn't change only costs a lookup. Layouts only hold
+		characters and positions, they stay valid when the glyphs are
+		kicked out of the font texture. Must be cleared when the glyph
+		metrics change, like when a font gets loaded.
+*/
+class CTextLayoutCache
+{
+	struct CEntry
+	{
+		unsigned m_Hash;
+		CTextLayoutSettings m_Settings;
+		int m_NextChr; // the kerning of the last glyph depends on it
+		std::string m_Text;
+		CTextLayout m_Layout;
+	};
+
+	int m_MaxEntries;
+	std::list<CEntry> m_lEntries; // most recently used first
+	std::unordered_map<unsigned, std::list<CEntry>::iterator> m_Lookup;
+	int m_NumHits;
+	int m_NumMisses;
+
+public:
+	CTextLayoutCache(int MaxEntries = 1024);
+
+	// the layout stays valid until the next call
+	const CTextLayout *Get(ITextGlyphMetrics *pMetrics, const CTextLayoutSettings *pSettings, const char *pText, int Length);
+	void Clear();
+
+	int Num() const { return m_lEntries.size(); }
+	int NumHits() const { return m_NumHits; }
+	int NumMisses() const { return m_NumMisses; }
+};
+
+#endif
@@ -728,6 +728,8 @@ public:
 	CMenus();
 
 	void RenderLoading();
+	// for components that load more than the data files, call RenderLoading once per step
+	void AddLoadingSteps(int Num) { m_LoadTotal += Num; }
 
 	bool IsActive() const { return m_MenuActive; }
 
@@ -451,6 +451,7 @@ void CMenus::RenderDemoList(CUIRect MainView)
 	static CButtonContainer s_RefreshButton;
 	if(DoButton_Menu(&s_RefreshButton, Localize("Refresh"), 0, &Button) || (Input()->KeyPress(KEY_R) && (Input()->KeyIsPressed(KEY_LCTRL) || Input()->KeyIsPressed(KEY_RCTRL))))
 	{
+		Storage()->InvalidateCache();
 		DemolistPopulate();
 		DemolistOnUpdate(false);
 	}
@@ -6,11 +6,14 @@
 #include <base/system.h>
 #include <base/math.h>
 
+#include <engine/engine.h>
 #include <engine/graphics.h>
 #include <engine/storage.h>
 #include <engine/external/json-parser/json.h>
 #include <engine/shared/config.h>
 
+#include <game/client/components/menus.h>
+
 #include "skins.h"
 
 
@@ -26,36 +29,25 @@ int *const CSkins::ms_apColorVariables[NUM_SKINPARTS] = {&g_Config.m_PlayerColor
 
 const float MIN_EYE_BODY_COLOR_DIST = 80.f; // between body and eyes (LAB color space)
 
-int CSkins::SkinPartScan(const char *pName, int IsDir, int DirType, void *pUser)
+CSkins::CSkinPartImage CSkins::DecodeSkinPart(IGraphics *pGraphics, const char *pFilename, int DirType, int Part)
 {
-	CSkins *pSelf = (CSkins *)pUser;
-	if(IsDir || !str_endswith(pName, ".png"))
-		return 0;
-
-	char aBuf[512];
-	str_format(aBuf, sizeof(aBuf), "skins/%s/%s", CSkins::ms_apSkinPartNames[pSelf->m_ScanningPart], pName);
-	CImageInfo Info;
-	if(!pSelf->Graphics()->LoadPNG(&Info, aBuf, DirType))
-	{
-		str_format(aBuf, sizeof(aBuf), "failed to load skin part '%s'", pName);
-		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", aBuf);
-		return 0;
-	}
-
-	CSkinPart Part;
-	Part.m_OrgTexture = pSelf->Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
-	Part.m_BloodColor = vec3(1.0f, 1.0f, 1.0f);
+	CSkinPartImage Image;
+	Image.m_pColorData = 0;
+	Image.m_BloodColor = vec3(1.0f, 1.0f, 1.0f);
+	Image.m_Loaded = pGraphics->LoadPNG(&Image.m_Info, pFilename, DirType);
+	if(!Image.m_Loaded)
+		return Image;
 
-	unsigned char *d = (unsigned char *)Info.m_pData;
-	int Pitch = Info.m_Width*4;
+	unsigned char *d = (unsigned char *)Image.m_Info.m_pData;
+	int Pitch = Image.m_Info.m_Width*4;
 
 	// dig out blood color
-	if(pSelf->m_ScanningPart == SKINPART_BODY)
+	if(Part == SKINPART_BODY)
 	{
-		int PartX = Info.m_Width/2;
+		int PartX = Image.m_Info.m_Width/2;
 		int PartY = 0;
-		int PartWidth = Info.m_Width/2;
-		int PartHeight = Info.m_Height/2;
+		int PartWidth = Image.m_Info.m_Width/2;
+		int PartHeight = Image.m_Info.m_Height/2;
 
 		int aColors[3] = {0};
 		for(int y = PartY; y < PartY+PartHeight; y++)
@@ -69,14 +61,18 @@ int CSkins::SkinPartScan(const char *pName, int IsDir, int DirType, void *pUser)
 				}
 			}
 
-		Part.m_BloodColor = normalize(vec3(aColors[0], aColors[1], aColors[2]));
+		Image.m_BloodColor = normalize(vec3(aColors[0], aColors[1], aColors[2]));
 	}
 
 	// create colorless version
-	int Step = Info.m_Format == CImageInfo::FORMAT_RGBA ? 4 : 3;
+	int Step = Image.m_Info.m_Format == CImageInfo::FORMAT_RGBA ? 4 : 3;
+	int Size = Image.m_Info.m_Width*Image.m_Info.m_Height*Step;
+	Image.m_pColorData = mem_alloc(Size, 1);
+	mem_copy(Image.m_pColorData, d, Size);
+	d = (unsigned char *)Image.m_pColorData;
 
 	// make the texture gray scale
-	for(int i = 0; i < Info.m_Width*Info.m_Height; i++)
+	for(int i = 0; i < Image.m_Info.m_Width*Image.m_Info.m_Height; i++)
 	{
 		int v = (d[i*Step]+d[i*Step+1]+d[i*Step+2])/3;
 		d[i*Step] = v;
@@ -84,22 +80,62 @@ int CSkins::SkinPartScan(const char *pName, int IsDir, int DirType, void *pUser)
 		d[i*Step+2] = v;
 	}
 
-	Part.m_ColorTexture = pSelf->Graphics()->LoadTextureRaw(Info.m_Width, Info.m_Height, Info.m_Format, Info.m_pData, Info.m_Format, 0);
-	mem_free(Info.m_pData);
+	return Image;
+}
+
+void CSkins::AddSkinPart(const CPendingSkinPart *pPending, CSkinPartImage *pImage)
+{
+	char aBuf[512];
+	const char *pName = pPending->m_aName;
+	if(!pImage->m_Loaded)
+	{
+		str_format(aBuf, sizeof(aBuf), "failed to load skin part '%s'", pName);
+		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", aBuf);
+		return;
+	}
+
+	CSkinPart Part;
+	Part.m_OrgTexture = Graphics()->LoadTextureRaw(pImage->m_Info.m_Width, pImage->m_Info.m_Height, pImage->m_Info.m_Format, pImage->m_Info.m_pData, pImage->m_Info.m_Format, 0);
+	Part.m_ColorTexture = Graphics()->LoadTextureRaw(pImage->m_Info.m_Width, pImage->m_Info.m_Height, pImage->m_Info.m_Format, pImage->m_pColorData, pImage->m_Info.m_Format, 0);
+	Part.m_BloodColor = pImage->m_BloodColor;
+	mem_free(pImage->m_Info.m_pData);
+	mem_free(pImage->m_pColorData);
 
 	// set skin part data
 	Part.m_Flags = 0;
 	if(pName[0] == 'x' && pName[1] == '_')
 		Part.m_Flags |= SKINFLAG_SPECIAL;
-	if(DirType != IStorage::TYPE_SAVE)
+	if(pPending->m_DirType != IStorage::TYPE_SAVE)
 		Part.m_Flags |= SKINFLAG_STANDARD;
 	str_truncate(Part.m_aName, sizeof(Part.m_aName), pName, str_length(pName) - 4);
 	if(g_Config.m_Debug)
 	{
 		str_format(aBuf, sizeof(aBuf), "load skin part %s", Part.m_aName);
-		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", aBuf);
+		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", aBuf);
 	}
-	pSelf->m_aaSkinParts[pSelf->m_ScanningPart].add(Part);
+	m_aaSkinParts[pPending->m_Part].add(Part);
+}
+
+int CSkins::SkinPartScan(const char *pName, int IsDir, int DirType, void *pUser)
+{
+	CSkins *pSelf = (CSkins *)pUser;
+	if(IsDir || !str_endswith(pName, ".png"))
+		return 0;
+
+	// only queue the decoding here, the textures are made once all parts are found
+	CPendingSkinPart Pending;
+	Pending.m_Part = pSelf->m_ScanningPart;
+	Pending.m_DirType = DirType;
+	str_copy(Pending.m_aName, pName, sizeof(Pending.m_aName));
+
+	char aBuf[512];
+	str_format(aBuf, sizeof(aBuf), "skins/%s/%s", CSkins::ms_apSkinPartNames[Pending.m_Part], pName);
+	IGraphics *pGraphics = pSelf->Graphics();
+	int Part = Pending.m_Part;
+	Pending.m_Image = pSelf->m_pClient->Engine()->JobPool()->Submit([pGraphics, aBuf, DirType, Part]() {
+		return DecodeSkinPart(pGraphics, aBuf, DirType, Part);
+	});
+	pSelf->m_lPendingParts.add(Pending);
 
 	return 0;
 }
@@ -214,6 +250,9 @@ int CSkins::SkinScan(const char *pName, int IsDir, int DirType, void *pUser)
 
 void CSkins::OnInit()
 {
+	// find the skin parts and decode them on the job pool
+	int64 StartTime = time_get();
+	m_lPendingParts.clear();
 	for(int p = 0; p < NUM_SKINPARTS; p++)
 	{
 		m_aaSkinParts[p].clear();
@@ -233,7 +272,26 @@ void CSkins::OnInit()
 		str_format(aBuf, sizeof(aBuf), "skins/%s", ms_apSkinPartNames[p]);
 		m_ScanningPart = p;
 		Storage()->ListDirectory(IStorage::TYPE_ALL, aBuf, SkinPartScan, this);
+	}
 
+	// upload them as they get done, textures can only be made on this thread
+	m_pClient->m_pMenus->AddLoadingSteps(m_lPendingParts.size());
+	for(int i = 0; i < m_lPendingParts.size(); i++)
+	{
+		CSkinPartImage Image = m_lPendingParts[i].m_Image.Get();
+		AddSkinPart(&m_lPendingParts[i], &Image);
+		m_pClient->m_pMenus->RenderLoading();
+	}
+	if(g_Config.m_Debug)
+	{
+		char aBuf[128];
+		str_format(aBuf, sizeof(aBuf), "loaded %d skin parts in %.2fms", m_lPendingParts.size(), (time_get()-StartTime)*1000.0f/time_freq());
+		Console()->Print(IConsole::OUTPUT_LEVEL_ADDINFO, "skins", aBuf);
+	}
+	m_lPendingParts.clear();
+
+	for(int p = 0; p < NUM_SKINPARTS; p++)
+	{
 		// add dummy skin part
 		if(!m_aaSkinParts[p].size())
 		{
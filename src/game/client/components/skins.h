@@ -3,7 +3,9 @@
 #ifndef GAME_CLIENT_COMPONENTS_SKINS_H
 #define GAME_CLIENT_COMPONENTS_SKINS_H
 #include <base/vmath.h>
+#include <base/tl/array.h>
 #include <base/tl/sorted_array.h>
+#include <engine/shared/jobs.h>
 #include <game/client/component.h>
 
 // todo: fix duplicate skins (different paths)
@@ -76,11 +78,31 @@ public:
 	bool ValidateSkinParts(char *aPartNames[NUM_SKINPARTS], int *aUseCustomColors, int* aPartColors, int GameFlags) const;
 
 private:
+	// decoded on the job pool, uploaded on the main thread
+	struct CSkinPartImage
+	{
+		bool m_Loaded;
+		CImageInfo m_Info;
+		void *m_pColorData; // colorless version
+		vec3 m_BloodColor;
+	};
+
+	struct CPendingSkinPart
+	{
+		int m_Part;
+		int m_DirType;
+		char m_aName[128];
+		CJobPool::CFuture<CSkinPartImage> m_Image;
+	};
+
 	int m_ScanningPart;
+	array<CPendingSkinPart> m_lPendingParts;
 	sorted_array<CSkinPart> m_aaSkinParts[NUM_SKINPARTS];
 	sorted_array<CSkin> m_aSkins;
 	CSkin m_DummySkin;
 
+	static CSkinPartImage DecodeSkinPart(class IGraphics *pGraphics, const char *pFilename, int DirType, int Part);
+	void AddSkinPart(const CPendingSkinPart *pPending, CSkinPartImage *pImage);
 	static int SkinPartScan(const char *pName, int IsDir, int DirType, void *pUser);
 	static int SkinScan(const char *pName, int IsDir, int DirType, void *pUser);
 };
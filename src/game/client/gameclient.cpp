@@ -1,5 +1,7 @@
 /* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/tl/array.h>
+
 #include <engine/editor.h>
 #include <engine/engine.h>
 #include <engine/contacts.h>
@@ -371,6 +373,20 @@ void CGameClient::OnInit()
 		}
 	}
 
+	// decode the textures on the job pool while the components load
+	array<CJobPool::CFuture<CImageInfo> > lImages;
+	for(int i = 0; i < g_pData->m_NumImages; i++)
+	{
+		IGraphics *pGraphics = Graphics();
+		const char *pFilename = g_pData->m_aImages[i].m_pFilename;
+		lImages.add(Engine()->JobPool()->Submit([pGraphics, pFilename]() {
+			CImageInfo Info;
+			if(!pGraphics->LoadPNG(&Info, pFilename, IStorage::TYPE_ALL))
+				Info.m_pData = 0;
+			return Info;
+		}));
+	}
+
 	// init all components
 	for(int i = m_All.m_Num-1; i >= 0; --i)
 		m_All.m_paComponents[i]->OnInit();
@@ -378,7 +394,15 @@ void CGameClient::OnInit()
 	// setup load amount// load textures
 	for(int i = 0; i < g_pData->m_NumImages; i++)
 	{
-		g_pData->m_aImages[i].m_Id = Graphics()->LoadTexture(g_pData->m_aImages[i].m_pFilename, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, g_pData->m_aImages[i].m_Flag ? IGraphics::TEXLOAD_LINEARMIPMAPS : 0);
+		CImageInfo Info = lImages[i].Get();
+		int Flags = g_pData->m_aImages[i].m_Flag ? IGraphics::TEXLOAD_LINEARMIPMAPS : 0;
+		if(Info.m_pData)
+		{
+			g_pData->m_aImages[i].m_Id = Graphics()->LoadTextureImage(g_pData->m_aImages[i].m_pFilename, &Info, CImageInfo::FORMAT_AUTO, Flags);
+			mem_free(Info.m_pData);
+		}
+		else // gets the invalid texture
+			g_pData->m_aImages[i].m_Id = Graphics()->LoadTexture(g_pData->m_aImages[i].m_pFilename, IStorage::TYPE_ALL, CImageInfo::FORMAT_AUTO, Flags);
 		m_pMenus->RenderLoading();
 	}
 
@@ -15,24 +15,42 @@
 CCollision::CCollision()
 {
 	m_pTiles = 0;
+	m_pTileFlags = 0;
 	m_Width = 0;
 	m_Height = 0;
 	m_pLayers = 0;
 }
 
+CCollision::~CCollision()
+{
+	mem_free(m_pTileFlags);
+}
+
 void CCollision::Init(class CLayers *pLayers)
 {
 	m_pLayers = pLayers;
-	m_Width = m_pLayers->GameLayer()->m_Width;
-	m_Height = m_pLayers->GameLayer()->m_Height;
-	m_pTiles = static_cast<CTile *>(m_pLayers->Map()->GetData(m_pLayers->GameLayer()->m_Data));
+	Init(static_cast<CTile *>(m_pLayers->Map()->GetData(m_pLayers->GameLayer()->m_Data)),
+		m_pLayers->GameLayer()->m_Width, m_pLayers->GameLayer()->m_Height);
+}
+
+void CCollision::Init(class CTile *pTiles, int Width, int Height)
+{
+	m_Width = Width;
+	m_Height = Height;
+	m_pTiles = pTiles;
+
+	mem_free(m_pTileFlags);
+	m_pTileFlags = static_cast<unsigned char *>(mem_alloc(m_Width*m_Height, 1));
 
 	for(int i = 0; i < m_Width*m_Height; i++)
 	{
 		int Index = m_pTiles[i].m_Index;
 
 		if(Index > 128)
+		{
+			m_pTileFlags[i] = 0;
 			continue;
+		}
 
 		switch(Index)
 		{
@@ -48,6 +66,7 @@ void CCollision::Init(class CLayers *pLayers)
 		default:
 			m_pTiles[i].m_Index = 0;
 		}
+		m_pTileFlags[i] = m_pTiles[i].m_Index;
 	}
 }
 
@@ -56,7 +75,7 @@ int CCollision::GetTile(int x, int y) const
 	int Nx = clamp(x/32, 0, m_Width-1);
 	int Ny = clamp(y/32, 0, m_Height-1);
 
-	return m_pTiles[Ny*m_Width+Nx].m_Index > 128 ? 0 : m_pTiles[Ny*m_Width+Nx].m_Index;
+	return m_pTileFlags[Ny*m_Width+Nx];
 }
 
 bool CCollision::IsTile(int x, int y, int Flag) const
@@ -64,14 +83,11 @@ bool CCollision::IsTile(int x, int y, int Flag) const
 	return GetTile(x, y)&Flag;
 }
 
-// TODO: rewrite this smarter!
-int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
+int CCollision::IntersectLineSampled(vec2 Pos0, vec2 Pos1, int Start, int End, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
-	float Distance = distance(Pos0, Pos1);
-	int End(Distance+1);
-	vec2 Last = Pos0;
+	vec2 Last = Start > 0 ? mix(Pos0, Pos1, (Start-1)/float(End)) : Pos0;
 
-	for(int i = 0; i <= End; i++)
+	for(int i = Start; i <= End; i++)
 	{
 		float a = i/float(End);
 		vec2 Pos = mix(Pos0, Pos1, a);
@@ -92,7 +108,88 @@ int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *p
 	return 0;
 }
 
-// TODO: OPT: rewrite this smarter!
+// a tile k covers the coordinates [32k-0.5, 32k+31.5) because of the rounding
+// in CheckPoint, the outermost tiles extend to infinity because of the clamping
+static int TileOfCoord(double Coord, int Size)
+{
+	return clamp((int)floor((Coord+0.5)/32.0), 0, Size-1);
+}
+
+// The line is tested at Distance+1 evenly spaced sample points and the first
+// sample inside a solid tile is reported. Instead of probing every sample, the
+// tiles along the line are traversed first (stepping tile by tile along the
+// dominant axis) to find the first tile that could contain a solid sample.
+// Tiles within a small margin of the line are included, so that rounding of
+// the sample positions can never reach a tile that was not looked at. The
+// sampling then only resumes shortly before that tile, which gives exactly the
+// same results as sampling the whole line.
+int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance+1);
+
+	// short lines are cheaper to sample directly and far away coordinates lose
+	// too much float precision for the margin below
+	const float MaxCoord = 65536.0f;
+	if(!(Distance >= 16.0f && Distance < MaxCoord) || absolute(Pos0.x) > MaxCoord || absolute(Pos0.y) > MaxCoord ||
+		absolute(Pos1.x) > MaxCoord || absolute(Pos1.y) > MaxCoord)
+		return IntersectLineSampled(Pos0, Pos1, 0, End, pOutCollision, pOutBeforeCollision);
+
+	const double Margin = 0.125;
+	const double aStart[2] = { Pos0.x, Pos0.y };
+	const double aDir[2] = { Pos1.x-Pos0.x, Pos1.y-Pos0.y };
+	const int aSize[2] = { m_Width, m_Height };
+	const int Major = absolute(aDir[0]) >= absolute(aDir[1]) ? 0 : 1;
+	const int Minor = 1-Major;
+	const int Step = aDir[Major] > 0 ? 1 : -1;
+
+	const int MajorFirst = TileOfCoord(aStart[Major] - Step*Margin, aSize[Major]);
+	const int MajorLast = TileOfCoord(aStart[Major] + aDir[Major] + Step*Margin, aSize[Major]);
+
+	double HitTime = -1.0;
+	for(int k = MajorFirst; HitTime < 0.0; k += Step)
+	{
+		// part of the line that lies within the (widened) tile column k
+		double Low = k == 0 ? -1e30 : 32.0*k - 0.5 - Margin;
+		double High = k == aSize[Major]-1 ? 1e30 : 32.0*k + 31.5 + Margin;
+		double t0 = ((Step > 0 ? Low : High) - aStart[Major]) / aDir[Major];
+		double t1 = ((Step > 0 ? High : Low) - aStart[Major]) / aDir[Major];
+		t0 = clamp(t0, 0.0, 1.0);
+		t1 = clamp(t1, 0.0, 1.0);
+
+		double v0 = aStart[Minor] + aDir[Minor]*t0;
+		double v1 = aStart[Minor] + aDir[Minor]*t1;
+		int MinorFrom = TileOfCoord(min(v0, v1) - Margin, aSize[Minor]);
+		int MinorTo = TileOfCoord(max(v0, v1) + Margin, aSize[Minor]);
+		for(int m = MinorFrom; m <= MinorTo; m++)
+		{
+			int Index = Major == 0 ? m*m_Width+k : k*m_Width+m;
+			if(m_pTileFlags[Index]&COLFLAG_SOLID)
+			{
+				HitTime = t0;
+				break;
+			}
+		}
+
+		if(k == MajorLast)
+			break;
+	}
+
+	if(HitTime < 0.0)
+	{
+		if(pOutCollision)
+			*pOutCollision = Pos1;
+		if(pOutBeforeCollision)
+			*pOutBeforeCollision = Pos1;
+		return 0;
+	}
+
+	// back off a few samples so that samples close to the tile border are
+	// tested as well
+	int Start = max((int)floor(HitTime*End) - 2, 0);
+	return IntersectLineSampled(Pos0, Pos1, Start, End, pOutCollision, pOutBeforeCollision);
+}
+
 void CCollision::MovePoint(vec2 *pInoutPos, vec2 *pInoutVel, float Elasticity, int *pBounces) const
 {
 	if(pBounces)
@@ -8,12 +8,14 @@
 class CCollision
 {
 	class CTile *m_pTiles;
+	unsigned char *m_pTileFlags; // collision flags of every tile, built once in Init
 	int m_Width;
 	int m_Height;
 	class CLayers *m_pLayers;
 
 	bool IsTile(int x, int y, int Flag=COLFLAG_SOLID) const;
 	int GetTile(int x, int y) const;
+	int IntersectLineSampled(vec2 Pos0, vec2 Pos1, int Start, int End, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const;
 
 public:
 	enum
@@ -24,7 +26,9 @@ public:
 	};
 
 	CCollision();
+	~CCollision();
 	void Init(class CLayers *pLayers);
+	void Init(class CTile *pTiles, int Width, int Height);
 	bool CheckPoint(float x, float y, int Flag=COLFLAG_SOLID) const { return IsTile(round_to_int(x), round_to_int(y), Flag); }
 	bool CheckPoint(vec2 Pos, int Flag=COLFLAG_SOLID) const { return CheckPoint(Pos.x, Pos.y, Flag); }
 	int GetCollisionAt(float x, float y) const { return GetTile(round_to_int(x), round_to_int(y)); }
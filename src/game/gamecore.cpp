@@ -55,10 +55,77 @@ float VelocityRamp(float Value, float Start, float Range, float Curvature)
 	return 1.0f/powf(Curvature, (Value-Start)/Range);
 }
 
+unsigned CWorldCore::BroadPhaseBucket(int CellX, int CellY)
+{
+	return ((unsigned)CellX*73856093u ^ (unsigned)CellY*19349663u) % BROADPHASE_NUM_BUCKETS;
+}
+
+void CWorldCore::BuildBroadPhase()
+{
+	for(int i = 0; i < BROADPHASE_NUM_BUCKETS; i++)
+		m_aBroadPhase[i].reset();
+	m_BroadPhaseOutside.reset();
+
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		m_apBroadPhaseCharacters[i] = m_apCharacters[i];
+		if(!m_apCharacters[i])
+			continue;
+
+		vec2 Pos = m_apCharacters[i]->m_Pos;
+		m_aBroadPhasePos[i] = Pos;
+		if(absolute(Pos.x) < BROADPHASE_LIMIT && absolute(Pos.y) < BROADPHASE_LIMIT)
+			m_aBroadPhase[BroadPhaseBucket(floorf(Pos.x/BROADPHASE_CELL_SIZE), floorf(Pos.y/BROADPHASE_CELL_SIZE))].set(i);
+		else
+			m_BroadPhaseOutside.set(i);
+	}
+	m_BroadPhaseValid = true;
+}
+
+// the game moves characters directly too, ninja and spawning for example
+bool CWorldCore::BroadPhaseChanged() const
+{
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(m_apCharacters[i] != m_apBroadPhaseCharacters[i])
+			return true;
+		if(m_apCharacters[i] && !(m_apCharacters[i]->m_Pos == m_aBroadPhasePos[i]))
+			return true;
+	}
+	return false;
+}
+
+CWorldCore::CCharacterSet CWorldCore::FindCharacters(vec2 Pos0, vec2 Pos1, float Radius)
+{
+	// a bit extra for the quantization of the positions and rounding in the distance checks
+	Radius += 1.0f;
+	if(!(absolute(Pos0.x) < BROADPHASE_LIMIT && absolute(Pos0.y) < BROADPHASE_LIMIT &&
+		absolute(Pos1.x) < BROADPHASE_LIMIT && absolute(Pos1.y) < BROADPHASE_LIMIT && Radius < BROADPHASE_LIMIT))
+		return CCharacterSet().set();
+
+	int MinX = floorf((min(Pos0.x, Pos1.x)-Radius)/BROADPHASE_CELL_SIZE);
+	int MinY = floorf((min(Pos0.y, Pos1.y)-Radius)/BROADPHASE_CELL_SIZE);
+	int MaxX = floorf((max(Pos0.x, Pos1.x)+Radius)/BROADPHASE_CELL_SIZE);
+	int MaxY = floorf((max(Pos0.y, Pos1.y)+Radius)/BROADPHASE_CELL_SIZE);
+	if((MaxX-MinX+1)*(MaxY-MinY+1) > BROADPHASE_MAX_CELLS)
+		return CCharacterSet().set();
+
+	if(!m_BroadPhaseValid || BroadPhaseChanged())
+		BuildBroadPhase();
+
+	CCharacterSet Result = m_BroadPhaseOutside;
+	for(int y = MinY; y <= MaxY; y++)
+		for(int x = MinX; x <= MaxX; x++)
+			Result |= m_aBroadPhase[BroadPhaseBucket(x, y)];
+	return Result;
+}
+
 void CCharacterCore::Init(CWorldCore *pWorld, CCollision *pCollision)
 {
 	m_pWorld = pWorld;
 	m_pCollision = pCollision;
+	if(m_pWorld)
+		m_pWorld->InvalidateBroadPhase();
 }
 
 void CCharacterCore::Reset()
@@ -199,10 +266,11 @@ void CCharacterCore::Tick(bool UseInput)
 		if(m_pWorld && m_pWorld->m_Tuning.m_PlayerHooking)
 		{
 			float Distance = 0.0f;
+			CWorldCore::CCharacterSet Candidates = m_pWorld->FindCharacters(m_HookPos, NewPos, PhysSize+2.0f);
 			for(int i = 0; i < MAX_CLIENTS; i++)
 			{
 				CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
-				if(!pCharCore || pCharCore == this)
+				if(!Candidates.test(i) || !pCharCore || pCharCore == this)
 					continue;
 
 				vec2 ClosestPoint = closest_point_on_line(m_HookPos, NewPos, pCharCore->m_Pos);
@@ -293,10 +361,15 @@ void CCharacterCore::Tick(bool UseInput)
 
 	if(m_pWorld)
 	{
+		// everyone close enough to collide, and the hooked player
+		CWorldCore::CCharacterSet Candidates = m_pWorld->FindCharacters(m_Pos, m_Pos, PhysSize*1.25f);
+		if(m_HookedPlayer >= 0 && m_HookedPlayer < MAX_CLIENTS)
+			Candidates.set(m_HookedPlayer);
+
 		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
 			CCharacterCore *pCharCore = m_pWorld->m_apCharacters[i];
-			if(!pCharCore)
+			if(!Candidates.test(i) || !pCharCore)
 				continue;
 
 			//player *p = (player*)ent;
@@ -349,6 +422,7 @@ void CCharacterCore::Move()
 {
 	if(!m_pWorld)
 		return;
+	m_pWorld->InvalidateBroadPhase();
 
 	float PhysSize = 28.0f;
 	float RampValue = VelocityRamp(length(m_Vel)*50, m_pWorld->m_Tuning.m_VelrampStart, m_pWorld->m_Tuning.m_VelrampRange, m_pWorld->m_Tuning.m_VelrampCurvature);
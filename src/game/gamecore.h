@@ -7,6 +7,7 @@
 #include <base/math.h>
 
 #include <math.h>
+#include <bitset>
 #include "collision.h"
 #include <engine/shared/protocol.h>
 #include <generated/protocol.h>
@@ -130,16 +131,55 @@ enum
 	HOOK_GRABBED,
 };
 
+/*
+	The world keeps a broad-phase of the character positions for the
+	hook and collision checks of CCharacterCore::Tick. It is a spatial
+	hash of client id sets that is built on the first query after the
+	characters moved, so all characters of a tick share it. Queries
+	return a superset of the characters in range, which the callers
+	test exactly in client id order like before.
+*/
 class CWorldCore
 {
+public:
+	typedef std::bitset<MAX_CLIENTS> CCharacterSet;
+
+private:
+	enum
+	{
+		BROADPHASE_CELL_SIZE=128,
+		BROADPHASE_NUM_BUCKETS=128,
+		// queries covering more cells just return everyone
+		BROADPHASE_MAX_CELLS=16,
+		// characters further out than this are in every query
+		BROADPHASE_LIMIT=1024*1024,
+	};
+
+	CCharacterSet m_aBroadPhase[BROADPHASE_NUM_BUCKETS];
+	CCharacterSet m_BroadPhaseOutside;
+	bool m_BroadPhaseValid;
+	// what the cells were built from, characters moved by anything but Move are noticed with it
+	const class CCharacterCore *m_apBroadPhaseCharacters[MAX_CLIENTS];
+	vec2 m_aBroadPhasePos[MAX_CLIENTS];
+
+	static unsigned BroadPhaseBucket(int CellX, int CellY);
+	void BuildBroadPhase();
+	bool BroadPhaseChanged() const;
+
 public:
 	CWorldCore()
 	{
 		mem_zero(m_apCharacters, sizeof(m_apCharacters));
+		m_BroadPhaseValid = false;
 	}
 
 	CTuningParams m_Tuning;
 	class CCharacterCore *m_apCharacters[MAX_CLIENTS];
+
+	// rebuilds the cells on the next query, changed characters are found without it as well
+	void InvalidateBroadPhase() { m_BroadPhaseValid = false; }
+	// characters that might be closer than Radius to the line from Pos0 to Pos1
+	CCharacterSet FindCharacters(vec2 Pos0, vec2 Pos1, float Radius);
 };
 
 class CCharacterCore
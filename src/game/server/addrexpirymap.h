@@ -0,0 +1,228 @@
+#ifndef GAME_SERVER_ADDREXPIRYMAP_H
+#define GAME_SERVER_ADDREXPIRYMAP_H
+
+#include <base/system.h>
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+/*
+	Class: Address Expiry Map
+		Entries keyed by the address of a client (the port is ignored)
+		that are valid until a given tick. Lookups go through a hash of
+		the binary address, expiry through a min-heap on the tick, so
+		that neither has to walk all entries.
+
+		An entry is expired once the current tick reached its expiry
+		tick. Expired entries are not returned by <Find>, even if
+		<Expire> didn't remove them yet.
+*/
+template<class T>
+class CAddrExpiryMap
+{
+public:
+	struct CEntry
+	{
+		NETADDR m_Addr;
+		int m_ExpiresTick;
+		T m_Data;
+	};
+
+private:
+	struct CAddrHash
+	{
+		size_t operator()(const NETADDR &Addr) const
+		{
+			// FNV-1a
+			unsigned Hash = 2166136261u ^ Addr.type;
+			for(unsigned i = 0; i < sizeof(Addr.ip); i++)
+				Hash = (Hash ^ Addr.ip[i]) * 16777619u;
+			return Hash;
+		}
+	};
+
+	struct CAddrEqual
+	{
+		bool operator()(const NETADDR &a, const NETADDR &b) const { return net_addr_comp(&a, &b) == 0; }
+	};
+
+	// the heap keeps outdated items of overwritten or removed entries,
+	// they are skipped when they come up
+	struct CHeapItem
+	{
+		int m_ExpiresTick;
+		NETADDR m_Addr;
+
+		bool operator>(const CHeapItem &Other) const { return m_ExpiresTick > Other.m_ExpiresTick; }
+	};
+
+	std::vector<CEntry> m_Entries;
+	std::unordered_map<NETADDR, int, CAddrHash, CAddrEqual> m_Index;
+	std::vector<CHeapItem> m_Heap;
+
+	static NETADDR Key(const NETADDR *pAddr)
+	{
+		NETADDR Addr = *pAddr;
+		Addr.port = 0;
+		return Addr;
+	}
+
+	void PushHeap(const NETADDR &Addr, int ExpiresTick)
+	{
+		// don't let outdated items pile up when entries are updated a lot
+		if(m_Heap.size() > 2*m_Entries.size()+32)
+		{
+			m_Heap.clear();
+			for(const CEntry &Entry : m_Entries)
+				m_Heap.push_back(CHeapItem{Entry.m_ExpiresTick, Entry.m_Addr});
+			std::make_heap(m_Heap.begin(), m_Heap.end(), std::greater<CHeapItem>());
+		}
+		m_Heap.push_back(CHeapItem{ExpiresTick, Addr});
+		std::push_heap(m_Heap.begin(), m_Heap.end(), std::greater<CHeapItem>());
+	}
+
+	void EraseIndex(int Index)
+	{
+		m_Index.erase(m_Entries[Index].m_Addr);
+		if(Index != (int)m_Entries.size()-1)
+		{
+			m_Entries[Index] = std::move(m_Entries.back());
+			m_Index[m_Entries[Index].m_Addr] = Index;
+		}
+		m_Entries.pop_back();
+	}
+
+	// removes the entry with the lowest expiry tick if it is below Tick
+	bool PopBefore(int Tick)
+	{
+		while(!m_Heap.empty() && m_Heap.front().m_ExpiresTick < Tick)
+		{
+			CHeapItem Item = m_Heap.front();
+			std::pop_heap(m_Heap.begin(), m_Heap.end(), std::greater<CHeapItem>());
+			m_Heap.pop_back();
+
+			auto It = m_Index.find(Item.m_Addr);
+			if(It != m_Index.end() && m_Entries[It->second].m_ExpiresTick == Item.m_ExpiresTick)
+			{
+				EraseIndex(It->second);
+				return true;
+			}
+		}
+		return false;
+	}
+
+public:
+	int Size() const { return m_Entries.size(); }
+	CEntry *Get(int Index) { return &m_Entries[Index]; }
+	const CEntry *Get(int Index) const { return &m_Entries[Index]; }
+
+	void Clear()
+	{
+		m_Entries.clear();
+		m_Index.clear();
+		m_Heap.clear();
+	}
+
+	CEntry *Find(const NETADDR *pAddr, int CurrentTick)
+	{
+		auto It = m_Index.find(Key(pAddr));
+		if(It == m_Index.end() || m_Entries[It->second].m_ExpiresTick <= CurrentTick)
+			return 0;
+		return &m_Entries[It->second];
+	}
+
+	// adds the entry or overwrites the one of the same address
+	CEntry *Set(const NETADDR *pAddr, int ExpiresTick, const T &Data)
+	{
+		NETADDR Addr = Key(pAddr);
+		auto It = m_Index.find(Addr);
+		int Index;
+		if(It == m_Index.end())
+		{
+			Index = m_Entries.size();
+			m_Entries.push_back(CEntry{Addr, ExpiresTick, Data});
+			m_Index[Addr] = Index;
+		}
+		else
+		{
+			Index = It->second;
+			m_Entries[Index].m_ExpiresTick = ExpiresTick;
+			m_Entries[Index].m_Data = Data;
+		}
+		PushHeap(Addr, ExpiresTick);
+		return &m_Entries[Index];
+	}
+
+	void SetExpiry(CEntry *pEntry, int ExpiresTick)
+	{
+		if(pEntry->m_ExpiresTick == ExpiresTick)
+			return;
+		pEntry->m_ExpiresTick = ExpiresTick;
+		PushHeap(pEntry->m_Addr, ExpiresTick);
+	}
+
+	bool Remove(const NETADDR *pAddr)
+	{
+		auto It = m_Index.find(Key(pAddr));
+		if(It == m_Index.end())
+			return false;
+		EraseIndex(It->second);
+		return true;
+	}
+
+	void Remove(CEntry *pEntry)
+	{
+		EraseIndex(pEntry - &m_Entries[0]);
+	}
+
+	// removes all entries the function returns true for
+	template<class F>
+	int RemoveIf(F Func)
+	{
+		int Removed = 0;
+		for(int i = 0; i < (int)m_Entries.size(); )
+		{
+			if(Func(m_Entries[i]))
+			{
+				EraseIndex(i);
+				Removed++;
+			}
+			else
+				i++;
+		}
+		return Removed;
+	}
+
+	// removes the expired entries
+	int Expire(int CurrentTick)
+	{
+		int Removed = 0;
+		while(PopBefore(CurrentTick+1))
+			Removed++;
+		return Removed;
+	}
+
+	// removes the entries that expire first until at most MaxSize are left
+	void Trim(int MaxSize)
+	{
+		while((int)m_Entries.size() > MaxSize && PopBefore(0x7fffffff))
+			;
+	}
+
+	// all entries ordered by expiry, for listing them
+	void GetSorted(std::vector<const CEntry *> *pResult) const
+	{
+		pResult->clear();
+		for(const CEntry &Entry : m_Entries)
+			pResult->push_back(&Entry);
+		std::stable_sort(pResult->begin(), pResult->end(), [](const CEntry *pA, const CEntry *pB) {
+			if(pA->m_ExpiresTick != pB->m_ExpiresTick)
+				return pA->m_ExpiresTick < pB->m_ExpiresTick;
+			return net_addr_comp(&pA->m_Addr, &pB->m_Addr) < 0;
+		});
+	}
+};
+
+#endif
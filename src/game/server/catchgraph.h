@@ -0,0 +1,129 @@
+#ifndef GAME_SERVER_CATCHGRAPH_H
+#define GAME_SERVER_CATCHGRAPH_H
+
+#include <base/system.h>
+#include <engine/shared/protocol.h>
+
+#include <bitset>
+
+/*
+	Class: Catch Graph
+		Who caught whom. Every player is caught by at most one other
+		player, so the relation is kept as a caught-by array. Each
+		catcher additionally has a bitset of its victims for counting
+		and membership tests, and the victims are chained into a
+		release stack through per-player links, so that the last caught
+		player is released first and any victim can be removed in
+		constant time.
+
+		The graph also knows which players are ingame (not spectating),
+		so that the number of ingame players doesn't need a scan either.
+*/
+class CCatchGraph
+{
+public:
+	typedef std::bitset<MAX_CLIENTS> CPlayerSet;
+
+	enum
+	{
+		NOT_CAUGHT=-1,
+	};
+
+private:
+	int m_aCaughtBy[MAX_CLIENTS];
+	// release stack, previous is the victim caught before
+	int m_aPrevious[MAX_CLIENTS];
+	int m_aNext[MAX_CLIENTS];
+	int m_aLastCaught[MAX_CLIENTS];
+
+	CPlayerSet m_aVictims[MAX_CLIENTS];
+	CPlayerSet m_Caught;
+	CPlayerSet m_Ingame;
+
+public:
+	CCatchGraph() { Clear(); }
+
+	void Clear()
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			m_aCaughtBy[i] = NOT_CAUGHT;
+			m_aPrevious[i] = NOT_CAUGHT;
+			m_aNext[i] = NOT_CAUGHT;
+			m_aLastCaught[i] = NOT_CAUGHT;
+			m_aVictims[i].reset();
+		}
+		m_Caught.reset();
+		m_Ingame.reset();
+	}
+
+	// puts Victim on top of the release stack of Catcher
+	void Catch(int Catcher, int Victim)
+	{
+		dbg_assert(Catcher >= 0 && Catcher < MAX_CLIENTS && Victim >= 0 && Victim < MAX_CLIENTS && Catcher != Victim, "invalid catch");
+		Release(Victim);
+
+		m_aCaughtBy[Victim] = Catcher;
+		m_aPrevious[Victim] = m_aLastCaught[Catcher];
+		m_aNext[Victim] = NOT_CAUGHT;
+		if(m_aLastCaught[Catcher] != NOT_CAUGHT)
+			m_aNext[m_aLastCaught[Catcher]] = Victim;
+		m_aLastCaught[Catcher] = Victim;
+
+		m_aVictims[Catcher].set(Victim);
+		m_Caught.set(Victim);
+	}
+
+	// takes Victim out of the release stack of its catcher, returns the catcher
+	int Release(int Victim)
+	{
+		int Catcher = m_aCaughtBy[Victim];
+		if(Catcher == NOT_CAUGHT)
+			return NOT_CAUGHT;
+
+		if(m_aPrevious[Victim] != NOT_CAUGHT)
+			m_aNext[m_aPrevious[Victim]] = m_aNext[Victim];
+		if(m_aNext[Victim] != NOT_CAUGHT)
+			m_aPrevious[m_aNext[Victim]] = m_aPrevious[Victim];
+		else
+			m_aLastCaught[Catcher] = m_aPrevious[Victim];
+
+		m_aCaughtBy[Victim] = NOT_CAUGHT;
+		m_aPrevious[Victim] = NOT_CAUGHT;
+		m_aNext[Victim] = NOT_CAUGHT;
+
+		m_aVictims[Catcher].reset(Victim);
+		m_Caught.reset(Victim);
+		return Catcher;
+	}
+
+	// forgets a leaving player, both as victim and as catcher
+	void Remove(int ClientID)
+	{
+		Release(ClientID);
+		while(m_aLastCaught[ClientID] != NOT_CAUGHT)
+			Release(m_aLastCaught[ClientID]);
+		m_Ingame.reset(ClientID);
+	}
+
+	void SetIngame(int ClientID, bool Ingame) { m_Ingame.set(ClientID, Ingame); }
+
+	int CaughtBy(int Victim) const { return m_aCaughtBy[Victim]; }
+	bool IsCaught(int Victim) const { return m_Caught.test(Victim); }
+	bool IsCaughtBy(int Victim, int Catcher) const { return m_aVictims[Catcher].test(Victim); }
+
+	// top of the release stack
+	int LastCaught(int Catcher) const { return m_aLastCaught[Catcher]; }
+	// the victim below in the release stack
+	int CaughtBefore(int Victim) const { return m_aPrevious[Victim]; }
+
+	int NumCaught(int Catcher) const { return m_aVictims[Catcher].count(); }
+	int NumCaught() const { return m_Caught.count(); }
+	int NumIngame() const { return m_Ingame.count(); }
+
+	const CPlayerSet &Victims(int Catcher) const { return m_aVictims[Catcher]; }
+	const CPlayerSet &Caught() const { return m_Caught; }
+	const CPlayerSet &Ingame() const { return m_Ingame; }
+};
+
+#endif
@@ -11,9 +11,22 @@
 CEventHandler::CEventHandler()
 {
 	m_pGameServer = 0;
+	m_EventsCapacity = 128;
+	m_pEvents = static_cast<CEvent *>(mem_alloc(m_EventsCapacity*sizeof(CEvent), sizeof(void*)));
+	m_DataCapacity = 128*64;
+	m_pData = static_cast<char *>(mem_alloc(m_DataCapacity, sizeof(void*)));
+	m_HashTableSize = 0;
+	m_pHashTable = 0;
 	Clear();
 }
 
+CEventHandler::~CEventHandler()
+{
+	mem_free(m_pEvents);
+	mem_free(m_pData);
+	mem_free(m_pHashTable);
+}
+
 void CEventHandler::SetGameServer(CGameContext *pGameServer)
 {
 	m_pGameServer = pGameServer;
@@ -26,13 +39,34 @@ void *CEventHandler::Create(int Type, int Size, int64 Mask)
 	if(m_CurrentOffset+Size >= MAX_DATASIZE)
 		return 0;
 
-	void *p = &m_aData[m_CurrentOffset];
-	m_aOffsets[m_NumEvents] = m_CurrentOffset;
-	m_aTypes[m_NumEvents] = Type;
-	m_aSizes[m_NumEvents] = Size;
-	m_aClientMasks[m_NumEvents] = Mask;
+	if(m_NumEvents == m_EventsCapacity)
+	{
+		int NewCapacity = min(m_EventsCapacity*2, MAX_EVENTS);
+		CEvent *pNewEvents = static_cast<CEvent *>(mem_alloc(NewCapacity*sizeof(CEvent), sizeof(void*)));
+		mem_copy(pNewEvents, m_pEvents, m_NumEvents*sizeof(CEvent));
+		mem_free(m_pEvents);
+		m_pEvents = pNewEvents;
+		m_EventsCapacity = NewCapacity;
+	}
+	if(m_CurrentOffset+Size > m_DataCapacity)
+	{
+		int NewCapacity = min(m_DataCapacity*2, MAX_DATASIZE);
+		char *pNewData = static_cast<char *>(mem_alloc(NewCapacity, sizeof(void*)));
+		mem_copy(pNewData, m_pData, m_CurrentOffset);
+		mem_free(m_pData);
+		m_pData = pNewData;
+		m_DataCapacity = NewCapacity;
+	}
+
+	void *p = &m_pData[m_CurrentOffset];
+	CEvent *pEvent = &m_pEvents[m_NumEvents];
+	pEvent->m_Offset = m_CurrentOffset;
+	pEvent->m_Type = Type;
+	pEvent->m_Size = Size;
+	pEvent->m_ClientMask = Mask;
 	m_CurrentOffset += Size;
 	m_NumEvents++;
+	m_Prepared = false;
 	return p;
 }
 
@@ -40,21 +74,97 @@ void CEventHandler::Clear()
 {
 	m_NumEvents = 0;
 	m_CurrentOffset = 0;
+	m_Prepared = false;
 }
 
-void CEventHandler::Snap(int SnappingClient)
+bool CEventHandler::IsEqual(const CEvent *pA, const CEvent *pB) const
 {
+	return pA->m_Type == pB->m_Type && pA->m_Size == pB->m_Size &&
+		mem_comp(&m_pData[pA->m_Offset], &m_pData[pB->m_Offset], pA->m_Size) == 0;
+}
+
+unsigned CEventHandler::Hash(const CEvent *pEvent) const
+{
+	// FNV-1a
+	unsigned Hash = 2166136261u ^ (unsigned)pEvent->m_Type;
+	const unsigned char *pData = (const unsigned char *)&m_pData[pEvent->m_Offset];
+	for(int i = 0; i < pEvent->m_Size; i++)
+		Hash = (Hash ^ pData[i]) * 16777619u;
+	return Hash;
+}
+
+void CEventHandler::Merge()
+{
+	int TableSize = 16;
+	while(TableSize < m_NumEvents*2)
+		TableSize *= 2;
+	if(TableSize > m_HashTableSize)
+	{
+		mem_free(m_pHashTable);
+		m_pHashTable = static_cast<int *>(mem_alloc(TableSize*sizeof(int), sizeof(int)));
+		m_HashTableSize = TableSize;
+	}
+	for(int i = 0; i < TableSize; i++)
+		m_pHashTable[i] = -1;
+
+	// identical events only have to be sent once, to everybody that wanted
+	// one of them. damage indicators are kept as the client adds them up.
+	int NumEvents = 0;
 	for(int i = 0; i < m_NumEvents; i++)
 	{
-		if(SnappingClient == -1 || CmaskIsSet(m_aClientMasks[i], SnappingClient))
+		CEvent *pEvent = &m_pEvents[i];
+		if(pEvent->m_Type != NETEVENTTYPE_DAMAGE)
 		{
-			CNetEvent_Common *ev = (CNetEvent_Common *)&m_aData[m_aOffsets[i]];
-			if(SnappingClient == -1 || distance(GameServer()->m_apPlayers[SnappingClient]->m_ViewPos, vec2(ev->m_X, ev->m_Y)) < 1500.0f)
+			int Slot = Hash(pEvent)&(TableSize-1);
+			while(m_pHashTable[Slot] != -1 && !IsEqual(&m_pEvents[m_pHashTable[Slot]], pEvent))
+				Slot = (Slot+1)&(TableSize-1);
+
+			if(m_pHashTable[Slot] != -1)
 			{
-				void *d = GameServer()->Server()->SnapNewItem(m_aTypes[i], i, m_aSizes[i]);
-				if(d)
-					mem_copy(d, &m_aData[m_aOffsets[i]], m_aSizes[i]);
+				m_pEvents[m_pHashTable[Slot]].m_ClientMask |= pEvent->m_ClientMask;
+				continue;
 			}
+			m_pHashTable[Slot] = NumEvents;
+		}
+		m_pEvents[NumEvents++] = *pEvent;
+	}
+	m_NumEvents = NumEvents;
+}
+
+void CEventHandler::Prepare()
+{
+	Merge();
+
+	// find out once which clients see which event
+	for(int i = 0; i < m_NumEvents; i++)
+	{
+		CEvent *pEvent = &m_pEvents[i];
+		const CNetEvent_Common *pCommon = (const CNetEvent_Common *)&m_pData[pEvent->m_Offset];
+		vec2 Pos = vec2(pCommon->m_X, pCommon->m_Y);
+		pEvent->m_VisibleMask = 0;
+		for(int c = 0; c < MAX_CLIENTS; c++)
+		{
+			if(GameServer()->m_apPlayers[c] && CmaskIsSet(pEvent->m_ClientMask, c) &&
+				distance(GameServer()->m_apPlayers[c]->m_ViewPos, Pos) < 1500.0f)
+				pEvent->m_VisibleMask |= CmaskOne(c);
+		}
+	}
+	m_Prepared = true;
+}
+
+void CEventHandler::Snap(int SnappingClient)
+{
+	if(!m_Prepared)
+		Prepare();
+
+	for(int i = 0; i < m_NumEvents; i++)
+	{
+		const CEvent *pEvent = &m_pEvents[i];
+		if(SnappingClient == -1 || CmaskIsSet(pEvent->m_VisibleMask, SnappingClient))
+		{
+			void *d = GameServer()->Server()->SnapNewItem(pEvent->m_Type, i, pEvent->m_Size);
+			if(d)
+				mem_copy(d, &m_pData[pEvent->m_Offset], pEvent->m_Size);
 		}
 	}
 }
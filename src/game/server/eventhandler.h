@@ -3,27 +3,51 @@
 #ifndef GAME_SERVER_EVENTHANDLER_H
 #define GAME_SERVER_EVENTHANDLER_H
 
-//
+#include <base/system.h>
+
+// Collects the events of the ticks between two snapshots. Event and data
+// storage grow on demand and are reused after Clear(). Before the first
+// client is snapped, identical events are merged and the visibility of every
+// event is determined for all clients at once.
 class CEventHandler
 {
-	static const int MAX_EVENTS = 128;
-	static const int MAX_DATASIZE = 128*64;
+	// a snapshot can't hold more than that anyway
+	static const int MAX_EVENTS = 1024;
+	static const int MAX_DATASIZE = 64*1024;
+
+	struct CEvent
+	{
+		int m_Type;
+		int m_Offset;
+		int m_Size;
+		int64 m_ClientMask;
+		int64 m_VisibleMask;
+	};
 
-	int m_aTypes[MAX_EVENTS]; // TODO: remove some of these arrays
-	int m_aOffsets[MAX_EVENTS];
-	int m_aSizes[MAX_EVENTS];
-	int64 m_aClientMasks[MAX_EVENTS];
-	char m_aData[MAX_DATASIZE];
+	CEvent *m_pEvents;
+	int m_EventsCapacity;
+	char *m_pData;
+	int m_DataCapacity;
+	int *m_pHashTable;
+	int m_HashTableSize;
 
 	class CGameContext *m_pGameServer;
 
 	int m_CurrentOffset;
 	int m_NumEvents;
+	bool m_Prepared;
+
+	bool IsEqual(const CEvent *pA, const CEvent *pB) const;
+	unsigned Hash(const CEvent *pEvent) const;
+	void Merge();
+	void Prepare();
+
 public:
 	CGameContext *GameServer() const { return m_pGameServer; }
 	void SetGameServer(CGameContext *pGameServer);
 
 	CEventHandler();
+	~CEventHandler();
 	void *Create(int Type, int Size, int64 Mask = -1);
 	void Clear();
 	void Snap(int SnappingClient);
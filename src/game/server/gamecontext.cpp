@@ -37,7 +37,11 @@ void CGameContext::Construct(int Resetting)
 	m_pServer = 0;
 
 	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
 		m_apPlayers[i] = 0;
+		m_aSkinChangeQueued[i] = false;
+		m_aBroadcastQueued[i] = false;
+	}
 
 	m_pController = 0;
 	m_VoteCloseTime = 0;
@@ -453,6 +457,69 @@ void CGameContext::SendSkinChange(int ClientID, int TargetID)
 	Server()->SendPackMsg(&Msg, MSGFLAG_VITAL|MSGFLAG_NORECORD, TargetID);
 }
 
+void CGameContext::QueueSkinChange(int ClientID)
+{
+	m_aSkinChangeQueued[ClientID] = true;
+}
+
+void CGameContext::QueueBroadcast(const char *pText, int ClientID)
+{
+	str_copy(m_aaQueuedBroadcasts[ClientID], pText, sizeof(m_aaQueuedBroadcasts[ClientID]));
+	m_aBroadcastQueued[ClientID] = true;
+}
+
+void CGameContext::FlushQueuedMessages()
+{
+	// the skin of a player goes to everyone, pack it once for all of them
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(!m_aSkinChangeQueued[i])
+			continue;
+		m_aSkinChangeQueued[i] = false;
+		if(!m_apPlayers[i])
+			continue;
+
+		CNetMsg_Sv_SkinChange Msg;
+		Msg.m_ClientID = i;
+		for(int p = 0; p < NUM_SKINPARTS; p++)
+		{
+			Msg.m_apSkinPartNames[p] = m_apPlayers[i]->m_TeeInfos.m_aaSkinPartNames[p];
+			Msg.m_aUseCustomColors[p] = m_apPlayers[i]->m_TeeInfos.m_aUseCustomColors[p];
+			Msg.m_aSkinPartColors[p] = m_apPlayers[i]->m_TeeInfos.m_aSkinPartColors[p];
+		}
+		CMsgPacker Packer(Msg.MsgID(), false);
+		if(Msg.Pack(&Packer))
+			continue;
+
+		for(int TargetID : PlayerIDs())
+		{
+			if(m_apPlayers[TargetID])
+				Server()->SendMsg(&Packer, MSGFLAG_VITAL|MSGFLAG_NORECORD, TargetID);
+		}
+	}
+
+	// players with the same broadcast text share the packed message
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(!m_aBroadcastQueued[i])
+			continue;
+
+		CNetMsg_Sv_Broadcast Msg;
+		Msg.m_pMessage = m_aaQueuedBroadcasts[i];
+		CMsgPacker Packer(Msg.MsgID(), false);
+		bool Packed = !Msg.Pack(&Packer);
+
+		for(int j = i; j < MAX_CLIENTS; j++)
+		{
+			if(!m_aBroadcastQueued[j] || str_comp(m_aaQueuedBroadcasts[j], m_aaQueuedBroadcasts[i]) != 0)
+				continue;
+			m_aBroadcastQueued[j] = false;
+			if(Packed)
+				Server()->SendMsg(&Packer, MSGFLAG_VITAL, j);
+		}
+	}
+}
+
 void CGameContext::SendGameMsg(int GameMsgID, int ClientID)
 {
 	CMsgPacker Msg(NETMSGTYPE_SV_GAMEMSG);
@@ -718,6 +785,7 @@ void CGameContext::OnTick()
 		}
 	}
 
+	FlushQueuedMessages();
 
 #ifdef CONF_DEBUG
 	for(int i = 0; i < MAX_CLIENTS; i++)
@@ -910,6 +978,8 @@ void CGameContext::OnClientDrop(int ClientID, const char *pReason)
 
 	delete m_apPlayers[ClientID];
 	m_apPlayers[ClientID] = 0;
+	m_aSkinChangeQueued[ClientID] = false;
+	m_aBroadcastQueued[ClientID] = false;
 
 	m_VoteUpdate = true;
 }
@@ -1880,19 +1950,8 @@ IGameServer *CreateGameServer() { return new CGameContext; }
 
 bool CGameContext::UnmuteID(int ClientID)
 {
-	char aAddrStr[NETADDR_MAXSTRSIZE] = {0};
-	Server()->GetClientAddr(ClientID, aAddrStr, sizeof(aAddrStr));
-	std::string IP{aAddrStr};
-
-	bool success = false;
-	auto it = std::remove_if(m_Mutes.begin(), m_Mutes.end(), [&IP, &success](auto& Mute) -> bool{
-		if(IP == Mute.m_IP)
-			success = true;
-
-		return IP == Mute.m_IP;
-	});
-
-	m_Mutes.erase(it, m_Mutes.end());
+	NETADDR Addr;
+	bool success = Server()->GetClientAddr(ClientID, &Addr) && m_Mutes.Remove(&Addr);
 
 	char aBuf[128];
 	str_format(aBuf, sizeof(aBuf), "%s has been unmuted.", Server()->ClientName(ClientID));
@@ -1903,26 +1962,29 @@ bool CGameContext::UnmuteID(int ClientID)
 bool CGameContext::UnmuteIndex(int Index)
 {
 	// TODO: proper logging for mutes and votebans and troll pit
-	if(Index < 0 || static_cast<int>(m_Mutes.size()) - 1 < Index)
+	// indices are the ones of the mutes command, ordered by expiration
+	std::vector<const CMuteMap::CEntry *> Mutes;
+	m_Mutes.GetSorted(&Mutes);
+	if(Index < 0 || static_cast<int>(Mutes.size()) - 1 < Index)
 		return false;
 
 	char aBuf[128];
-	str_format(aBuf, sizeof(aBuf), "%s has been unmuted.", m_Mutes[Index].m_Nickname.c_str());
+	str_format(aBuf, sizeof(aBuf), "%s has been unmuted.", Mutes[Index]->m_Data.m_Nickname.c_str());
 	SendServerMessage(-1, aBuf);
 
-	m_Mutes.erase(m_Mutes.begin() + Index);
+	m_Mutes.Remove(&Mutes[Index]->m_Addr);
 	return true;
 }
 
-void CGameContext::AddMute(const char* pIP, int Secs, std::string Nickname, std::string Reason, bool Auto)
+void CGameContext::AddMute(const NETADDR *pAddr, int Secs, std::string Nickname, std::string Reason, bool Auto)
 {
-	int Pos = IsMuted(pIP);
-	if(Pos > -1)
-		m_Mutes[Pos].m_ExpiresTick = Server()->TickSpeed() * Secs + Server()->Tick();	// overwrite mute
+	CleanMutes();
+	int ExpiresTick = Server()->Tick() + Server()->TickSpeed() * Secs;
+	CMuteMap::CEntry *pMute = m_Mutes.Find(pAddr, Server()->Tick());
+	if(pMute)
+		m_Mutes.SetExpiry(pMute, ExpiresTick);	// overwrite mute
 	else
-	{
-		m_Mutes.emplace_back(pIP, Server()->Tick() + Server()->TickSpeed() * Secs, Nickname, Reason);
-	}
+		m_Mutes.Set(pAddr, ExpiresTick, CMute{Nickname, Reason});
 
 	char aBuf[128];
 	if(Secs > 0)
@@ -1936,46 +1998,24 @@ void CGameContext::AddMute(const char* pIP, int Secs, std::string Nickname, std:
 
 void CGameContext::AddMute(int ClientID, int Secs, std::string Nickname, std::string Reason, bool Auto)
 {
-	char aAddrStr[NETADDR_MAXSTRSIZE] = {0};
-	Server()->GetClientAddr(ClientID, aAddrStr, sizeof(aAddrStr));
-	AddMute(aAddrStr, Secs, Nickname, Reason, Auto);
+	NETADDR Addr;
+	if(Server()->GetClientAddr(ClientID, &Addr))
+		AddMute(&Addr, Secs, Nickname, Reason, Auto);
 }
 
-int CGameContext::IsMuted(const char *pIP)
+const CGameContext::CMuteMap::CEntry *CGameContext::FindMute(int ClientID)
 {
 	CleanMutes();
-	int Pos = -1;
-	size_t size = m_Mutes.size();
-	for (size_t i = 0; i < size; i++)
-	{
-		const char* currentIP = m_Mutes[i].m_IP.c_str();
-
-		if(!str_comp_num(pIP, currentIP, sizeof(currentIP)))
-		{
-			Pos = i;
-			break;
-		}
-	}
-	
-	return Pos;
-}
-
-int CGameContext::IsMuted(int ClientID)
-{
-	char aIP[NETADDR_MAXSTRSIZE] = {0};
-	Server()->GetClientAddr(ClientID, aIP, sizeof(aIP));
-	return IsMuted(aIP);
+	NETADDR Addr;
+	if(!Server()->GetClientAddr(ClientID, &Addr))
+		return 0;
+	return m_Mutes.Find(&Addr, Server()->Tick());
 }
 
 void CGameContext::CleanMutes()
 {
-	int CurrentTick = Server()->Tick();
-	auto it = std::remove_if(m_Mutes.begin(), m_Mutes.end(), [CurrentTick](CMute& lookedAtMute) -> bool
-	{
-		// remove from mutes if expiration tick is reached.
-		return lookedAtMute.m_ExpiresTick < CurrentTick;
-	});
-	m_Mutes.erase(it, m_Mutes.end());
+	// only looks at the mutes that actually expired
+	m_Mutes.Expire(Server()->Tick());
 }
 
 void CGameContext::ConMute(IConsole::IResult *pResult, void *pUserData)
@@ -1995,21 +2035,25 @@ void CGameContext::ConMutes(IConsole::IResult *pResult, void *pUserData)
 	CGameContext *pSelf = (CGameContext*)pUserData;
 	pSelf->CleanMutes();
 	char aBuf[128];
-	auto& Mutes = pSelf->m_Mutes;
+	std::vector<const CMuteMap::CEntry *> Mutes;
+	pSelf->m_Mutes.GetSorted(&Mutes);
 	int Sec;
 	int Size = Mutes.size();
 
 	for(int i = 0; i < Size; i++)
 	{
-		Sec = (pSelf->m_Mutes.at(i).m_ExpiresTick - pSelf->Server()->Tick())/pSelf->Server()->TickSpeed();
+		Sec = (Mutes[i]->m_ExpiresTick - pSelf->Server()->Tick())/pSelf->Server()->TickSpeed();
+		char aAddrStr[NETADDR_MAXSTRSIZE];
+		net_addr_str(&Mutes[i]->m_Addr, aAddrStr, sizeof(aAddrStr), false);
+		const CMute &Mute = Mutes[i]->m_Data;
 
-		if(Mutes[i].m_Reason.size() > 0)
+		if(Mute.m_Reason.size() > 0)
 		{
-			str_format(aBuf, sizeof(aBuf), "#%d: %s for %d:%02d min; Nickname: '%s' Reason: '%s'", i, Mutes[i].m_IP.c_str(), Sec/60, Sec%60, Mutes[i].m_Nickname.c_str(), Mutes[i].m_Reason.c_str());
+			str_format(aBuf, sizeof(aBuf), "#%d: %s for %d:%02d min; Nickname: '%s' Reason: '%s'", i, aAddrStr, Sec/60, Sec%60, Mute.m_Nickname.c_str(), Mute.m_Reason.c_str());
 		}
 		else
 		{
-			str_format(aBuf, sizeof(aBuf), "#%d: %s for %d:%02d min; Nickname: '%s'", i, Mutes[i].m_IP.c_str(), Sec/60, Sec%60, Mutes[i].m_Nickname.c_str());
+			str_format(aBuf, sizeof(aBuf), "#%d: %s for %d:%02d min; Nickname: '%s'", i, aAddrStr, Sec/60, Sec%60, Mute.m_Nickname.c_str());
 		}
 
 		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "mute", aBuf);
@@ -2024,14 +2068,11 @@ void CGameContext::ConUnmute(IConsole::IResult *pResult, void *pUserData)
 	CGameContext *pSelf = (CGameContext*)pUserData;
 	int Index = pResult->GetInteger(0);
 
-	if(Index < 0 ||  pSelf->m_Mutes.size() - 1 < static_cast<size_t>(Index))
+	pSelf->CleanMutes();
+	if(!pSelf->UnmuteIndex(Index))
 	{
 		pSelf->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "mute", "Invalid index!");
 	}
-	else
-	{
-		pSelf->UnmuteIndex(Index);
-	}
 }
 
 // returns whether the player is allowed to chat, informs the player and mutes him if needed
@@ -2039,11 +2080,11 @@ bool CGameContext::IsAllowedToChat(int ClientID)
 {
 	CPlayer* pPlayer = m_apPlayers[ClientID];
 
-	int i = IsMuted(ClientID);
-	if(i > -1)
+	const CMuteMap::CEntry *pMute = FindMute(ClientID);
+	if(pMute)
 	{
 		char aBuf[48];
-		int ExpiresSeconds = (m_Mutes[i].m_ExpiresTick - Server()->Tick())/Server()->TickSpeed();
+		int ExpiresSeconds = (pMute->m_ExpiresTick - Server()->Tick())/Server()->TickSpeed();
 		str_format(aBuf, sizeof(aBuf), "You are muted for %d:%02d min.", ExpiresSeconds/60, ExpiresSeconds%60);
 		SendServerMessage(ClientID, aBuf);
 		return false;
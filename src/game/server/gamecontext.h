@@ -10,6 +10,8 @@
 #include <game/layers.h>
 #include <game/voting.h>
 
+#include "addrexpirymap.h"
+#include "catchgraph.h"
 #include "eventhandler.h"
 #include "gamecontroller.h"
 #include "gameworld.h"
@@ -107,6 +109,17 @@ class CGameContext : public IGameServer
 	// and removed when leaving.
 	std::vector<int> m_PlayerIDs;
 
+	// skin changes and broadcasts queued during a tick, they are coalesced
+	// per player and every distinct message is packed only once
+	enum
+	{
+		QUEUED_BROADCAST_LENGTH=128,
+	};
+	bool m_aSkinChangeQueued[MAX_CLIENTS];
+	bool m_aBroadcastQueued[MAX_CLIENTS];
+	char m_aaQueuedBroadcasts[MAX_CLIENTS][QUEUED_BROADCAST_LENGTH];
+	void FlushQueuedMessages();
+
 
 public:
 	IServer *Server() const { return m_pServer; }
@@ -121,6 +134,8 @@ public:
 
 	CEventHandler m_Events;
 	class CPlayer *m_apPlayers[MAX_CLIENTS];
+	// who caught whom, kept up to date by the players
+	CCatchGraph m_CatchGraph;
 
 	class IGameController *m_pController;
 	CGameWorld m_World;
@@ -188,6 +203,10 @@ public:
 	void SendSettings(int ClientID);
 	void SendSkinChange(int ClientID, int TargetID);
 
+	// sent to everyone at the end of the tick, later calls within the tick replace earlier ones
+	void QueueSkinChange(int ClientID);
+	void QueueBroadcast(const char *pText, int ClientID);
+
 	void SendGameMsg(int GameMsgID, int ClientID);
 	void SendGameMsg(int GameMsgID, int ParaI1, int ClientID);
 	void SendGameMsg(int GameMsgID, int ParaI1, int ParaI2, int ParaI3, int ClientID);
@@ -235,27 +254,20 @@ public:
 	// mutes
 	struct CMute
 	{
-		CMute(const char* pIP, int ExpirationTick, std::string Nickname = {}, std::string Reason = {}) : 
-			m_IP{pIP}, m_ExpiresTick{ExpirationTick}, m_Nickname{Nickname}, m_Reason{Reason}
-		{
-		};
-		std::string m_IP;
-		int m_ExpiresTick;
 		std::string m_Nickname;
 		std::string m_Reason;
 	};
+	typedef CAddrExpiryMap<CMute> CMuteMap;
 
-	std::vector<CMute> m_Mutes;
-	void AddMute(const char* pIP, int Secs, std::string Nickname, std::string Reason, bool Auto = false);
+	CMuteMap m_Mutes;
+	void AddMute(const NETADDR *pAddr, int Secs, std::string Nickname, std::string Reason, bool Auto = false);
 	void AddMute(int ClientID, int Secs, std::string Nickname, std::string Reason, bool Auto = false);
 
 	bool UnmuteIndex(int Index);
 	bool UnmuteID(int ClientID);
 
-	// returns -1 if is not mutes, otherwise returns the 
-	// index of position, at which to find the mute
-	int IsMuted(const char *pIP);
-	int IsMuted(int ClientID);
+	// returns 0 if the client is not muted
+	const CMuteMap::CEntry *FindMute(int ClientID);
 
 	// remove expired mutes
 	void CleanMutes();
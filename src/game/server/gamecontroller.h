@@ -9,6 +9,8 @@
 #include <generated/protocol.h>
 #include <engine/shared/config.h>
 
+#include "spawneval.h"
+
 #include <functional>
 
 /*
@@ -75,26 +77,7 @@ private:
 	void CycleMap();
 
 	// spawn
-	struct CSpawnEval
-	{
-		CSpawnEval()
-		{
-			m_Got = false;
-			m_FriendlyTeam = -1;
-			m_Pos = vec2(100,100);
-		}
-
-		vec2 m_Pos;
-		bool m_Got;
-		bool m_RandomSpawn;
-		int m_FriendlyTeam;
-		float m_Score;
-	};
-	vec2 m_aaSpawnPoints[3][64];
-	int m_aNumSpawnPoints[3];
-	
-	float EvaluateSpawnPos(CSpawnEval *pEval, vec2 Pos) const;
-	void EvaluateSpawnType(CSpawnEval *pEval, int Type) const;
+	CSpawnEvaluator m_SpawnEvaluator;
 
 	// team
 	int ClampTeam(int Team) const;
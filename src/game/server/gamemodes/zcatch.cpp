@@ -35,11 +35,6 @@ CGameControllerZCATCH::CGameControllerZCATCH(CGameContext *pGameServer) : IGameC
 	InitRankingServer();	
 
 	
-	// reserve double the needed space, 
-	// in order to not have any reallocations
-	// mid game
-	m_LeftCaughtCache.reserve(MAX_CLIENTS * 2 * 2);
-	
 	for (size_t i = 0; i < MAX_CLIENTS; i++)
 	{
 		m_PlayerKickTicksCountdown[i] = NO_KICK;
@@ -173,7 +168,12 @@ void CGameControllerZCATCH::InitRankingServer()
 	}
 	else if (DatabaseType == "sqlite" || DatabaseType == "sqlite3")
 	{
-		m_pRankingServer = new CSQLiteRankingServer{g_Config.m_SvSQLiteFilename, {GetDatabasePrefix()}};
+		CSQLiteSettings Settings;
+		Settings.m_WriteAheadLog = g_Config.m_SvSQLiteWal;
+		Settings.m_Synchronous = g_Config.m_SvSQLiteSynchronous;
+		Settings.m_CacheSizeKiB = g_Config.m_SvSQLiteCacheSize;
+		Settings.m_NumReaders = g_Config.m_SvSQLiteReaders;
+		m_pRankingServer = new CSQLiteRankingServer{g_Config.m_SvSQLiteFilename, {GetDatabasePrefix()}, 10000, false, Settings};
 	}
 	
 }
@@ -734,7 +734,31 @@ void CGameControllerZCATCH::EndRound()
 	// Change game state
 	IGameController::EndRound();
 
-	
+	// the round has a winner if exactly one of several players survived
+	int IngamePlayers = 0;
+	int AlivePlayers = 0;
+	CPlayer *pWinner = nullptr;
+	for (int ID : GameServer()->PlayerIDs())
+	{
+		CPlayer *pIngamePlayer = GameServer()->m_apPlayers[ID];
+		if (!pIngamePlayer || pIngamePlayer->GetTeam() == TEAM_SPECTATORS)
+			continue;
+
+		IngamePlayers++;
+		if (pIngamePlayer->IsNotCaught())
+		{
+			AlivePlayers++;
+			pWinner = pIngamePlayer;
+		}
+	}
+	if (IngamePlayers < 2 || AlivePlayers != 1)
+		pWinner = nullptr;
+
+	// before the caught players are released
+	Server()->DemoRecorder_HandleRoundEnd(m_GameStartTick,
+		pWinner ? Server()->ClientName(pWinner->GetCID()) : "",
+		pWinner ? pWinner->GetNumTotalCaughtPlayers() : 0);
+
 	CPlayer *pPlayer = nullptr;
 
 	for (int ID : GameServer()->PlayerIDs())
@@ -1347,18 +1371,9 @@ void CGameControllerZCATCH::OnPlayerInfoChange(class CPlayer *pPlayer)
 
 void CGameControllerZCATCH::UpdateIngamePlayerCount()
 {
-	CPlayer* pTmpPlayer = nullptr;
-	
+	// the players keep their team in the catch graph
 	m_PreviousIngamePlayerCount = m_IngamePlayerCount;
-	m_IngamePlayerCount = 0;
-
-	for(int ClientID : GameServer()->PlayerIDs())
-	{
-		pTmpPlayer = GameServer()->m_apPlayers[ClientID];
-		if(pTmpPlayer && pTmpPlayer->GetTeam() != TEAM_SPECTATORS)
-			++m_IngamePlayerCount;
-		pTmpPlayer = nullptr;
-	}
+	m_IngamePlayerCount = GameServer()->m_CatchGraph.NumIngame();
 }
 
 void CGameControllerZCATCH::UpdateBroadcastOf(std::initializer_list<int> IDs)
@@ -1383,11 +1398,11 @@ void CGameControllerZCATCH::UpdateBroadcastOf(std::initializer_list<int> IDs)
 				if (enemiesLeft > 0)
 				{
 					str_format(aBuf, sizeof(aBuf), "%d enem%s left", enemiesLeft, enemiesLeft == 1 ? "y" : "ies");
-					GameServer()->SendBroadcast(aBuf, ID);
+					GameServer()->QueueBroadcast(aBuf, ID);
 				}
 				else
 				{
-					GameServer()->SendBroadcast("", ID);
+					GameServer()->QueueBroadcast("", ID);
 				}
 			}
 			else
@@ -1395,7 +1410,7 @@ void CGameControllerZCATCH::UpdateBroadcastOf(std::initializer_list<int> IDs)
 				// Spectating players should not receive any visible broadcasts
 				// this is basically updated, when someone joins the spectators
 				// in order to hide the enemies left counter
-				GameServer()->SendBroadcast("", ID);
+				GameServer()->QueueBroadcast("", ID);
 			}
 		}		
 		pTmpPlayer = nullptr;
@@ -1425,11 +1440,11 @@ void CGameControllerZCATCH::UpdateBroadcastOfEverybody()
 				if (enemiesLeft > 0)
 				{
 					str_format(aBuf, sizeof(aBuf), "%d enem%s left", enemiesLeft, enemiesLeft == 1 ? "y" : "ies");
-					GameServer()->SendBroadcast(aBuf, i);
+					GameServer()->QueueBroadcast(aBuf, i);
 				}
 				else
 				{
-					GameServer()->SendBroadcast("", i);
+					GameServer()->QueueBroadcast("", i);
 				}
 			}
 			else
@@ -1437,7 +1452,7 @@ void CGameControllerZCATCH::UpdateBroadcastOfEverybody()
 				// Spectating players should not receive any visible broadcasts
 				// this is basically updated, when someone joins the spectators
 				// in order to hide the enemies left counter
-				GameServer()->SendBroadcast("", i);
+				GameServer()->QueueBroadcast("", i);
 			}
 		}		
 		pTmpPlayer = nullptr;
@@ -1471,11 +1486,11 @@ void CGameControllerZCATCH::RefreshBroadcast()
 				if (enemiesLeft > 0)
 				{
 					str_format(aBuf, sizeof(aBuf), "%d enem%s left", enemiesLeft, enemiesLeft == 1 ? "y" : "ies");
-					GameServer()->SendBroadcast(aBuf, i);
+					GameServer()->QueueBroadcast(aBuf, i);
 				}
 				else
 				{
-					GameServer()->SendBroadcast("", i);
+					GameServer()->QueueBroadcast("", i);
 				}
 			}
 			else
@@ -1491,33 +1506,20 @@ void CGameControllerZCATCH::RefreshBroadcast()
 
 void CGameControllerZCATCH::UpdateSkinsOf(std::initializer_list<int> IDs)
 {
-	for (int toID : GameServer()->PlayerIDs())
+	// sent to everyone at the end of the tick
+	for (int ofID : IDs)
 	{
-		if (GameServer()->m_apPlayers[toID])
-		{
-			// send skin update message of id to everyone
-			for (int ofID : IDs)
-			{
-				GameServer()->SendSkinChange(ofID, toID);
-			}
-		}
+		GameServer()->QueueSkinChange(ofID);
 	}
 }
 
 void CGameControllerZCATCH::UpdateSkinsOfEverybody()
 {
-	for (int toID : GameServer()->PlayerIDs())
+	for (int ofID : GameServer()->PlayerIDs())
 	{
-		if (GameServer()->m_apPlayers[toID])
+		if (GameServer()->m_apPlayers[ofID])
 		{
-			// send skin update message of id to everyone
-			for (int ofID : GameServer()->PlayerIDs())
-			{
-				if (GameServer()->m_apPlayers[ofID])
-				{
-					GameServer()->SendSkinChange(ofID, toID);
-				}	
-			}
+			GameServer()->QueueSkinChange(ofID);
 		}
 	}
 }
@@ -1544,26 +1546,20 @@ void CGameControllerZCATCH::ShowPlayerStatistics(class CPlayer *pOfPlayer)
 
 CPlayer* CGameControllerZCATCH::ChooseDominatingPlayer(int excludeID)
 {
-
-	std::vector<class CPlayer*> dominatingPlayers;
-
-	class CPlayer *pTmpPlayer = nullptr;
+	class CPlayer *apDominatingPlayers[MAX_CLIENTS];
+	int numDominatingPlayers = 0;
 	int tmpMaxCaughtPlayers = -1;
+	const CCatchGraph::CPlayerSet &Caught = GameServer()->m_CatchGraph.Caught();
 
 	// find number of catches of dominating player
 	for (int i : GameServer()->PlayerIDs())
 	{
-		if (excludeID == i)
+		if (excludeID == i || Caught.test(i))
 			continue;
-		
-		pTmpPlayer = GameServer()->m_apPlayers[i];
-		if (pTmpPlayer && pTmpPlayer->IsNotCaught())
-		{
-			if (pTmpPlayer->GetNumTotalCaughtPlayers() > tmpMaxCaughtPlayers )
-			{
-				tmpMaxCaughtPlayers = pTmpPlayer->GetNumTotalCaughtPlayers();
-			}	
-		}
+
+		class CPlayer *pTmpPlayer = GameServer()->m_apPlayers[i];
+		if (pTmpPlayer && pTmpPlayer->IsNotCaught() && pTmpPlayer->GetNumTotalCaughtPlayers() > tmpMaxCaughtPlayers)
+			tmpMaxCaughtPlayers = pTmpPlayer->GetNumTotalCaughtPlayers();
 	}
 
 	// if invalid number
@@ -1573,23 +1569,19 @@ CPlayer* CGameControllerZCATCH::ChooseDominatingPlayer(int excludeID)
 		// this behavior is explicitly used, do not change <= to <
 		return nullptr;
 	}
-	
-	pTmpPlayer = nullptr;
 
-	// find all players with the same catched players streak
+	// find all players with the same catched players streak, this includes
+	// the excluded player and caught players, like it always did
 	for (int i : GameServer()->PlayerIDs())
 	{
-		pTmpPlayer = GameServer()->m_apPlayers[i];
+		class CPlayer *pTmpPlayer = GameServer()->m_apPlayers[i];
 		// totalcaughtplayers = currently caught + those who left while being caught.
 		if (pTmpPlayer && pTmpPlayer->GetNumTotalCaughtPlayers() == tmpMaxCaughtPlayers)
-		{
-			dominatingPlayers.push_back(pTmpPlayer);
-		}
-		pTmpPlayer = nullptr;
+			apDominatingPlayers[numDominatingPlayers++] = pTmpPlayer;
 	}
+
 	// choose random dominating player
-	std::size_t pickedPlayer = Server()->Tick() % dominatingPlayers.size();
-	return dominatingPlayers.at(pickedPlayer);
+	return apDominatingPlayers[Server()->Tick() % numDominatingPlayers];
 }
 
 std::string CGameControllerZCATCH::GetDatabasePrefix(){
@@ -1884,142 +1876,59 @@ void CGameControllerZCATCH::AddLeavingPlayerIPToCaughtCache(int LeavingID)
 	if (pPlayer)
 	{
 		int caughtByID = pPlayer->GetIDCaughtBy();
-		if (caughtByID >= 0)
+		NETADDR Addr;
+		if (caughtByID >= 0 && Server()->GetClientAddr(LeavingID, &Addr))
 		{
-			char aBuf[NETADDR_MAXSTRSIZE];
-			Server()->GetClientAddr(LeavingID, aBuf, NETADDR_MAXSTRSIZE);
-			
 			// expires in 1 minute
 			int expirationTick = Server()->Tick() + (Server()->TickSpeed() * 60);
-			std::string IP = {aBuf};
-			m_LeftCaughtCache.emplace_back(IP, caughtByID, expirationTick);
+			m_LeftCaughtCache.Set(&Addr, expirationTick, caughtByID);
 		}
 	}
 }
 
 void CGameControllerZCATCH::RemovePlayerIDFromCaughtCache(int DyingOrLeavingID)
 {
-	if (m_LeftCaughtCache.size() == 0)
+	if (m_LeftCaughtCache.Size() == 0)
 	{
 		return;
 	}
 
 	// if a player leaves, his caught cache is cleared
-	m_LeftCaughtCache.erase(std::remove_if(
-			m_LeftCaughtCache.begin(), 
-			m_LeftCaughtCache.end(), 
-			[DyingOrLeavingID](std::tuple<std::string, int, int>& element)-> bool 
-				{
-					const auto& [addr, caughtByID, expirationTick] = element;
-					(void) addr;
-					(void) expirationTick;
-					if (DyingOrLeavingID == caughtByID)
-					{
-						return true;
-					}
-					else
-					{
-						return false;
-					}
-				}), 
-			m_LeftCaughtCache.end()
-		);
+	m_LeftCaughtCache.RemoveIf([DyingOrLeavingID](const CAddrExpiryMap<int>::CEntry& Entry) -> bool
+		{
+			return Entry.m_Data == DyingOrLeavingID;
+		});
 }
 
-void CGameControllerZCATCH::RemoveIPOfJoiningPlayerFromCaughtCache(std::string& IP)
+void CGameControllerZCATCH::RemoveJoiningPlayerFromCaughtCache(int JoiningID)
 {
-	if (m_LeftCaughtCache.size() == 0)
+	// remove element by IP of previously left player and now joining player
+	NETADDR Addr;
+	if (Server()->GetClientAddr(JoiningID, &Addr))
 	{
-		return;
+		m_LeftCaughtCache.Remove(&Addr);
 	}
-
-
-	// remove element by IP of previously left player and now joining player
-	m_LeftCaughtCache.erase(std::remove_if(
-			m_LeftCaughtCache.begin(), 
-			m_LeftCaughtCache.end(), 
-			[IP](std::tuple<std::string, int, int>& element)-> bool 
-				{
-					const auto& [cachedIP, caughtByID, expirationTick] = element;
-					if (cachedIP == IP)
-					{
-						(void)caughtByID;
-						(void)expirationTick;
-						return true;
-					}
-					else
-					{
-						return false;
-					}
-				}), 
-			m_LeftCaughtCache.end()
-		);
 }
 
 int CGameControllerZCATCH::IsInCaughtCache(int JoiningID)
 {
-	if (m_LeftCaughtCache.size() == 0)
+	NETADDR Addr;
+	if (m_LeftCaughtCache.Size() == 0 || !Server()->GetClientAddr(JoiningID, &Addr))
 	{
 		return -1;
 	}
-		
-
-	char aBuf[NETADDR_MAXSTRSIZE];
-	Server()->GetClientAddr(JoiningID, aBuf, NETADDR_MAXSTRSIZE);
-
-	std::string joiningIP = {aBuf};
-	int currentTick = Server()->Tick();
 
-	for (auto& [cachedIP, caughtByID, expirationTick] : m_LeftCaughtCache)
-	{
-		if (joiningIP == cachedIP && currentTick < expirationTick)
-		{
-			return caughtByID;
-		}	
-	}
-	
-	return -1;	
+	const CAddrExpiryMap<int>::CEntry* pEntry = m_LeftCaughtCache.Find(&Addr, Server()->Tick());
+	return pEntry ? pEntry->m_Data : -1;
 }
 
 void CGameControllerZCATCH::CleanLeftCaughtCache()
 {
+	// remove expired cache elements
+	m_LeftCaughtCache.Expire(Server()->Tick());
 
-	if (m_LeftCaughtCache.size() > 0)
-	{
-		int currentTick = Server()->Tick();
-
-		// remove expired cache elements
-		m_LeftCaughtCache.erase(std::remove_if(
-			m_LeftCaughtCache.begin(), 
-			m_LeftCaughtCache.end(), 
-			[currentTick](std::tuple<std::string, int, int>& element)-> bool 
-				{
-					const auto& [cachedIP, caughtByID, expirationTick] = element;
-					(void)cachedIP;	// silence warnings
-					(void)caughtByID;
-					if (currentTick >= expirationTick)
-					{
-						return true;
-					}
-					else
-					{
-						return false;
-					}
-				}), 
-			m_LeftCaughtCache.end()
-		);
-
-		
-		int moreThanLimit = (int) (m_LeftCaughtCache.size() - MAX_CLIENTS * 2);
-		if (moreThanLimit > 0)
-		{
-			auto it = m_LeftCaughtCache.begin() + moreThanLimit;
-			std::vector<std::tuple<std::string, int, int> > tmpVec = {it, m_LeftCaughtCache.end()};
-			m_LeftCaughtCache = tmpVec;
-			 
-		}	
-	}
-
+	// the ones expiring first are the ones that left first
+	m_LeftCaughtCache.Trim(MAX_CLIENTS * 2);
 }
 
 void CGameControllerZCATCH::HandleLeavingPlayerCaching(int LeavingID)
@@ -2055,13 +1964,8 @@ bool CGameControllerZCATCH::HandleJoiningPlayerCaching(int JoiningPlayerID)
 			// be caught
 			pKiller->CatchPlayer(JoiningPlayerID, CPlayer::REASON_PLAYER_JOINED);
 
-			// retireve IP
-			char aBuf[NETADDR_MAXSTRSIZE];
-			Server()->GetClientAddr(JoiningPlayerID, aBuf, NETADDR_MAXSTRSIZE);
-			std::string IP = {aBuf};
-
 			// remove ip from cache
-			RemoveIPOfJoiningPlayerFromCaughtCache(IP);
+			RemoveJoiningPlayerFromCaughtCache(JoiningPlayerID);
 			return true;
 		}
 	}
@@ -6,6 +6,7 @@
 #include <set>
 #include <tuple>
 #include  <deque>
+#include <game/server/addrexpirymap.h>
 #include <game/server/gamecontroller.h>
 #include <game/server/gamemodes/zcatch/rankingserver.h>
 #include <game/server/gamemodes/zcatch/deletionrequest.h>
@@ -86,7 +87,8 @@ private:
 
 	/**
 	 * This, contraty to @RefreshBroadcast, updates the enemies left to catch
-	 * counter for specified/every player/s, and sends the updated value.
+	 * counter for specified/every player/s, and sends the updated value
+	 * at the end of the tick.
 	 */
 	void UpdateBroadcastOf(std::initializer_list<int> IDs);
 	void UpdateBroadcastOfEverybody();
@@ -95,6 +97,7 @@ private:
 	 * allows the usage of UpdateSkinsOf({multiple, ids})
 	 * sends to everyone that the skin information of those
 	 * multiple ids has changed. (color change)
+	 * Changes within one tick are sent only once, at the end of it.
 	 */
 	void UpdateSkinsOf(std::initializer_list<int> IDs);
 	void UpdateSkinsOfEverybody();
@@ -166,8 +169,8 @@ private:
 	// leaving player's ips are saved here with the player's id who caught them
 	// if the catching player dies, their entry is removed from cache, if the leaving player
 	// rejoins, they are caught by the same player again.
-	// <leaving IP, caught by ID, expires at Tick>
-	std::vector<std::tuple<std::string, int, int> > m_LeftCaughtCache;
+	// leaving IP -> caught by ID, until the expiration tick
+	CAddrExpiryMap<int> m_LeftCaughtCache;
 
 	void AddLeavingPlayerIPToCaughtCache(int LeavingID);
 
@@ -181,9 +184,9 @@ private:
 	/**
 	 * @brief If a player joins and gets caught, his entry in the cache is being removed
 	 * 
-	 * @param IP 
+	 * @param JoiningID 
 	 */
-	void RemoveIPOfJoiningPlayerFromCaughtCache(std::string& IP);
+	void RemoveJoiningPlayerFromCaughtCache(int JoiningID);
 
 	/**
 	 * @brief A joining player that previously left the game can be added
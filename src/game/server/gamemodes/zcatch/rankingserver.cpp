@@ -3,13 +3,18 @@
 #include <cctype>
 #include <chrono>
 #include <future>
+#include <cstdint>
+#include <map>
 #include <sstream>
+#include <stdexcept>
 #include <base/system.h>
 #include <engine/shared/protocol.h>
 
 
 IRankingServer::IRankingServer()
 {
+    m_ConcurrentReads = false;
+
     // all possible fields are invalid nicks
     CPlayerStats tmp;
     m_InvalidNicknames = tmp.keys();
@@ -100,8 +105,10 @@ bool IRankingServer::GetRanking(std::string nickname, IRankingServer::cb_stats_t
             CPlayerStats stats;
             try
             {
-                // lock mutex for multi threaded access
-                std::lock_guard<std::mutex> lock(m_DatabaseMutex);
+                // lock mutex for multi threaded access, unless reads can run concurrently
+                std::unique_lock<std::mutex> lock(m_DatabaseMutex, std::defer_lock);
+                if (!m_ConcurrentReads)
+                    lock.lock();
 
                 stats = this->GetRankingSync(nick, pref); // get data from server
             }
@@ -170,8 +177,10 @@ bool IRankingServer::GetTopRanking(int topNumber, std::string key, IRankingServe
 
             try
             {
-                // lock mutex for multi threaded access
-                std::lock_guard<std::mutex> lock(m_DatabaseMutex);
+                // lock mutex for multi threaded access, unless reads can run concurrently
+                std::unique_lock<std::mutex> lock(m_DatabaseMutex, std::defer_lock);
+                if (!m_ConcurrentReads)
+                    lock.lock();
 
                 result = this->GetTopRankingSync(topNum, field, pref, bigFirst);
             }
@@ -345,6 +354,55 @@ void IRankingServer::AwaitFutures()
     m_Futures.clear();
 }
 
+size_t IRankingServer::CountRankings(std::string prefix)
+{
+    if (m_DefaultConstructed)
+        throw std::runtime_error("Ranking server is not available.");
+
+    std::lock_guard<std::mutex> lock(m_DatabaseMutex);
+    return CountRankingsSync(prefix);
+}
+
+void IRankingServer::ExportRankings(std::string prefix, int part, int numParts, size_t batchSize, IRankingServer::cb_key_stats_vec_t callback)
+{
+    if (m_DefaultConstructed)
+        throw std::runtime_error("Ranking server is not available.");
+    else if (numParts < 1 || part < 0 || part >= numParts || batchSize == 0 || callback == nullptr)
+        throw std::invalid_argument("Invalid export parameters.");
+
+    std::lock_guard<std::mutex> lock(m_DatabaseMutex);
+    ExportRankingsSync(prefix, part, numParts, batchSize, callback);
+}
+
+void IRankingServer::ImportRankings(IRankingServer::key_stats_vec_t& rankings, std::string prefix)
+{
+    if (m_DefaultConstructed)
+        throw std::runtime_error("Ranking server is not available.");
+    else if (rankings.empty())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_DatabaseMutex);
+    ImportRankingsSync(rankings, prefix);
+}
+
+void IRankingServer::BeginBulkImport(std::string prefix)
+{
+    if (m_DefaultConstructed)
+        throw std::runtime_error("Ranking server is not available.");
+
+    std::lock_guard<std::mutex> lock(m_DatabaseMutex);
+    BeginBulkImportSync(prefix);
+}
+
+void IRankingServer::EndBulkImport(std::string prefix)
+{
+    if (m_DefaultConstructed)
+        throw std::runtime_error("Ranking server is not available.");
+
+    std::lock_guard<std::mutex> lock(m_DatabaseMutex);
+    EndBulkImportSync(prefix);
+}
+
 // ############################################################
 CRedisRankingServer::CRedisRankingServer()
 {
@@ -888,11 +946,211 @@ void CRedisRankingServer::DeleteRankingSync(std::string nickname, std::string pr
 }
 
 
+size_t CRedisRankingServer::CountRankingsSync(std::string prefix)
+{
+    if (!m_Client.is_connected())
+        throw cpp_redis::redis_error("Not connected.");
+
+    // every ranked player is part of the ranking index
+    std::future<cpp_redis::reply> countFuture = m_Client.zcard(prefix + m_RankingKey);
+    m_Client.sync_commit();
+
+    cpp_redis::reply reply = countFuture.get();
+    if (!reply.is_integer())
+        throw cpp_redis::redis_error("zcard: expected integer reply");
+
+    return reply.as_integer();
+}
+
+void CRedisRankingServer::ExportRankingsSync(std::string prefix, int part, int numParts, size_t batchSize, IRankingServer::cb_key_stats_vec_t callback)
+{
+    std::string index = prefix + m_RankingKey;
+    int64_t count = CountRankingsSync(prefix);
+    int64_t begin = count * part / numParts;
+    int64_t end = count * (part + 1) / numParts;
+
+    CPlayerStats tmpStat;
+    std::vector<std::string> Keys = tmpStat.keys();
+    std::vector<std::string> Fields = tmpStat.keys(prefix);
+
+    IRankingServer::key_stats_vec_t batch;
+    std::vector<std::string> nicknames;
+    std::vector<std::future<cpp_redis::reply> > getFutures;
+
+    for (int64_t start = begin; start < end; start += batchSize)
+    {
+        int64_t stop = std::min<int64_t>(start + batchSize, end) - 1;
+
+        std::future<cpp_redis::reply> rangeFuture = m_Client.zrange(index, static_cast<int>(start), static_cast<int>(stop));
+        m_Client.sync_commit();
+
+        cpp_redis::reply rangeReply = rangeFuture.get();
+        if (!rangeReply.is_array())
+            throw cpp_redis::redis_error("Expected array return value of zrange(...)");
+
+        // retrieve all players of this page within a single round trip
+        nicknames.clear();
+        getFutures.clear();
+        for (auto& r : rangeReply.as_array())
+        {
+            if (!r.is_string())
+                throw cpp_redis::redis_error("Expected string as nickname.");
+
+            nicknames.push_back(r.as_string());
+            getFutures.push_back(m_Client.hmget(nicknames.back(), Fields));
+        }
+        m_Client.sync_commit();
+
+        batch.clear();
+        for (size_t i = 0; i < nicknames.size(); i++)
+        {
+            cpp_redis::reply reply = getFutures[i].get();
+            if (!reply.is_array())
+                throw cpp_redis::redis_error("Expected array return value of hmget(...)");
+
+            std::vector<cpp_redis::reply> result = reply.as_array();
+
+            tmpStat.Reset();
+            for (size_t idx = 0; idx < Keys.size() && idx < result.size(); idx++)
+            {
+                // fields that don't exist stay 0
+                if (result[idx].is_string())
+                    tmpStat[Keys[idx]] = std::stoi(result[idx].as_string());
+                else if (result[idx].is_integer())
+                    tmpStat[Keys[idx]] = result[idx].as_integer();
+            }
+            batch.emplace_back(nicknames[i], tmpStat);
+        }
+
+        callback(batch);
+    }
+}
+
+void CRedisRankingServer::ImportRankingsSync(IRankingServer::key_stats_vec_t& rankings, std::string prefix)
+{
+    if (!m_Client.is_connected())
+        throw cpp_redis::redis_error("Not connected.");
+
+    std::vector<std::future<cpp_redis::reply> > futures;
+    futures.reserve(rankings.size() + 16);
+
+    // collect the index entries, so that every index is updated by a single command
+    std::map<std::string, std::multimap<std::string, std::string> > indices;
+
+    for (auto& [nickname, stats] : rankings)
+    {
+        futures.push_back(m_Client.hmset(nickname, stats.GetStringPairs(prefix)));
+
+        for (auto& key : stats.keys())
+        {
+            indices[prefix + key].insert({std::to_string(stats[key]), nickname});
+        }
+    }
+
+    std::vector<std::string> options = {};
+    for (auto& [index, scoreMembers] : indices)
+    {
+        futures.push_back(m_Client.zadd(index, options, scoreMembers));
+    }
+
+    m_Client.sync_commit();
+
+    for (auto& f : futures)
+    {
+        cpp_redis::reply reply = f.get();
+        if (reply.is_error())
+            throw cpp_redis::redis_error(reply.error());
+    }
+}
+
+
 // ############################################
+namespace
+{
+    // resets a cached statement when leaving the scope, so that it neither
+    // keeps a read transaction open nor carries an error into the next use.
+    class CStatementScope
+    {
+        SQLite::Statement& m_Statement;
+
+       public:
+        CStatementScope(SQLite::Statement& statement) : m_Statement{statement}
+        {
+            Reset();
+        }
+
+        ~CStatementScope()
+        {
+            Reset();
+        }
+
+        void Reset()
+        {
+            try
+            {
+                m_Statement.reset();
+            }
+            catch (const SQLite::Exception&)
+            {
+                // reset reports the error of the previous step again
+            }
+        }
+    };
+} // namespace
+
+SQLite::Statement& CSQLiteRankingServer::CConnection::Statement(const std::string& name, const std::function<std::string()>& buildQuery)
+{
+    auto it = m_Statements.find(name);
+    if (it != m_Statements.end())
+        return *it->second;
+
+    std::unique_ptr<SQLite::Statement> stmt{new SQLite::Statement{*m_pDatabase, buildQuery()}};
+    SQLite::Statement& result = *stmt;
+    m_Statements[name] = std::move(stmt);
+    return result;
+}
+
+void CSQLiteRankingServer::CConnection::Close()
+{
+    // statements need to be finalized before their database is closed
+    m_Statements.clear();
+
+    if (m_pDatabase)
+    {
+        delete m_pDatabase;
+        m_pDatabase = nullptr;
+    }
+}
+
+CSQLiteRankingServer::CReadConnection::CReadConnection(CSQLiteRankingServer *pServer) : m_pServer{pServer}
+{
+    if (m_pServer->m_Readers.empty())
+    {
+        // the caller holds the database mutex
+        m_pConnection = &m_pServer->m_Database;
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_pServer->m_ReadersMutex);
+    m_pServer->m_ReadersCondition.wait(lock, [this]() { return !m_pServer->m_IdleReaders.empty(); });
+
+    m_pConnection = m_pServer->m_IdleReaders.back();
+    m_pServer->m_IdleReaders.pop_back();
+}
+
+CSQLiteRankingServer::CReadConnection::~CReadConnection()
+{
+    if (m_pConnection == &m_pServer->m_Database)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_pServer->m_ReadersMutex);
+    m_pServer->m_IdleReaders.push_back(m_pConnection);
+    m_pServer->m_ReadersCondition.notify_one();
+}
+
 CSQLiteRankingServer::CSQLiteRankingServer()
 {
     m_DefaultConstructed = true;
-    m_pDatabase = nullptr;
 }
 
 void CSQLiteRankingServer::FixPrefix(std::string& prefix)
@@ -909,13 +1167,12 @@ void CSQLiteRankingServer::FixPrefix(std::string& prefix)
     }
 }
 
-CSQLiteRankingServer::CSQLiteRankingServer(std::string filePath, std::vector<std::string> validPrefixList, int busyTimeoutMs)
+CSQLiteRankingServer::CSQLiteRankingServer(std::string filePath, std::vector<std::string> validPrefixList, int busyTimeoutMs, bool readOnly, CSQLiteSettings settings)
 {
     // needed to get keys in order to create table columns
     CPlayerStats stats;
 
     m_DefaultConstructed = false;
-    m_pDatabase = nullptr;
 
     m_ValidPrefixList.reserve(validPrefixList.size());
 
@@ -949,21 +1206,50 @@ CSQLiteRankingServer::CSQLiteRankingServer(std::string filePath, std::vector<std
         }
         ss << " );\n";
 
-        // create indices
-        for (size_t i = 0; i < ColumnsSize; i++)
-        {
-            ss << "CREATE INDEX IF NOT EXISTS " << TableName << "_" << Columns[i] << "_index ON " << TableName << " (" << Columns[i] << ");\n";
-        }
+        ss << IndicesQuery(TableName, false);
     }
 
+    // negative cache sizes are in KiB instead of pages
+    std::string CacheSizeQuery = "PRAGMA cache_size = -" + std::to_string(settings.m_CacheSizeKiB) + ";\n";
+
     try
     {
         m_FilePath = filePath;
-        m_pDatabase = new SQLite::Database(m_FilePath, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
-        m_pDatabase->setBusyTimeout(busyTimeoutMs);
-        m_pDatabase->exec(ss.str());
 
-        dbg_msg("SQLite", "Successfully created database: '%s'", m_FilePath.c_str());
+        if (readOnly)
+        {
+            m_Database.m_pDatabase = new SQLite::Database(m_FilePath, SQLite::OPEN_READONLY);
+            m_Database.m_pDatabase->setBusyTimeout(busyTimeoutMs);
+            m_Database.m_pDatabase->exec(CacheSizeQuery);
+
+            dbg_msg("SQLite", "Successfully opened database: '%s'", m_FilePath.c_str());
+        }
+        else
+        {
+            m_Database.m_pDatabase = new SQLite::Database(m_FilePath, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+            m_Database.m_pDatabase->setBusyTimeout(busyTimeoutMs);
+
+            // the journal mode is stored in the database file, the other settings are per connection
+            m_Database.m_pDatabase->exec(std::string("PRAGMA journal_mode = ") + (settings.m_WriteAheadLog ? "WAL" : "DELETE") + ";\n" +
+                                         "PRAGMA synchronous = " + std::to_string(settings.m_Synchronous) + ";\n" +
+                                         CacheSizeQuery);
+            m_Database.m_pDatabase->exec(ss.str());
+
+            dbg_msg("SQLite", "Successfully created database: '%s'", m_FilePath.c_str());
+        }
+
+        // the tables exist now, open the read connections
+        for (int i = 0; i < settings.m_NumReaders; i++)
+        {
+            CConnection *pReader = new CConnection;
+            m_Readers.push_back(pReader);
+
+            pReader->m_pDatabase = new SQLite::Database(m_FilePath, SQLite::OPEN_READONLY);
+            pReader->m_pDatabase->setBusyTimeout(busyTimeoutMs);
+            pReader->m_pDatabase->exec(CacheSizeQuery);
+        }
+        m_IdleReaders = m_Readers;
+        m_ConcurrentReads = !m_Readers.empty();
     }
     catch (const std::exception& e)
     {
@@ -972,12 +1258,17 @@ CSQLiteRankingServer::CSQLiteRankingServer(std::string filePath, std::vector<std
         // got an error opening db
         // no sense in trying again
         m_DefaultConstructed = true;
+        m_ConcurrentReads = false;
 
-        if (m_pDatabase)
+        for (auto pReader : m_Readers)
         {
-            delete m_pDatabase;
-            m_pDatabase = nullptr;
+            pReader->Close();
+            delete pReader;
         }
+        m_Readers.clear();
+        m_IdleReaders.clear();
+
+        m_Database.Close();
     }
 }
 
@@ -985,11 +1276,69 @@ CSQLiteRankingServer::~CSQLiteRankingServer()
 {
     AwaitFutures();
 
-    if (m_pDatabase)
+    for (auto pReader : m_Readers)
     {
-        delete m_pDatabase;
-        m_pDatabase = nullptr;
+        pReader->Close();
+        delete pReader;
+    }
+    m_Readers.clear();
+    m_IdleReaders.clear();
+
+    m_Database.Close();
+}
+
+std::string CSQLiteRankingServer::IndicesQuery(const std::string& tableName, bool drop) const
+{
+    CPlayerStats stats;
+    std::stringstream ss;
+
+    for (auto& column : stats.keys())
+    {
+        if (drop)
+            ss << "DROP INDEX IF EXISTS " << tableName << "_" << column << "_index;\n";
+        else
+            ss << "CREATE INDEX IF NOT EXISTS " << tableName << "_" << column << "_index ON " << tableName << " (" << column << ");\n";
     }
+    return ss.str();
+}
+
+std::string CSQLiteRankingServer::InsertQuery(const std::string& tableName) const
+{
+    CPlayerStats stats;
+    std::vector<std::string> Columns = stats.keys();
+    size_t ColumnsSize = Columns.size();
+
+    std::stringstream ss;
+
+    ss << "INSERT OR REPLACE INTO " << tableName << " ( ";
+
+    ss << "Key , "; // nickname is the primary key.
+
+    // all columns
+    for (size_t i = 0; i < ColumnsSize; i++)
+    {
+        ss << Columns[i];
+        if (i < ColumnsSize - 1)
+        {
+            ss << " , ";
+        }
+    }
+
+    // for evry column, create a bind variable, to escape possible user input
+    ss << " ) VALUES ( ";
+    ss << "?1 , "; // bind nickname
+
+    for (size_t i = 0; i < ColumnsSize; i++)
+    {
+        ss << "?" << (i + 2);
+        if (i < ColumnsSize - 1)
+        {
+            ss << " , ";
+        }
+    }
+    ss << " );";
+
+    return ss.str();
 }
 
 bool CSQLiteRankingServer::IsValidPrefix(const std::string& prefix)
@@ -1024,65 +1373,53 @@ CPlayerStats CSQLiteRankingServer::GetRankingSync(std::string nickname, std::str
     auto Columns = stats.keys();
     size_t ColumnsSize = Columns.size();
 
-    std::stringstream ss;
+    CReadConnection connection{this};
 
-    ss << "SELECT ";
-    ss << "R.Key as Key , R.Rank as Rank,";
+    SQLite::Statement& stmt = connection->Statement("get " + TableName, [&]() {
+        std::stringstream ss;
 
-    for (size_t i = 0; i < ColumnsSize; i++)
-    {
-        ss << " R." << Columns[i] << " as " << Columns[i];
+        ss << "SELECT ";
+        ss << "P.Key as Key ,";
 
-        if (i < ColumnsSize - 1)
-            ss << " ,\n";
-    }
+        for (size_t i = 0; i < ColumnsSize; i++)
+        {
+            ss << " P." << Columns[i] << " as " << Columns[i] << " ,\n";
+        }
 
-    // order by nickname as secondary criterium
-    ss << " FROM ( "
-       << "SELECT "
-       << "Key , "
-       << "ROW_NUMBER() OVER (ORDER BY " << m_RankingKey << (m_BiggestFirst ? " DESC " : " ASC , Key ASC") << ") Rank ,";
+        // the rank is the number of players before this one plus one,
+        // counting them in the index is a lot cheaper than numbering the whole table.
+        // order by nickname as secondary criterium
+        const char *pCompare = m_BiggestFirst ? ">" : "<";
+        ss << " ( SELECT COUNT(*) FROM " << TableName << " WHERE " << m_RankingKey << " " << pCompare << " P." << m_RankingKey << " ) +"
+           << " ( SELECT COUNT(*) FROM " << TableName << " WHERE " << m_RankingKey << " = P." << m_RankingKey << " AND Key < P.Key ) + 1 as Rank";
 
-    for (size_t i = 0; i < ColumnsSize; i++)
-    {
-        ss << " " << Columns[i] << " ";
+        ss << " FROM " << TableName << " as P"
+           << " WHERE P.Key = ? ;";
 
-        if (i < ColumnsSize - 1)
-            ss << " ,\n";
-    }
+        return ss.str();
+    });
+    CStatementScope scope{stmt};
 
-    ss << " FROM " << TableName << " ) as R"
-       << " WHERE Key = ? ;";
+    // sqlite binding starts counting at 1
+    stmt.bind(1, nickname);
 
-    try
+    if (stmt.executeStep())
     {
-        SQLite::Statement stmt{*m_pDatabase, ss.str()};
-
-        // sqlite binding starts counting at 1
-        stmt.bind(1, nickname);
+        // get rank column
+        stats.SetRank(stmt.getColumn("Rank").getInt());
 
-        if (stmt.executeStep())
+        // get all the other in CPlayerStats defined column values
+        for (auto& column : Columns)
         {
-            // get rank column
-            stats.SetRank(stmt.getColumn("Rank").getInt());
-
-            // get all the other in CPlayerStats defined column values
-            for (auto& column : Columns)
-            {
-                stats[column] = stmt.getColumn(column.c_str()).getInt();
-            }
-            return stats;
-        }
-        else
-        {
-            // not found - > returns invalid player stats.
-            stats.Invalidate();
-            return stats;
+            stats[column] = stmt.getColumn(column.c_str()).getInt();
         }
+        return stats;
     }
-    catch (const SQLite::Exception&)
+    else
     {
-        throw;
+        // not found - > returns invalid player stats.
+        stats.Invalidate();
+        return stats;
     }
 }
 
@@ -1102,58 +1439,20 @@ void CSQLiteRankingServer::SetRankingSync(std::string nickname, CPlayerStats sta
     std::vector<std::string> Columns = stats.keys();
     size_t ColumnsSize = Columns.size();
 
-    std::stringstream ss;
+    SQLite::Statement& stmt = m_Database.Statement("set " + TableName, [&]() { return InsertQuery(TableName); });
+    CStatementScope scope{stmt};
 
-    ss << "INSERT OR REPLACE INTO " << TableName << " ( ";
+    // columns start counting at 1, not at 0.
+    stmt.bind(1, nickname); // primary key
 
-    ss << "Key , "; // nickname is the primary key.
-
-    // all columns
     for (size_t i = 0; i < ColumnsSize; i++)
     {
-        ss << Columns[i];
-        if (i < ColumnsSize - 1)
-        {
-            ss << " , ";
-        }
+        // column position offset
+        stmt.bind(i + 2, stats[Columns[i]]);
     }
 
-    // for evry column, create a bind variable, to escape possible user input
-    ss << " ) VALUES ( ";
-    ss << "?1 , "; // bind nickname
-
-    for (size_t i = 0; i < ColumnsSize; i++)
-    {
-        ss << "?" << (i + 2);
-        if (i < ColumnsSize - 1)
-        {
-            ss << " , ";
-        }
-    }
-    ss << " );";
-
-    try
-    {
-        // bind values to the execution statement
-        SQLite::Statement stmt{*m_pDatabase, ss.str()};
-
-        // columns start counting at 1, not at 0.
-        stmt.bind(1, nickname); // primary key
-
-        for (size_t i = 0; i < ColumnsSize; i++)
-        {
-            // column position offset
-            stmt.bind(i + 2, stats[Columns[i]]);
-        }
-
-        // execute statement.
-        stmt.exec();
-    }
-    catch (const SQLite::Exception&)
-    {
-        // throw and add to backlog.
-        throw;
-    }
+    // execute statement.
+    stmt.exec();
 }
 
 void CSQLiteRankingServer::UpdateRankingSync(std::string nickname, CPlayerStats stats, std::string prefix)
@@ -1172,62 +1471,117 @@ void CSQLiteRankingServer::UpdateRankingSync(std::string nickname, CPlayerStats
     std::vector<std::string> Columns = stats.keys();
     size_t ColumnsSize = Columns.size();
 
-    std::stringstream ss;
+    {
+        SQLite::Statement& stmt = m_Database.Statement("select " + TableName, [&]() {
+            std::stringstream ss;
 
-    ss << "SELECT ";
-    ss << "Key ,";
+            ss << "SELECT ";
+            ss << "Key ,";
 
-    for (size_t i = 0; i < ColumnsSize; i++)
-    {
-        ss << " " << Columns[i];
+            for (size_t i = 0; i < ColumnsSize; i++)
+            {
+                ss << " " << Columns[i];
 
-        if (i < ColumnsSize - 1)
-            ss << " ,\n";
-    }
+                if (i < ColumnsSize - 1)
+                    ss << " ,\n";
+            }
 
-    ss << " FROM " << TableName << " WHERE Key = ? ;";
+            ss << " FROM " << TableName << " WHERE Key = ? ;";
 
-    try
-    {
-        SQLite::Statement stmt{*m_pDatabase, ss.str()};
+            return ss.str();
+        });
+        CStatementScope scope{stmt};
 
         // sqlite binding starts counting at 1
         stmt.bind(1, nickname);
 
-
         if (stmt.executeStep())
         {
             // found player data
 
             // get all the other in CPlayerStats defined column values
-            for (auto& column : Columns)
+            for (size_t i = 0; i < ColumnsSize; i++)
             {
-                savedStats[column] = stmt.getColumn(column.c_str()).getInt();
-            }        
+                savedStats[Columns[i]] = stmt.getColumn(i + 1).getInt();
+            }
         }
         else
         {
             // no data retrieved -> player is not ranked yet.
         }
+    }
 
-        // reset stringstream
-        ss.str(std::string());
-        ss.clear();
+    // update stats
+    if (!savedStats.IsValid())
+    {
+        // invalid, reset to a valid state
+        savedStats.Reset();
+    }
 
-        // update stats
-        if (!savedStats.IsValid())
-        {
-            // invalid, reset to a valid state
-            savedStats.Reset();
-        }
+    // savedStats is either empty or has the needed data stored.
+    savedStats += stats;
+
+    // bind values to the execution statement
+    SQLite::Statement& stmt = m_Database.Statement("set " + TableName, [&]() { return InsertQuery(TableName); });
+    CStatementScope scope{stmt};
+
+    // columns start counting at 1, not at 0.
+    stmt.bind(1, nickname); // primary key
+
+    // bind new values to their respective columns
+    for (size_t i = 0; i < ColumnsSize; i++)
+    {
+        // column position offset
+        stmt.bind(i + 2, savedStats[Columns[i]]);
+    }
+
+    // update player data.
+    stmt.exec();
+}
+
+void CSQLiteRankingServer::DeleteRankingSync(std::string nickname, std::string prefix)
+{
+    FixPrefix(prefix);
+
+    if (!IsValidPrefix(prefix))
+        throw SQLite::Exception("Invalid prefix(not in valid prefix list): " + prefix);
+    else if(!IsValidNickname(nickname, prefix))
+        throw SQLite::Exception("Invalid nickname: " + nickname);
+
+    std::string TableName = prefix + m_BaseTableName;
+
+    SQLite::Statement& stmt = m_Database.Statement("delete " + TableName, [&]() {
+        return "DELETE FROM " + TableName + " WHERE Key = ?;";
+    });
+    CStatementScope scope{stmt};
+
+    // where key = nickname
+    stmt.bind(1, nickname);
+
+    // delete player data
+    stmt.exec();
+}
+
+IRankingServer::key_stats_vec_t CSQLiteRankingServer::GetTopRankingSync(int topNumber, std::string key, std::string prefix, bool biggestFirst)
+{
+    FixPrefix(prefix);
+
+    if (!IsValidPrefix(prefix))
+        throw SQLite::Exception("Invalid prefix: " + prefix);
+    
+    CPlayerStats tmpStat;
+    auto Columns = tmpStat.keys();
+    size_t ColumnsSize = Columns.size();
+
+
+    std::string TableName = prefix + m_BaseTableName;
 
-        // savedStats is either empty or has the needed data stored.
-        savedStats += stats;
+    CReadConnection connection{this};
 
-        // construct query in order to insert tha updated player data
-        ss << "INSERT OR REPLACE INTO " << TableName << " ( ";
+    SQLite::Statement& stmt = connection->Statement(std::string(biggestFirst ? "top desc " : "top asc ") + TableName, [&]() {
+        std::stringstream ss;
 
-        ss << "Key , "; // nickname is the primary key.
+        ss << "SELECT Key , ";
 
         // all columns
         for (size_t i = 0; i < ColumnsSize; i++)
@@ -1239,136 +1593,186 @@ void CSQLiteRankingServer::UpdateRankingSync(std::string nickname, CPlayerStats
             }
         }
 
-        // for evry column, create a bind variable, to escape possible user input
-        ss << " ) VALUES ( ";
-        ss << "?1 , "; // bind nickname
+        // order by nickname as secondary criterium
+        ss << " FROM " << TableName
+        << " ORDER BY " << m_RankingKey << ( biggestFirst ? " DESC " : " ASC ")
+        << ", Key ASC "
+        << " LIMIT ? ;";
 
-        for (size_t i = 0; i < ColumnsSize; i++)
-        {
-            ss << "?" << (i + 2);
-            if (i < ColumnsSize - 1)
-            {
-                ss << " , ";
-            }
-        }
-        ss << " );";
+        return ss.str();
+    });
+    CStatementScope scope{stmt};
 
+    stmt.bind(1, topNumber);
 
-        // bind values to the execution statement
-        SQLite::Statement stmt2{*m_pDatabase, ss.str()};
+    IRankingServer::key_stats_vec_t result;
+    std::string tmpName;
 
-        // columns start counting at 1, not at 0.
-        stmt2.bind(1, nickname); // primary key
+    while (stmt.executeStep())
+    {
+        tmpName = stmt.getColumn("Key").getString();
 
-        // bind new values to their respective columns
-        for (size_t i = 0; i < ColumnsSize; i++)
+        for (auto &column : Columns)
         {
-            // column position offset
-            stmt2.bind(i + 2, savedStats[Columns[i]]);
+            tmpStat[column] = stmt.getColumn(column.c_str()).getInt();
         }
 
-        // update player data.
-        stmt2.exec();
-    }
-    catch (const SQLite::Exception&)
-    {
-        throw;
+        result.emplace_back(tmpName, tmpStat);
+
+        // reset tmp variables
+        tmpStat.Reset();
+        tmpName = {};
+
     }
+    return result;
 }
 
-void CSQLiteRankingServer::DeleteRankingSync(std::string nickname, std::string prefix)
+size_t CSQLiteRankingServer::CountRankingsSync(std::string prefix)
 {
     FixPrefix(prefix);
 
     if (!IsValidPrefix(prefix))
-        throw SQLite::Exception("Invalid prefix(not in valid prefix list): " + prefix);
-    else if(!IsValidNickname(nickname, prefix))
-        throw SQLite::Exception("Invalid nickname: " + nickname);
+        throw SQLite::Exception("Invalid prefix: " + prefix);
 
     std::string TableName = prefix + m_BaseTableName;
 
-    std::stringstream ss;
-
-    ss << "DELETE FROM " << TableName << " WHERE Key = ?;";
+    SQLite::Statement stmt{*m_Database.m_pDatabase, "SELECT COUNT(*) FROM " + TableName + " ;"};
+    if (!stmt.executeStep())
+        throw SQLite::Exception("Failed to count rows of " + TableName);
 
-    try
-    {
-        SQLite::Statement stmt{*m_pDatabase, ss.str()};
-
-        // where key = nickname
-        stmt.bind(1, nickname);
-
-        // delete player data
-        stmt.exec();
-    }
-    catch(const SQLite::Exception&)
-    {
-        throw;
-    }
+    return stmt.getColumn(0).getInt64();
 }
 
-IRankingServer::key_stats_vec_t CSQLiteRankingServer::GetTopRankingSync(int topNumber, std::string key, std::string prefix, bool biggestFirst)
+void CSQLiteRankingServer::ExportRankingsSync(std::string prefix, int part, int numParts, size_t batchSize, IRankingServer::cb_key_stats_vec_t callback)
 {
     FixPrefix(prefix);
 
     if (!IsValidPrefix(prefix))
         throw SQLite::Exception("Invalid prefix: " + prefix);
-    
+
     CPlayerStats tmpStat;
-    auto Columns = tmpStat.keys();
+    std::vector<std::string> Keys = tmpStat.keys();
+    std::string TableName = prefix + m_BaseTableName;
+
+    // the table might have been created with other fields than the current ones,
+    // only read the columns that exist in both.
+    std::vector<std::string> Columns;
+    SQLite::Statement infoStmt{*m_Database.m_pDatabase, "PRAGMA table_info(" + TableName + ");"};
+    while (infoStmt.executeStep())
+    {
+        std::string column = infoStmt.getColumn("name").getString();
+        if (std::find(Keys.begin(), Keys.end(), column) != Keys.end())
+            Columns.push_back(column);
+    }
     size_t ColumnsSize = Columns.size();
 
+    // every part is a range of rowids
+    SQLite::Statement rangeStmt{*m_Database.m_pDatabase, "SELECT MIN(rowid) , MAX(rowid) FROM " + TableName + " ;"};
+    if (!rangeStmt.executeStep() || rangeStmt.getColumn(0).isNull())
+        return; // empty table
 
-    std::string TableName = prefix + m_BaseTableName;
+    int64_t first = rangeStmt.getColumn(0).getInt64();
+    int64_t span = rangeStmt.getColumn(1).getInt64() - first + 1;
+    int64_t begin = first + span * part / numParts;
+    int64_t end = first + span * (part + 1) / numParts;
 
     std::stringstream ss;
 
-    ss << "SELECT Key , ";
-
-    // all columns
+    ss << "SELECT rowid , Key";
     for (size_t i = 0; i < ColumnsSize; i++)
     {
-        ss << Columns[i];
-        if (i < ColumnsSize - 1)
-        {
-            ss << " , ";
-        }
+        ss << " , " << Columns[i];
     }
 
-    // order by nickname as secondary criterium
-    ss << " FROM " << TableName 
-    << " ORDER BY " << m_RankingKey << ( biggestFirst ? " DESC " : " ASC ") 
-    << ", Key ASC " 
-    << " LIMIT " << topNumber << ";";
-
-    try
-    {   
-        IRankingServer::key_stats_vec_t result;
-        std::string tmpName;
+    // pages are continued after the last rowid instead of using an offset,
+    // so that every page is a simple index lookup.
+    ss << " FROM " << TableName
+       << " WHERE rowid >= ? AND rowid < ?"
+       << " ORDER BY rowid ASC"
+       << " LIMIT ? ;";
 
+    SQLite::Statement stmt{*m_Database.m_pDatabase, ss.str()};
+    IRankingServer::key_stats_vec_t batch;
+    batch.reserve(batchSize);
 
-        SQLite::Statement stmt{*m_pDatabase, ss.str()};
+    while (begin < end)
+    {
+        stmt.bind(1, begin);
+        stmt.bind(2, end);
+        stmt.bind(3, static_cast<int64_t>(batchSize));
 
+        batch.clear();
         while (stmt.executeStep())
         {
-            tmpName = stmt.getColumn("Key").getString();            
+            begin = stmt.getColumn(0).getInt64() + 1;
 
-            for (auto &column : Columns)
+            tmpStat.Reset();
+            for (size_t i = 0; i < ColumnsSize; i++)
             {
-                tmpStat[column] = stmt.getColumn(column.c_str()).getInt();
+                tmpStat[Columns[i]] = stmt.getColumn(i + 2).getInt();
             }
-            
-            result.emplace_back(tmpName, tmpStat);
+            batch.emplace_back(stmt.getColumn(1).getString(), tmpStat);
+        }
+        stmt.reset();
 
-            // reset tmp variables
-            tmpStat.Reset();
-            tmpName = {};
+        size_t batchRows = batch.size();
+        if (batchRows > 0)
+            callback(batch);
 
-        }
-        return result;
+        if (batchRows < batchSize)
+            break; // last page
     }
-    catch(const SQLite::Exception&)
+}
+
+void CSQLiteRankingServer::ImportRankingsSync(IRankingServer::key_stats_vec_t& rankings, std::string prefix)
+{
+    FixPrefix(prefix);
+
+    if (!IsValidPrefix(prefix))
+        throw SQLite::Exception("Invalid prefix(not in valid prefix list): " + prefix);
+
+    CPlayerStats tmpStat;
+    std::string TableName = prefix + m_BaseTableName;
+    std::vector<std::string> Columns = tmpStat.keys();
+    size_t ColumnsSize = Columns.size();
+
+    // a single transaction for all rows, instead of one per row
+    SQLite::Transaction transaction{*m_Database.m_pDatabase};
+    SQLite::Statement& stmt = m_Database.Statement("set " + TableName, [&]() { return InsertQuery(TableName); });
+    CStatementScope scope{stmt};
+
+    for (auto& [nickname, stats] : rankings)
     {
-        throw;
+        stmt.bind(1, nickname);
+
+        for (size_t i = 0; i < ColumnsSize; i++)
+        {
+            stmt.bind(i + 2, stats[Columns[i]]);
+        }
+
+        stmt.exec();
+        stmt.reset();
     }
+
+    transaction.commit();
+}
+
+void CSQLiteRankingServer::BeginBulkImportSync(std::string prefix)
+{
+    FixPrefix(prefix);
+
+    if (!IsValidPrefix(prefix))
+        throw SQLite::Exception("Invalid prefix(not in valid prefix list): " + prefix);
+
+    m_Database.m_pDatabase->exec(IndicesQuery(prefix + m_BaseTableName, true));
+}
+
+void CSQLiteRankingServer::EndBulkImportSync(std::string prefix)
+{
+    FixPrefix(prefix);
+
+    if (!IsValidPrefix(prefix))
+        throw SQLite::Exception("Invalid prefix(not in valid prefix list): " + prefix);
+
+    m_Database.m_pDatabase->exec(IndicesQuery(prefix + m_BaseTableName, false));
 }
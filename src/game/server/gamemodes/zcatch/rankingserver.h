@@ -1,8 +1,11 @@
 #ifndef GAME_SERVER_RANKINGSERVER_H
 #define GAME_SERVER_RANKINGSERVER_H
 
+#include <condition_variable>
 #include <functional>
 #include <future>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <tuple>
@@ -44,6 +47,9 @@ class IRankingServer
     // Synchronizing threads
     std::mutex m_DatabaseMutex;
 
+    // reads don't need to lock the mutex above, if the database can handle them concurrently.
+    bool m_ConcurrentReads;
+
 
      // ranking order is based on this key.
     const std::string m_RankingKey{"Score"};
@@ -90,6 +96,20 @@ class IRankingServer
 
     // retrieve top x player ranks based on their key property(like score, wins, kills, deaths etc.) synchronously.
     virtual key_stats_vec_t GetTopRankingSync(int topNumber, std::string key, std::string prefix, bool biggestFirst) = 0;
+
+    // number of ranked players synchronously.
+    virtual size_t CountRankingsSync(std::string prefix) = 0;
+
+    // retrieve the player data of one part out of numParts parts in batches of at most batchSize players synchronously.
+    // the order is undefined and ranks are not set, fields that are not in the database are 0.
+    virtual void ExportRankingsSync(std::string prefix, int part, int numParts, size_t batchSize, cb_key_stats_vec_t callback) = 0;
+
+    // set the values of many players at once synchronously, using as few transactions/round trips as possible.
+    virtual void ImportRankingsSync(key_stats_vec_t& rankings, std::string prefix) = 0;
+
+    // prepare for/finish importing many players, e.g. by postponing index updates.
+    virtual void BeginBulkImportSync(std::string prefix) {}
+    virtual void EndBulkImportSync(std::string prefix) {}
     // ############################################################################################################
 
    public:
@@ -126,6 +146,20 @@ class IRankingServer
     bool DeleteRanking(std::string nickname, std::string prefix = "");
 
 
+    // Bulk access for offline tools like ranking_migrate.
+    // These functions are synchronous, throw on errors and bypass the backlog.
+    // Every instance has its own connection, use one instance per thread to read in parallel.
+    size_t CountRankings(std::string prefix = "");
+
+    void ExportRankings(std::string prefix, int part, int numParts, size_t batchSize, cb_key_stats_vec_t callback);
+
+    void ImportRankings(key_stats_vec_t& rankings, std::string prefix = "");
+
+    // the database might not be usable by the game server between those two calls.
+    void BeginBulkImport(std::string prefix = "");
+    void EndBulkImport(std::string prefix = "");
+
+
     // This functions can, but should not necessarily be used.
     // It can be used to synchronize execution.
     // wait for all futures to finish execution(used in destructor)
@@ -168,6 +202,15 @@ class CRedisRankingServer : public IRankingServer
     // retrieve top x player ranks based on their key property(like score, kills etc.).
     virtual IRankingServer::key_stats_vec_t GetTopRankingSync(int topNumber, std::string key, std::string prefix = "", bool biggestFirst = true);
 
+    // number of players in the ranking index
+    virtual size_t CountRankingsSync(std::string prefix = "");
+
+    // pages through the ranking index, player data of a page is retrieved in a single pipeline
+    virtual void ExportRankingsSync(std::string prefix, int part, int numParts, size_t batchSize, IRankingServer::cb_key_stats_vec_t callback);
+
+    // all hashes and index entries are sent in a single pipeline
+    virtual void ImportRankingsSync(IRankingServer::key_stats_vec_t& rankings, std::string prefix = "");
+
    public:
 
     // default constructor - prevents the creation of a backlog(especially the allocation of RAM)
@@ -182,12 +225,58 @@ class CRedisRankingServer : public IRankingServer
     virtual ~CRedisRankingServer();
 };
 
+// tuning of the sqlite connections
+struct CSQLiteSettings
+{
+    // readers don't block the writer and the other way around
+    bool m_WriteAheadLog{true};
+
+    // 0 = OFF, 1 = NORMAL, 2 = FULL
+    int m_Synchronous{1};
+
+    // page cache per connection
+    int m_CacheSizeKiB{8192};
+
+    // read only connections, reads run concurrently to each other and to writes(0 = reads share the writing connection)
+    int m_NumReaders{4};
+};
+
 class CSQLiteRankingServer : public IRankingServer
 {
    private:
     std::string m_FilePath;
 
-    SQLite::Database *m_pDatabase;
+    // a database connection with its prepared statements
+    struct CConnection
+    {
+        SQLite::Database *m_pDatabase{nullptr};
+        std::map<std::string, std::unique_ptr<SQLite::Statement> > m_Statements;
+
+        // statements are cached by name, buildQuery is only called when a statement is prepared for the first time.
+        SQLite::Statement& Statement(const std::string& name, const std::function<std::string()>& buildQuery);
+        void Close();
+    };
+
+    // used for writing and everything else that is not a ranking lookup
+    CConnection m_Database;
+
+    // pool of read only connections
+    std::vector<CConnection*> m_Readers;
+    std::vector<CConnection*> m_IdleReaders;
+    std::mutex m_ReadersMutex;
+    std::condition_variable m_ReadersCondition;
+
+    // lends an idle read connection for its lifetime, or the main connection if there is no pool.
+    class CReadConnection
+    {
+        CSQLiteRankingServer *m_pServer;
+        CConnection *m_pConnection;
+
+       public:
+        CReadConnection(CSQLiteRankingServer *pServer);
+        ~CReadConnection();
+        CConnection* operator->() { return m_pConnection; }
+    };
 
     std::mutex m_ValidPrefixListMutex;
     std::vector<std::string> m_ValidPrefixList;
@@ -199,6 +288,12 @@ class CSQLiteRankingServer : public IRankingServer
     bool IsValidPrefix(const std::string& prefix);
     void FixPrefix(std::string& prefix);
 
+    // creates or drops the indices of a prefix table
+    std::string IndicesQuery(const std::string& tableName, bool drop) const;
+
+    // inserts or replaces all fields of a player
+    std::string InsertQuery(const std::string& tableName) const;
+
    protected:
     // retrieve player data syncronously
     virtual CPlayerStats GetRankingSync(std::string nickname, std::string prefix = "");
@@ -215,13 +310,27 @@ class CSQLiteRankingServer : public IRankingServer
     // retrieve top x player ranks based on their key property(like score, kills etc.).
     virtual IRankingServer::key_stats_vec_t GetTopRankingSync(int topNumber, std::string key, std::string prefix = "", bool biggestFirst = true);
 
+    // number of rows in the prefix table
+    virtual size_t CountRankingsSync(std::string prefix = "");
+
+    // pages through a rowid range, only fields that exist as columns are read
+    virtual void ExportRankingsSync(std::string prefix, int part, int numParts, size_t batchSize, IRankingServer::cb_key_stats_vec_t callback);
+
+    // inserts all rows within a single transaction
+    virtual void ImportRankingsSync(IRankingServer::key_stats_vec_t& rankings, std::string prefix = "");
+
+    // building the indices once at the end is a lot faster than updating them for every row
+    virtual void BeginBulkImportSync(std::string prefix);
+    virtual void EndBulkImportSync(std::string prefix);
+
    public:
 
     // dummy
     CSQLiteRankingServer();
 
     // all prefixes need to be defined at construction time, in ordr to create the db tables.
-    CSQLiteRankingServer(std::string filePath, std::vector<std::string> validPrefixList = {{""}}, int busyTimeoutMs = 10000);
+    // a read only database is neither created nor are tables added to it.
+    CSQLiteRankingServer(std::string filePath, std::vector<std::string> validPrefixList = {{""}}, int busyTimeoutMs = 10000, bool readOnly = false, CSQLiteSettings settings = {});
     virtual ~CSQLiteRankingServer();
 };
 
@@ -40,11 +40,10 @@ CPlayer::CPlayer(CGameContext *pGameServer, int ClientID, bool Dummy, bool AsSpe
 
 	// Optimizations
 	m_pGameServer->AddPlayer(m_ClientID);
+	m_pGameServer->m_CatchGraph.SetIngame(m_ClientID, m_Team != TEAM_SPECTATORS);
 
 	// zCatch
-	m_CaughtBy = NOT_CAUGHT;
 	m_CaughtReason = REASON_NONE;
-	m_CaughtPlayers.reserve(MAX_PLAYERS);
 	m_NumCaughtPlayersWhoJoined = 0;
 	m_NumCaughtPlayersWhoLeft = 0;
 	m_NumWillinglyReleasedPlayers = 0;
@@ -60,6 +59,7 @@ CPlayer::~CPlayer()
 {
 	// player doesn't exist -> no need to iterate over that player anymore.
 	m_pGameServer->RemovePlayer(m_ClientID);
+	m_pGameServer->m_CatchGraph.Remove(m_ClientID);
 	delete m_pCharacter;
 	m_pCharacter = 0;
 }
@@ -499,6 +499,7 @@ void CPlayer::SetTeam(int Team, bool DoChatMsg)
 	KillCharacter();
 
 	m_Team = Team;
+	GameServer()->m_CatchGraph.SetIngame(m_ClientID, m_Team != TEAM_SPECTATORS);
 	m_LastActionTick = Server()->Tick();
 	m_SpecMode = SPEC_FREEVIEW;
 	m_SpectatorID = -1;
@@ -547,8 +548,7 @@ bool CPlayer::CatchPlayer(int ID, int reason)
 	// player can be caught by me(if not already caught)
 	if (GameServer()->m_apPlayers[ID] && GameServer()->m_apPlayers[ID]->BeCaught(m_ClientID, reason))
 	{
-		// player not cauht by anybody, add him to my caught players
-		m_CaughtPlayers.push_back(ID);
+		// player was not caught by anybody and is now on top of my caught players
 
 		// statistics
 		m_Kills++;
@@ -602,7 +602,7 @@ bool CPlayer::BeCaught(int byID, int reason)
 		// do not be caught
 		return false;
 	}
-	else if(m_CaughtBy == NOT_CAUGHT && GameServer()->m_apPlayers[byID])
+	else if(GetIDCaughtBy() == NOT_CAUGHT && GameServer()->m_apPlayers[byID])
 	{
 		// not caught case: be caught by ID
 		// can only be caught if player actually exists
@@ -628,9 +628,9 @@ bool CPlayer::BeCaught(int byID, int reason)
 				GameServer()->SendServerMessage(GetCID(), aBuf);
 		}
 
-		m_CaughtBy = byID;
+		GameServer()->m_CatchGraph.Catch(byID, m_ClientID);
 		m_CaughtReason = reason;
-		m_SpectatorID = m_CaughtBy;
+		m_SpectatorID = byID;
 		m_RespawnDisabled = true;
 
 		// respawn at least 3 seconds after being caught.
@@ -667,8 +667,9 @@ bool CPlayer::BeReleased(int reason)
 	// can be released if caught
 	// or if not caught and either joined the server
 	// or rejoined the game after being in spec
-	if (m_CaughtBy >= 0 || 
-		(m_CaughtBy == NOT_CAUGHT && 
+	int CaughtBy = GetIDCaughtBy();
+	if (CaughtBy >= 0 || 
+		(CaughtBy == NOT_CAUGHT && 
 			(
 				reason == REASON_PLAYER_JOINED || 
 				reason == REASON_PLAYER_JOINED_GAME_AGAIN
@@ -688,7 +689,7 @@ bool CPlayer::BeReleased(int reason)
 				if(m_DetailedServerMessages)
 				{
 					// this happens too often, as that it should be displayed on every death.
-					str_format(aBuf, sizeof(aBuf), "You were released because '%s' died.", Server()->ClientName(m_CaughtBy));
+					str_format(aBuf, sizeof(aBuf), "You were released because '%s' died.", Server()->ClientName(CaughtBy));
 				}
 				else
 				{
@@ -696,10 +697,10 @@ bool CPlayer::BeReleased(int reason)
 				}
 				break;
 			case REASON_PLAYER_FAILED:
-				str_format(aBuf, sizeof(aBuf), "You were released because '%s' failed miserably.", Server()->ClientName(m_CaughtBy));
+				str_format(aBuf, sizeof(aBuf), "You were released because '%s' failed miserably.", Server()->ClientName(CaughtBy));
 				break;
 			case REASON_PLAYER_RELEASED:
-				str_format(aBuf, sizeof(aBuf), "You were released because '%s' is a generous player.", Server()->ClientName(m_CaughtBy));
+				str_format(aBuf, sizeof(aBuf), "You were released because '%s' is a generous player.", Server()->ClientName(CaughtBy));
 				break;
 			case REASON_PLAYER_WARMUP_RELEASED:
 				sendServerMessage = false;
@@ -708,7 +709,7 @@ bool CPlayer::BeReleased(int reason)
 				str_format(aBuf, sizeof(aBuf), "You were released because nobody has caught any players yet.");
 				break;
 			case REASON_PLAYER_JOINED_SPEC:
-				str_format(aBuf, sizeof(aBuf), "You were released because '%s' joined the spectators.", Server()->ClientName(m_CaughtBy));
+				str_format(aBuf, sizeof(aBuf), "You were released because '%s' joined the spectators.", Server()->ClientName(CaughtBy));
 				break;
 			case REASON_PLAYER_JOINED_GAME_AGAIN:
 				sendServerMessage = false;
@@ -717,7 +718,7 @@ bool CPlayer::BeReleased(int reason)
 				// the player was previously willingly explicitly stectating.
 				break;
 			case REASON_PLAYER_LEFT:
-				str_format(aBuf, sizeof(aBuf), "You were released because '%s' has left the game.", Server()->ClientName(m_CaughtBy));
+				str_format(aBuf, sizeof(aBuf), "You were released because '%s' has left the game.", Server()->ClientName(CaughtBy));
 				break;
 			case REASON_EVERYONE_RELEASED:
 				str_format(aBuf, sizeof(aBuf), "Everyone was released!");
@@ -729,7 +730,8 @@ bool CPlayer::BeReleased(int reason)
 				GameServer()->SendServerMessage(GetCID(), aBuf);
 		}
 
-		m_CaughtBy = NOT_CAUGHT;
+		// takes me off the caught players of my killer
+		GameServer()->m_CatchGraph.Release(m_ClientID);
 		m_CaughtReason = REASON_NONE;
 		m_SpectatorID = -1;
 		m_RespawnDisabled = false;
@@ -755,17 +757,14 @@ bool CPlayer::BeReleased(int reason)
 // affects oneself & caught players
 int CPlayer::ReleaseLastCaughtPlayer(int reason, bool updateSkinColors)
 {
-	if (m_CaughtPlayers.size() > 0)
+	int playerToReleaseID = GameServer()->m_CatchGraph.LastCaught(m_ClientID);
+	if (playerToReleaseID != NOT_CAUGHT)
 	{
-		int playerToReleaseID = m_CaughtPlayers.back();
-		
-
 		// look at last still existing player.
 
 		if(GameServer()->m_apPlayers[playerToReleaseID] && GameServer()->m_apPlayers[playerToReleaseID]->BeReleased(reason))
 		{
-			// player can be released
-			m_CaughtPlayers.pop_back();
+			// player was released and is not among my caught players anymore
 
 			/*
 				Inform the releasing player about the player he/she willingly
@@ -795,14 +794,8 @@ int CPlayer::ReleaseLastCaughtPlayer(int reason, bool updateSkinColors)
 				// our updated skin color in here.
 				if (reason == REASON_PLAYER_RELEASED || reason == REASON_PLAYER_WARMUP_RELEASED)
 				{
-					for (int toID : GameServer()->PlayerIDs())
-					{
-						if (GameServer()->m_apPlayers[toID])
-						{
-							// send skin update message of id to everyone
-							GameServer()->SendSkinChange(m_ClientID, toID);
-						}
-					}
+					// send skin update message of id to everyone
+					GameServer()->QueueSkinChange(m_ClientID);
 				}
 			
 			}
@@ -811,8 +804,8 @@ int CPlayer::ReleaseLastCaughtPlayer(int reason, bool updateSkinColors)
 		else
 		{
 			// player that needs to be released does not exist anymore
-			// but is still popped from the vector
-			m_CaughtPlayers.pop_back();
+			// but is still removed from my caught players
+			GameServer()->m_CatchGraph.Release(playerToReleaseID);
 
 			// player cannot be released
 			return NOT_CAUGHT;
@@ -828,52 +821,40 @@ int CPlayer::ReleaseLastCaughtPlayer(int reason, bool updateSkinColors)
 // remove given id from my caught players
 bool CPlayer::RemoveFromCaughtPlayers(int ID, int reason)
 {
-	// removes elements, but leaves garbage at the end of the vector
-	auto it = std::remove_if(m_CaughtPlayers.begin(), m_CaughtPlayers.end(), [this, ID, reason](int lookAtID) {
-		if (lookAtID == ID)
-		{
-			// remove from my caught players & release at the same time.
-			if(GameServer()->m_apPlayers[lookAtID])
-			{
-				// if player is still online, release him/her.
-				GameServer()->m_apPlayers[lookAtID]->BeReleased(reason);
-			}
-			return true;
-		}
-		else
-		{
-			return false;
-		}
-	});
+	if(!GameServer()->m_CatchGraph.IsCaughtBy(ID, m_ClientID))
+		return false;
 
-	if(it != m_CaughtPlayers.end())
+	// remove from my caught players & release at the same time.
+	if(GameServer()->m_apPlayers[ID])
 	{
-		// erase garbage elements from end of vector
-		m_CaughtPlayers.erase(it, m_CaughtPlayers.end());
-		switch(reason)
-		{
-			case REASON_PLAYER_LEFT:
-				// player was removed from my caught players, 
-				// because he/she left the game
-				m_NumCaughtPlayersWhoLeft++;
-				break;
-		}
+		// if player is still online, release him/her.
+		GameServer()->m_apPlayers[ID]->BeReleased(reason);
+	}
+	GameServer()->m_CatchGraph.Release(ID);
 
-		// only update colors if actually someone was released
-		UpdateSkinColors();
+	switch(reason)
+	{
+		case REASON_PLAYER_LEFT:
+			// player was removed from my caught players, 
+			// because he/she left the game
+			m_NumCaughtPlayersWhoLeft++;
+			break;
 	}
 
-	return it != m_CaughtPlayers.end();
+	// only update colors if actually someone was released
+	UpdateSkinColors();
+	return true;
 }
 
 bool CPlayer::BeSetFree(int reason)
 {
-	if (m_CaughtBy != NOT_CAUGHT)
+	int CaughtBy = GetIDCaughtBy();
+	if (CaughtBy != NOT_CAUGHT)
 	{
-		if(GameServer()->m_apPlayers[m_CaughtBy])
+		if(GameServer()->m_apPlayers[CaughtBy])
 		{
 			// if my killer still exists, remove from his caught players
-			return GameServer()->m_apPlayers[m_CaughtBy]->RemoveFromCaughtPlayers(m_ClientID, reason);
+			return GameServer()->m_apPlayers[CaughtBy]->RemoveFromCaughtPlayers(m_ClientID, reason);
 		}
 		else
 		{
@@ -893,7 +874,7 @@ int CPlayer::ReleaseAllCaughtPlayers(int reason)
 	m_NumCaughtPlayersWhoLeft = 0;
 	m_NumWillinglyReleasedPlayers = 0;
 
-	int releasedPlayers = m_CaughtPlayers.size();
+	int releasedPlayers = GetNumCurrentlyCaughtPlayers();
 
 	// don't send messages, when nobody was released.
 	if(releasedPlayers == 0)
@@ -975,12 +956,13 @@ void CPlayer::SetPlayersLeftToCatch(int leftToCatch)
 
 		dbg_msg("DEBUG", "CAUGHT PLAYERs: %d", GetNumCurrentlyCaughtPlayers());
 
-		for(const int ID : m_CaughtPlayers)
+		// from the last caught player to the first one
+		for(int ID = GameServer()->m_CatchGraph.LastCaught(m_ClientID); ID != NOT_CAUGHT; ID = GameServer()->m_CatchGraph.CaughtBefore(ID))
 		{
 			if(GameServer()->m_apPlayers[ID])
 				dbg_msg("DEBUG", "%s", GameServer()->m_apPlayers[ID]->str().c_str());
 			else{
-				dbg_msg("DEBUG", "INVALID ID IN m_CaughtPlayers: %d", ID);
+				dbg_msg("DEBUG", "INVALID ID IN CAUGHT PLAYERS: %d", ID);
 			}
 		}
 
@@ -998,12 +980,12 @@ int CPlayer::GetPlayersLeftToCatch()
 
 int CPlayer::GetNumCurrentlyCaughtPlayers()
 {
-	return m_CaughtPlayers.size();
+	return GameServer()->m_CatchGraph.NumCaught(m_ClientID);
 }
 
 int CPlayer::GetNumTotalCaughtPlayers()
 {
-	return m_CaughtPlayers.size() + m_NumCaughtPlayersWhoLeft - m_NumCaughtPlayersWhoJoined;
+	return GetNumCurrentlyCaughtPlayers() + m_NumCaughtPlayersWhoLeft - m_NumCaughtPlayersWhoJoined;
 }
 
 int CPlayer::GetNumCaughtPlayersWhoLeft()
@@ -1023,12 +1005,12 @@ int CPlayer::GetNumReleasedPlayers()
 
 int CPlayer::GetNumCaughtPlayersInARow()
 {
-	return m_CaughtPlayers.size() - m_NumCaughtPlayersWhoJoined + m_NumCaughtPlayersWhoLeft + m_NumWillinglyReleasedPlayers;
+	return GetNumCurrentlyCaughtPlayers() - m_NumCaughtPlayersWhoJoined + m_NumCaughtPlayersWhoLeft + m_NumWillinglyReleasedPlayers;
 }
 
 int CPlayer::GetIDCaughtBy()
 {
-	return m_CaughtBy;
+	return GameServer()->m_CatchGraph.CaughtBy(m_ClientID);
 }
 
 int CPlayer::GetCaughtReason()
@@ -1038,8 +1020,8 @@ int CPlayer::GetCaughtReason()
 
 bool CPlayer::IsCaught()
 {
-	return m_CaughtBy >= 0 
-		&& m_CaughtBy < MAX_CLIENTS  // caught
+	return GetIDCaughtBy() >= 0 
+		&& GetIDCaughtBy() < MAX_CLIENTS  // caught
 		&& m_Team != TEAM_SPECTATORS  // not in spec
 		&& (m_RespawnDisabled // cannot spawn
 		|| (m_pCharacter && !m_pCharacter->IsAlive())); // 
@@ -1047,7 +1029,7 @@ bool CPlayer::IsCaught()
 
 bool CPlayer::IsNotCaught()
 {
-	return m_CaughtBy == NOT_CAUGHT // not caught
+	return GetIDCaughtBy() == NOT_CAUGHT // not caught
 		&& m_Team != TEAM_SPECTATORS // not in spec
 		&& (!m_RespawnDisabled  // can spawn
 		|| (m_pCharacter && m_pCharacter->IsAlive())); // or is alive
@@ -1161,7 +1143,7 @@ std::string CPlayer::str()
 {
 	std::stringstream ss;
 	ss << "\n" << Server()->ClientName(m_ClientID) << "\n{\n";
-	ss << "Caught by: " << m_CaughtBy << "\n";
+	ss << "Caught by: " << GetIDCaughtBy() << "\n";
 	ss << "IsCaught: " << IsCaught() << "\n";
 	ss << "IsNotCaught: " << IsNotCaught() << "\n";
 	ss << "CaughtReason: " << GetCaughtReason() << "\n";
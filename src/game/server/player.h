@@ -248,8 +248,7 @@ private:
 	int m_Team;
 	bool m_Dummy;
 
-	// zCatch
-	int m_CaughtBy;
+	// zCatch, who caught whom is kept in CGameContext::m_CatchGraph
 	int m_CaughtReason;
 
 	int m_PlayersLeftToCatch;
@@ -261,8 +260,6 @@ private:
 	// and release him/her
 	bool RemoveFromCaughtPlayers(int ID, int reason=REASON_NONE);
 
-
-	std::vector<int> m_CaughtPlayers;
 	// preventing rejoin exploitation.
 	int m_NumCaughtPlayersWhoLeft;
 	int m_NumCaughtPlayersWhoJoined;
@@ -0,0 +1,93 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <game/collision.h>
+
+#include "spawneval.h"
+
+// start, left, up, right, down
+const vec2 CSpawnEvaluator::ms_aOffsets[NUM_OFFSETS] = { vec2(0.0f, 0.0f), vec2(-32.0f, 0.0f), vec2(0.0f, -32.0f), vec2(32.0f, 0.0f), vec2(0.0f, 32.0f) };
+
+CSpawnEvaluator::CSpawnEvaluator()
+{
+	Clear();
+}
+
+void CSpawnEvaluator::Clear()
+{
+	for(int i = 0; i < NUM_SPAWNTYPES; i++)
+		m_aNumSpawnPoints[i] = 0;
+}
+
+void CSpawnEvaluator::AddSpawnPoint(int Type, vec2 Pos, const CCollision *pCollision)
+{
+	if(m_aNumSpawnPoints[Type] >= MAX_SPAWNPOINTS)
+		return;
+
+	CSpawnPoint *pSpawn = &m_aaSpawnPoints[Type][m_aNumSpawnPoints[Type]++];
+	pSpawn->m_Pos = Pos;
+	for(int i = 0; i < NUM_OFFSETS; i++)
+		pSpawn->m_aSolid[i] = pCollision->CheckPoint(Pos+ms_aOffsets[i]);
+}
+
+float CSpawnEvaluator::EvaluatePos(const CSpawnEval *pEval, vec2 Pos) const
+{
+	float Score = 0.0f;
+	for(int c = 0; c < pEval->m_NumChars; c++)
+	{
+		// team mates are not as dangerous as enemies
+		float Scoremod = 1.0f;
+		if(pEval->m_FriendlyTeam != -1 && pEval->m_aCharTeam[c] == pEval->m_FriendlyTeam)
+			Scoremod = 0.5f;
+
+		float d = distance(Pos, pEval->m_aCharPos[c]);
+		Score += Scoremod * (d == 0 ? 1000000000.0f : 1.0f/d);
+	}
+
+	return Score;
+}
+
+void CSpawnEvaluator::EvaluateType(CSpawnEval *pEval, int Type) const
+{
+	int aNear[MAX_CLIENTS];
+
+	// get spawn point
+	for(int i = 0; i < m_aNumSpawnPoints[Type]; i++)
+	{
+		const CSpawnPoint *pSpawn = &m_aaSpawnPoints[Type][i];
+
+		// check if the position is occupado
+		int Num = 0;
+		for(int c = 0; c < pEval->m_NumChars; c++)
+			if(distance(pEval->m_aCharPos[c], pSpawn->m_Pos) < 64+pEval->m_aCharRadius[c])
+				aNear[Num++] = c;
+
+		// the map is only checked if there are characters close by
+		int Result = -1;
+		for(int Index = 0; Index < NUM_OFFSETS && Result == -1; ++Index)
+		{
+			Result = Index;
+			if(Num && pSpawn->m_aSolid[Index])
+			{
+				Result = -1;
+				continue;
+			}
+			for(int n = 0; n < Num; ++n)
+				if(distance(pEval->m_aCharPos[aNear[n]], pSpawn->m_Pos+ms_aOffsets[Index]) <= pEval->m_aCharRadius[aNear[n]])
+				{
+					Result = -1;
+					break;
+				}
+		}
+		if(Result == -1)
+			continue;	// try next spawn point
+
+		vec2 P = pSpawn->m_Pos+ms_aOffsets[Result];
+		float S = EvaluatePos(pEval, P);
+		if(!pEval->m_Got || pEval->m_Score > S)
+		{
+			pEval->m_Got = true;
+			pEval->m_Score = S;
+			pEval->m_Pos = P;
+		}
+	}
+}
@@ -0,0 +1,93 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#ifndef GAME_SERVER_SPAWNEVAL_H
+#define GAME_SERVER_SPAWNEVAL_H
+
+#include <base/vmath.h>
+#include <engine/shared/protocol.h>
+
+struct CSpawnEval
+{
+	CSpawnEval()
+	{
+		m_Got = false;
+		m_FriendlyTeam = -1;
+		m_Pos = vec2(100,100);
+		m_NumChars = 0;
+	}
+
+	vec2 m_Pos;
+	bool m_Got;
+	bool m_RandomSpawn;
+	int m_FriendlyTeam;
+	float m_Score;
+
+	// characters in the order of the world's character list
+	vec2 m_aCharPos[MAX_CLIENTS];
+	float m_aCharRadius[MAX_CLIENTS];
+	int m_aCharTeam[MAX_CLIENTS];
+	int m_NumChars;
+
+	void AddCharacter(vec2 Pos, float Radius, int Team)
+	{
+		if(m_NumChars >= MAX_CLIENTS)
+			return;
+		m_aCharPos[m_NumChars] = Pos;
+		m_aCharRadius[m_NumChars] = Radius;
+		m_aCharTeam[m_NumChars] = Team;
+		m_NumChars++;
+	}
+};
+
+/*
+	Class: Spawn Evaluator
+		Keeps the spawn points of the map together with the offsets
+		around them that are blocked by the map, so that those are
+		only tested once at map load. Before evaluating, the characters
+		of the world are gathered in a single pass into the flat arrays
+		of the evaluation, which the occupation checks and the scoring
+		of all spawn points then run over.
+*/
+class CSpawnEvaluator
+{
+public:
+	enum
+	{
+		NUM_SPAWNTYPES=3,
+		MAX_SPAWNPOINTS=64,
+		NUM_OFFSETS=5,
+	};
+
+private:
+	struct CSpawnPoint
+	{
+		vec2 m_Pos;
+		bool m_aSolid[NUM_OFFSETS];
+	};
+
+	CSpawnPoint m_aaSpawnPoints[NUM_SPAWNTYPES][MAX_SPAWNPOINTS];
+	int m_aNumSpawnPoints[NUM_SPAWNTYPES];
+
+	float EvaluatePos(const CSpawnEval *pEval, vec2 Pos) const;
+
+public:
+	static const vec2 ms_aOffsets[NUM_OFFSETS];
+
+	CSpawnEvaluator();
+
+	void Clear();
+	void AddSpawnPoint(int Type, vec2 Pos, const class CCollision *pCollision);
+	int NumSpawnPoints(int Type) const { return m_aNumSpawnPoints[Type]; }
+
+	/*
+		Function: EvaluateType
+			The characters of the world have to be added to pEval
+			before, in the order of the world's character list.
+			Looks for the least dangerous free spawn position of the
+			given spawn type and stores it in pEval if it is better
+			than the one found so far.
+	*/
+	void EvaluateType(CSpawnEval *pEval, int Type) const;
+};
+
+#endif
@@ -168,6 +168,10 @@ MACRO_CONFIG_STR(SvDatabaseHost, sv_db_host, 16, "127.0.0.1", CFGFLAG_SERVER, "H
 MACRO_CONFIG_INT(SvDatabasePort, sv_db_port, 6379, 1024, 65535, CFGFLAG_SERVER, "Port of the database")
 
 MACRO_CONFIG_STR(SvSQLiteFilename, sv_db_sqlite_file, 256, "ranking.db", CFGFLAG_SERVER, "Relative path to the sqlite3 database(default: ranking.db).")
+MACRO_CONFIG_INT(SvSQLiteWal, sv_db_sqlite_wal, 1, 0, 1, CFGFLAG_SERVER, "Use a write-ahead log, so that ranking lookups and updates don't wait for each other")
+MACRO_CONFIG_INT(SvSQLiteSynchronous, sv_db_sqlite_synchronous, 1, 0, 2, CFGFLAG_SERVER, "How often sqlite waits for writes to reach the disk(0 = off, 1 = normal, 2 = full)")
+MACRO_CONFIG_INT(SvSQLiteCacheSize, sv_db_sqlite_cache_size, 8192, 256, 1048576, CFGFLAG_SERVER, "Page cache of every sqlite connection in KiB")
+MACRO_CONFIG_INT(SvSQLiteReaders, sv_db_sqlite_readers, 4, 0, 16, CFGFLAG_SERVER, "Read only sqlite connections for concurrent ranking lookups(0 = lookups share the writing connection)")
 
 // beginner server stuff
 MACRO_CONFIG_STR(SvBeginnerServerKickWarning, sv_beginner_srv_kick_warning, 512, "This is a beginner server, you are not allowed to play here.", CFGFLAG_SERVER, "Warning message when the countdown starts.")
@@ -453,6 +453,7 @@ int main(int argc, const char **argv) // ignore_convention
 			PurgeServers();
 			UpdateServers();
 			BuildPackets();
+			m_NetBan.Update();
 		}
 
 		// be nice to the CPU
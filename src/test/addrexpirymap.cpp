@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/server/addrexpirymap.h>
+
+static NETADDR Addr(const char *pStr)
+{
+	NETADDR Addr;
+	net_addr_from_str(&Addr, pStr);
+	return Addr;
+}
+
+TEST(AddrExpiryMap, FindIgnoresPort)
+{
+	CAddrExpiryMap<int> Map;
+	NETADDR A = Addr("192.168.1.5:8303");
+	NETADDR B = Addr("192.168.1.5:8304");
+	NETADDR C = Addr("192.168.1.7:8303");
+	Map.Set(&A, 100, 1);
+
+	ASSERT_TRUE(Map.Find(&B, 0));
+	EXPECT_EQ(Map.Find(&B, 0)->m_Data, 1);
+	EXPECT_FALSE(Map.Find(&C, 0));
+
+	// overwriting keeps a single entry
+	Map.Set(&B, 200, 2);
+	EXPECT_EQ(Map.Size(), 1);
+	EXPECT_EQ(Map.Find(&A, 0)->m_Data, 2);
+}
+
+TEST(AddrExpiryMap, Expire)
+{
+	CAddrExpiryMap<int> Map;
+	NETADDR A = Addr("10.0.0.1");
+	NETADDR B = Addr("10.0.0.2");
+	NETADDR C = Addr("[::1]");
+	Map.Set(&A, 10, 1);
+	Map.Set(&B, 20, 2);
+	Map.Set(&C, 30, 3);
+
+	// expired entries are not found before they are removed
+	EXPECT_TRUE(Map.Find(&A, 9));
+	EXPECT_FALSE(Map.Find(&A, 10));
+
+	EXPECT_EQ(Map.Expire(10), 1);
+	EXPECT_EQ(Map.Size(), 2);
+
+	// moved expiry replaces the old one
+	Map.SetExpiry(Map.Find(&B, 10), 40);
+	EXPECT_EQ(Map.Expire(30), 1);
+	EXPECT_FALSE(Map.Find(&C, 0));
+	EXPECT_TRUE(Map.Find(&B, 30));
+	EXPECT_EQ(Map.Expire(40), 1);
+	EXPECT_EQ(Map.Size(), 0);
+}
+
+TEST(AddrExpiryMap, RemoveAndTrim)
+{
+	CAddrExpiryMap<int> Map;
+	char aBuf[32];
+	for(int i = 0; i < 100; i++)
+	{
+		str_format(aBuf, sizeof(aBuf), "10.0.%d.%d", i/10, i%10);
+		NETADDR A = Addr(aBuf);
+		Map.Set(&A, 1000-i, i%5);
+	}
+	EXPECT_EQ(Map.RemoveIf([](const CAddrExpiryMap<int>::CEntry &Entry) { return Entry.m_Data == 0; }), 20);
+	EXPECT_EQ(Map.Size(), 80);
+
+	NETADDR A = Addr("10.0.0.1");
+	EXPECT_TRUE(Map.Remove(&A));
+	EXPECT_FALSE(Map.Remove(&A));
+
+	// the entries expiring first go first
+	Map.Trim(10);
+	EXPECT_EQ(Map.Size(), 10);
+	std::vector<const CAddrExpiryMap<int>::CEntry *> Sorted;
+	Map.GetSorted(&Sorted);
+	ASSERT_EQ(Sorted.size(), 10u);
+	EXPECT_EQ(Sorted[0]->m_ExpiresTick, 1000-13);
+	EXPECT_EQ(Sorted[9]->m_ExpiresTick, 1000-2);
+	for(unsigned i = 1; i < Sorted.size(); i++)
+		EXPECT_LT(Sorted[i-1]->m_ExpiresTick, Sorted[i]->m_ExpiresTick);
+}
+
+TEST(AddrExpiryMap, ManyUpdates)
+{
+	CAddrExpiryMap<int> Map;
+	NETADDR A = Addr("10.0.0.1");
+	NETADDR B = Addr("10.0.0.2");
+	Map.Set(&B, 5000, 0);
+	for(int i = 0; i < 1000; i++)
+		Map.Set(&A, 2000-i, i);
+	EXPECT_EQ(Map.Expire(1000), 0);
+	EXPECT_EQ(Map.Find(&A, 1000)->m_Data, 999);
+	EXPECT_EQ(Map.Expire(1001), 1);
+	EXPECT_EQ(Map.Size(), 1);
+	EXPECT_TRUE(Map.Find(&B, 1001));
+}
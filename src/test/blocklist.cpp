@@ -0,0 +1,88 @@
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/shared/blocklist.h>
+#include <engine/shared/netban.h>
+#include <engine/storage.h>
+
+static bool Blocked(const CBlocklist *pBlocklist, const char *pAddr)
+{
+	NETADDR Addr;
+	EXPECT_EQ(net_addr_from_str(&Addr, pAddr), 0);
+	return pBlocklist->Contains(&Addr);
+}
+
+TEST(Blocklist, WriteAndLookup)
+{
+	const char *apEntries[] = {
+		"10.0.0.0/8",
+		"10.1.0.0-10.1.0.255", // inside of the one above
+		"192.168.0.1",
+		"192.168.0.2-192.168.0.9", // adjacent to the one above
+		"1.2.3.4",
+		"2001:db8::/32",
+		"::5",
+	};
+	const int NumEntries = sizeof(apEntries)/sizeof(apEntries[0]);
+	CNetRange aRanges[NumEntries];
+	for(int i = 0; i < NumEntries; i++)
+	{
+		int Result = NetRangeFromStr(apEntries[i], &aRanges[i]);
+		ASSERT_NE(Result, 0);
+		if(Result == 1)
+			aRanges[i].m_UB = aRanges[i].m_LB;
+	}
+
+	CTestInfo Info;
+	IStorage *pStorage = CreateTestStorage();
+	IOHANDLE File = pStorage->OpenFile(Info.m_aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	EXPECT_TRUE(CBlocklist::Write(File, aRanges, NumEntries));
+	io_close(File);
+
+	CBlocklist Blocklist;
+	char aError[64];
+	ASSERT_TRUE(Blocklist.Open(pStorage, Info.m_aFilename, aError, sizeof(aError)));
+	// the nested and adjacent ranges got merged
+	EXPECT_EQ(Blocklist.NumRanges(), 5);
+
+	EXPECT_TRUE(Blocked(&Blocklist, "10.0.0.0"));
+	EXPECT_TRUE(Blocked(&Blocklist, "10.255.255.255"));
+	EXPECT_FALSE(Blocked(&Blocklist, "11.0.0.0"));
+	EXPECT_FALSE(Blocked(&Blocklist, "9.255.255.255"));
+	EXPECT_TRUE(Blocked(&Blocklist, "192.168.0.1"));
+	EXPECT_TRUE(Blocked(&Blocklist, "192.168.0.9"));
+	EXPECT_FALSE(Blocked(&Blocklist, "192.168.0.10"));
+	EXPECT_FALSE(Blocked(&Blocklist, "192.168.0.0"));
+	EXPECT_TRUE(Blocked(&Blocklist, "1.2.3.4"));
+	EXPECT_FALSE(Blocked(&Blocklist, "1.2.3.5"));
+	EXPECT_FALSE(Blocked(&Blocklist, "0.0.0.0"));
+	EXPECT_TRUE(Blocked(&Blocklist, "[2001:db8:1234::1]"));
+	EXPECT_FALSE(Blocked(&Blocklist, "[2001:db9::]"));
+	EXPECT_TRUE(Blocked(&Blocklist, "[::5]"));
+	EXPECT_FALSE(Blocked(&Blocklist, "[::6]"));
+
+	Blocklist.Close();
+	pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+}
+
+TEST(Blocklist, Invalid)
+{
+	CTestInfo Info;
+	IStorage *pStorage = CreateTestStorage();
+	IOHANDLE File = pStorage->OpenFile(Info.m_aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, "not a blocklist", 15);
+	io_close(File);
+
+	CBlocklist Blocklist;
+	char aError[64];
+	EXPECT_FALSE(Blocklist.Open(pStorage, Info.m_aFilename, aError, sizeof(aError)));
+	EXPECT_FALSE(Blocklist.IsOpen());
+	EXPECT_FALSE(Blocklist.Open(pStorage, "nonexistent_blocklist.bin", aError, sizeof(aError)));
+
+	pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+}
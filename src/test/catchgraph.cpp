@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/server/catchgraph.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// the catch relation as the players used to keep it, one vector per catcher
+class CReferenceCatches
+{
+public:
+	int m_aCaughtBy[MAX_CLIENTS];
+	std::vector<int> m_aCaughtPlayers[MAX_CLIENTS];
+	bool m_aIngame[MAX_CLIENTS];
+
+	CReferenceCatches()
+	{
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			m_aCaughtBy[i] = CCatchGraph::NOT_CAUGHT;
+			m_aIngame[i] = false;
+		}
+	}
+
+	void Catch(int Catcher, int Victim)
+	{
+		m_aCaughtBy[Victim] = Catcher;
+		m_aCaughtPlayers[Catcher].push_back(Victim);
+	}
+
+	int ReleaseLast(int Catcher)
+	{
+		if(m_aCaughtPlayers[Catcher].empty())
+			return CCatchGraph::NOT_CAUGHT;
+		int Victim = m_aCaughtPlayers[Catcher].back();
+		m_aCaughtPlayers[Catcher].pop_back();
+		m_aCaughtBy[Victim] = CCatchGraph::NOT_CAUGHT;
+		return Victim;
+	}
+
+	bool Remove(int Catcher, int Victim)
+	{
+		std::vector<int> &Caught = m_aCaughtPlayers[Catcher];
+		auto it = std::remove_if(Caught.begin(), Caught.end(), [Victim](int ID) { return ID == Victim; });
+		if(it == Caught.end())
+			return false;
+		Caught.erase(it, Caught.end());
+		m_aCaughtBy[Victim] = CCatchGraph::NOT_CAUGHT;
+		return true;
+	}
+
+	int NumIngame() const
+	{
+		return std::count(m_aIngame, m_aIngame+MAX_CLIENTS, true);
+	}
+};
+
+static void ExpectEqual(const CCatchGraph &Graph, const CReferenceCatches &Reference)
+{
+	int NumCaught = 0;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		const std::vector<int> &Caught = Reference.m_aCaughtPlayers[i];
+		ASSERT_EQ(Graph.CaughtBy(i), Reference.m_aCaughtBy[i]);
+		ASSERT_EQ(Graph.IsCaught(i), Reference.m_aCaughtBy[i] != CCatchGraph::NOT_CAUGHT);
+		ASSERT_EQ(Graph.NumCaught(i), (int)Caught.size());
+
+		// the release stack holds the same players in the same order
+		int ID = Graph.LastCaught(i);
+		for(int j = (int)Caught.size()-1; j >= 0; j--)
+		{
+			ASSERT_EQ(ID, Caught[j]);
+			ASSERT_TRUE(Graph.IsCaughtBy(ID, i));
+			ID = Graph.CaughtBefore(ID);
+		}
+		ASSERT_EQ(ID, CCatchGraph::NOT_CAUGHT);
+		NumCaught += Caught.size();
+	}
+	ASSERT_EQ(Graph.NumCaught(), NumCaught);
+	ASSERT_EQ(Graph.NumIngame(), Reference.NumIngame());
+}
+
+TEST(CatchGraph, ReleaseOrder)
+{
+	CCatchGraph Graph;
+	Graph.Catch(0, 3);
+	Graph.Catch(0, 1);
+	Graph.Catch(0, 2);
+	EXPECT_EQ(Graph.NumCaught(0), 3);
+	EXPECT_EQ(Graph.LastCaught(0), 2);
+
+	// taking one out of the middle keeps the order of the others
+	EXPECT_EQ(Graph.Release(1), 0);
+	EXPECT_EQ(Graph.Release(1), CCatchGraph::NOT_CAUGHT);
+	EXPECT_EQ(Graph.LastCaught(0), 2);
+	EXPECT_EQ(Graph.CaughtBefore(2), 3);
+
+	// a leaving catcher frees its victims
+	Graph.Catch(2, 5);
+	Graph.Remove(0);
+	EXPECT_EQ(Graph.NumCaught(0), 0);
+	EXPECT_EQ(Graph.CaughtBy(2), CCatchGraph::NOT_CAUGHT);
+	EXPECT_EQ(Graph.CaughtBy(3), CCatchGraph::NOT_CAUGHT);
+	EXPECT_EQ(Graph.CaughtBy(5), 2);
+	EXPECT_EQ(Graph.NumCaught(), 1);
+}
+
+TEST(CatchGraph, Fuzz)
+{
+	CCatchGraph Graph;
+	CReferenceCatches Reference;
+	std::mt19937 Rand(1234);
+
+	for(int Step = 0; Step < 200000; Step++)
+	{
+		// few players make long chains and many collisions more likely
+		int NumPlayers = Step < 100000 ? 8 : MAX_CLIENTS;
+		int a = Rand()%NumPlayers;
+		int b = Rand()%NumPlayers;
+
+		switch(Rand()%8)
+		{
+		case 0:
+		case 1:
+		case 2:
+			// being caught releases all own victims, like CPlayer::BeCaught
+			if(a != b && Reference.m_aCaughtBy[b] == CCatchGraph::NOT_CAUGHT)
+			{
+				Graph.Catch(a, b);
+				Reference.Catch(a, b);
+				while(true)
+				{
+					int Released = Graph.LastCaught(b);
+					ASSERT_EQ(Released, Reference.ReleaseLast(b));
+					if(Released == CCatchGraph::NOT_CAUGHT)
+						break;
+					Graph.Release(Released);
+				}
+			}
+			break;
+		case 3:
+		{
+			// the suicide key releases the last caught player
+			int Released = Graph.LastCaught(a);
+			ASSERT_EQ(Released, Reference.ReleaseLast(a));
+			if(Released != CCatchGraph::NOT_CAUGHT)
+			{
+				EXPECT_EQ(Graph.Release(Released), a);
+			}
+			break;
+		}
+		case 4:
+		{
+			// set free by the catcher, e.g. when leaving
+			bool Removed = Graph.IsCaughtBy(b, a);
+			ASSERT_EQ(Removed, Reference.Remove(a, b));
+			if(Removed)
+			{
+				EXPECT_EQ(Graph.Release(b), a);
+			}
+			break;
+		}
+		case 5:
+			// dying releases everyone
+			while(Graph.LastCaught(a) != CCatchGraph::NOT_CAUGHT)
+				ASSERT_EQ(Graph.Release(Graph.LastCaught(a)), a);
+			while(Reference.ReleaseLast(a) != CCatchGraph::NOT_CAUGHT);
+			break;
+		case 6:
+			// leaving the server
+			Graph.Remove(a);
+			if(Reference.m_aCaughtBy[a] != CCatchGraph::NOT_CAUGHT)
+				Reference.Remove(Reference.m_aCaughtBy[a], a);
+			while(Reference.ReleaseLast(a) != CCatchGraph::NOT_CAUGHT);
+			Reference.m_aIngame[a] = false;
+			break;
+		case 7:
+			Graph.SetIngame(a, b%2);
+			Reference.m_aIngame[a] = b%2;
+			break;
+		}
+
+		if(Step%97 == 0 || Step == 100000-1)
+			ExpectEqual(Graph, Reference);
+		if(HasFatalFailure())
+			return;
+	}
+	ExpectEqual(Graph, Reference);
+}
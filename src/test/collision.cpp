@@ -0,0 +1,175 @@
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/map.h>
+#include <engine/shared/datafile.h>
+#include <engine/storage.h>
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+
+// the plain sampling IntersectLine used to do, the traversal has to match it
+static int IntersectLineReference(const CCollision *pCollision, vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision)
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance+1);
+	vec2 Last = Pos0;
+
+	for(int i = 0; i <= End; i++)
+	{
+		float a = i/float(End);
+		vec2 Pos = mix(Pos0, Pos1, a);
+		if(pCollision->CheckPoint(Pos.x, Pos.y))
+		{
+			*pOutCollision = Pos;
+			*pOutBeforeCollision = Last;
+			return pCollision->GetCollisionAt(Pos.x, Pos.y);
+		}
+		Last = Pos;
+	}
+	*pOutCollision = Pos1;
+	*pOutBeforeCollision = Pos1;
+	return 0;
+}
+
+static vec2 RandomPoint(CRandom *pRandom, const CCollision *pCollision)
+{
+	float Width = pCollision->GetWidth()*32.0f;
+	float Height = pCollision->GetHeight()*32.0f;
+	switch(pRandom->Int(3))
+	{
+	case 0: // on a tile border, where rounding matters
+		return vec2(pRandom->Int(pCollision->GetWidth()+2)*32.0f-32.5f + pRandom->Int(3)*0.5f,
+			pRandom->Int(pCollision->GetHeight()+2)*32.0f-32.5f + pRandom->Int(3)*0.5f);
+	case 1: // anywhere, including outside of the map
+		return vec2(pRandom->Float(-200.0f, Width+200.0f), pRandom->Float(-200.0f, Height+200.0f));
+	default:
+		return vec2(pRandom->Float(0.0f, Width), pRandom->Float(0.0f, Height));
+	}
+}
+
+static void CompareLines(const CCollision *pCollision, unsigned Seed, int Lines)
+{
+	CRandom Random(Seed);
+	for(int i = 0; i < Lines; i++)
+	{
+		vec2 Pos0 = RandomPoint(&Random, pCollision);
+		vec2 Pos1;
+		switch(Random.Int(4))
+		{
+		case 0: Pos1 = vec2(Pos0.x, Pos0.y + Random.Float(-800.0f, 800.0f)); break;
+		case 1: Pos1 = vec2(Pos0.x + Random.Float(-800.0f, 800.0f), Pos0.y); break;
+		case 2: Pos1 = Pos0 + vec2(Random.Float(-40.0f, 40.0f), Random.Float(-40.0f, 40.0f)); break;
+		default: Pos1 = RandomPoint(&Random, pCollision);
+		}
+
+		vec2 Collision, BeforeCollision, RefCollision, RefBeforeCollision;
+		int Hit = pCollision->IntersectLine(Pos0, Pos1, &Collision, &BeforeCollision);
+		int RefHit = IntersectLineReference(pCollision, Pos0, Pos1, &RefCollision, &RefBeforeCollision);
+
+		ASSERT_EQ(Hit, RefHit) << "line (" << Pos0.x << ", " << Pos0.y << ") -> (" << Pos1.x << ", " << Pos1.y << ")";
+		ASSERT_EQ(Collision.x, RefCollision.x);
+		ASSERT_EQ(Collision.y, RefCollision.y);
+		ASSERT_EQ(BeforeCollision.x, RefBeforeCollision.x);
+		ASSERT_EQ(BeforeCollision.y, RefBeforeCollision.y);
+	}
+}
+
+TEST(Collision, IntersectLineRandomTiles)
+{
+	CRandom Random(1337);
+	for(int Map = 0; Map < 8; Map++)
+	{
+		int Width = 2 + Random.Int(60);
+		int Height = 2 + Random.Int(60);
+		int Density = 1 + Random.Int(40);
+		CTile *pTiles = new CTile[Width*Height];
+		mem_zero(pTiles, sizeof(CTile)*Width*Height);
+		for(int i = 0; i < Width*Height; i++)
+		{
+			if(Random.Int(100) < Density)
+				pTiles[i].m_Index = TILE_SOLID + Random.Int(3);
+			else if(Random.Int(100) == 0)
+				pTiles[i].m_Index = 129 + Random.Int(127);
+		}
+
+		CCollision Collision;
+		Collision.Init(pTiles, Width, Height);
+		CompareLines(&Collision, Map, 20000);
+		delete[] pTiles;
+	}
+}
+
+static void WriteTestMap(IStorage *pStorage, const char *pFilename, int Width, int Height)
+{
+	CDataFileWriter Writer;
+	ASSERT_TRUE(Writer.Open(pStorage, pFilename));
+
+	CMapItemVersion Version;
+	Version.m_Version = CMapItemVersion::CURRENT_VERSION;
+	Writer.AddItem(MAPITEMTYPE_VERSION, 0, sizeof(Version), &Version);
+
+	// walls around, platforms and pillars of the different solid kinds inside
+	CRandom Random(Width*Height);
+	CTile *pTiles = new CTile[Width*Height];
+	mem_zero(pTiles, sizeof(CTile)*Width*Height);
+	for(int y = 0; y < Height; y++)
+		for(int x = 0; x < Width; x++)
+		{
+			if(x == 0 || y == 0 || x == Width-1 || y == Height-1)
+				pTiles[y*Width+x].m_Index = TILE_SOLID;
+			else if((y%7 == 0 && x%13 < 8) || (x%11 == 0 && y%5 < 3))
+				pTiles[y*Width+x].m_Index = TILE_SOLID + Random.Int(3);
+		}
+
+	CMapItemGroup Group;
+	mem_zero(&Group, sizeof(Group));
+	Group.m_Version = CMapItemGroup::CURRENT_VERSION;
+	Group.m_ParallaxX = 100;
+	Group.m_ParallaxY = 100;
+	Group.m_StartLayer = 0;
+	Group.m_NumLayers = 1;
+	Writer.AddItem(MAPITEMTYPE_GROUP, 0, sizeof(Group), &Group);
+
+	CMapItemLayerTilemap Layer;
+	mem_zero(&Layer, sizeof(Layer));
+	Layer.m_Layer.m_Type = LAYERTYPE_TILES;
+	Layer.m_Version = 3; // uncompressed tiles
+	Layer.m_Width = Width;
+	Layer.m_Height = Height;
+	Layer.m_Flags = TILESLAYERFLAG_GAME;
+	Layer.m_ColorEnv = -1;
+	Layer.m_Image = -1;
+	Layer.m_Data = Writer.AddData(sizeof(CTile)*Width*Height, pTiles);
+	Writer.AddItem(MAPITEMTYPE_LAYER, 0, sizeof(Layer), &Layer);
+	delete[] pTiles;
+
+	EXPECT_EQ(Writer.Finish(), 0);
+}
+
+TEST(Collision, IntersectLineMap)
+{
+	CTestInfo Info;
+	char aFilename[128];
+	str_format(aFilename, sizeof(aFilename), "%s.map", Info.m_aFilename);
+	IStorage *pStorage = CreateTestStorage();
+	WriteTestMap(pStorage, aFilename, 97, 53);
+
+	IEngineMap *pMap = CreateEngineMap();
+	ASSERT_TRUE(pMap->Load(aFilename, pStorage));
+	CLayers Layers;
+	Layers.Init(0, pMap);
+	ASSERT_TRUE(Layers.GameLayer());
+	CCollision Collision;
+	Collision.Init(&Layers);
+	EXPECT_EQ(Collision.GetWidth(), 97);
+	EXPECT_EQ(Collision.GetHeight(), 53);
+	CompareLines(&Collision, 42, 50000);
+
+	pMap->Unload();
+	delete pMap;
+	EXPECT_TRUE(pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE));
+	delete pStorage;
+}
@@ -0,0 +1,153 @@
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
+#include <engine/storage.h>
+
+enum
+{
+	NUM_TEST_DATA=12,
+};
+
+static int TestDataSize(int Index)
+{
+	return 4*(Index*Index*97+3);
+}
+
+static void FillTestData(int Index, int *pData)
+{
+	// compressible, but not trivially
+	for(int i = 0; i < TestDataSize(Index)/4; i++)
+		pData[i] = (i*Index)%31 + (i%7 == 0 ? i : 0);
+}
+
+static void WriteTestFile(IStorage *pStorage, const char *pFilename, int Compression, CJobPool *pPool = 0)
+{
+	CDataFileWriter Writer;
+	ASSERT_TRUE(Writer.Open(pStorage, pFilename, Compression, pPool));
+	int aItem[2] = {1, 2};
+	Writer.AddItem(1, 0, sizeof(aItem), aItem);
+	for(int i = 0; i < NUM_TEST_DATA; i++)
+	{
+		int *pData = (int *)mem_alloc(TestDataSize(i), 1);
+		FillTestData(i, pData);
+		EXPECT_EQ(Writer.AddData(TestDataSize(i), pData), i);
+		mem_free(pData);
+	}
+	EXPECT_EQ(Writer.Finish(), 0);
+}
+
+static void ExpectTestData(CDataFileReader *pReader, int Index)
+{
+	int *pExpected = (int *)mem_alloc(TestDataSize(Index), 1);
+	FillTestData(Index, pExpected);
+	EXPECT_EQ(pReader->GetUncompressedDataSize(Index), TestDataSize(Index));
+	const void *pData = pReader->GetData(Index);
+	ASSERT_TRUE(pData);
+	EXPECT_EQ(mem_comp(pData, pExpected, TestDataSize(Index)), 0) << "data " << Index;
+	mem_free(pExpected);
+}
+
+TEST(Datafile, LoadData)
+{
+	CTestInfo Info;
+	IStorage *pStorage = CreateTestStorage();
+	char aFilename[128];
+	str_format(aFilename, sizeof(aFilename), "%s.map", Info.m_aFilename);
+
+	CJobPool Pool;
+	Pool.Init(2);
+
+	int aCompressions[] = {CDataFileWriter::COMPRESSION_DEFAULT, CDataFileWriter::COMPRESSION_FAST, CDataFileWriter::COMPRESSION_NONE};
+	int aFileSizes[3];
+	for(int c = 0; c < 3; c++)
+	{
+		WriteTestFile(pStorage, aFilename, aCompressions[c]);
+
+		IOHANDLE File = pStorage->OpenFile(aFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(File);
+		aFileSizes[c] = io_length(File);
+		io_close(File);
+
+		// one by one
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage, aFilename, IStorage::TYPE_SAVE));
+		ASSERT_EQ(Reader.NumData(), (int)NUM_TEST_DATA);
+		ASSERT_EQ(Reader.NumItems(), 1);
+		EXPECT_EQ(Reader.GetItemSize(0), (int)(2*sizeof(int)));
+		for(int i = 0; i < NUM_TEST_DATA; i++)
+			ExpectTestData(&Reader, i);
+		Reader.Close();
+
+		// all at once, some of them already loaded, with duplicates and
+		// invalid indices, on the pool and without one
+		for(int p = 0; p < 2; p++)
+		{
+			ASSERT_TRUE(Reader.Open(pStorage, aFilename, IStorage::TYPE_SAVE));
+			ExpectTestData(&Reader, 3);
+			int aIndices[NUM_TEST_DATA+3];
+			for(int i = 0; i < NUM_TEST_DATA; i++)
+				aIndices[i] = NUM_TEST_DATA-1-i;
+			aIndices[NUM_TEST_DATA] = 5;
+			aIndices[NUM_TEST_DATA+1] = -1;
+			aIndices[NUM_TEST_DATA+2] = NUM_TEST_DATA;
+			Reader.LoadData(aIndices, NUM_TEST_DATA+3, p ? &Pool : 0);
+			for(int i = 0; i < NUM_TEST_DATA; i++)
+				ExpectTestData(&Reader, i);
+			Reader.Close();
+		}
+	}
+
+	// stored data is larger
+	EXPECT_LT(aFileSizes[0], aFileSizes[2]);
+	EXPECT_LE(aFileSizes[0], aFileSizes[1]);
+
+	pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+	delete pStorage;
+}
+
+TEST(Datafile, ParallelWriteIsDeterministic)
+{
+	CTestInfo Info;
+	IStorage *pStorage = CreateTestStorage();
+	char aFilename[128];
+	str_format(aFilename, sizeof(aFilename), "%s.map", Info.m_aFilename);
+
+	void *apFiles[3] = {0};
+	int aSizes[3];
+	for(int t = 0; t < 3; t++)
+	{
+		// no pool, one thread and a few of them
+		CJobPool Pool;
+		if(t > 0)
+			Pool.Init(t == 1 ? 1 : 4);
+		WriteTestFile(pStorage, aFilename, CDataFileWriter::COMPRESSION_DEFAULT, t > 0 ? &Pool : 0);
+
+		IOHANDLE File = pStorage->OpenFile(aFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+		ASSERT_TRUE(File);
+		aSizes[t] = io_length(File);
+		apFiles[t] = mem_alloc(aSizes[t], 1);
+		io_read(File, apFiles[t], aSizes[t]);
+		io_close(File);
+	}
+
+	for(int t = 1; t < 3; t++)
+	{
+		ASSERT_EQ(aSizes[t], aSizes[0]);
+		EXPECT_EQ(mem_comp(apFiles[t], apFiles[0], aSizes[0]), 0);
+	}
+
+	CDataFileReader Reader;
+	ASSERT_TRUE(Reader.Open(pStorage, aFilename, IStorage::TYPE_SAVE));
+	for(int i = 0; i < NUM_TEST_DATA; i++)
+		ExpectTestData(&Reader, i);
+	Reader.Close();
+
+	for(int t = 0; t < 3; t++)
+		mem_free(apFiles[t]);
+	pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+	delete pStorage;
+}
@@ -0,0 +1,202 @@
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+#include <base/hash.h>
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/network.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+
+#include <cstddef>
+#include <vector>
+
+static void RecordDemo(IStorage *pStorage, IConsole *pConsole, const char *pFilename, const char *pMap, SHA256_DIGEST MapSha256)
+{
+	CSnapshotDelta SnapshotDelta;
+	CDemoRecorder Recorder(&SnapshotDelta);
+	ASSERT_EQ(Recorder.Start(pStorage, pConsole, pFilename, "0.7", pMap, MapSha256, 0, "server"), 0);
+
+	CSnapshotBuilder Builder;
+	static char s_aData[CSnapshot::MAX_SIZE];
+	for(int Tick = 1; Tick <= SERVER_TICK_SPEED*12; Tick++)
+	{
+		// some items move, some come and go, some never change
+		Builder.Init();
+		for(int i = 0; i < 16; i++)
+		{
+			if(i%4 == 3 && (Tick/(i+10))%2)
+				continue;
+			int *pItem = (int *)Builder.NewItem(1+i%3, i, 8*sizeof(int));
+			for(int j = 0; j < 8; j++)
+				pItem[j] = i%2 ? i*j : Tick*(j+1)+i;
+		}
+		int Size = Builder.Finish(s_aData);
+		Recorder.RecordSnapshot(Tick, s_aData, Size);
+
+		if(Tick%7 == 0)
+		{
+			int aMsg[16];
+			for(int i = 0; i < 16; i++)
+				aMsg[i] = Tick+i;
+			Recorder.RecordMessage(aMsg, 1+Tick%(int)sizeof(aMsg));
+		}
+		if(Tick%(SERVER_TICK_SPEED*3) == 0)
+			Recorder.AddDemoMarker();
+		if(Tick%(SERVER_TICK_SPEED*5) == 0)
+		{
+			CDemoRound Round;
+			Round.m_StartTick = Tick-SERVER_TICK_SPEED*5;
+			Round.m_EndTick = Tick;
+			Round.m_Catches = Tick/SERVER_TICK_SPEED;
+			str_format(Round.m_aWinner, sizeof(Round.m_aWinner), "winner %d", Tick);
+			Recorder.AddRound(&Round);
+		}
+	}
+	EXPECT_EQ(Recorder.Length(), 11);
+	EXPECT_EQ(Recorder.Stop(), 0);
+}
+
+static std::vector<unsigned char> ReadDemo(IStorage *pStorage, const char *pFilename)
+{
+	std::vector<unsigned char> Data;
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_SAVE);
+	EXPECT_TRUE(File);
+	if(!File)
+		return Data;
+	Data.resize(io_length(File));
+	EXPECT_EQ(io_read(File, Data.data(), Data.size()), (unsigned)Data.size());
+	io_close(File);
+
+	// the timestamp may differ between the recordings
+	if(Data.size() >= sizeof(CDemoHeader))
+		mem_zero(&Data[offsetof(CDemoHeader, m_aTimestamp)], sizeof(((CDemoHeader *)0)->m_aTimestamp));
+	return Data;
+}
+
+static const char s_aMapData[] = "not really a map";
+
+// the recorder embeds the map and the player extracts it, any data does
+static void CreateMap(IStorage *pStorage, const char *pFolder, const char *pFilename)
+{
+	if(!fs_is_dir(pFolder))
+		pStorage->CreateFolder(pFolder, IStorage::TYPE_SAVE);
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, s_aMapData, sizeof(s_aMapData));
+	io_close(File);
+}
+
+TEST(Demo, WriterThreadOutputIdentical)
+{
+	CNetBase::Init();
+
+	CTestInfo Info;
+	IStorage *pStorage = CreateTestStorage();
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+
+	bool CreatedMapFolder = !fs_is_dir("maps");
+	char aMapFilename[128];
+	str_format(aMapFilename, sizeof(aMapFilename), "maps/%s.map", Info.m_aFilename);
+	CreateMap(pStorage, "maps", aMapFilename);
+	SHA256_DIGEST MapSha256 = sha256(s_aMapData, sizeof(s_aMapData));
+
+	char aDemoSync[128];
+	char aDemoThread[128];
+	str_format(aDemoSync, sizeof(aDemoSync), "%s.sync.demo", Info.m_aFilename);
+	str_format(aDemoThread, sizeof(aDemoThread), "%s.thread.demo", Info.m_aFilename);
+
+	int OldQueueSize = g_Config.m_DemoQueueSize;
+	g_Config.m_DemoQueueSize = 0;
+	RecordDemo(pStorage, pConsole, aDemoSync, Info.m_aFilename, MapSha256);
+	// a short queue makes the recorder wait for the writer
+	g_Config.m_DemoQueueSize = 2;
+	RecordDemo(pStorage, pConsole, aDemoThread, Info.m_aFilename, MapSha256);
+	g_Config.m_DemoQueueSize = OldQueueSize;
+
+	std::vector<unsigned char> Sync = ReadDemo(pStorage, aDemoSync);
+	std::vector<unsigned char> Thread = ReadDemo(pStorage, aDemoThread);
+	EXPECT_GT(Sync.size(), sizeof(CDemoHeader)+sizeof(s_aMapData));
+	EXPECT_TRUE(Sync == Thread);
+
+	pStorage->RemoveFile(aDemoSync, IStorage::TYPE_SAVE);
+	pStorage->RemoveFile(aDemoThread, IStorage::TYPE_SAVE);
+	pStorage->RemoveFile(aMapFilename, IStorage::TYPE_SAVE);
+	if(CreatedMapFolder)
+		fs_remove("maps");
+	delete pConsole;
+	delete pStorage;
+}
+
+TEST(Demo, Index)
+{
+	CNetBase::Init();
+
+	CTestInfo Info;
+	IStorage *pStorage = CreateTestStorage();
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+
+	bool CreatedMapFolder = !fs_is_dir("maps");
+	bool CreatedDownloadFolder = !fs_is_dir("downloadedmaps");
+	char aMapFilename[128];
+	char aDownloadedMapFilename[128];
+	str_format(aMapFilename, sizeof(aMapFilename), "maps/%s.map", Info.m_aFilename);
+	str_format(aDownloadedMapFilename, sizeof(aDownloadedMapFilename), "downloadedmaps/%s_%08x.map", Info.m_aFilename, 0);
+	CreateMap(pStorage, "maps", aMapFilename);
+	CreateMap(pStorage, "downloadedmaps", aDownloadedMapFilename);
+	SHA256_DIGEST MapSha256 = sha256(s_aMapData, sizeof(s_aMapData));
+
+	char aDemo[128];
+	char aDemoNoIndex[128];
+	str_format(aDemo, sizeof(aDemo), "%s.demo", Info.m_aFilename);
+	str_format(aDemoNoIndex, sizeof(aDemoNoIndex), "%s.noindex.demo", Info.m_aFilename);
+	RecordDemo(pStorage, pConsole, aDemo, Info.m_aFilename, MapSha256);
+
+	// without its last byte the locator is gone and the file has to be scanned
+	std::vector<unsigned char> Data = ReadDemo(pStorage, aDemo);
+	ASSERT_FALSE(Data.empty());
+	IOHANDLE File = pStorage->OpenFile(aDemoNoIndex, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, Data.data(), Data.size()-1);
+	io_close(File);
+
+	CSnapshotDelta SnapshotDelta;
+	CDemoPlayer Player(&SnapshotDelta);
+	Player.SetListner(0);
+	ASSERT_FALSE(Player.Load(pStorage, pConsole, aDemo, IStorage::TYPE_SAVE, "0.7"));
+	EXPECT_EQ(Player.Info()->m_Info.m_FirstTick, 1);
+	EXPECT_EQ(Player.Info()->m_Info.m_LastTick, SERVER_TICK_SPEED*12);
+	EXPECT_EQ(Player.Info()->m_SeekablePoints, 3);
+	ASSERT_EQ(Player.NumRounds(), 2);
+	EXPECT_EQ(Player.GetRound(0)->m_StartTick, 0);
+	EXPECT_EQ(Player.GetRound(0)->m_EndTick, SERVER_TICK_SPEED*5);
+	EXPECT_EQ(Player.GetRound(1)->m_Catches, 10);
+	EXPECT_STREQ(Player.GetRound(1)->m_aWinner, "winner 500");
+	EXPECT_EQ(Player.SetPos(0.5f), 0);
+	EXPECT_TRUE(Player.IsPlaying());
+	const CDemoPlayer::CPlaybackInfo IndexInfo = *Player.Info();
+	Player.Stop();
+
+	ASSERT_FALSE(Player.Load(pStorage, pConsole, aDemoNoIndex, IStorage::TYPE_SAVE, "0.7"));
+	EXPECT_EQ(Player.Info()->m_Info.m_FirstTick, IndexInfo.m_Info.m_FirstTick);
+	EXPECT_EQ(Player.Info()->m_Info.m_LastTick, IndexInfo.m_Info.m_LastTick);
+	EXPECT_EQ(Player.Info()->m_SeekablePoints, IndexInfo.m_SeekablePoints);
+	EXPECT_EQ(Player.NumRounds(), 0);
+	EXPECT_EQ(Player.SetPos(0.5f), 0);
+	EXPECT_EQ(Player.Info()->m_Info.m_CurrentTick, IndexInfo.m_Info.m_CurrentTick);
+	Player.Stop();
+
+	pStorage->RemoveFile(aDemo, IStorage::TYPE_SAVE);
+	pStorage->RemoveFile(aDemoNoIndex, IStorage::TYPE_SAVE);
+	pStorage->RemoveFile(aMapFilename, IStorage::TYPE_SAVE);
+	pStorage->RemoveFile(aDownloadedMapFilename, IStorage::TYPE_SAVE);
+	if(CreatedMapFolder)
+		fs_remove("maps");
+	if(CreatedDownloadFolder)
+		fs_remove("downloadedmaps");
+	delete pConsole;
+	delete pStorage;
+}
@@ -12,3 +12,34 @@ TEST(Filesystem, CreateCloseDelete)
 	EXPECT_FALSE(io_close(File));
 	EXPECT_FALSE(fs_remove(Info.m_aFilename));
 }
+
+TEST(Filesystem, Watch)
+{
+	void *pWatch = fs_watch_create();
+	if(!pWatch)
+		return;
+
+	CTestInfo Info;
+	char aDir[128];
+	char aFilename[128];
+	str_format(aDir, sizeof(aDir), "%s.dir", Info.m_aFilename);
+	str_format(aFilename, sizeof(aFilename), "%s/file", aDir);
+	ASSERT_FALSE(fs_makedir(aDir));
+
+	int ID = fs_watch_add(pWatch, aDir);
+	ASSERT_GE(ID, 0);
+	IOHANDLE File = io_open(aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	io_close(File);
+	int aIDs[4];
+	ASSERT_EQ(fs_watch_read(pWatch, aIDs, 4, 1000), 1);
+	EXPECT_EQ(aIDs[0], ID);
+
+	// nothing is reported after removing the watch
+	fs_watch_remove(pWatch, ID);
+	EXPECT_FALSE(fs_remove(aFilename));
+	EXPECT_EQ(fs_watch_read(pWatch, aIDs, 4, 10), 0);
+
+	EXPECT_FALSE(fs_remove(aDir));
+	fs_watch_destroy(pWatch);
+}
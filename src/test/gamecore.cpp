@@ -0,0 +1,117 @@
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/gamecore.h>
+
+// every character the plain loops of CCharacterCore::Tick would hit has to be found
+static void ExpectFound(CWorldCore *pWorld, vec2 Pos0, vec2 Pos1, float Radius)
+{
+	CWorldCore::CCharacterSet Found = pWorld->FindCharacters(Pos0, Pos1, Radius);
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		if(!pWorld->m_apCharacters[i])
+			continue;
+
+		vec2 Pos = pWorld->m_apCharacters[i]->m_Pos;
+		float Distance = Pos0 == Pos1 ? distance(Pos0, Pos) : distance(closest_point_on_line(Pos0, Pos1, Pos), Pos);
+		if(Distance < Radius)
+		{
+			EXPECT_TRUE(Found.test(i)) << "character " << i << " at " << Pos.x << "," << Pos.y << " distance " << Distance;
+		}
+	}
+}
+
+TEST(GameCore, FindCharacters)
+{
+	CRandom Random(1337);
+	CWorldCore World;
+	CCharacterCore aCores[MAX_CLIENTS];
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		aCores[i].Init(&World, 0);
+		aCores[i].Reset();
+		if(Random.Int(4))
+			World.m_apCharacters[i] = &aCores[i];
+	}
+
+	for(int Round = 0; Round < 20; Round++)
+	{
+		// crowd them into a small area so that most queries find someone
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			aCores[i].m_Pos = vec2(Random.Float(-300.0f, 600.0f), Random.Float(-300.0f, 600.0f));
+		World.InvalidateBroadPhase();
+
+		for(int i = 0; i < 200; i++)
+		{
+			vec2 Pos = aCores[Random.Int(MAX_CLIENTS)].m_Pos + vec2(Random.Float(-40.0f, 40.0f), Random.Float(-40.0f, 40.0f));
+			ExpectFound(&World, Pos, Pos, 28.0f*1.25f);
+
+			vec2 Dir = normalize(vec2(Random.Float(-1.0f, 1.0f), Random.Float(-1.0f, 1.0f)));
+			ExpectFound(&World, Pos, Pos + Dir*80.0f, 28.0f+2.0f);
+		}
+	}
+}
+
+TEST(GameCore, FindCharactersOutside)
+{
+	CWorldCore World;
+	CCharacterCore aCores[2];
+	for(int i = 0; i < 2; i++)
+	{
+		aCores[i].Init(&World, 0);
+		aCores[i].Reset();
+		World.m_apCharacters[i] = &aCores[i];
+	}
+	aCores[0].m_Pos = vec2(100.0f, 100.0f);
+	aCores[1].m_Pos = vec2(1e9f, 100.0f);
+
+	CWorldCore::CCharacterSet Found = World.FindCharacters(vec2(5000.0f, 5000.0f), vec2(5000.0f, 5000.0f), 35.0f);
+	EXPECT_FALSE(Found.test(0));
+	EXPECT_TRUE(Found.test(1));
+
+	// very long lines check everyone
+	Found = World.FindCharacters(vec2(0.0f, 0.0f), vec2(100000.0f, 0.0f), 30.0f);
+	EXPECT_TRUE(Found.test(0));
+	EXPECT_TRUE(Found.test(1));
+
+	// moved characters are found at their new position
+	aCores[0].m_Pos = vec2(5000.0f, 5000.0f);
+	World.InvalidateBroadPhase();
+	Found = World.FindCharacters(vec2(5000.0f, 5000.0f), vec2(5000.0f, 5000.0f), 35.0f);
+	EXPECT_TRUE(Found.test(0));
+}
+
+TEST(GameCore, FindCharactersMovedDirectly)
+{
+	CWorldCore World;
+	CCharacterCore aCores[2];
+	for(int i = 0; i < 2; i++)
+	{
+		aCores[i].Init(&World, 0);
+		aCores[i].Reset();
+	}
+	World.m_apCharacters[0] = &aCores[0];
+	aCores[0].m_Pos = vec2(100.0f, 100.0f);
+	aCores[1].m_Pos = vec2(3000.0f, 3000.0f);
+
+	CWorldCore::CCharacterSet Found = World.FindCharacters(vec2(3000.0f, 3000.0f), vec2(3000.0f, 3000.0f), 35.0f);
+	EXPECT_FALSE(Found.test(0));
+
+	// like ninja and spawning do, without Move
+	aCores[0].m_Pos = vec2(3000.0f, 3010.0f);
+	Found = World.FindCharacters(vec2(3000.0f, 3000.0f), vec2(3000.0f, 3000.0f), 35.0f);
+	EXPECT_TRUE(Found.test(0));
+	EXPECT_FALSE(Found.test(1));
+
+	World.m_apCharacters[1] = &aCores[1];
+	Found = World.FindCharacters(vec2(3000.0f, 3000.0f), vec2(3000.0f, 3000.0f), 35.0f);
+	EXPECT_TRUE(Found.test(1));
+
+	World.m_apCharacters[0] = 0;
+	aCores[1].m_Pos = vec2(100.0f, 100.0f);
+	Found = World.FindCharacters(vec2(3000.0f, 3000.0f), vec2(3000.0f, 3000.0f), 35.0f);
+	EXPECT_FALSE(Found.test(0));
+	EXPECT_FALSE(Found.test(1));
+}
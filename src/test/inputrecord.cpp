@@ -0,0 +1,108 @@
+#include "test.h"
+
+#include <gtest/gtest.h>
+
+#include <base/hash.h>
+#include <base/system.h>
+#include <engine/shared/config.h>
+#include <engine/shared/inputrecord.h>
+#include <engine/storage.h>
+
+TEST(InputRecord, RoundTrip)
+{
+	CTestInfo Info;
+	IStorage *pStorage = CreateTestStorage();
+	char aFilename[128];
+	str_format(aFilename, sizeof(aFilename), "%s.inputs", Info.m_aFilename);
+
+	int OldScorelimit = g_Config.m_SvScorelimit;
+	g_Config.m_SvScorelimit = 1234;
+	SHA256_DIGEST MapSha256 = sha256("map", 3);
+	static const char s_aMessage[] = "hello";
+
+	CInputRecorder *pRecorder = new CInputRecorder;
+	ASSERT_EQ(pRecorder->Start(pStorage, aFilename, "0.7", "ctf1", MapSha256, 0xdeadbeef), 0);
+	g_Config.m_SvScorelimit = OldScorelimit;
+	pRecorder->RecordConnect(3, true, 1797);
+	pRecorder->RecordEnter(3);
+	pRecorder->RecordMessage(3, s_aMessage, sizeof(s_aMessage));
+	int aInput[MAX_INPUT_SIZE] = {0};
+	for(int Tick = 0; Tick < 100; Tick++)
+	{
+		// only a few fields change every tick
+		aInput[0] = Tick/10-5;
+		aInput[4] = -Tick*1000;
+		pRecorder->RecordLatency(3, 40+Tick/50);
+		pRecorder->RecordInput(3, aInput);
+		pRecorder->RecordTick();
+		if(Tick%2)
+			pRecorder->RecordSnap();
+	}
+	pRecorder->RecordDirectInput(3, aInput);
+	pRecorder->RecordDrop(3, "bye");
+	ASSERT_EQ(pRecorder->Stop(0x12345678), 0);
+	delete pRecorder;
+
+	CInputPlayer Player;
+	ASSERT_EQ(Player.Load(pStorage, aFilename, IStorage::TYPE_SAVE), 0);
+	EXPECT_STREQ(Player.Header()->m_aNetVersion, "0.7");
+	EXPECT_STREQ(Player.Header()->m_aMap, "ctf1");
+	EXPECT_EQ(Player.Header()->m_MapCrc, 0xdeadbeef);
+	EXPECT_EQ(sha256_comp(Player.Header()->m_MapSha256, MapSha256), 0);
+	EXPECT_TRUE(str_find(Player.Header()->m_pConfig, "sv_scorelimit 1234\n"));
+
+	for(int Pass = 0; Pass < 2; Pass++)
+	{
+		CInputRecord::CRecord Record;
+		ASSERT_EQ(Player.NextRecord(&Record), 1);
+		EXPECT_EQ(Record.m_Type, CInputRecord::RECORD_CONNECT);
+		EXPECT_EQ(Record.m_ClientID, 3);
+		EXPECT_EQ(Record.m_Value, 1);
+		EXPECT_EQ(Record.m_Version, 1797);
+		ASSERT_EQ(Player.NextRecord(&Record), 1);
+		EXPECT_EQ(Record.m_Type, CInputRecord::RECORD_ENTER);
+		ASSERT_EQ(Player.NextRecord(&Record), 1);
+		EXPECT_EQ(Record.m_Type, CInputRecord::RECORD_MESSAGE);
+		ASSERT_EQ(Record.m_DataSize, (int)sizeof(s_aMessage));
+		EXPECT_EQ(mem_comp(Record.m_pData, s_aMessage, sizeof(s_aMessage)), 0);
+
+		int NumTicks = 0;
+		int NumSnaps = 0;
+		int NumLatencies = 0;
+		while(Player.NextRecord(&Record) == 1 && Record.m_Type != CInputRecord::RECORD_DIRECT_INPUT)
+		{
+			if(Record.m_Type == CInputRecord::RECORD_INPUT)
+			{
+				EXPECT_EQ(Record.m_pInput[0], NumTicks/10-5);
+				EXPECT_EQ(Record.m_pInput[4], -NumTicks*1000);
+				EXPECT_EQ(Record.m_pInput[1], 0);
+			}
+			else if(Record.m_Type == CInputRecord::RECORD_LATENCY)
+			{
+				EXPECT_EQ(Record.m_Value, 40+NumTicks/50);
+				NumLatencies++;
+			}
+			NumTicks += Record.m_Type == CInputRecord::RECORD_TICK;
+			NumSnaps += Record.m_Type == CInputRecord::RECORD_SNAP;
+		}
+		EXPECT_EQ(NumTicks, 100);
+		EXPECT_EQ(NumSnaps, 50);
+		// only changes are recorded
+		EXPECT_EQ(NumLatencies, 2);
+		EXPECT_EQ(Record.m_Type, CInputRecord::RECORD_DIRECT_INPUT);
+		EXPECT_EQ(Record.m_pInput[4], -99000);
+
+		ASSERT_EQ(Player.NextRecord(&Record), 1);
+		EXPECT_EQ(Record.m_Type, CInputRecord::RECORD_DROP);
+		EXPECT_STREQ((const char *)Record.m_pData, "bye");
+		ASSERT_EQ(Player.NextRecord(&Record), 1);
+		EXPECT_EQ(Record.m_Type, CInputRecord::RECORD_END);
+		EXPECT_EQ((unsigned)Record.m_Value, 0x12345678u);
+		EXPECT_EQ(Player.NextRecord(&Record), 0);
+		Player.Rewind();
+	}
+
+	Player.Unload();
+	pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE);
+	delete pStorage;
+}
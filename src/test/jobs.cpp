@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/jobs.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+static void WaitForJob(const CJob *pJob)
+{
+	while(pJob->Status() != CJob::STATE_DONE)
+		thread_yield();
+}
+
+static int ReturnInteger(void *pUser)
+{
+	return *(int *)pUser;
+}
+
+TEST(Jobs, Add)
+{
+	CJobPool Pool;
+	Pool.Init(2);
+	int aIntegers[16];
+	CJob aJobs[16];
+	for(int i = 0; i < 16; i++)
+	{
+		aIntegers[i] = i*3;
+		Pool.Add(&aJobs[i], ReturnInteger, &aIntegers[i]);
+	}
+	for(int i = 0; i < 16; i++)
+	{
+		WaitForJob(&aJobs[i]);
+		EXPECT_EQ(aJobs[i].Result(), i*3);
+		EXPECT_FALSE(aJobs[i].Cancelled());
+	}
+}
+
+struct CBlocker
+{
+	std::atomic<bool> m_Started;
+	std::atomic<bool> m_Release;
+};
+
+static int Block(void *pUser)
+{
+	CBlocker *pBlocker = (CBlocker *)pUser;
+	pBlocker->m_Started = true;
+	while(!pBlocker->m_Release)
+		thread_yield();
+	return 0;
+}
+
+struct COrder
+{
+	std::atomic<int> m_Next;
+	int m_aOrder[3];
+};
+
+static COrder gs_Order;
+
+static int RecordOrder(void *pUser)
+{
+	gs_Order.m_aOrder[gs_Order.m_Next++] = *(int *)pUser;
+	return 0;
+}
+
+TEST(Jobs, PriorityAndCancel)
+{
+	CJobPool Pool;
+	Pool.Init(1);
+
+	// keep the only worker busy while the other jobs get queued
+	CBlocker Blocker;
+	Blocker.m_Started = false;
+	Blocker.m_Release = false;
+	CJob BlockJob;
+	Pool.Add(&BlockJob, Block, &Blocker);
+	while(!Blocker.m_Started)
+		thread_yield();
+	EXPECT_FALSE(Pool.Cancel(&BlockJob));
+
+	gs_Order.m_Next = 0;
+	int aPriorities[] = {CJob::PRIORITY_LOW, CJob::PRIORITY_NORMAL, CJob::PRIORITY_HIGH};
+	CJob aJobs[3];
+	for(int i = 0; i < 3; i++)
+		Pool.Add(&aJobs[i], RecordOrder, &aPriorities[i], aPriorities[i]);
+
+	CJob Cancelled;
+	int Unused = 0;
+	Pool.Add(&Cancelled, RecordOrder, &Unused, CJob::PRIORITY_HIGH);
+	EXPECT_TRUE(Pool.Cancel(&Cancelled));
+	EXPECT_EQ(Cancelled.Status(), (int)CJob::STATE_DONE);
+	EXPECT_TRUE(Cancelled.Cancelled());
+	EXPECT_FALSE(Pool.Cancel(&Cancelled));
+
+	Blocker.m_Release = true;
+	for(int i = 0; i < 3; i++)
+		WaitForJob(&aJobs[i]);
+	ASSERT_EQ(gs_Order.m_Next, 3);
+	EXPECT_EQ(gs_Order.m_aOrder[0], (int)CJob::PRIORITY_HIGH);
+	EXPECT_EQ(gs_Order.m_aOrder[1], (int)CJob::PRIORITY_NORMAL);
+	EXPECT_EQ(gs_Order.m_aOrder[2], (int)CJob::PRIORITY_LOW);
+}
+
+TEST(Jobs, Submit)
+{
+	CJobPool Pool;
+	Pool.Init(4);
+
+	std::vector<CJobPool::CFuture<std::string> > aFutures;
+	for(int i = 0; i < 32; i++)
+		aFutures.push_back(Pool.Submit([i]() { return std::to_string(i*i); }));
+
+	std::atomic<int> Sum(0);
+	CJobPool::CFuture<void> Void = Pool.Submit([&Sum]() { Sum += 5; });
+
+	for(int i = 0; i < 32; i++)
+		EXPECT_EQ(aFutures[i].Get(), std::to_string(i*i));
+	Void.Get();
+	EXPECT_TRUE(Void.Done());
+	EXPECT_EQ(Sum, 5);
+}
+
+TEST(Jobs, NestedAndMainThread)
+{
+	CJobPool Pool;
+	Pool.Init(3);
+
+	// jobs adding jobs, handing the results back to the main thread
+	std::atomic<int> NumQueued(0);
+	int Sum = 0;
+	for(int i = 0; i < 8; i++)
+	{
+		Pool.Submit([&Pool, &NumQueued, &Sum, i]() {
+			for(int j = 0; j < 8; j++)
+			{
+				Pool.Submit([&Pool, &NumQueued, &Sum, i, j]() {
+					Pool.RunOnMainThread([&Sum, i, j]() { Sum += i*8+j; });
+					NumQueued++;
+				}, CJob::PRIORITY_HIGH);
+			}
+		}, CJob::PRIORITY_LOW);
+	}
+
+	while(NumQueued < 64)
+		thread_yield();
+	EXPECT_EQ(Pool.RunMainThreadJobs(), 64);
+	EXPECT_EQ(Sum, 64*63/2);
+	EXPECT_EQ(Pool.RunMainThreadJobs(), 0);
+}
+
+TEST(Jobs, ShutdownWithPending)
+{
+	CJobPool::CFuture<int> Future;
+	{
+		CJobPool Pool;
+		Future = Pool.Submit([]() { return 1; });
+	}
+	// never started, so it was cancelled
+	EXPECT_TRUE(Future.Done());
+	EXPECT_TRUE(Future.Cancelled());
+}
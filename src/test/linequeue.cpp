@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/linequeue.h>
+
+TEST(LineQueue, Empty)
+{
+	CLineQueue Queue;
+	Queue.Init(1024);
+	EXPECT_FALSE(Queue.Front());
+	Queue.Pop();
+	EXPECT_FALSE(Queue.Front());
+}
+
+TEST(LineQueue, Order)
+{
+	CLineQueue Queue;
+	Queue.Init(1024);
+	EXPECT_TRUE(Queue.PushString(1, 2, 3, "first"));
+	EXPECT_TRUE(Queue.Push(4, 5, 6, 0, 0));
+	EXPECT_TRUE(Queue.PushString(7, -1, 0, "third"));
+
+	const CLineQueue::CItem *pItem = Queue.Front();
+	ASSERT_TRUE(pItem);
+	EXPECT_EQ(pItem->m_Type, 1);
+	EXPECT_EQ(pItem->m_ClientID, 2);
+	EXPECT_EQ(pItem->m_Generation, 3);
+	EXPECT_STREQ((const char *)pItem->Data(), "first");
+	Queue.Pop();
+
+	pItem = Queue.Front();
+	ASSERT_TRUE(pItem);
+	EXPECT_EQ(pItem->m_Type, 4);
+	EXPECT_EQ(pItem->m_DataSize, 0);
+	Queue.Pop();
+
+	pItem = Queue.Front();
+	ASSERT_TRUE(pItem);
+	EXPECT_EQ(pItem->m_ClientID, -1);
+	EXPECT_STREQ((const char *)pItem->Data(), "third");
+	Queue.Pop();
+	EXPECT_FALSE(Queue.Front());
+}
+
+TEST(LineQueue, Full)
+{
+	CLineQueue Queue;
+	Queue.Init(256);
+	char aLine[100];
+	mem_zero(aLine, sizeof(aLine));
+
+	int Pushed = 0;
+	while(Queue.Push(0, Pushed, 0, aLine, sizeof(aLine)))
+		Pushed++;
+	EXPECT_EQ(Pushed, 2);
+	EXPECT_FALSE(Queue.HasSpace(sizeof(aLine)));
+	EXPECT_FALSE(Queue.Push(0, 0, 0, aLine, 1000));
+
+	// freeing one item makes room again, after wrapping around
+	Queue.Pop();
+	EXPECT_TRUE(Queue.Push(0, Pushed, 0, aLine, sizeof(aLine)));
+	for(int i = 1; i <= Pushed; i++)
+	{
+		ASSERT_TRUE(Queue.Front());
+		EXPECT_EQ(Queue.Front()->m_ClientID, i);
+		Queue.Pop();
+	}
+	EXPECT_FALSE(Queue.Front());
+}
+
+static const int s_NumLines = 200000;
+
+static void Produce(void *pUser)
+{
+	CLineQueue *pQueue = (CLineQueue *)pUser;
+	char aLine[256];
+	for(int i = 0; i < s_NumLines; i++)
+	{
+		// varying lengths so that the records wrap at different offsets
+		int Length = i%200;
+		for(int c = 0; c < Length; c++)
+			aLine[c] = 'a'+(i+c)%26;
+		aLine[Length] = 0;
+		while(!pQueue->PushString(0, i, 0, aLine))
+			thread_yield();
+	}
+}
+
+TEST(LineQueue, Threaded)
+{
+	CLineQueue Queue;
+	Queue.Init(4096);
+	void *pThread = thread_init(Produce, &Queue);
+
+	for(int i = 0; i < s_NumLines; i++)
+	{
+		const CLineQueue::CItem *pItem;
+		while(!(pItem = Queue.Front()))
+			thread_yield();
+
+		ASSERT_EQ(pItem->m_ClientID, i);
+		const char *pLine = (const char *)pItem->Data();
+		int Length = i%200;
+		ASSERT_EQ(str_length(pLine), Length);
+		for(int c = 0; c < Length; c++)
+			ASSERT_EQ(pLine[c], 'a'+(i+c)%26);
+		Queue.Pop();
+	}
+	thread_wait(pThread);
+	EXPECT_FALSE(Queue.Front());
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/shared/nettrie.h>
+
+#include <random>
+#include <vector>
+
+struct CRange
+{
+	NETADDR m_LB;
+	NETADDR m_UB;
+	bool m_Active;
+};
+
+static NETADDR MakeAddr(int Type, unsigned char Seed, std::mt19937 &Rng)
+{
+	NETADDR Addr;
+	mem_zero(&Addr, sizeof(Addr));
+	Addr.type = Type;
+	int Bytes = Type == NETTYPE_IPV4 ? 4 : 16;
+	// only vary the last two bytes, so that the ranges overlap a lot
+	for(int i = 0; i < Bytes-2; i++)
+		Addr.ip[i] = Seed;
+	Addr.ip[Bytes-2] = Rng()%4;
+	Addr.ip[Bytes-1] = Rng()%256;
+	return Addr;
+}
+
+static int Comp(const NETADDR *pAddr1, const NETADDR *pAddr2)
+{
+	return mem_comp(pAddr1->ip, pAddr2->ip, pAddr1->type == NETTYPE_IPV4 ? 4 : 16);
+}
+
+static bool Contains(const CRange *pRange, const NETADDR *pAddr)
+{
+	return pRange->m_LB.type == pAddr->type && Comp(&pRange->m_LB, pAddr) <= 0 && Comp(pAddr, &pRange->m_UB) <= 0;
+}
+
+static void CheckLookups(const CNetTrie<CRange> &Trie, const std::vector<CRange> &Ranges, int Type, std::mt19937 &Rng)
+{
+	for(int i = 0; i < 2000; i++)
+	{
+		NETADDR Addr = MakeAddr(Type, 7, Rng);
+		bool Covered = false;
+		for(const CRange &Range : Ranges)
+			Covered |= Range.m_Active && Contains(&Range, &Addr);
+
+		const CRange *pFound = Trie.Lookup(&Addr);
+		ASSERT_EQ(pFound != 0, Covered);
+		if(pFound)
+		{
+			EXPECT_TRUE(pFound->m_Active);
+			EXPECT_TRUE(Contains(pFound, &Addr));
+		}
+	}
+}
+
+static void TestRandomRanges(int Type)
+{
+	std::mt19937 Rng(Type);
+	std::vector<CRange> Ranges(200);
+	CNetTrie<CRange> Trie;
+
+	for(CRange &Range : Ranges)
+	{
+		Range.m_LB = MakeAddr(Type, 7, Rng);
+		Range.m_UB = MakeAddr(Type, 7, Rng);
+		if(Comp(&Range.m_UB, &Range.m_LB) < 0)
+			std::swap(Range.m_LB, Range.m_UB);
+		// some single addresses
+		if(Rng()%4 == 0)
+			Range.m_UB = Range.m_LB;
+		Range.m_Active = true;
+		Trie.InsertRange(&Range.m_LB, &Range.m_UB, &Range);
+	}
+	CheckLookups(Trie, Ranges, Type, Rng);
+
+	for(CRange &Range : Ranges)
+	{
+		EXPECT_EQ(Trie.FindRange(&Range.m_LB, &Range.m_UB, [&Range](const CRange *pRange) { return pRange == &Range; }), &Range);
+		if(Rng()%2)
+		{
+			Trie.RemoveRange(&Range.m_LB, &Range.m_UB, &Range);
+			Range.m_Active = false;
+			EXPECT_FALSE(Trie.FindRange(&Range.m_LB, &Range.m_UB, [&Range](const CRange *pRange) { return pRange == &Range; }));
+		}
+	}
+	CheckLookups(Trie, Ranges, Type, Rng);
+
+	for(CRange &Range : Ranges)
+	{
+		if(Range.m_Active)
+			Trie.RemoveRange(&Range.m_LB, &Range.m_UB, &Range);
+		Range.m_Active = false;
+	}
+	CheckLookups(Trie, Ranges, Type, Rng);
+}
+
+TEST(NetTrie, RandomRangesIPv4)
+{
+	TestRandomRanges(NETTYPE_IPV4);
+}
+
+TEST(NetTrie, RandomRangesIPv6)
+{
+	TestRandomRanges(NETTYPE_IPV6);
+}
+
+TEST(NetTrie, MostSpecific)
+{
+	CRange Wide, Narrow;
+	ASSERT_EQ(net_addr_from_str(&Wide.m_LB, "10.0.0.0"), 0);
+	ASSERT_EQ(net_addr_from_str(&Wide.m_UB, "10.255.255.255"), 0);
+	ASSERT_EQ(net_addr_from_str(&Narrow.m_LB, "10.1.2.0"), 0);
+	ASSERT_EQ(net_addr_from_str(&Narrow.m_UB, "10.1.2.127"), 0);
+
+	CNetTrie<CRange> Trie;
+	Trie.InsertRange(&Wide.m_LB, &Wide.m_UB, &Wide);
+	Trie.InsertRange(&Narrow.m_LB, &Narrow.m_UB, &Narrow);
+
+	NETADDR Addr;
+	ASSERT_EQ(net_addr_from_str(&Addr, "10.1.2.3"), 0);
+	EXPECT_EQ(Trie.Lookup(&Addr), &Narrow);
+	ASSERT_EQ(net_addr_from_str(&Addr, "10.1.2.200"), 0);
+	EXPECT_EQ(Trie.Lookup(&Addr), &Wide);
+	ASSERT_EQ(net_addr_from_str(&Addr, "11.0.0.0"), 0);
+	EXPECT_FALSE(Trie.Lookup(&Addr));
+
+	// IPv4 entries don't match IPv6 addresses
+	ASSERT_EQ(net_addr_from_str(&Addr, "[::a01:203]"), 0);
+	EXPECT_FALSE(Trie.Lookup(&Addr));
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <engine/contacts.h>
+#include <engine/serverbrowser.h>
+#include <engine/shared/config.h>
+#include <engine/client/serverbrowser_entry.h>
+#include <engine/client/serverbrowser_filter.h>
+
+#include <random>
+#include <vector>
+
+// players whose name starts with an f are friends
+class CTestFriends : public IFriends
+{
+public:
+	void Init() {}
+	int NumFriends() const { return 0; }
+	const CContactInfo *GetFriend(int Index) const { return 0; }
+	int GetFriendState(const char *pName, const char *pClan) const { return pName[0] == 'f' ? CContactInfo::CONTACT_PLAYER : CContactInfo::CONTACT_NO; }
+	bool IsFriend(const char *pName, const char *pClan, bool PlayersOnly) const { return pName[0] == 'f'; }
+	void AddFriend(const char *pName, const char *pClan) {}
+	void RemoveFriend(const char *pName, const char *pClan) {}
+};
+
+// few distinct values, so there are many ties in every sort mode
+static void RandomServer(std::mt19937 *pRandom, CServerEntry *pEntry)
+{
+	std::mt19937 &Random = *pRandom;
+	mem_zero(pEntry, sizeof(*pEntry));
+	pEntry->m_InfoState = Random()%3;
+	str_format(pEntry->m_Info.m_aName, sizeof(pEntry->m_Info.m_aName), "server %d", (int)(Random()%50));
+	str_format(pEntry->m_Info.m_aMap, sizeof(pEntry->m_Info.m_aMap), "map%d", (int)(Random()%10));
+	str_format(pEntry->m_Info.m_aGameType, sizeof(pEntry->m_Info.m_aGameType), "gametype%d", (int)(Random()%5));
+	pEntry->m_Info.m_Latency = Random()%300;
+	pEntry->m_Info.m_MaxClients = 16;
+	pEntry->m_Info.m_MaxPlayers = 16;
+	pEntry->m_Info.m_NumClients = Random()%17;
+	pEntry->m_Info.m_NumPlayers = Random()%(pEntry->m_Info.m_NumClients+1);
+	pEntry->m_Info.m_NumBotPlayers = Random()%(pEntry->m_Info.m_NumPlayers+1);
+	pEntry->m_Info.m_Flags = Random()%8;
+	pEntry->m_Info.m_Favorite = Random()%2;
+	for(int i = 0; i < pEntry->m_Info.m_NumClients; i++)
+		str_copy(pEntry->m_Info.m_aClients[i].m_aName, Random()%10 ? "player" : "friend", sizeof(pEntry->m_Info.m_aClients[i].m_aName));
+}
+
+TEST(ServerBrowserFilter, UpdateMatchesSort)
+{
+	std::mt19937 Random(1234);
+	CTestFriends Friends;
+	const int OldBrSort = g_Config.m_BrSort;
+	const int OldBrSortOrder = g_Config.m_BrSortOrder;
+
+	for(int Mode = 0; Mode < 2*(IServerBrowser::SORT_NUMPLAYERS+1); Mode++)
+	{
+		g_Config.m_BrSort = Mode/2;
+		g_Config.m_BrSortOrder = Mode%2;
+
+		for(int Round = 0; Round < 10; Round++)
+		{
+			CServerFilterInfo Info;
+			mem_zero(&Info, sizeof(Info));
+			Info.m_SortHash = Random()&(IServerBrowser::FILTER_EMPTY|IServerBrowser::FILTER_FAVORITE|IServerBrowser::FILTER_BOTS|IServerBrowser::FILTER_SPECTATORS|IServerBrowser::FILTER_FRIENDS);
+			Info.m_Ping = 200;
+
+			// one browser updates the changed servers, the other sorts everything
+			CServerBrowserFilter Updated, Sorted;
+			Updated.Init(&Friends, "0.7");
+			Sorted.Init(&Friends, "0.7");
+			int UpdatedIndex = Updated.AddFilter(&Info);
+			int SortedIndex = Sorted.AddFilter(&Info);
+
+			int NumServers = 50 + Random()%200;
+			std::vector<CServerEntry> aServers(NumServers+100);
+			std::vector<CServerEntry *> apServers;
+			for(int i = 0; i < NumServers; i++)
+			{
+				RandomServer(&Random, &aServers[i]);
+				apServers.push_back(&aServers[i]);
+			}
+			Updated.Sort(apServers.data(), apServers.size(), CServerBrowserFilter::RESORT_FLAG_FORCE);
+
+			for(int Step = 0; Step < 20; Step++)
+			{
+				// few enough changes to not sort everything
+				int NumChanges = Random()%8;
+				for(int c = 0; c < NumChanges; c++)
+				{
+					int Index;
+					if(Random()%4 == 0 && apServers.size() < aServers.size())
+					{
+						Index = apServers.size();
+						apServers.push_back(&aServers[Index]);
+					}
+					else
+						Index = Random()%apServers.size();
+					RandomServer(&Random, apServers[Index]);
+					Updated.Changed(Index);
+				}
+				Updated.Sort(apServers.data(), apServers.size(), 0);
+				Sorted.Sort(apServers.data(), apServers.size(), CServerBrowserFilter::RESORT_FLAG_FORCE);
+
+				ASSERT_EQ(Updated.GetNumSortedServers(UpdatedIndex), Sorted.GetNumSortedServers(SortedIndex)) << "mode " << Mode << " round " << Round << " step " << Step;
+				ASSERT_EQ(Updated.GetNumSortedPlayers(UpdatedIndex), Sorted.GetNumSortedPlayers(SortedIndex)) << "mode " << Mode << " round " << Round << " step " << Step;
+				for(int i = 0; i < Sorted.GetNumSortedServers(SortedIndex); i++)
+					ASSERT_EQ(Updated.GetIndex(UpdatedIndex, i), Sorted.GetIndex(SortedIndex, i)) << "mode " << Mode << " round " << Round << " step " << Step << " position " << i;
+			}
+		}
+	}
+
+	g_Config.m_BrSort = OldBrSort;
+	g_Config.m_BrSortOrder = OldBrSortOrder;
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <base/system.h>
+#include <game/collision.h>
+#include <game/mapitems.h>
+#include <game/server/spawneval.h>
+
+#include <random>
+#include <vector>
+
+struct CTestCharacter
+{
+	vec2 m_Pos;
+	float m_Radius;
+	int m_Team;
+};
+
+// the scoring the game controller used to do, one world scan per spawn point
+class CReferenceSpawns
+{
+public:
+	const CCollision *m_pCollision;
+	std::vector<vec2> m_aSpawnPoints[CSpawnEvaluator::NUM_SPAWNTYPES];
+	std::vector<CTestCharacter> m_aChars;
+
+	int FindEntities(vec2 Pos, float Radius, const CTestCharacter **ppChars) const
+	{
+		int Num = 0;
+		for(unsigned i = 0; i < m_aChars.size() && Num < MAX_CLIENTS; i++)
+			if(distance(m_aChars[i].m_Pos, Pos) < Radius+m_aChars[i].m_Radius)
+				ppChars[Num++] = &m_aChars[i];
+		return Num;
+	}
+
+	float EvaluateSpawnPos(CSpawnEval *pEval, vec2 Pos) const
+	{
+		float Score = 0.0f;
+		for(unsigned i = 0; i < m_aChars.size(); i++)
+		{
+			float Scoremod = 1.0f;
+			if(pEval->m_FriendlyTeam != -1 && m_aChars[i].m_Team == pEval->m_FriendlyTeam)
+				Scoremod = 0.5f;
+
+			float d = distance(Pos, m_aChars[i].m_Pos);
+			Score += Scoremod * (d == 0 ? 1000000000.0f : 1.0f/d);
+		}
+		return Score;
+	}
+
+	void EvaluateSpawnType(CSpawnEval *pEval, int Type) const
+	{
+		for(unsigned i = 0; i < m_aSpawnPoints[Type].size(); i++)
+		{
+			const CTestCharacter *apChars[MAX_CLIENTS];
+			int Num = FindEntities(m_aSpawnPoints[Type][i], 64, apChars);
+			vec2 Positions[5] = { vec2(0.0f, 0.0f), vec2(-32.0f, 0.0f), vec2(0.0f, -32.0f), vec2(32.0f, 0.0f), vec2(0.0f, 32.0f) };
+			int Result = -1;
+			for(int Index = 0; Index < 5 && Result == -1; ++Index)
+			{
+				Result = Index;
+				for(int c = 0; c < Num; ++c)
+					if(m_pCollision->CheckPoint(m_aSpawnPoints[Type][i]+Positions[Index]) ||
+						distance(apChars[c]->m_Pos, m_aSpawnPoints[Type][i]+Positions[Index]) <= apChars[c]->m_Radius)
+					{
+						Result = -1;
+						break;
+					}
+			}
+			if(Result == -1)
+				continue;
+
+			vec2 P = m_aSpawnPoints[Type][i]+Positions[Result];
+			float S = EvaluateSpawnPos(pEval, P);
+			if(!pEval->m_Got || pEval->m_Score > S)
+			{
+				pEval->m_Got = true;
+				pEval->m_Score = S;
+				pEval->m_Pos = P;
+			}
+		}
+	}
+};
+
+// the order CanSpawn evaluates the spawn types in
+template<class T>
+static void EvaluateAll(const T *pSpawns, CSpawnEval *pEval, int Team, bool Teamplay)
+{
+	if(Teamplay)
+	{
+		pEval->m_FriendlyTeam = Team;
+		pSpawns->EvaluateType(pEval, 1+(Team&1));
+		if(!pEval->m_Got)
+		{
+			pSpawns->EvaluateType(pEval, 0);
+			if(!pEval->m_Got)
+				pSpawns->EvaluateType(pEval, 1+((Team+1)&1));
+		}
+	}
+	else
+	{
+		pSpawns->EvaluateType(pEval, 0);
+		pSpawns->EvaluateType(pEval, 1);
+		pSpawns->EvaluateType(pEval, 2);
+	}
+}
+
+class CReferenceAdapter
+{
+public:
+	const CReferenceSpawns *m_pReference;
+	void EvaluateType(CSpawnEval *pEval, int Type) const { m_pReference->EvaluateSpawnType(pEval, Type); }
+};
+
+TEST(SpawnEval, MatchesReference)
+{
+	std::mt19937 Random(1234);
+	const int Width = 40, Height = 30;
+
+	for(int World = 0; World < 200; World++)
+	{
+		CTile aTiles[Width*Height];
+		mem_zero(aTiles, sizeof(aTiles));
+		int Density = Random()%30;
+		for(int i = 0; i < Width*Height; i++)
+			if((int)(Random()%100) < Density)
+				aTiles[i].m_Index = TILE_SOLID;
+		CCollision Collision;
+		Collision.Init(aTiles, Width, Height);
+
+		CReferenceSpawns Reference;
+		Reference.m_pCollision = &Collision;
+		CSpawnEvaluator Evaluator;
+		for(int Type = 0; Type < CSpawnEvaluator::NUM_SPAWNTYPES; Type++)
+		{
+			int Num = Random()%12;
+			for(int i = 0; i < Num; i++)
+			{
+				vec2 Pos((Random()%Width)*32.0f+16.0f, (Random()%Height)*32.0f+16.0f);
+				Reference.m_aSpawnPoints[Type].push_back(Pos);
+				Evaluator.AddSpawnPoint(Type, Pos, &Collision);
+			}
+		}
+
+		// many characters close to the spawn points, some right on them or their offsets
+		int NumChars = Random()%(MAX_CLIENTS+1);
+		for(int i = 0; i < NumChars; i++)
+		{
+			CTestCharacter Char;
+			Char.m_Radius = 28.0f;
+			Char.m_Team = Random()%2;
+			int Type = Random()%CSpawnEvaluator::NUM_SPAWNTYPES;
+			if(Reference.m_aSpawnPoints[Type].empty() || Random()%4 == 0)
+				Char.m_Pos = vec2((Random()%(Width*32)), (Random()%(Height*32)));
+			else
+			{
+				vec2 Spawn = Reference.m_aSpawnPoints[Type][Random()%Reference.m_aSpawnPoints[Type].size()];
+				int Where = Random()%4;
+				if(Where == 0)
+					Char.m_Pos = Spawn + CSpawnEvaluator::ms_aOffsets[Random()%CSpawnEvaluator::NUM_OFFSETS];
+				else if(Where == 1) // exactly touching an offset
+					Char.m_Pos = Spawn + CSpawnEvaluator::ms_aOffsets[Random()%CSpawnEvaluator::NUM_OFFSETS] + vec2(Char.m_Radius, 0.0f);
+				else
+					Char.m_Pos = Spawn + vec2((int)(Random()%193)-96, (int)(Random()%193)-96);
+			}
+			Reference.m_aChars.push_back(Char);
+		}
+
+		for(int Mode = 0; Mode < 3; Mode++)
+		{
+			bool Teamplay = Mode > 0;
+			int Team = Mode-1;
+
+			CSpawnEval RefEval;
+			CReferenceAdapter Adapter = { &Reference };
+			EvaluateAll(&Adapter, &RefEval, Team, Teamplay);
+
+			CSpawnEval Eval;
+			for(unsigned i = 0; i < Reference.m_aChars.size(); i++)
+				Eval.AddCharacter(Reference.m_aChars[i].m_Pos, Reference.m_aChars[i].m_Radius, Reference.m_aChars[i].m_Team);
+			EvaluateAll(&Evaluator, &Eval, Team, Teamplay);
+
+			ASSERT_EQ(Eval.m_Got, RefEval.m_Got) << "world " << World << " mode " << Mode;
+			ASSERT_EQ(Eval.m_Pos.x, RefEval.m_Pos.x) << "world " << World << " mode " << Mode;
+			ASSERT_EQ(Eval.m_Pos.y, RefEval.m_Pos.y) << "world " << World << " mode " << Mode;
+			if(Eval.m_Got)
+			{
+				ASSERT_EQ(Eval.m_Score, RefEval.m_Score) << "world " << World << " mode " << Mode;
+			}
+		}
+	}
+}
@@ -39,3 +39,65 @@ TEST(Storage, FindFile)
 	EXPECT_FALSE(pStorage->FindFile(Info.m_aFilename, ".", IStorage::TYPE_ALL, aFound, sizeof(aFound), &WrongSha256, 0x3bb935c6, 5));
 	EXPECT_FALSE(pStorage->FindFile(Info.m_aFilename, ".", IStorage::TYPE_ALL, aFound, sizeof(aFound), &SHA256_ZEROED, 0x3bb935c6, 5));
 }
+
+static int CountFileCallback(const char *pName, int IsDir, int Type, void *pUser)
+{
+	if(!IsDir && str_comp(pName, "file") == 0)
+		(*(int *)pUser)++;
+	return 0;
+}
+
+static bool CanOpen(IStorage *pStorage, const char *pFilename)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, IStorage::TYPE_ALL);
+	if(File)
+		io_close(File);
+	return File != 0;
+}
+
+TEST(Storage, Cache)
+{
+	CTestInfo Info;
+	char aDir[128];
+	char aFilename[128];
+	str_format(aDir, sizeof(aDir), "%s.dir", Info.m_aFilename);
+	str_format(aFilename, sizeof(aFilename), "%s/file", aDir);
+
+	IStorage *pStorage = CreateTestStorage();
+	EXPECT_FALSE(CanOpen(pStorage, aFilename));
+
+	// changes made through the storage are seen right away
+	ASSERT_TRUE(pStorage->CreateFolder(aDir, IStorage::TYPE_SAVE));
+	IOHANDLE File = pStorage->OpenFile(aFilename, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_close(File);
+	EXPECT_TRUE(CanOpen(pStorage, aFilename));
+	int Count = 0;
+	pStorage->ListDirectory(IStorage::TYPE_ALL, aDir, CountFileCallback, &Count);
+	EXPECT_EQ(Count, 1);
+
+	// others need an invalidation
+	char aPath[128];
+	pStorage->GetCompletePath(IStorage::TYPE_SAVE, aFilename, aPath, sizeof(aPath));
+	ASSERT_FALSE(fs_remove(aPath));
+	pStorage->InvalidateCache();
+	EXPECT_FALSE(CanOpen(pStorage, aFilename));
+
+	// or are noticed after a moment
+	File = io_open(aPath, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	io_close(File);
+	bool Found = false;
+	for(int i = 0; i < 500 && !Found; i++)
+	{
+		Found = CanOpen(pStorage, aFilename);
+		if(!Found)
+			thread_sleep(10);
+	}
+	EXPECT_TRUE(Found);
+
+	EXPECT_TRUE(pStorage->RemoveFile(aFilename, IStorage::TYPE_SAVE));
+	EXPECT_TRUE(pStorage->RemoveFile(aDir, IStorage::TYPE_SAVE));
+	EXPECT_FALSE(CanOpen(pStorage, aFilename));
+	delete pStorage;
+}
@@ -6,4 +6,15 @@ public:
 	CTestInfo();
 	char m_aFilename[64];
 };
+
+// small generator that gives the same numbers everywhere, unlike rand()
+class CRandom
+{
+	unsigned m_State;
+public:
+	CRandom(unsigned Seed) : m_State(Seed) {}
+	unsigned Next() { m_State = m_State*1103515245u + 12345u; return m_State>>8; }
+	int Int(int Max) { return Next()%Max; }
+	float Float(float Min, float Max) { return Min + (Max-Min)*(Next()&0xffff)/float(0xffff); }
+};
 #endif // TEST_TEST_H
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <engine/shared/textlayout.h>
+#include <engine/textrender.h>
+
+// every glyph is half as wide as the font is high
+class CMonospaceMetrics : public ITextGlyphMetrics
+{
+public:
+	int m_NumAdvances;
+
+	CMonospaceMetrics() : m_NumAdvances(0) {}
+
+	bool Advance(int Chr, float *pAdvance)
+	{
+		m_NumAdvances++;
+		*pAdvance = 0.5f;
+		return Chr != '\t';
+	}
+	float Kerning(int Left, int Right) { return 0.0f; }
+};
+
+static CTextLayoutSettings Settings(float LineWidth, int Flags = 0)
+{
+	CTextLayoutSettings Settings;
+	Settings.m_pFont = 0;
+	Settings.m_FontSize = 10;
+	Settings.m_Size = 10.0f;
+	Settings.m_ScaleX = 1.0f;
+	Settings.m_ScaleY = 1.0f;
+	Settings.m_StartX = 0.0f;
+	Settings.m_LineWidth = LineWidth;
+	Settings.m_MaxLines = 0;
+	Settings.m_LineCount = 1;
+	Settings.m_Flags = Flags;
+	return Settings;
+}
+
+static CTextLayout Layout(const CTextLayoutSettings &Settings, const char *pText)
+{
+	CMonospaceMetrics Metrics;
+	CTextLayout Layout;
+	Layout.Layout(&Metrics, &Settings, pText, str_length(pText));
+	return Layout;
+}
+
+TEST(TextLayout, SingleLine)
+{
+	CTextLayout Layout = ::Layout(Settings(-1), "abc");
+	ASSERT_EQ(Layout.m_aGlyphs.size(), 3u);
+	EXPECT_EQ(Layout.m_aGlyphs[1].m_Chr, 'b');
+	EXPECT_FLOAT_EQ(Layout.m_aGlyphs[1].m_X, 5.0f);
+	EXPECT_FLOAT_EQ(Layout.m_aGlyphs[2].m_X, 10.0f);
+	EXPECT_FLOAT_EQ(Layout.m_EndX, 15.0f);
+	EXPECT_EQ(Layout.m_LineCount, 1);
+	EXPECT_EQ(Layout.m_GlyphCount, 3);
+	EXPECT_EQ(Layout.m_CharCount, 3);
+	EXPECT_FALSE(Layout.m_GotNewLine);
+}
+
+TEST(TextLayout, SkipsMissingGlyphs)
+{
+	CTextLayout Layout = ::Layout(Settings(-1), "a\tb");
+	ASSERT_EQ(Layout.m_aGlyphs.size(), 2u);
+	EXPECT_FLOAT_EQ(Layout.m_aGlyphs[1].m_X, 5.0f);
+	EXPECT_EQ(Layout.m_CharCount, 3);
+}
+
+TEST(TextLayout, NewLine)
+{
+	CTextLayout Layout = ::Layout(Settings(-1), "ab\ncd");
+	ASSERT_EQ(Layout.m_aGlyphs.size(), 4u);
+	EXPECT_FLOAT_EQ(Layout.m_aGlyphs[2].m_X, 0.0f);
+	EXPECT_FLOAT_EQ(Layout.m_aGlyphs[2].m_Y, 10.0f);
+	EXPECT_FLOAT_EQ(Layout.m_EndX, 10.0f);
+	EXPECT_FLOAT_EQ(Layout.m_EndY, 10.0f);
+	EXPECT_EQ(Layout.m_LineCount, 2);
+	EXPECT_TRUE(Layout.m_GotNewLine);
+	EXPECT_FALSE(Layout.m_Wrapped);
+}
+
+TEST(TextLayout, MaxLines)
+{
+	CTextLayoutSettings Limited = Settings(-1);
+	Limited.m_MaxLines = 2;
+	CTextLayout Layout = ::Layout(Limited, "a\nb\nc");
+	EXPECT_EQ(Layout.m_aGlyphs.size(), 2u);
+	EXPECT_EQ(Layout.m_LineCount, 3);
+}
+
+TEST(TextLayout, WrapWords)
+{
+	// each word is 15 wide, two of them with the space don't fit in 30
+	CTextLayout Layout = ::Layout(Settings(30), "abc def");
+	ASSERT_EQ(Layout.m_aGlyphs.size(), 7u);
+	EXPECT_EQ(Layout.m_aGlyphs[4].m_Chr, 'd');
+	EXPECT_FLOAT_EQ(Layout.m_aGlyphs[4].m_X, 0.0f);
+	EXPECT_FLOAT_EQ(Layout.m_aGlyphs[4].m_Y, 10.0f);
+	EXPECT_EQ(Layout.m_LineCount, 2);
+	EXPECT_TRUE(Layout.m_Wrapped);
+}
+
+TEST(TextLayout, CutLongWords)
+{
+	// 10 glyphs fit in a line of 50
+	CTextLayout Layout = ::Layout(Settings(50), "abcdefghijklmno");
+	ASSERT_EQ(Layout.m_aGlyphs.size(), 15u);
+	EXPECT_FLOAT_EQ(Layout.m_aGlyphs[9].m_Y, 0.0f);
+	EXPECT_FLOAT_EQ(Layout.m_aGlyphs[10].m_X, 0.0f);
+	EXPECT_FLOAT_EQ(Layout.m_aGlyphs[10].m_Y, 10.0f);
+	EXPECT_EQ(Layout.m_LineCount, 2);
+}
+
+TEST(TextLayout, StopAtEnd)
+{
+	CTextLayout Layout = ::Layout(Settings(12, TEXTFLAG_STOP_AT_END), "abcdef");
+	EXPECT_EQ(Layout.m_GlyphCount, 2);
+	EXPECT_EQ(Layout.m_CharCount, 3);
+	EXPECT_FLOAT_EQ(Layout.m_EndX, 10.0f);
+}
+
+TEST(TextLayout, SnapToPixels)
+{
+	CTextLayoutSettings Scaled = Settings(-1);
+	Scaled.m_Size = 2.7f;
+	Scaled.m_ScaleY = 2.0f;
+	CTextLayout Layout = ::Layout(Scaled, "a\nb\nc");
+	ASSERT_EQ(Layout.m_aGlyphs.size(), 3u);
+	EXPECT_FLOAT_EQ(Layout.m_aGlyphs[1].m_Y, 2.5f);
+	EXPECT_FLOAT_EQ(Layout.m_aGlyphs[2].m_Y, 5.0f);
+}
+
+TEST(TextLayoutCache, Hit)
+{
+	CMonospaceMetrics Metrics;
+	CTextLayoutCache Cache;
+	CTextLayoutSettings Wide = Settings(-1);
+	const CTextLayout *pFirst = Cache.Get(&Metrics, &Wide, "hello", 5);
+	int NumAdvances = Metrics.m_NumAdvances;
+	const CTextLayout *pSecond = Cache.Get(&Metrics, &Wide, "hello", 5);
+	EXPECT_EQ(pFirst, pSecond);
+	EXPECT_EQ(Metrics.m_NumAdvances, NumAdvances);
+	EXPECT_EQ(Cache.NumHits(), 1);
+	EXPECT_EQ(Cache.NumMisses(), 1);
+	EXPECT_EQ(Cache.Num(), 1);
+}
+
+TEST(TextLayoutCache, Key)
+{
+	CMonospaceMetrics Metrics;
+	CTextLayoutCache Cache;
+	CTextLayoutSettings Wide = Settings(-1);
+	CTextLayoutSettings Narrow = Settings(30);
+	EXPECT_EQ(Cache.Get(&Metrics, &Wide, "abc def", 7)->m_LineCount, 1);
+	EXPECT_EQ(Cache.Get(&Metrics, &Narrow, "abc def", 7)->m_LineCount, 2);
+	EXPECT_EQ(Cache.Get(&Metrics, &Wide, "abc deg", 7)->m_aGlyphs[6].m_Chr, 'g');
+	// a prefix of a longer text is its own layout
+	EXPECT_EQ(Cache.Get(&Metrics, &Wide, "abc def", 3)->m_GlyphCount, 3);
+	EXPECT_EQ(Cache.NumHits(), 0);
+	EXPECT_EQ(Cache.Num(), 4);
+}
+
+TEST(TextLayoutCache, IgnoreStartWithoutLineBreaks)
+{
+	CMonospaceMetrics Metrics;
+	CTextLayoutCache Cache;
+	CTextLayoutSettings Moved = Settings(-1);
+	Moved.m_StartX = 0.25f;
+	Cache.Get(&Metrics, &Moved, "abc", 3);
+	Moved.m_StartX = 0.75f;
+	Cache.Get(&Metrics, &Moved, "abc", 3);
+	EXPECT_EQ(Cache.NumHits(), 1);
+
+	Cache.Get(&Metrics, &Moved, "a\nc", 3);
+	Moved.m_StartX = 0.25f;
+	Cache.Get(&Metrics, &Moved, "a\nc", 3);
+	EXPECT_EQ(Cache.NumHits(), 1);
+}
+
+TEST(TextLayoutCache, Evict)
+{
+	CMonospaceMetrics Metrics;
+	CTextLayoutCache Cache(2);
+	CTextLayoutSettings Wide = Settings(-1);
+	Cache.Get(&Metrics, &Wide, "a", 1);
+	Cache.Get(&Metrics, &Wide, "b", 1);
+	Cache.Get(&Metrics, &Wide, "a", 1); // b is the oldest now
+	Cache.Get(&Metrics, &Wide, "c", 1);
+	EXPECT_EQ(Cache.Num(), 2);
+	EXPECT_EQ(Cache.NumHits(), 1);
+
+	Cache.Get(&Metrics, &Wide, "a", 1);
+	EXPECT_EQ(Cache.NumHits(), 2);
+	Cache.Get(&Metrics, &Wide, "b", 1);
+	EXPECT_EQ(Cache.NumHits(), 2);
+
+	Cache.Clear();
+	EXPECT_EQ(Cache.Num(), 0);
+}
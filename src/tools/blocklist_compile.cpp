@@ -0,0 +1,73 @@
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/shared/blocklist.h>
+#include <engine/shared/linereader.h>
+#include <engine/shared/netban.h>
+#include <engine/storage.h>
+
+#include <vector>
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	if(!pStorage || argc != 3)
+	{
+		dbg_msg("blocklist_compile", "usage: blocklist_compile <input.txt> <output.bin>");
+		return -1;
+	}
+
+	IOHANDLE File = pStorage->OpenFile(argv[1], IOFLAG_READ, IStorage::TYPE_ALL);
+	if(!File)
+	{
+		dbg_msg("blocklist_compile", "failed to open '%s'", argv[1]);
+		return -1;
+	}
+
+	// same syntax as bans_load: one entry per line, '#' starts a comment
+	std::vector<CNetRange> Ranges;
+	int LineNumber = 0, NumInvalid = 0;
+	CLineReader LineReader;
+	LineReader.Init(File);
+	while(char *pLine = LineReader.Get())
+	{
+		LineNumber++;
+		char *pComment = (char *)str_find(pLine, "#");
+		if(pComment)
+			*pComment = 0;
+		char *pEntry = str_skip_whitespaces(pLine);
+		*str_skip_to_whitespace(pEntry) = 0;
+		if(!pEntry[0])
+			continue;
+
+		CNetRange Range;
+		int Result = NetRangeFromStr(pEntry, &Range);
+		if(Result == 0)
+		{
+			dbg_msg("blocklist_compile", "%s:%d: invalid entry '%s'", argv[1], LineNumber, pEntry);
+			NumInvalid++;
+			continue;
+		}
+		if(Result == 1)
+			Range.m_UB = Range.m_LB;
+		Ranges.push_back(Range);
+	}
+	io_close(File);
+
+	File = pStorage->OpenFile(argv[2], IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+	{
+		dbg_msg("blocklist_compile", "failed to open '%s' for writing", argv[2]);
+		return -1;
+	}
+	bool Success = CBlocklist::Write(File, Ranges.empty() ? 0 : &Ranges[0], Ranges.size());
+	io_close(File);
+	if(!Success)
+	{
+		dbg_msg("blocklist_compile", "failed to write '%s'", argv[2]);
+		return -1;
+	}
+
+	dbg_msg("blocklist_compile", "compiled %d entries (%d invalid) to '%s'", (int)Ranges.size(), NumInvalid, argv[2]);
+	return 0;
+}
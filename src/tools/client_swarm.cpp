@@ -0,0 +1,745 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/message.h>
+#include <engine/shared/compression.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/snapshot.h>
+#include <generated/protocol.h>
+#include <game/version.h>
+
+#include <stdio.h>	// sscanf
+
+#include <algorithm>
+#include <vector>
+
+/*
+	Connects many headless clients to one or more servers and keeps
+	them playing, to see how a server copes with a full house.
+
+	Every client goes through the handshake and the map download like
+	a real one, enters the game, acks the snapshots it receives and
+	sends an input every predicted tick, either following a script or
+	at random. All of them share one thread, a client is not much more
+	than its connection.
+
+	The bandwidth is measured on the sockets of the clients, which is
+	what the server sends and receives. The lateness of a snapshot is
+	its arrival compared to the earliest arrival of any snapshot
+	relative to its tick. The server snaps every other tick, if the
+	tick of a snapshot is further away from the previous one, the
+	server fell behind and had to run several ticks at once.
+*/
+
+struct CInputStep
+{
+	int m_Ticks;
+	int m_Direction;
+	int m_Jump;
+	int m_Fire;
+	int m_Hook;
+	int m_TargetX;
+	int m_TargetY;
+	int m_Weapon;
+};
+
+class CInputScript
+{
+	std::vector<CInputStep> m_aSteps;
+
+public:
+	// one step per line: <ticks> <direction> <jump> <fire> <hook> <target x> <target y> [weapon]
+	bool Load(const char *pFilename)
+	{
+		IOHANDLE File = io_open(pFilename, IOFLAG_READ);
+		if(!File)
+			return false;
+		int Length = io_length(File);
+		char *pData = (char *)mem_alloc(Length+1, 1);
+		io_read(File, pData, Length);
+		pData[Length] = 0;
+		io_close(File);
+
+		for(char *pLine = pData; pLine && *pLine; )
+		{
+			char *pEnd = (char *)str_find(pLine, "\n");
+			if(pEnd)
+				*pEnd = 0;
+			CInputStep Step = {0, 0, 0, 0, 0, 100, 0, -1};
+			if(pLine[0] != '#' && sscanf(pLine, "%d %d %d %d %d %d %d %d", &Step.m_Ticks, &Step.m_Direction, &Step.m_Jump,
+				&Step.m_Fire, &Step.m_Hook, &Step.m_TargetX, &Step.m_TargetY, &Step.m_Weapon) >= 7 && Step.m_Ticks > 0)
+			{
+				Step.m_Direction = clamp(Step.m_Direction, -1, 1);
+				m_aSteps.push_back(Step);
+			}
+			pLine = pEnd ? pEnd+1 : 0;
+		}
+		mem_free(pData);
+		return !m_aSteps.empty();
+	}
+
+	bool Empty() const { return m_aSteps.empty(); }
+	int Num() const { return m_aSteps.size(); }
+	const CInputStep &Get(int Index) const { return m_aSteps[Index%m_aSteps.size()]; }
+};
+
+struct CSwarmStats
+{
+	int m_NumIngame;
+	int m_NumDropped;
+	int m_NumSnapshots;
+	int m_NumSnapshotErrors;
+	int m_NumOverruns;
+	int m_NumSkippedTicks;
+	int m_NumInputs;
+	std::vector<int64> m_aJoinTimes;
+	std::vector<int64> m_aPings;
+	std::vector<int64> m_aLateness;
+};
+
+class CSwarmClient
+{
+	enum
+	{
+		STATE_OFFLINE=0,
+		STATE_CONNECTING,
+		STATE_LOADING,
+		STATE_READY,
+		STATE_INGAME,
+		STATE_DROPPED,
+	};
+
+	int m_ID;
+	int m_State;
+	CNetClient m_Net;
+	NETADDR m_ServerAddr;
+	CSwarmStats *m_pStats;
+	const CInputScript *m_pScript;
+	const char *m_pPassword;
+	bool m_DownloadMap;
+
+	int64 m_ConnectTime;
+	int64 m_LastPing;
+
+	int m_MapChunk;
+	int m_MapChunkNum;
+	int m_MapChunkSize;
+	int m_MapSize;
+	int m_MapAmount;
+
+	CSnapshotStorage m_Snapshots;
+	unsigned char m_aSnapshotIncomingData[CSnapshot::MAX_SIZE];
+	unsigned m_SnapshotParts;
+	int m_CurrentRecvTick;
+	int m_AckGameTick;
+	int m_LatestTick;
+	int64 m_LatestTickTime;
+	bool m_LatestDelta;
+	int m_SnapInterval;
+	int64 m_MinSnapOffset;
+
+	int m_PredMargin;
+	int m_LastInputTick;
+	CNetObj_PlayerInput m_Input;
+	int m_Step;
+	int m_StepTicksLeft;
+	unsigned m_RandomState;
+
+	unsigned Random()
+	{
+		m_RandomState = m_RandomState*1103515245u + 12345u;
+		return m_RandomState>>8;
+	}
+
+	void SendMsg(CMsgPacker *pMsg, int Flags)
+	{
+		CNetChunk Packet;
+		Packet.m_ClientID = 0;
+		Packet.m_pData = pMsg->Data();
+		Packet.m_DataSize = pMsg->Size();
+		Packet.m_Flags = Flags;
+		m_Net.Send(&Packet);
+	}
+
+	template<class T>
+	void SendPackMsg(T *pMsg, int Flags)
+	{
+		CMsgPacker Packer(pMsg->MsgID(), false);
+		if(!pMsg->Pack(&Packer))
+			SendMsg(&Packer, Flags);
+	}
+
+	void SendReady()
+	{
+		CMsgPacker Msg(NETMSG_READY, true);
+		SendMsg(&Msg, NETSENDFLAG_VITAL|NETSENDFLAG_FLUSH);
+		m_State = STATE_READY;
+	}
+
+	void SendStartInfo()
+	{
+		static const char *s_apSkinParts[NUM_SKINPARTS] = {"standard", "", "", "standard", "standard", "standard"};
+		char aName[MAX_NAME_LENGTH];
+		str_format(aName, sizeof(aName), "swarm %d", m_ID);
+
+		CNetMsg_Cl_StartInfo Msg;
+		Msg.m_pName = aName;
+		Msg.m_pClan = "swarm";
+		Msg.m_Country = -1;
+		for(int p = 0; p < NUM_SKINPARTS; p++)
+		{
+			Msg.m_apSkinPartNames[p] = s_apSkinParts[p];
+			Msg.m_aUseCustomColors[p] = 1;
+			Msg.m_aSkinPartColors[p] = (m_ID*2654435761u)&0xffffff;
+		}
+		SendPackMsg(&Msg, NETSENDFLAG_VITAL|NETSENDFLAG_FLUSH);
+
+		CMsgPacker EnterMsg(NETMSG_ENTERGAME, true);
+		SendMsg(&EnterMsg, NETSENDFLAG_VITAL|NETSENDFLAG_FLUSH);
+	}
+
+	void NextStep()
+	{
+		CInputStep Step;
+		if(m_pScript)
+			Step = m_pScript->Get(m_Step++);
+		else
+		{
+			// move around, jump and shoot in all directions every now and then
+			Step.m_Ticks = 5 + Random()%40;
+			Step.m_Direction = (int)(Random()%3)-1;
+			Step.m_Jump = Random()%4 == 0;
+			Step.m_Fire = Random()%3 == 0;
+			Step.m_Hook = Random()%5 == 0;
+			Step.m_TargetX = (int)(Random()%400)-200;
+			Step.m_TargetY = (int)(Random()%400)-200;
+			Step.m_Weapon = -1;
+		}
+
+		// a press is a change of the counter
+		if(Step.m_Fire && !(m_Input.m_Fire&1))
+			m_Input.m_Fire++;
+		else if(!Step.m_Fire && (m_Input.m_Fire&1))
+			m_Input.m_Fire++;
+		m_Input.m_Direction = Step.m_Direction;
+		m_Input.m_Jump = Step.m_Jump;
+		m_Input.m_Hook = Step.m_Hook;
+		m_Input.m_TargetX = Step.m_TargetX ? Step.m_TargetX : 1;
+		m_Input.m_TargetY = Step.m_TargetY;
+		if(Step.m_Weapon >= 0 && Step.m_Weapon < NUM_WEAPONS)
+			m_Input.m_WantedWeapon = Step.m_Weapon+1;
+		m_StepTicksLeft = Step.m_Ticks;
+	}
+
+	void SendInput(int64 Now)
+	{
+		if(m_LatestTick <= 0)
+			return;
+
+		int PredTick = m_LatestTick + (int)((Now-m_LatestTickTime)*SERVER_TICK_SPEED/time_freq()) + m_PredMargin;
+		if(PredTick <= m_LastInputTick)
+			return;
+
+		for(int Ticks = m_LastInputTick > 0 ? PredTick-m_LastInputTick : 1; Ticks > 0; Ticks--)
+		{
+			if(--m_StepTicksLeft <= 0)
+				NextStep();
+		}
+		m_LastInputTick = PredTick;
+
+		CMsgPacker Msg(NETMSG_INPUT, true);
+		Msg.AddInt(m_AckGameTick);
+		Msg.AddInt(PredTick);
+		Msg.AddInt(sizeof(m_Input));
+		const int *pData = (const int *)&m_Input;
+		for(unsigned i = 0; i < sizeof(m_Input)/sizeof(int); i++)
+			Msg.AddInt(pData[i]);
+		Msg.AddInt(0); // ping correction
+		SendMsg(&Msg, NETSENDFLAG_FLUSH);
+		m_pStats->m_NumInputs++;
+	}
+
+	void OnSnapshot(int Msg, CUnpacker *pUnpacker, class CSnapshotDelta *pSnapshotDelta, int64 Now)
+	{
+		int NumParts = 1;
+		int Part = 0;
+		int GameTick = pUnpacker->GetInt();
+		int DeltaTick = GameTick-pUnpacker->GetInt();
+		int PartSize = 0;
+		int Crc = 0;
+
+		if(Msg == NETMSG_SNAP)
+		{
+			NumParts = pUnpacker->GetInt();
+			Part = pUnpacker->GetInt();
+		}
+		if(Msg != NETMSG_SNAPEMPTY)
+		{
+			Crc = pUnpacker->GetInt();
+			PartSize = pUnpacker->GetInt();
+		}
+		const unsigned char *pData = pUnpacker->GetRaw(PartSize);
+		if(pUnpacker->Error() || NumParts < 1 || NumParts > CSnapshot::MAX_PARTS || Part < 0 || Part >= NumParts || PartSize < 0 || PartSize > MAX_SNAPSHOT_PACKSIZE)
+			return;
+		if(GameTick < m_CurrentRecvTick)
+			return;
+
+		if(GameTick != m_CurrentRecvTick)
+		{
+			m_SnapshotParts = 0;
+			m_CurrentRecvTick = GameTick;
+		}
+		mem_copy(m_aSnapshotIncomingData + Part*MAX_SNAPSHOT_PACKSIZE, pData, PartSize);
+		m_SnapshotParts |= 1<<Part;
+		if(m_SnapshotParts != (unsigned)((1<<NumParts)-1))
+			return;
+		m_SnapshotParts = 0;
+
+		static CSnapshot s_EmptySnap;
+		static unsigned char s_aDeltaData[CSnapshot::MAX_SIZE];
+		static unsigned char s_aSnapData[CSnapshot::MAX_SIZE];
+		s_EmptySnap.Clear();
+		CSnapshot *pDeltaShot = &s_EmptySnap;
+		if(DeltaTick >= 0 && m_Snapshots.Get(DeltaTick, 0, &pDeltaShot, 0) < 0)
+		{
+			// the server has to start over with a full snapshot
+			m_pStats->m_NumSnapshotErrors++;
+			m_AckGameTick = -1;
+			return;
+		}
+
+		const void *pDeltaData = pSnapshotDelta->EmptyDelta();
+		int DeltaSize = sizeof(int)*3;
+		int CompleteSize = (NumParts-1)*MAX_SNAPSHOT_PACKSIZE + PartSize;
+		if(CompleteSize)
+		{
+			DeltaSize = CVariableInt::Decompress(m_aSnapshotIncomingData, CompleteSize, s_aDeltaData, sizeof(s_aDeltaData));
+			if(DeltaSize < 0)
+			{
+				m_pStats->m_NumSnapshotErrors++;
+				return;
+			}
+			pDeltaData = s_aDeltaData;
+		}
+
+		CSnapshot *pSnap = (CSnapshot *)s_aSnapData;
+		int SnapSize = pSnapshotDelta->UnpackDelta(pDeltaShot, pSnap, pDeltaData, DeltaSize);
+		if(SnapSize < 0 || (Msg != NETMSG_SNAPEMPTY && pSnap->Crc() != Crc))
+		{
+			m_pStats->m_NumSnapshotErrors++;
+			m_AckGameTick = -1;
+			return;
+		}
+
+		m_Snapshots.PurgeUntil(DeltaTick >= 0 ? DeltaTick : GameTick-SERVER_TICK_SPEED);
+		m_Snapshots.Add(GameTick, Now, SnapSize, pSnap, 0);
+		m_AckGameTick = GameTick;
+		m_pStats->m_NumSnapshots++;
+
+		if(m_State == STATE_READY)
+		{
+			m_State = STATE_INGAME;
+			m_pStats->m_NumIngame++;
+			m_pStats->m_aJoinTimes.push_back(Now-m_ConnectTime);
+		}
+
+		// only snapshots that are deltas of acked ones come at the full rate
+		bool Delta = DeltaTick >= 0;
+		if(Delta && m_LatestDelta && GameTick > m_LatestTick)
+		{
+			int Interval = GameTick-m_LatestTick;
+			m_SnapInterval = min(m_SnapInterval, Interval);
+			if(Interval > m_SnapInterval)
+			{
+				m_pStats->m_NumOverruns++;
+				m_pStats->m_NumSkippedTicks += Interval-m_SnapInterval;
+			}
+
+			int64 Offset = Now - GameTick*time_freq()/SERVER_TICK_SPEED;
+			m_MinSnapOffset = min(m_MinSnapOffset, Offset);
+			m_pStats->m_aLateness.push_back(Offset-m_MinSnapOffset);
+		}
+		m_LatestDelta = Delta;
+		m_LatestTick = GameTick;
+		m_LatestTickTime = Now;
+	}
+
+	void OnSystemMessage(int Msg, CUnpacker *pUnpacker, bool Vital, class CSnapshotDelta *pSnapshotDelta, int64 Now)
+	{
+		if(Vital && Msg == NETMSG_MAP_CHANGE)
+		{
+			pUnpacker->GetString(CUnpacker::SANITIZE_CC);
+			pUnpacker->GetInt(); // crc
+			int MapSize = pUnpacker->GetInt();
+			int MapChunkNum = pUnpacker->GetInt();
+			int MapChunkSize = pUnpacker->GetInt();
+			if(pUnpacker->Error() || MapSize <= 0 || MapChunkNum <= 0 || MapChunkSize <= 0)
+				return;
+
+			// the server changed the map, start over
+			if(m_State == STATE_INGAME)
+				m_pStats->m_NumIngame--;
+			m_Snapshots.PurgeAll();
+			m_CurrentRecvTick = 0;
+			m_AckGameTick = -1;
+			m_LatestTick = 0;
+			m_LatestDelta = false;
+			m_LastInputTick = 0;
+			m_State = STATE_LOADING;
+
+			if(!m_DownloadMap)
+			{
+				SendReady();
+				return;
+			}
+			m_MapChunk = 0;
+			m_MapChunkNum = MapChunkNum;
+			m_MapChunkSize = MapChunkSize;
+			m_MapSize = MapSize;
+			m_MapAmount = 0;
+			CMsgPacker Request(NETMSG_REQUEST_MAP_DATA, true);
+			SendMsg(&Request, NETSENDFLAG_VITAL|NETSENDFLAG_FLUSH);
+		}
+		else if(Vital && Msg == NETMSG_MAP_DATA)
+		{
+			if(m_State != STATE_LOADING || m_MapAmount >= m_MapSize)
+				return;
+			int Size = min(m_MapChunkSize, m_MapSize-m_MapAmount);
+			pUnpacker->GetRaw(Size);
+			if(pUnpacker->Error())
+				return;
+
+			// the data itself is of no use here
+			m_MapChunk++;
+			m_MapAmount += Size;
+			if(m_MapAmount == m_MapSize)
+				SendReady();
+			else if(m_MapChunk%m_MapChunkNum == 0)
+			{
+				CMsgPacker Request(NETMSG_REQUEST_MAP_DATA, true);
+				SendMsg(&Request, NETSENDFLAG_VITAL|NETSENDFLAG_FLUSH);
+			}
+		}
+		else if(Vital && Msg == NETMSG_CON_READY)
+			SendStartInfo();
+		else if(Msg == NETMSG_PING)
+		{
+			CMsgPacker Reply(NETMSG_PING_REPLY, true);
+			SendMsg(&Reply, 0);
+		}
+		else if(Msg == NETMSG_PING_REPLY)
+		{
+			if(m_LastPing)
+				m_pStats->m_aPings.push_back(Now-m_LastPing);
+			m_LastPing = 0;
+		}
+		else if(Msg == NETMSG_INPUTTIMING)
+		{
+			pUnpacker->GetInt();
+			int TimeLeft = pUnpacker->GetInt();
+			if(pUnpacker->Error())
+				return;
+
+			// keep the inputs a little ahead of the server
+			if(TimeLeft < 5)
+				m_PredMargin = min(m_PredMargin+1, (int)SERVER_TICK_SPEED);
+			else if(TimeLeft > 60)
+				m_PredMargin = max(m_PredMargin-1, 1);
+		}
+		else if(Msg == NETMSG_SNAP || Msg == NETMSG_SNAPSINGLE || Msg == NETMSG_SNAPEMPTY)
+		{
+			if(m_State >= STATE_READY)
+				OnSnapshot(Msg, pUnpacker, pSnapshotDelta, Now);
+		}
+	}
+
+public:
+	CSwarmClient(int ID, CSwarmStats *pStats, const CInputScript *pScript, const char *pPassword, bool DownloadMap) :
+		m_ID(ID), m_State(STATE_OFFLINE), m_pStats(pStats), m_pScript(pScript), m_pPassword(pPassword), m_DownloadMap(DownloadMap)
+	{
+		m_Snapshots.Init();
+		m_SnapshotParts = 0;
+		m_CurrentRecvTick = 0;
+		m_AckGameTick = -1;
+		m_LatestTick = 0;
+		m_LatestTickTime = 0;
+		m_LatestDelta = false;
+		m_SnapInterval = SERVER_TICK_SPEED;
+		m_MinSnapOffset = 0x7fffffffffffffffll;
+		m_PredMargin = 3;
+		m_LastInputTick = 0;
+		m_LastPing = 0;
+		mem_zero(&m_Input, sizeof(m_Input));
+		m_Input.m_TargetX = 1;
+		m_RandomState = ID*7919u + 1;
+		m_Step = pScript ? ID : 0;
+		m_StepTicksLeft = 0;
+	}
+
+	~CSwarmClient()
+	{
+		m_Snapshots.PurgeAll();
+	}
+
+	bool Connect(NETADDR BindAddr, const NETADDR &ServerAddr)
+	{
+		if(!m_Net.Open(BindAddr, NETCREATE_FLAG_RANDOMPORT))
+			return false;
+		m_ServerAddr = ServerAddr;
+		m_Net.Connect(&m_ServerAddr);
+		m_ConnectTime = time_get();
+		m_State = STATE_CONNECTING;
+		return true;
+	}
+
+	void Disconnect()
+	{
+		if(m_State == STATE_OFFLINE || m_State == STATE_DROPPED)
+			return;
+		m_Net.Disconnect("load test done");
+		m_Net.Update();
+	}
+
+	bool Offline() const { return m_State == STATE_OFFLINE; }
+
+	void Update(class CSnapshotDelta *pSnapshotDelta, int64 Now, bool SendPing)
+	{
+		if(m_State == STATE_OFFLINE || m_State == STATE_DROPPED)
+			return;
+
+		m_Net.Update();
+		if(m_Net.State() == NETSTATE_OFFLINE)
+		{
+			dbg_msg("client_swarm", "client %d dropped: %s", m_ID, m_Net.ErrorString());
+			if(m_State == STATE_INGAME)
+				m_pStats->m_NumIngame--;
+			m_pStats->m_NumDropped++;
+			m_State = STATE_DROPPED;
+			return;
+		}
+
+		if(m_State == STATE_CONNECTING && m_Net.State() == NETSTATE_ONLINE)
+		{
+			CMsgPacker Msg(NETMSG_INFO, true);
+			Msg.AddString(GAME_NETVERSION, 128);
+			Msg.AddString(m_pPassword, 128);
+			Msg.AddInt(CLIENT_VERSION);
+			SendMsg(&Msg, NETSENDFLAG_VITAL|NETSENDFLAG_FLUSH);
+			m_State = STATE_LOADING;
+		}
+
+		CNetChunk Packet;
+		while(m_Net.Recv(&Packet))
+		{
+			if(Packet.m_ClientID == -1)
+				continue;
+			CUnpacker Unpacker;
+			Unpacker.Reset(Packet.m_pData, Packet.m_DataSize);
+			int Msg = Unpacker.GetInt();
+			if(Unpacker.Error())
+				continue;
+			// game messages are not of interest
+			if(Msg&1)
+				OnSystemMessage(Msg>>1, &Unpacker, (Packet.m_Flags&NET_CHUNKFLAG_VITAL) != 0, pSnapshotDelta, Now);
+		}
+
+		if(m_State == STATE_INGAME)
+		{
+			SendInput(Now);
+			if(SendPing && !m_LastPing)
+			{
+				CMsgPacker Msg(NETMSG_PING, true);
+				SendMsg(&Msg, NETSENDFLAG_FLUSH);
+				m_LastPing = Now;
+			}
+		}
+	}
+};
+
+static void PrintTimes(const char *pName, std::vector<int64> &aTimes)
+{
+	if(aTimes.empty())
+	{
+		dbg_msg("client_swarm", "%-9s no samples", pName);
+		return;
+	}
+	std::sort(aTimes.begin(), aTimes.end());
+	double Freq = time_freq()/1000.0;
+	dbg_msg("client_swarm", "%-9s %7d samples  p50 %7.2fms  p99 %7.2fms  max %7.2fms", pName, (int)aTimes.size(),
+		aTimes[aTimes.size()/2]/Freq, aTimes[aTimes.size()*99/100]/Freq, aTimes.back()/Freq);
+}
+
+static bool ParseAddress(const char *pStr, NETADDR *pAddr)
+{
+	if(net_addr_from_str(pAddr, pStr) != 0 && net_host_lookup(pStr, pAddr, NETTYPE_IPV4) != 0)
+		return false;
+	if(!pAddr->port)
+		pAddr->port = 8303;
+	return true;
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+
+	int NumClients = 16;
+	int ConnectRate = 10;
+	int Seconds = 30;
+	int ClientsPerAddress = 0;
+	bool DownloadMap = true;
+	const char *pScript = 0;
+	const char *pPassword = "";
+	std::vector<NETADDR> aServers;
+
+	for(int i = 1; i < argc; i++) // ignore_convention
+	{
+		NETADDR Addr;
+		if(str_comp(argv[i], "-n") == 0 && i+1 < argc) // ignore_convention
+			NumClients = clamp(str_toint(argv[++i]), 1, 4096); // ignore_convention
+		else if(str_comp(argv[i], "-r") == 0 && i+1 < argc) // ignore_convention
+			ConnectRate = clamp(str_toint(argv[++i]), 1, 1000); // ignore_convention
+		else if(str_comp(argv[i], "-t") == 0 && i+1 < argc) // ignore_convention
+			Seconds = max(str_toint(argv[++i]), 1); // ignore_convention
+		else if(str_comp(argv[i], "-perip") == 0 && i+1 < argc) // ignore_convention
+			ClientsPerAddress = max(str_toint(argv[++i]), 0); // ignore_convention
+		else if(str_comp(argv[i], "-f") == 0 && i+1 < argc) // ignore_convention
+			pScript = argv[++i]; // ignore_convention
+		else if(str_comp(argv[i], "-password") == 0 && i+1 < argc) // ignore_convention
+			pPassword = argv[++i]; // ignore_convention
+		else if(str_comp(argv[i], "-nomap") == 0) // ignore_convention
+			DownloadMap = false;
+		else if(argv[i][0] != '-' && ParseAddress(argv[i], &Addr)) // ignore_convention
+			aServers.push_back(Addr);
+		else
+		{
+			aServers.clear();
+			break;
+		}
+	}
+
+	if(aServers.empty())
+	{
+		dbg_msg("client_swarm", "usage: client_swarm [-n clients] [-r connects per second] [-t seconds] [-f input script]");
+		dbg_msg("client_swarm", "                    [-perip clients] [-password password] [-nomap] <server>...");
+		dbg_msg("client_swarm", "-perip spreads the clients over the loopback addresses 127.0.0.2 and up, to stay below sv_max_clients_per_ip");
+		dbg_msg("client_swarm", "script lines: <ticks> <direction> <jump> <fire> <hook> <target x> <target y> [weapon]");
+		return -1;
+	}
+
+	CInputScript Script;
+	if(pScript && !Script.Load(pScript))
+	{
+		dbg_msg("client_swarm", "failed to load input script '%s'", pScript);
+		return -1;
+	}
+
+	if(secure_random_init() != 0)
+	{
+		dbg_msg("client_swarm", "could not initialize secure RNG");
+		return -1;
+	}
+	CNetBase::Init();
+	CNetObjHandler NetObjHandler;
+	CSnapshotDelta SnapshotDelta;
+	for(int i = 0; i < NUM_NETOBJTYPES; i++)
+		SnapshotDelta.SetStaticsize(i, NetObjHandler.GetObjSize(i));
+
+	CSwarmStats Stats;
+	Stats.m_NumIngame = 0;
+	Stats.m_NumDropped = 0;
+	Stats.m_NumSnapshots = 0;
+	Stats.m_NumSnapshotErrors = 0;
+	Stats.m_NumOverruns = 0;
+	Stats.m_NumSkippedTicks = 0;
+	Stats.m_NumInputs = 0;
+
+	std::vector<CSwarmClient *> apClients;
+	for(int i = 0; i < NumClients; i++)
+		apClients.push_back(new CSwarmClient(i, &Stats, pScript ? &Script : 0, pPassword, DownloadMap));
+
+	NETSTATS StartNetStats, LastNetStats;
+	net_stats(&StartNetStats);
+	LastNetStats = StartNetStats;
+	int64 SentBytes = 0, RecvBytes = 0, SentPackets = 0, RecvPackets = 0;
+	int LastSnapshots = 0, LastOverruns = 0;
+
+	int64 StartTime = time_get();
+	int64 EndTime = StartTime + Seconds*time_freq();
+	int64 LastReport = StartTime;
+	int64 LastPing = StartTime;
+	int NumStarted = 0;
+
+	while(true)
+	{
+		int64 Now = time_get();
+		if(Now >= EndTime)
+			break;
+
+		// ramp up, a whole swarm at once would look like an attack
+		int Due = min(NumClients, (int)((Now-StartTime)*ConnectRate/time_freq())+1);
+		for(; NumStarted < Due; NumStarted++)
+		{
+			NETADDR BindAddr;
+			mem_zero(&BindAddr, sizeof(BindAddr));
+			BindAddr.type = NETTYPE_IPV4;
+			if(ClientsPerAddress)
+			{
+				int Address = 2 + NumStarted/ClientsPerAddress;
+				BindAddr.ip[0] = 127;
+				BindAddr.ip[1] = (Address>>16)&0xff;
+				BindAddr.ip[2] = (Address>>8)&0xff;
+				BindAddr.ip[3] = Address&0xff;
+			}
+			if(!apClients[NumStarted]->Connect(BindAddr, aServers[NumStarted%aServers.size()]))
+				dbg_msg("client_swarm", "client %d: couldn't open socket", NumStarted);
+		}
+
+		bool SendPing = Now-LastPing > time_freq();
+		if(SendPing)
+			LastPing = Now;
+		for(auto *pClient : apClients)
+			pClient->Update(&SnapshotDelta, Now, SendPing);
+
+		if(Now-LastReport >= time_freq())
+		{
+			NETSTATS NetStats;
+			net_stats(&NetStats);
+			// the counters may wrap around on long runs
+			unsigned Sent = NetStats.sent_bytes-LastNetStats.sent_bytes;
+			unsigned Recv = NetStats.recv_bytes-LastNetStats.recv_bytes;
+			SentBytes += Sent;
+			RecvBytes += Recv;
+			SentPackets += (unsigned)(NetStats.sent_packets-LastNetStats.sent_packets);
+			RecvPackets += (unsigned)(NetStats.recv_packets-LastNetStats.recv_packets);
+			LastNetStats = NetStats;
+
+			double Elapsed = (Now-LastReport)/(double)time_freq();
+			dbg_msg("client_swarm", "%3ds  %d/%d ingame  %d dropped  server sends %7.1f KiB/s  receives %6.1f KiB/s  %5.0f snapshots/s  %d overruns",
+				(int)((Now-StartTime)/time_freq()), Stats.m_NumIngame, NumStarted, Stats.m_NumDropped, Recv/1024.0/Elapsed, Sent/1024.0/Elapsed,
+				(Stats.m_NumSnapshots-LastSnapshots)/Elapsed, Stats.m_NumOverruns-LastOverruns);
+			LastSnapshots = Stats.m_NumSnapshots;
+			LastOverruns = Stats.m_NumOverruns;
+			LastReport = Now;
+		}
+
+		thread_sleep(1);
+	}
+
+	for(auto *pClient : apClients)
+		pClient->Disconnect();
+
+	double Elapsed = (time_get()-StartTime)/(double)time_freq();
+	dbg_msg("client_swarm", "%d clients, %d ingame at the end, %d dropped", NumClients, Stats.m_NumIngame, Stats.m_NumDropped);
+	dbg_msg("client_swarm", "server sent %.1f KiB/s in %.0f packets/s, received %.1f KiB/s in %.0f packets/s",
+		RecvBytes/1024.0/Elapsed, RecvPackets/Elapsed, SentBytes/1024.0/Elapsed, SentPackets/Elapsed);
+	dbg_msg("client_swarm", "%d snapshots, %d broken, %d inputs, %d overruns with %d skipped ticks",
+		Stats.m_NumSnapshots, Stats.m_NumSnapshotErrors, Stats.m_NumInputs, Stats.m_NumOverruns, Stats.m_NumSkippedTicks);
+	PrintTimes("join", Stats.m_aJoinTimes);
+	PrintTimes("ping", Stats.m_aPings);
+	PrintTimes("lateness", Stats.m_aLateness);
+
+	for(auto *pClient : apClients)
+		delete pClient;
+	return Stats.m_NumDropped ? 1 : 0;
+}
@@ -0,0 +1,495 @@
+#include <base/hash.h>
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/console.h>
+#include <engine/shared/config.h>
+#include <engine/shared/demo.h>
+#include <engine/shared/jobs.h>
+#include <engine/shared/network.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/snapshot.h>
+#include <engine/storage.h>
+#include <generated/protocol.h>
+#include <game/version.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	Reconstructs the rounds of server demos and the kills, catches,
+	deaths and shots of every player in them.
+
+	Kill messages are sent to every client separately and therefore
+	recorded several times, only the first one of a tick counts. Shots
+	are taken from the attack tick of the characters.
+*/
+
+struct CPlayerStats
+{
+	bool m_Active;
+	int m_Kills;
+	int m_Catches;
+	int m_Deaths;
+	int m_Shots;
+	char m_aName[MAX_NAME_LENGTH];
+};
+
+struct CRoundStats
+{
+	int m_StartTick;
+	int m_EndTick;
+	bool m_Complete;
+	char m_aWinner[MAX_NAME_LENGTH];
+	int m_WinnerCatches;
+	CPlayerStats m_aPlayers[MAX_CLIENTS];
+};
+
+class CDemoAnalyzer : public CDemoPlayer::IListner
+{
+	struct CKill
+	{
+		int m_Killer;
+		int m_Victim;
+		int m_Weapon;
+	};
+
+	CNetObjHandler m_NetObjHandler;
+	CSnapshotDelta m_SnapshotDelta;
+	CDemoPlayer m_DemoPlayer;
+
+	char m_aaNames[MAX_CLIENTS][MAX_NAME_LENGTH];
+	int m_aLastAttackTick[MAX_CLIENTS];
+	int m_GameStateFlags;
+	bool m_RoundOpen;
+
+	int m_KillTick;
+	int m_NumTickKills;
+	CKill m_aTickKills[MAX_CLIENTS*MAX_CLIENTS];
+
+	int Tick() const { return m_DemoPlayer.Info()->m_Info.m_CurrentTick; }
+
+	void StartRound(int StartTick)
+	{
+		m_Rounds.emplace_back();
+		CRoundStats *pRound = &m_Rounds.back();
+		mem_zero(pRound, sizeof(*pRound));
+		pRound->m_StartTick = StartTick;
+		pRound->m_EndTick = StartTick;
+		m_RoundOpen = true;
+	}
+
+	CPlayerStats *Player(int ClientID)
+	{
+		CPlayerStats *pStats = &m_Rounds.back().m_aPlayers[ClientID];
+		pStats->m_Active = true;
+		str_copy(pStats->m_aName, m_aaNames[ClientID], sizeof(pStats->m_aName));
+		return pStats;
+	}
+
+	void EndRound(bool Complete)
+	{
+		if(!m_RoundOpen)
+			return;
+		m_Rounds.back().m_EndTick = Tick();
+		m_Rounds.back().m_Complete = Complete;
+		m_RoundOpen = false;
+	}
+
+	void OnDemoPlayerSnapshot(void *pData, int Size)
+	{
+		const CSnapshot *pSnap = (const CSnapshot *)pData;
+		bool aCharacters[MAX_CLIENTS] = {false};
+
+		for(int i = 0; i < pSnap->NumItems(); i++)
+		{
+			const CSnapshotItem *pItem = pSnap->GetItem(i);
+			if(pItem->Type() == NETOBJTYPE_GAMEDATA)
+			{
+				const CNetObj_GameData *pGameData = (const CNetObj_GameData *)pItem->Data();
+				if(m_RoundOpen && m_Rounds.back().m_StartTick != pGameData->m_GameStartTick)
+					EndRound(false);
+				if(!m_RoundOpen && !(pGameData->m_GameStateFlags&(GAMESTATEFLAG_ROUNDOVER|GAMESTATEFLAG_GAMEOVER)))
+					StartRound(pGameData->m_GameStartTick);
+
+				int Ended = pGameData->m_GameStateFlags&~m_GameStateFlags&(GAMESTATEFLAG_ROUNDOVER|GAMESTATEFLAG_GAMEOVER);
+				if(Ended)
+					EndRound(true);
+				m_GameStateFlags = pGameData->m_GameStateFlags;
+			}
+			else if(pItem->Type() == NETOBJTYPE_CHARACTER && pItem->ID() >= 0 && pItem->ID() < MAX_CLIENTS)
+			{
+				const CNetObj_Character *pCharacter = (const CNetObj_Character *)pItem->Data();
+				int ClientID = pItem->ID();
+				aCharacters[ClientID] = true;
+
+				// a character that just appeared didn't shoot, the tick is from before
+				if(m_aLastAttackTick[ClientID] != -1 && pCharacter->m_AttackTick != m_aLastAttackTick[ClientID] && m_RoundOpen)
+					Player(ClientID)->m_Shots++;
+				m_aLastAttackTick[ClientID] = pCharacter->m_AttackTick;
+			}
+		}
+
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(!aCharacters[i])
+				m_aLastAttackTick[i] = -1;
+		}
+	}
+
+	void OnDemoPlayerMessage(void *pData, int Size)
+	{
+		CUnpacker Unpacker;
+		Unpacker.Reset(pData, Size);
+
+		int Msg = Unpacker.GetInt();
+		int Sys = Msg&1;
+		Msg >>= 1;
+		if(Unpacker.Error() || Sys)
+			return;
+
+		void *pRawMsg = m_NetObjHandler.SecureUnpackMsg(Msg, &Unpacker);
+		if(!pRawMsg)
+			return;
+
+		if(Msg == NETMSGTYPE_SV_CLIENTINFO)
+		{
+			const CNetMsg_Sv_ClientInfo *pMsg = (const CNetMsg_Sv_ClientInfo *)pRawMsg;
+			str_copy(m_aaNames[pMsg->m_ClientID], pMsg->m_pName, sizeof(m_aaNames[pMsg->m_ClientID]));
+		}
+		else if(Msg == NETMSGTYPE_SV_KILLMSG)
+		{
+			const CNetMsg_Sv_KillMsg *pMsg = (const CNetMsg_Sv_KillMsg *)pRawMsg;
+			// kills between the rounds, like releasing everyone at the end, don't count
+			if(!m_RoundOpen || pMsg->m_Victim < 0 || pMsg->m_Victim >= MAX_CLIENTS || pMsg->m_Killer < 0 || pMsg->m_Killer >= MAX_CLIENTS)
+				return;
+
+			// every client got its own copy
+			if(m_KillTick != Tick())
+			{
+				m_KillTick = Tick();
+				m_NumTickKills = 0;
+			}
+			for(int i = 0; i < m_NumTickKills; i++)
+			{
+				const CKill *pKill = &m_aTickKills[i];
+				if(pKill->m_Killer == pMsg->m_Killer && pKill->m_Victim == pMsg->m_Victim && pKill->m_Weapon == pMsg->m_Weapon)
+					return;
+			}
+			if(m_NumTickKills < (int)(sizeof(m_aTickKills)/sizeof(m_aTickKills[0])))
+			{
+				CKill *pKill = &m_aTickKills[m_NumTickKills++];
+				pKill->m_Killer = pMsg->m_Killer;
+				pKill->m_Victim = pMsg->m_Victim;
+				pKill->m_Weapon = pMsg->m_Weapon;
+			}
+
+			Player(pMsg->m_Victim)->m_Deaths++;
+			if(pMsg->m_Killer != pMsg->m_Victim && pMsg->m_Weapon >= 0)
+			{
+				CPlayerStats *pKiller = Player(pMsg->m_Killer);
+				pKiller->m_Kills++;
+				// nobody stays caught during warmup
+				if(!(m_GameStateFlags&GAMESTATEFLAG_WARMUP))
+					pKiller->m_Catches++;
+			}
+		}
+	}
+
+public:
+	std::vector<CRoundStats> m_Rounds;
+
+	CDemoAnalyzer() : m_DemoPlayer(&m_SnapshotDelta)
+	{
+		for(int i = 0; i < NUM_NETOBJTYPES; i++)
+			m_SnapshotDelta.SetStaticsize(i, m_NetObjHandler.GetObjSize(i));
+		m_DemoPlayer.SetListner(this);
+	}
+
+	bool Analyze(IStorage *pStorage, IConsole *pConsole, const char *pFilename, char *pError, int ErrorSize)
+	{
+		mem_zero(m_aaNames, sizeof(m_aaNames));
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			m_aLastAttackTick[i] = -1;
+		m_GameStateFlags = 0;
+		m_RoundOpen = false;
+		m_KillTick = -1;
+		m_NumTickKills = 0;
+		m_Rounds.clear();
+
+		const char *pLoadError = m_DemoPlayer.Load(pStorage, pConsole, pFilename, IStorage::TYPE_ALL, GAME_NETVERSION);
+		if(pLoadError)
+		{
+			str_copy(pError, pLoadError, ErrorSize);
+			return false;
+		}
+		if(m_DemoPlayer.GetDemoType() != IDemoPlayer::DEMOTYPE_SERVER)
+		{
+			str_copy(pError, "not a server demo", ErrorSize);
+			m_DemoPlayer.Stop();
+			return false;
+		}
+
+		while(m_DemoPlayer.IsPlaying() && !m_DemoPlayer.BaseInfo()->m_Paused)
+			m_DemoPlayer.NextFrame();
+		EndRound(false);
+
+		// the index knows the winners of the rounds
+		for(int i = 0; i < m_DemoPlayer.NumRounds(); i++)
+		{
+			const CDemoRound *pIndexRound = m_DemoPlayer.GetRound(i);
+			for(unsigned r = 0; r < m_Rounds.size(); r++)
+			{
+				if(m_Rounds[r].m_StartTick == pIndexRound->m_StartTick)
+				{
+					str_copy(m_Rounds[r].m_aWinner, pIndexRound->m_aWinner, sizeof(m_Rounds[r].m_aWinner));
+					m_Rounds[r].m_WinnerCatches = pIndexRound->m_Catches;
+				}
+			}
+		}
+
+		m_DemoPlayer.Stop();
+		return true;
+	}
+};
+
+struct CDemoJob
+{
+	char m_aFilename[512];
+	IStorage *m_pStorage;
+	IConsole *m_pConsole;
+	CJobPool::CFuture<void> m_Done;
+	bool m_Success;
+	char m_aError[256];
+	std::vector<CRoundStats> m_Rounds;
+};
+
+static void AnalyzeJob(CDemoJob *pJob)
+{
+	CDemoAnalyzer *pAnalyzer = new CDemoAnalyzer();
+	pJob->m_Success = pAnalyzer->Analyze(pJob->m_pStorage, pJob->m_pConsole, pJob->m_aFilename, pJob->m_aError, sizeof(pJob->m_aError));
+	pJob->m_Rounds.swap(pAnalyzer->m_Rounds);
+	delete pAnalyzer;
+}
+
+static void EscapeCsv(std::string *pOut, const char *pStr)
+{
+	*pOut += '"';
+	for(; *pStr; pStr++)
+	{
+		if(*pStr == '"')
+			*pOut += '"';
+		*pOut += *pStr;
+	}
+	*pOut += '"';
+}
+
+static void EscapeJson(std::string *pOut, const char *pStr)
+{
+	*pOut += '"';
+	for(; *pStr; pStr++)
+	{
+		if(*pStr == '"' || *pStr == '\\')
+		{
+			*pOut += '\\';
+			*pOut += *pStr;
+		}
+		else if((unsigned char)*pStr < 0x20)
+		{
+			char aBuf[8];
+			str_format(aBuf, sizeof(aBuf), "\\u%04x", *pStr);
+			*pOut += aBuf;
+		}
+		else
+			*pOut += *pStr;
+	}
+	*pOut += '"';
+}
+
+static void FormatCsv(std::string *pOut, const CDemoJob *pJob)
+{
+	char aBuf[256];
+	for(unsigned r = 0; r < pJob->m_Rounds.size(); r++)
+	{
+		const CRoundStats *pRound = &pJob->m_Rounds[r];
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			const CPlayerStats *pPlayer = &pRound->m_aPlayers[i];
+			if(!pPlayer->m_Active)
+				continue;
+			EscapeCsv(pOut, pJob->m_aFilename);
+			str_format(aBuf, sizeof(aBuf), ",%d,%d,%d,%d,", r, pRound->m_StartTick, pRound->m_EndTick, pRound->m_Complete);
+			*pOut += aBuf;
+			EscapeCsv(pOut, pRound->m_aWinner);
+			str_format(aBuf, sizeof(aBuf), ",%d,", i);
+			*pOut += aBuf;
+			EscapeCsv(pOut, pPlayer->m_aName);
+			str_format(aBuf, sizeof(aBuf), ",%d,%d,%d,%d\n", pPlayer->m_Kills, pPlayer->m_Catches, pPlayer->m_Deaths, pPlayer->m_Shots);
+			*pOut += aBuf;
+		}
+	}
+}
+
+static void FormatJson(std::string *pOut, const CDemoJob *pJob)
+{
+	char aBuf[256];
+	*pOut += "{\"demo\":";
+	EscapeJson(pOut, pJob->m_aFilename);
+	*pOut += ",\"rounds\":[";
+	for(unsigned r = 0; r < pJob->m_Rounds.size(); r++)
+	{
+		const CRoundStats *pRound = &pJob->m_Rounds[r];
+		str_format(aBuf, sizeof(aBuf), "%s{\"start_tick\":%d,\"end_tick\":%d,\"complete\":%s,\"winner\":", r ? "," : "",
+			pRound->m_StartTick, pRound->m_EndTick, pRound->m_Complete ? "true" : "false");
+		*pOut += aBuf;
+		EscapeJson(pOut, pRound->m_aWinner);
+		str_format(aBuf, sizeof(aBuf), ",\"winner_catches\":%d,\"players\":[", pRound->m_WinnerCatches);
+		*pOut += aBuf;
+		bool First = true;
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			const CPlayerStats *pPlayer = &pRound->m_aPlayers[i];
+			if(!pPlayer->m_Active)
+				continue;
+			str_format(aBuf, sizeof(aBuf), "%s{\"id\":%d,\"name\":", First ? "" : ",", i);
+			*pOut += aBuf;
+			EscapeJson(pOut, pPlayer->m_aName);
+			str_format(aBuf, sizeof(aBuf), ",\"kills\":%d,\"catches\":%d,\"deaths\":%d,\"shots\":%d}",
+				pPlayer->m_Kills, pPlayer->m_Catches, pPlayer->m_Deaths, pPlayer->m_Shots);
+			*pOut += aBuf;
+			First = false;
+		}
+		*pOut += "]}";
+	}
+	*pOut += "]}";
+}
+
+struct CListDemos
+{
+	const char *m_pPath;
+	std::vector<std::string> *m_pFilenames;
+};
+
+static int ListDemosCallback(const char *pName, int IsDir, int DirType, void *pUser)
+{
+	CListDemos *pList = (CListDemos *)pUser;
+	if(IsDir || !str_endswith(pName, ".demo"))
+		return 0;
+
+	char aFilename[512];
+	str_format(aFilename, sizeof(aFilename), "%s/%s", pList->m_pPath, pName);
+	// the same directory can be in several storage paths
+	for(unsigned i = 0; i < pList->m_pFilenames->size(); i++)
+	{
+		if(str_comp((*pList->m_pFilenames)[i].c_str(), aFilename) == 0)
+			return 0;
+	}
+	pList->m_pFilenames->push_back(aFilename);
+	return 0;
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	// the results go to stdout by default
+	dbg_logger_filehandle(io_stderr());
+
+	int NumThreads = max((int)std::thread::hardware_concurrency(), 1);
+	bool Json = false;
+	const char *pOutput = 0;
+	std::vector<std::string> Filenames;
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	if(!pStorage)
+		return -1;
+
+	for(int i = 1; i < argc; i++) // ignore_convention
+	{
+		if(str_comp(argv[i], "-j") == 0 && i+1 < argc) // ignore_convention
+			NumThreads = clamp(str_toint(argv[++i]), 1, 32); // ignore_convention
+		else if(str_comp(argv[i], "-f") == 0 && i+1 < argc) // ignore_convention
+			Json = str_comp(argv[++i], "json") == 0; // ignore_convention
+		else if(str_comp(argv[i], "-o") == 0 && i+1 < argc) // ignore_convention
+			pOutput = argv[++i]; // ignore_convention
+		else if(str_endswith(argv[i], ".demo")) // ignore_convention
+			Filenames.push_back(argv[i]); // ignore_convention
+		else
+		{
+			CListDemos List;
+			List.m_pPath = argv[i]; // ignore_convention
+			List.m_pFilenames = &Filenames;
+			unsigned First = Filenames.size();
+			pStorage->ListDirectory(IStorage::TYPE_ALL, argv[i], ListDemosCallback, &List); // ignore_convention
+			std::sort(Filenames.begin()+First, Filenames.end());
+		}
+	}
+
+	if(Filenames.empty())
+	{
+		dbg_msg("demo_analyze", "usage: demo_analyze [-j threads] [-f csv|json] [-o output] <demo or directory>...");
+		return -1;
+	}
+
+	IOHANDLE Output = pOutput ? pStorage->OpenFile(pOutput, IOFLAG_WRITE, IStorage::TYPE_SAVE) : io_stdout();
+	if(!Output)
+	{
+		dbg_msg("demo_analyze", "failed to open '%s' for writing", pOutput);
+		return -1;
+	}
+
+	CNetBase::Init();
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+
+	std::vector<CDemoJob> Jobs(Filenames.size());
+	CJobPool Pool;
+	Pool.Init(min(NumThreads, (int)Jobs.size()));
+	for(unsigned i = 0; i < Jobs.size(); i++)
+	{
+		str_copy(Jobs[i].m_aFilename, Filenames[i].c_str(), sizeof(Jobs[i].m_aFilename));
+		Jobs[i].m_pStorage = pStorage;
+		Jobs[i].m_pConsole = pConsole;
+		Jobs[i].m_Success = false;
+		CDemoJob *pJob = &Jobs[i];
+		pJob->m_Done = Pool.Submit([pJob]() { AnalyzeJob(pJob); });
+	}
+
+	// write the results in the order of the demos
+	std::string Out = Json ? "[" : "demo,round,start_tick,end_tick,complete,winner,client_id,name,kills,catches,deaths,shots\n";
+	int NumFailed = 0;
+	bool First = true;
+	for(unsigned i = 0; i < Jobs.size(); i++)
+	{
+		// blocks until the worker finished this demo
+		Jobs[i].m_Done.Get();
+
+		if(!Jobs[i].m_Success)
+		{
+			dbg_msg("demo_analyze", "skipping '%s': %s", Jobs[i].m_aFilename, Jobs[i].m_aError);
+			NumFailed++;
+			continue;
+		}
+
+		if(Json)
+		{
+			if(!First)
+				Out += ",";
+			FormatJson(&Out, &Jobs[i]);
+		}
+		else
+			FormatCsv(&Out, &Jobs[i]);
+		First = false;
+
+		io_write(Output, Out.c_str(), Out.size());
+		Out.clear();
+		Jobs[i].m_Rounds.clear();
+	}
+	if(Json)
+		Out += "]\n";
+	io_write(Output, Out.c_str(), Out.size());
+	if(pOutput)
+		io_close(Output);
+
+	dbg_msg("demo_analyze", "analyzed %d demos, %d failed", (int)Jobs.size()-NumFailed, NumFailed);
+	delete pConsole;
+	return NumFailed ? 1 : 0;
+}
@@ -2,26 +2,48 @@
 /* If you are missing that file, acquire a complete release at teeworlds.com.                */
 #include <base/system.h>
 #include <engine/shared/datafile.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
-int main(int argc, const char **argv)
+#include <string>
+#include <vector>
+
+struct CResaveResult
 {
-	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+	bool m_Success;
+	int m_SourceSize;
+	int m_DestSize;
+	int64 m_Time;
+};
+
+static int FileSize(IStorage *pStorage, const char *pFilename, int StorageType)
+{
+	IOHANDLE File = pStorage->OpenFile(pFilename, IOFLAG_READ, StorageType);
+	if(!File)
+		return 0;
+	int Size = io_length(File);
+	io_close(File);
+	return Size;
+}
+
+static CResaveResult ResaveMap(IStorage *pStorage, const char *pSource, const char *pDest, int Compression, CJobPool *pPool)
+{
+	CResaveResult Result;
+	Result.m_Success = false;
+	Result.m_SourceSize = FileSize(pStorage, pSource, IStorage::TYPE_ALL);
+	Result.m_DestSize = 0;
+	Result.m_Time = 0;
+	int64 StartTime = time_get();
+
 	int Index, ID = 0, Type = 0, Size;
 	void *pPtr;
-	char aFileName[1024];
 	CDataFileReader DataFile;
 	CDataFileWriter df;
 
-	if(!pStorage || argc != 3)
-		return -1;
-
-	str_format(aFileName, sizeof(aFileName), "%s", argv[2]);
-
-	if(!DataFile.Open(pStorage, argv[1], IStorage::TYPE_ALL))
-		return -1;
-	if(!df.Open(pStorage, aFileName))
-		return -1;
+	if(!DataFile.Open(pStorage, pSource, IStorage::TYPE_ALL))
+		return Result;
+	if(!df.Open(pStorage, pDest, Compression, pPool))
+		return Result;
 
 	// add all items
 	for(Index = 0; Index < DataFile.NumItems(); Index++)
@@ -31,15 +53,132 @@ int main(int argc, const char **argv)
 		df.AddItem(Type, ID, Size, pPtr);
 	}
 
-	// add all data
+	// add all data, decompressing it on the pool first
+	std::vector<int> aIndices;
+	for(Index = 0; Index < DataFile.NumData(); Index++)
+		aIndices.push_back(Index);
+	if(!aIndices.empty())
+		DataFile.LoadData(&aIndices[0], aIndices.size(), pPool);
 	for(Index = 0; Index < DataFile.NumData(); Index++)
 	{
 		pPtr = DataFile.GetData(Index);
-		Size = DataFile.GetDataSize(Index);
+		Size = DataFile.GetUncompressedDataSize(Index);
 		df.AddData(Size, pPtr);
+		// the writer has its own copy
+		DataFile.UnloadData(Index);
 	}
 
 	DataFile.Close();
 	df.Finish();
+
+	Result.m_Success = true;
+	Result.m_DestSize = FileSize(pStorage, pDest, IStorage::TYPE_SAVE);
+	Result.m_Time = time_get()-StartTime;
+	return Result;
+}
+
+static void PrintResult(const char *pName, const CResaveResult &Result)
+{
+	if(!Result.m_Success)
+	{
+		dbg_msg("map_resave", "%s: failed", pName);
+		return;
+	}
+	dbg_msg("map_resave", "%s: %d -> %d bytes (%.1f%%), %.2f ms", pName, Result.m_SourceSize, Result.m_DestSize,
+		Result.m_SourceSize ? Result.m_DestSize*100.0f/Result.m_SourceSize : 0.0f, Result.m_Time*1000.0f/time_freq());
+}
+
+struct CMapList
+{
+	std::vector<std::string> m_aNames;
+};
+
+static int AddMapCallback(const char *pName, int IsDir, int StorageType, void *pUser)
+{
+	CMapList *pList = (CMapList *)pUser;
+	int Length = str_length(pName);
+	if(IsDir || Length < 4 || str_comp(pName+Length-4, ".map") != 0)
+		return 0;
+
+	// the same map can be in several storage paths
+	for(unsigned i = 0; i < pList->m_aNames.size(); i++)
+		if(pList->m_aNames[i] == pName)
+			return 0;
+	pList->m_aNames.push_back(pName);
 	return 0;
 }
+
+int main(int argc, const char **argv)
+{
+	dbg_logger_stdout();
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv);
+
+	// -fast writes quicker, -store makes maps that load quicker but are larger
+	int Compression = CDataFileWriter::COMPRESSION_DEFAULT;
+	int NumThreads = 0;
+	int Arg = 1;
+	for(; Arg < argc && argv[Arg][0] == '-'; Arg++)
+	{
+		if(str_comp(argv[Arg], "-fast") == 0)
+			Compression = CDataFileWriter::COMPRESSION_FAST;
+		else if(str_comp(argv[Arg], "-store") == 0)
+			Compression = CDataFileWriter::COMPRESSION_NONE;
+		else if(str_comp(argv[Arg], "-j") == 0 && Arg+1 < argc)
+			NumThreads = str_toint(argv[++Arg]);
+		else
+			break;
+	}
+	if(argc-Arg != 2)
+	{
+		dbg_msg("map_resave", "usage: map_resave [-fast|-store] [-j <threads>] <source map|directory> <destination map|directory>");
+		return -1;
+	}
+	const char *pSource = argv[Arg];
+	const char *pDest = argv[Arg+1];
+
+	if(!pStorage)
+		return -1;
+
+	// maps are resaved on the pool, their data is compressed on it as well
+	CJobPool Pool;
+	Pool.Init(NumThreads);
+
+	CMapList List;
+	pStorage->ListDirectory(IStorage::TYPE_ALL, pSource, AddMapCallback, &List);
+	if(List.m_aNames.empty())
+	{
+		CResaveResult Result = ResaveMap(pStorage, pSource, pDest, Compression, &Pool);
+		PrintResult(pSource, Result);
+		return Result.m_Success ? 0 : -1;
+	}
+
+	pStorage->CreateFolder(pDest, IStorage::TYPE_SAVE);
+	dbg_msg("map_resave", "resaving %d maps on %d threads", (int)List.m_aNames.size(), Pool.NumThreads());
+	int64 StartTime = time_get();
+
+	std::vector<CJobPool::CFuture<CResaveResult> > aResults;
+	for(unsigned i = 0; i < List.m_aNames.size(); i++)
+	{
+		std::string Source = std::string(pSource) + "/" + List.m_aNames[i];
+		std::string Dest = std::string(pDest) + "/" + List.m_aNames[i];
+		aResults.push_back(Pool.Submit([pStorage, Source, Dest, Compression, &Pool]() {
+			return ResaveMap(pStorage, Source.c_str(), Dest.c_str(), Compression, &Pool);
+		}));
+	}
+
+	int NumFailed = 0;
+	int64 SourceSize = 0, DestSize = 0;
+	for(unsigned i = 0; i < aResults.size(); i++)
+	{
+		CResaveResult Result = aResults[i].Get();
+		PrintResult(List.m_aNames[i].c_str(), Result);
+		if(!Result.m_Success)
+			NumFailed++;
+		SourceSize += Result.m_SourceSize;
+		DestSize += Result.m_DestSize;
+	}
+
+	dbg_msg("map_resave", "%d maps, %d failed: %lld -> %lld bytes, %.2f ms", (int)aResults.size(), NumFailed,
+		SourceSize, DestSize, (time_get()-StartTime)*1000.0f/time_freq());
+	return NumFailed ? -1 : 0;
+}
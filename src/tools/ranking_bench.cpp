@@ -0,0 +1,226 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <game/server/gamemodes/zcatch/rankingserver.h>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	Mixed read/write load against a synthetic sqlite ranking database.
+
+	Lookup threads alternate between /rank and /top queries, update
+	threads add round results to random players, both as fast as they
+	can. The locking is the same as in the asynchronous interface the
+	game server uses.
+*/
+
+class CBenchRankingServer : public CSQLiteRankingServer
+{
+public:
+	CBenchRankingServer(const char *pFilename, CSQLiteSettings Settings) :
+		CSQLiteRankingServer(pFilename, {""}, 10000, false, Settings)
+	{
+	}
+
+	bool IsAvailable() const { return !m_DefaultConstructed; }
+
+	CPlayerStats GetRanking(const std::string &Nickname)
+	{
+		std::unique_lock<std::mutex> Lock(m_DatabaseMutex, std::defer_lock);
+		if(!m_ConcurrentReads)
+			Lock.lock();
+		return GetRankingSync(Nickname, "");
+	}
+
+	key_stats_vec_t GetTopRanking(int Num)
+	{
+		std::unique_lock<std::mutex> Lock(m_DatabaseMutex, std::defer_lock);
+		if(!m_ConcurrentReads)
+			Lock.lock();
+		return GetTopRankingSync(Num, "Score", "", true);
+	}
+
+	void UpdateRanking(const std::string &Nickname, const CPlayerStats &Stats)
+	{
+		std::lock_guard<std::mutex> Lock(m_DatabaseMutex);
+		UpdateRankingSync(Nickname, Stats, "");
+	}
+};
+
+static std::string PlayerName(int Index)
+{
+	char aName[32];
+	str_format(aName, sizeof(aName), "player %d", Index);
+	return aName;
+}
+
+static void Fill(CBenchRankingServer *pServer, int NumPlayers)
+{
+	int Existing = pServer->CountRankings("");
+	if(Existing >= NumPlayers)
+		return;
+
+	dbg_msg("ranking_bench", "adding %d players", NumPlayers-Existing);
+	std::mt19937 Rand(NumPlayers);
+	IRankingServer::key_stats_vec_t Batch;
+	pServer->BeginBulkImport("");
+	for(int i = Existing; i < NumPlayers; i++)
+	{
+		int Kills = Rand()%20000;
+		int Deaths = Rand()%20000;
+		Batch.emplace_back(PlayerName(i), CPlayerStats(Kills, Deaths, Rand()%1000000, Rand()%5000000, Rand()%100000,
+			Kills*3-Deaths, Rand()%500, Rand()%500, Kills*4+Rand()%1000));
+		if(Batch.size() == 10000 || i == NumPlayers-1)
+		{
+			pServer->ImportRankings(Batch, "");
+			Batch.clear();
+		}
+	}
+	pServer->EndBulkImport("");
+}
+
+struct CLatencies
+{
+	std::vector<int64> m_aTimes;
+
+	void Print(const char *pName, double Seconds)
+	{
+		if(m_aTimes.empty())
+			return;
+		std::sort(m_aTimes.begin(), m_aTimes.end());
+		double Freq = time_freq()/1000000.0;
+		dbg_msg("ranking_bench", "%-8s %8d ops %9.0f/s  p50 %7.0fus  p99 %7.0fus  max %7.0fus", pName, (int)m_aTimes.size(),
+			m_aTimes.size()/Seconds, m_aTimes[m_aTimes.size()/2]/Freq, m_aTimes[m_aTimes.size()*99/100]/Freq, m_aTimes.back()/Freq);
+	}
+};
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+
+	const char *pFilename = "ranking_bench.db";
+	int NumPlayers = 1000000;
+	int NumLookupThreads = 8;
+	int NumUpdateThreads = 1;
+	int Seconds = 10;
+	CSQLiteSettings Settings;
+
+	for(int i = 1; i < argc; i++) // ignore_convention
+	{
+		if(str_comp(argv[i], "-n") == 0 && i+1 < argc) // ignore_convention
+			NumPlayers = max(str_toint(argv[++i]), 1); // ignore_convention
+		else if(str_comp(argv[i], "-l") == 0 && i+1 < argc) // ignore_convention
+			NumLookupThreads = clamp(str_toint(argv[++i]), 0, 64); // ignore_convention
+		else if(str_comp(argv[i], "-u") == 0 && i+1 < argc) // ignore_convention
+			NumUpdateThreads = clamp(str_toint(argv[++i]), 0, 64); // ignore_convention
+		else if(str_comp(argv[i], "-t") == 0 && i+1 < argc) // ignore_convention
+			Seconds = max(str_toint(argv[++i]), 1); // ignore_convention
+		else if(str_comp(argv[i], "-r") == 0 && i+1 < argc) // ignore_convention
+			Settings.m_NumReaders = clamp(str_toint(argv[++i]), 0, 64); // ignore_convention
+		else if(str_comp(argv[i], "-s") == 0 && i+1 < argc) // ignore_convention
+			Settings.m_Synchronous = clamp(str_toint(argv[++i]), 0, 2); // ignore_convention
+		else if(str_comp(argv[i], "-c") == 0 && i+1 < argc) // ignore_convention
+			Settings.m_CacheSizeKiB = max(str_toint(argv[++i]), 256); // ignore_convention
+		else if(str_comp(argv[i], "-nowal") == 0) // ignore_convention
+			Settings.m_WriteAheadLog = false;
+		else if(argv[i][0] != '-') // ignore_convention
+			pFilename = argv[i]; // ignore_convention
+		else
+		{
+			dbg_msg("ranking_bench", "usage: ranking_bench [-n players] [-l lookup threads] [-u update threads] [-t seconds]");
+			dbg_msg("ranking_bench", "                     [-r read connections] [-s synchronous] [-c cache KiB] [-nowal] [database]");
+			return -1;
+		}
+	}
+
+	CBenchRankingServer Server(pFilename, Settings);
+	if(!Server.IsAvailable())
+		return -1;
+	Fill(&Server, NumPlayers);
+
+	dbg_msg("ranking_bench", "%d players, %d lookup and %d update threads, %d read connections, %s, synchronous %d, %d KiB cache",
+		NumPlayers, NumLookupThreads, NumUpdateThreads, Settings.m_NumReaders, Settings.m_WriteAheadLog ? "wal" : "no wal",
+		Settings.m_Synchronous, Settings.m_CacheSizeKiB);
+
+	std::atomic<bool> Stop(false);
+	std::atomic<int> NumErrors(0);
+	std::vector<CLatencies> aRank(NumLookupThreads);
+	std::vector<CLatencies> aTop(NumLookupThreads);
+	std::vector<CLatencies> aUpdate(NumUpdateThreads);
+	std::vector<std::thread> Threads;
+
+	for(int t = 0; t < NumLookupThreads; t++)
+	{
+		Threads.emplace_back([&, t]() {
+			std::mt19937 Rand(t);
+			for(int i = 0; !Stop; i++)
+			{
+				int64 Start = time_get();
+				try
+				{
+					// most lookups are /rank, every few is a /top
+					if(i%8 == 7)
+					{
+						Server.GetTopRanking(5);
+						aTop[t].m_aTimes.push_back(time_get()-Start);
+					}
+					else
+					{
+						Server.GetRanking(PlayerName(Rand()%NumPlayers));
+						aRank[t].m_aTimes.push_back(time_get()-Start);
+					}
+				}
+				catch(const std::exception &)
+				{
+					NumErrors++;
+				}
+			}
+		});
+	}
+	for(int t = 0; t < NumUpdateThreads; t++)
+	{
+		Threads.emplace_back([&, t]() {
+			std::mt19937 Rand(1000+t);
+			while(!Stop)
+			{
+				int64 Start = time_get();
+				try
+				{
+					CPlayerStats Stats(Rand()%10, Rand()%10, Rand()%3000, 6000, 0, Rand()%30, Rand()%2, 0, Rand()%40);
+					Server.UpdateRanking(PlayerName(Rand()%NumPlayers), Stats);
+					aUpdate[t].m_aTimes.push_back(time_get()-Start);
+				}
+				catch(const std::exception &)
+				{
+					NumErrors++;
+				}
+			}
+		});
+	}
+
+	int64 StartTime = time_get();
+	thread_sleep(Seconds*1000);
+	Stop = true;
+	for(auto &Thread : Threads)
+		Thread.join();
+	double Elapsed = (time_get()-StartTime)/(double)time_freq();
+
+	CLatencies Rank, Top, Update;
+	for(auto &Latencies : aRank)
+		Rank.m_aTimes.insert(Rank.m_aTimes.end(), Latencies.m_aTimes.begin(), Latencies.m_aTimes.end());
+	for(auto &Latencies : aTop)
+		Top.m_aTimes.insert(Top.m_aTimes.end(), Latencies.m_aTimes.begin(), Latencies.m_aTimes.end());
+	for(auto &Latencies : aUpdate)
+		Update.m_aTimes.insert(Update.m_aTimes.end(), Latencies.m_aTimes.begin(), Latencies.m_aTimes.end());
+
+	Rank.Print("rank", Elapsed);
+	Top.Print("top", Elapsed);
+	Update.Print("update", Elapsed);
+	if(NumErrors)
+		dbg_msg("ranking_bench", "%d queries failed", NumErrors.load());
+	return NumErrors ? 1 : 0;
+}
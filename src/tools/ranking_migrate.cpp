@@ -0,0 +1,290 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <game/server/gamemodes/zcatch/rankingserver.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	Copies the rankings of all given prefixes from one database into
+	another one, e.g. from redis to sqlite or from an sqlite database
+	with old fields into a new one with the current fields.
+
+	Every prefix is read by several reader threads with their own
+	connections in large batches, a single writer inserts the batches
+	with one transaction or pipeline each while the indices of the
+	target are not maintained. At the end the number of players and a
+	checksum over all of them is compared.
+*/
+
+struct CEndpoint
+{
+	bool m_Redis;
+	std::string m_Path;
+	std::string m_Host;
+	size_t m_Port;
+};
+
+static bool ParseEndpoint(const char *pStr, CEndpoint *pEndpoint)
+{
+	std::string Str = pStr;
+	if(Str.compare(0, 7, "sqlite:") == 0 && Str.size() > 7)
+	{
+		pEndpoint->m_Redis = false;
+		pEndpoint->m_Path = Str.substr(7);
+		return true;
+	}
+	else if(Str.compare(0, 6, "redis:") == 0)
+	{
+		std::string Address = Str.substr(6);
+		size_t Colon = Address.rfind(':');
+		pEndpoint->m_Redis = true;
+		pEndpoint->m_Host = Address.substr(0, Colon);
+		pEndpoint->m_Port = Colon == std::string::npos ? 6379 : str_toint(Address.c_str()+Colon+1);
+		return !pEndpoint->m_Host.empty() && pEndpoint->m_Port > 0;
+	}
+	return false;
+}
+
+static IRankingServer *CreateRankingServer(const CEndpoint &Endpoint, const std::vector<std::string> &Prefixes, bool Source)
+{
+	if(Endpoint.m_Redis)
+		return new CRedisRankingServer{Endpoint.m_Host, Endpoint.m_Port};
+
+	// every reader thread has its own instance, none of them needs a pool of read connections
+	CSQLiteSettings Settings;
+	Settings.m_NumReaders = 0;
+	return new CSQLiteRankingServer{Endpoint.m_Path, Prefixes, 10000, Source, Settings};
+}
+
+// order independent, so that parallel readers and different backends give the same result
+static uint64_t Checksum(const IRankingServer::key_stats_vec_t &Rankings)
+{
+	uint64_t Sum = 0;
+	for(auto &Entry : Rankings)
+	{
+		uint64_t Hash = 14695981039346656037ull;
+		for(char c : Entry.first)
+			Hash = (Hash^(unsigned char)c)*1099511628211ull;
+		for(auto &Field : Entry.second.m_Data)
+			Hash = (Hash^(uint32_t)Field.second)*1099511628211ull;
+		Sum += Hash;
+	}
+	return Sum;
+}
+
+class CMigration
+{
+	const CEndpoint *m_pSource;
+	const std::vector<std::string> *m_pPrefixes;
+	int m_NumReaders;
+	size_t m_BatchSize;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Cond;
+	std::deque<IRankingServer::key_stats_vec_t> m_Batches;
+	int m_RunningReaders;
+	bool m_Abort;
+	std::string m_Error;
+
+	std::atomic<uint64_t> m_Checksum;
+	std::atomic<size_t> m_NumRead;
+
+	void Fail(const std::string &Error)
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		if(m_Error.empty())
+			m_Error = Error;
+		m_Abort = true;
+		m_Cond.notify_all();
+	}
+
+	void Reader(std::string Prefix, int Part)
+	{
+		IRankingServer *pSource = CreateRankingServer(*m_pSource, *m_pPrefixes, true);
+		try
+		{
+			pSource->ExportRankings(Prefix, Part, m_NumReaders, m_BatchSize, [this](IRankingServer::key_stats_vec_t &Batch) {
+				m_Checksum += Checksum(Batch);
+				m_NumRead += Batch.size();
+
+				// don't read the whole database into memory if the writer is slower
+				std::unique_lock<std::mutex> Lock(m_Mutex);
+				m_Cond.wait(Lock, [this] { return m_Abort || (int)m_Batches.size() < m_NumReaders*2; });
+				if(m_Abort)
+					throw std::runtime_error("aborted");
+				m_Batches.emplace_back();
+				m_Batches.back().swap(Batch);
+				m_Cond.notify_all();
+			});
+		}
+		catch(const std::exception &e)
+		{
+			Fail(std::string("reading failed: ") + e.what());
+		}
+		delete pSource;
+
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_RunningReaders--;
+		m_Cond.notify_all();
+	}
+
+public:
+	CMigration(const CEndpoint *pSource, const std::vector<std::string> *pPrefixes, int NumReaders, size_t BatchSize) :
+		m_pSource(pSource), m_pPrefixes(pPrefixes), m_NumReaders(NumReaders), m_BatchSize(BatchSize)
+	{
+	}
+
+	bool Run(IRankingServer *pTarget, const std::string &Prefix, size_t *pNumRead, uint64_t *pChecksum)
+	{
+		m_Batches.clear();
+		m_RunningReaders = m_NumReaders;
+		m_Abort = false;
+		m_Error.clear();
+		m_Checksum = 0;
+		m_NumRead = 0;
+
+		std::vector<std::thread> Readers;
+		for(int i = 0; i < m_NumReaders; i++)
+			Readers.emplace_back(&CMigration::Reader, this, Prefix, i);
+
+		size_t NumWritten = 0;
+		while(true)
+		{
+			IRankingServer::key_stats_vec_t Batch;
+			{
+				std::unique_lock<std::mutex> Lock(m_Mutex);
+				m_Cond.wait(Lock, [this] { return m_Abort || !m_Batches.empty() || m_RunningReaders == 0; });
+				if(m_Abort || m_Batches.empty())
+					break;
+				Batch.swap(m_Batches.front());
+				m_Batches.pop_front();
+				m_Cond.notify_all();
+			}
+
+			try
+			{
+				pTarget->ImportRankings(Batch, Prefix);
+			}
+			catch(const std::exception &e)
+			{
+				Fail(std::string("writing failed: ") + e.what());
+				break;
+			}
+			NumWritten += Batch.size();
+			dbg_msg("ranking_migrate", "'%s': %d players written", Prefix.c_str(), (int)NumWritten);
+		}
+
+		for(auto &Reader : Readers)
+			Reader.join();
+
+		if(!m_Error.empty())
+		{
+			dbg_msg("ranking_migrate", "'%s': %s", Prefix.c_str(), m_Error.c_str());
+			return false;
+		}
+		*pNumRead = m_NumRead;
+		*pChecksum = m_Checksum;
+		return true;
+	}
+};
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+
+	int NumReaders = 4;
+	size_t BatchSize = 10000;
+	std::vector<std::string> Prefixes;
+	std::vector<CEndpoint> Endpoints;
+
+	for(int i = 1; i < argc; i++) // ignore_convention
+	{
+		CEndpoint Endpoint;
+		if(str_comp(argv[i], "-j") == 0 && i+1 < argc) // ignore_convention
+			NumReaders = clamp(str_toint(argv[++i]), 1, 64); // ignore_convention
+		else if(str_comp(argv[i], "-b") == 0 && i+1 < argc) // ignore_convention
+			BatchSize = clamp(str_toint(argv[++i]), 1, 1000000); // ignore_convention
+		else if(str_comp(argv[i], "-p") == 0 && i+1 < argc) // ignore_convention
+			Prefixes.push_back(argv[++i]); // ignore_convention
+		else if(ParseEndpoint(argv[i], &Endpoint)) // ignore_convention
+			Endpoints.push_back(Endpoint);
+		else
+			Endpoints.clear();
+	}
+
+	if(Endpoints.size() != 2)
+	{
+		dbg_msg("ranking_migrate", "usage: ranking_migrate [-j readers] [-b batch size] [-p prefix]... <from> <to>");
+		dbg_msg("ranking_migrate", "databases are given as sqlite:<file> or redis:<host>[:<port>]");
+		return -1;
+	}
+	if(Prefixes.empty())
+		Prefixes.push_back("");
+
+	IRankingServer *pTarget = CreateRankingServer(Endpoints[1], Prefixes, false);
+	IRankingServer *pSource = CreateRankingServer(Endpoints[0], Prefixes, true);
+	CMigration Migration(&Endpoints[0], &Prefixes, NumReaders, BatchSize);
+	int64 StartTime = time_get();
+	bool Success = true;
+
+	for(auto &Prefix : Prefixes)
+	{
+		size_t NumRead = 0;
+		uint64_t SourceChecksum = 0;
+		bool Migrated;
+		try
+		{
+			pTarget->BeginBulkImport(Prefix);
+			Migrated = Migration.Run(pTarget, Prefix, &NumRead, &SourceChecksum);
+			pTarget->EndBulkImport(Prefix);
+		}
+		catch(const std::exception &e)
+		{
+			dbg_msg("ranking_migrate", "'%s': preparing the target failed: %s", Prefix.c_str(), e.what());
+			Migrated = false;
+		}
+		if(!Migrated)
+		{
+			Success = false;
+			continue;
+		}
+
+		// verify what actually ended up in the target
+		size_t NumSource = 0;
+		size_t NumTarget = 0;
+		uint64_t TargetChecksum = 0;
+		try
+		{
+			NumSource = pSource->CountRankings(Prefix);
+			NumTarget = pTarget->CountRankings(Prefix);
+			pTarget->ExportRankings(Prefix, 0, 1, BatchSize, [&TargetChecksum](IRankingServer::key_stats_vec_t &Batch) {
+				TargetChecksum += Checksum(Batch);
+			});
+		}
+		catch(const std::exception &e)
+		{
+			dbg_msg("ranking_migrate", "'%s': verifying failed: %s", Prefix.c_str(), e.what());
+			Success = false;
+			continue;
+		}
+
+		bool Match = NumRead == NumSource && NumTarget == NumSource && TargetChecksum == SourceChecksum;
+		dbg_msg("ranking_migrate", "'%s': source %d, read %d, target %d players, checksum %016llx %s %016llx",
+			Prefix.c_str(), (int)NumSource, (int)NumRead, (int)NumTarget,
+			(unsigned long long)SourceChecksum, Match ? "==" : "!=", (unsigned long long)TargetChecksum);
+		Success &= Match;
+	}
+
+	dbg_msg("ranking_migrate", "%s after %.2fs", Success ? "done" : "failed", (time_get()-StartTime)/(double)time_freq());
+	delete pSource;
+	delete pTarget;
+	return Success ? 0 : 1;
+}
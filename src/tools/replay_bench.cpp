@@ -0,0 +1,539 @@
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/config.h>
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/server.h>
+#include <engine/storage.h>
+#include <engine/shared/config.h>
+#include <engine/shared/inputrecord.h>
+#include <engine/shared/packer.h>
+#include <engine/shared/protocol.h>
+#include <engine/shared/snapshot.h>
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+/*
+	Replays an input recording of a live server (see record_inputs)
+	into the game server, tick by tick and without any networking, to
+	measure the game simulation alone.
+
+	The game runs against a server that only keeps the state of the
+	recorded clients. Snapshots are built for every ingame client at
+	the recorded points in time but not sent anywhere. At the end the
+	hash of the game state is compared against the one of the live
+	server and of the other runs, so the same recording doubles as a
+	determinism test. The settings of the live server are part of the
+	recording, databases are never used.
+*/
+
+static int64 gs_NumAllocations = 0;
+
+void *operator new(size_t Size)
+{
+	gs_NumAllocations++;
+	void *pData = mem_alloc(Size ? Size : 1, 1);
+	if(!pData)
+		throw std::bad_alloc();
+	return pData;
+}
+
+void operator delete(void *pData) noexcept
+{
+	mem_free(pData);
+}
+
+void operator delete(void *pData, size_t Size) noexcept
+{
+	operator delete(pData);
+}
+
+class CReplayServer : public IServer
+{
+	enum
+	{
+		STATE_EMPTY=0,
+		STATE_READY,
+		STATE_INGAME,
+
+		MAX_IDS=16*1024,
+	};
+
+	struct CClient
+	{
+		int m_State;
+		char m_aName[MAX_NAME_LENGTH];
+		char m_aClan[MAX_CLAN_LENGTH];
+		int m_Country;
+		int m_Latency;
+		int m_Version;
+		bool m_HasInput;
+		int m_aInput[MAX_INPUT_SIZE];
+	};
+
+	IGameServer *m_pGameServer;
+	CClient m_aClients[MAX_CLIENTS];
+	CSnapshotBuilder m_SnapshotBuilder;
+	int m_aFreeIDs[MAX_IDS];
+	int m_NumFreeIDs;
+	int m_NextID;
+
+public:
+	int64 m_NumMessages;
+	int64 m_NumDiverged;
+
+	CReplayServer()
+	{
+		m_TickSpeed = SERVER_TICK_SPEED;
+		m_pGameServer = 0;
+		Reset();
+	}
+
+	void Init(IGameServer *pGameServer) { m_pGameServer = pGameServer; }
+
+	void Reset()
+	{
+		m_CurrentGameTick = 0;
+		m_LastMapChangeTick = 0;
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			mem_zero(&m_aClients[i], sizeof(m_aClients[i]));
+			m_aClients[i].m_Country = -1;
+		}
+		m_NumFreeIDs = 0;
+		m_NextID = 0;
+		m_NumMessages = 0;
+		m_NumDiverged = 0;
+	}
+
+	// feeds one record to the game, like the server did when recording
+	void Replay(const CInputRecord::CRecord *pRecord)
+	{
+		CClient *pClient = &m_aClients[pRecord->m_ClientID];
+		switch(pRecord->m_Type)
+		{
+		case CInputRecord::RECORD_TICK:
+			m_CurrentGameTick++;
+			for(int c = 0; c < MAX_CLIENTS; c++)
+			{
+				if(m_aClients[c].m_HasInput && m_aClients[c].m_State == STATE_INGAME)
+					m_pGameServer->OnClientPredictedInput(c, m_aClients[c].m_aInput);
+				m_aClients[c].m_HasInput = false;
+			}
+			m_pGameServer->OnTick();
+			break;
+		case CInputRecord::RECORD_CONNECT:
+			mem_zero(pClient, sizeof(*pClient));
+			pClient->m_State = STATE_READY;
+			pClient->m_Country = -1;
+			pClient->m_Version = pRecord->m_Version;
+			m_pGameServer->OnClientConnected(pRecord->m_ClientID, pRecord->m_Value);
+			break;
+		case CInputRecord::RECORD_ENTER:
+			if(pClient->m_State != STATE_READY || !m_pGameServer->IsClientReady(pRecord->m_ClientID))
+			{
+				m_NumDiverged++;
+				break;
+			}
+			pClient->m_State = STATE_INGAME;
+			m_pGameServer->OnClientEnter(pRecord->m_ClientID);
+			break;
+		case CInputRecord::RECORD_DROP:
+			// the game may have kicked the client already
+			Drop(pRecord->m_ClientID, (const char *)pRecord->m_pData);
+			break;
+		case CInputRecord::RECORD_MESSAGE:
+			if(pClient->m_State >= STATE_READY)
+			{
+				CUnpacker Unpacker;
+				Unpacker.Reset(pRecord->m_pData, pRecord->m_DataSize);
+				int Msg = Unpacker.GetInt();
+				if(!Unpacker.Error() && !(Msg&1))
+					m_pGameServer->OnMessage(Msg>>1, &Unpacker, pRecord->m_ClientID);
+			}
+			break;
+		case CInputRecord::RECORD_INPUT:
+			mem_copy(pClient->m_aInput, pRecord->m_pInput, sizeof(pClient->m_aInput));
+			pClient->m_HasInput = true;
+			break;
+		case CInputRecord::RECORD_DIRECT_INPUT:
+			if(pClient->m_State == STATE_INGAME)
+			{
+				int aInput[MAX_INPUT_SIZE];
+				mem_copy(aInput, pRecord->m_pInput, sizeof(aInput));
+				m_pGameServer->OnClientDirectInput(pRecord->m_ClientID, aInput);
+			}
+			break;
+		case CInputRecord::RECORD_LATENCY:
+			pClient->m_Latency = pRecord->m_Value;
+			break;
+		}
+	}
+
+	void DoSnapshot(bool BuildSnapshots)
+	{
+		static char s_aData[CSnapshot::MAX_SIZE];
+		m_pGameServer->OnPreSnap();
+		for(int i = 0; BuildSnapshots && i < MAX_CLIENTS; i++)
+		{
+			if(m_aClients[i].m_State != STATE_INGAME)
+				continue;
+			m_SnapshotBuilder.Init();
+			m_pGameServer->OnSnap(i);
+			m_SnapshotBuilder.Finish(s_aData);
+		}
+		m_pGameServer->OnPostSnap();
+	}
+
+	unsigned GameStateHash()
+	{
+		static char s_aData[CSnapshot::MAX_SIZE];
+		m_SnapshotBuilder.Init();
+		m_pGameServer->OnSnap(-1);
+		m_SnapshotBuilder.Finish(s_aData);
+		return CInputRecord::StateHash((CSnapshot *)s_aData);
+	}
+
+	void Drop(int ClientID, const char *pReason)
+	{
+		if(m_aClients[ClientID].m_State == STATE_EMPTY)
+			return;
+		m_pGameServer->OnClientDrop(ClientID, pReason);
+		m_aClients[ClientID].m_State = STATE_EMPTY;
+	}
+
+	int MaxClients() const { return g_Config.m_SvMaxClients; }
+
+	const char *ClientName(int ClientID) const
+	{
+		if(ClientID < 0 || ClientID >= MAX_CLIENTS || m_aClients[ClientID].m_State == STATE_EMPTY)
+			return "(invalid)";
+		return m_aClients[ClientID].m_State == STATE_INGAME ? m_aClients[ClientID].m_aName : "(connecting)";
+	}
+
+	const char *ClientClan(int ClientID) const
+	{
+		return ClientIngame(ClientID) ? m_aClients[ClientID].m_aClan : "";
+	}
+
+	int ClientCountry(int ClientID) const
+	{
+		return ClientIngame(ClientID) ? m_aClients[ClientID].m_Country : -1;
+	}
+
+	bool ClientIngame(int ClientID) const
+	{
+		return ClientID >= 0 && ClientID < MAX_CLIENTS && m_aClients[ClientID].m_State == STATE_INGAME;
+	}
+
+	int GetClientInfo(int ClientID, CClientInfo *pInfo) const
+	{
+		if(!ClientIngame(ClientID))
+			return 0;
+		pInfo->m_pName = m_aClients[ClientID].m_aName;
+		pInfo->m_Latency = m_aClients[ClientID].m_Latency;
+		return 1;
+	}
+
+	// the addresses aren't recorded, every client gets its own one
+	void GetClientAddr(int ClientID, char *pAddrStr, int Size, bool Port) const
+	{
+		if(ClientIngame(ClientID))
+			str_format(pAddrStr, Size, Port ? "10.0.%d.%d:8303" : "10.0.%d.%d", ClientID/256, ClientID%256);
+	}
+
+	bool GetClientAddr(int ClientID, NETADDR *pAddr) const
+	{
+		if(!ClientIngame(ClientID))
+			return false;
+		mem_zero(pAddr, sizeof(*pAddr));
+		pAddr->type = NETTYPE_IPV4;
+		pAddr->ip[0] = 10;
+		pAddr->ip[2] = ClientID/256;
+		pAddr->ip[3] = ClientID%256;
+		pAddr->port = 8303;
+		return true;
+	}
+
+	int GetClientVersion(int ClientID) const
+	{
+		return ClientIngame(ClientID) ? m_aClients[ClientID].m_Version : 0;
+	}
+
+	int SendMsg(CMsgPacker *pMsg, int Flags, int ClientID)
+	{
+		m_NumMessages++;
+		return 0;
+	}
+
+	void SetClientName(int ClientID, const char *pName)
+	{
+		if(ClientID >= 0 && ClientID < MAX_CLIENTS && m_aClients[ClientID].m_State != STATE_EMPTY && pName && pName[0])
+			str_copy(m_aClients[ClientID].m_aName, pName, sizeof(m_aClients[ClientID].m_aName));
+	}
+
+	void SetClientClan(int ClientID, const char *pClan)
+	{
+		if(ClientID >= 0 && ClientID < MAX_CLIENTS && m_aClients[ClientID].m_State != STATE_EMPTY && pClan)
+			str_copy(m_aClients[ClientID].m_aClan, pClan, sizeof(m_aClients[ClientID].m_aClan));
+	}
+
+	void SetClientCountry(int ClientID, int Country)
+	{
+		if(ClientID >= 0 && ClientID < MAX_CLIENTS && m_aClients[ClientID].m_State != STATE_EMPTY)
+			m_aClients[ClientID].m_Country = Country;
+	}
+
+	void SetClientScore(int ClientID, int Score) {}
+
+	int SnapNewID()
+	{
+		if(m_NumFreeIDs)
+			return m_aFreeIDs[--m_NumFreeIDs];
+		dbg_assert(m_NextID < MAX_IDS, "id error");
+		return m_NextID++;
+	}
+
+	void SnapFreeID(int ID)
+	{
+		if(m_NumFreeIDs < MAX_IDS)
+			m_aFreeIDs[m_NumFreeIDs++] = ID;
+	}
+
+	void *SnapNewItem(int Type, int ID, int Size)
+	{
+		dbg_assert(Type >= 0 && Type <= 0xffff, "incorrect type");
+		dbg_assert(ID >= 0 && ID <= 0xffff, "incorrect id");
+		return ID < 0 ? 0 : m_SnapshotBuilder.NewItem(Type, ID, Size);
+	}
+
+	void SnapSetStaticsize(int ItemType, int Size) {}
+
+	void SetRconCID(int ClientID) {}
+	bool IsAuthed(int ClientID) const { return false; }
+	bool IsBanned(int ClientID) { return false; }
+	void Kick(int ClientID, const char *pReason) { Drop(ClientID, pReason); }
+
+	void AddVoteban(int ClientID, int Time) {}
+	int ClientVotebannedTime(int ClientID) { return 0; }
+
+	void DemoRecorder_HandleAutoStart() {}
+	bool DemoRecorder_IsRecording() { return false; }
+	void DemoRecorder_HandleRoundEnd(int StartTick, const char *pWinner, int Catches) {}
+};
+
+struct CRunResult
+{
+	int m_NumTicks;
+	int m_NumSnapshots;
+	unsigned m_StateHash;
+	bool m_HasStateHash;
+	int64 m_TickTime;
+	int64 m_SnapTime;
+	int64 m_NumAllocations;
+	std::vector<int64> m_aTickTimes;
+};
+
+static bool Run(IKernel *pKernel, CReplayServer *pServer, IGameServer *pGameServer, CInputPlayer *pPlayer, bool BuildSnapshots, unsigned *pExpectedHash, bool *pHasExpectedHash, CRunResult *pResult)
+{
+	pServer->Reset();
+	pPlayer->Rewind();
+	// the game context reconstructs itself on shutdown, like on a map change
+	pKernel->ReregisterInterface(pGameServer);
+	pGameServer->OnInit();
+
+	pResult->m_NumTicks = 0;
+	pResult->m_NumSnapshots = 0;
+	pResult->m_HasStateHash = false;
+	pResult->m_TickTime = 0;
+	pResult->m_SnapTime = 0;
+	pResult->m_aTickTimes.clear();
+	*pHasExpectedHash = false;
+	int64 StartAllocations = gs_NumAllocations;
+
+	CInputRecord::CRecord Record;
+	int Result;
+	while((Result = pPlayer->NextRecord(&Record)) > 0)
+	{
+		if(Record.m_Type == CInputRecord::RECORD_TICK)
+		{
+			int64 Start = time_get();
+			pServer->Replay(&Record);
+			int64 Time = time_get()-Start;
+			pResult->m_TickTime += Time;
+			pResult->m_aTickTimes.push_back(Time);
+			pResult->m_NumTicks++;
+		}
+		else if(Record.m_Type == CInputRecord::RECORD_SNAP)
+		{
+			int64 Start = time_get();
+			pServer->DoSnapshot(BuildSnapshots);
+			pResult->m_SnapTime += time_get()-Start;
+			pResult->m_NumSnapshots++;
+		}
+		else if(Record.m_Type == CInputRecord::RECORD_END)
+		{
+			*pExpectedHash = (unsigned)Record.m_Value;
+			*pHasExpectedHash = true;
+			break;
+		}
+		else
+			pServer->Replay(&Record);
+	}
+
+	pResult->m_StateHash = pServer->GameStateHash();
+	pResult->m_HasStateHash = true;
+	pResult->m_NumAllocations = gs_NumAllocations-StartAllocations;
+	pGameServer->OnShutdown();
+	return Result >= 0;
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+
+	int NumRuns = 3;
+	bool BuildSnapshots = true;
+	const char *pFilename = 0;
+	const char *pMap = 0;
+
+	for(int i = 1; i < argc; i++) // ignore_convention
+	{
+		if(str_comp(argv[i], "-runs") == 0 && i+1 < argc) // ignore_convention
+			NumRuns = clamp(str_toint(argv[++i]), 1, 1000); // ignore_convention
+		else if(str_comp(argv[i], "-map") == 0 && i+1 < argc) // ignore_convention
+			pMap = argv[++i]; // ignore_convention
+		else if(str_comp(argv[i], "-nosnap") == 0) // ignore_convention
+			BuildSnapshots = false;
+		else if(argv[i][0] != '-' && !pFilename) // ignore_convention
+			pFilename = argv[i]; // ignore_convention
+		else
+		{
+			pFilename = 0;
+			break;
+		}
+	}
+
+	if(!pFilename)
+	{
+		dbg_msg("replay_bench", "usage: replay_bench [-runs n] [-map map name] [-nosnap] <input recording>");
+		return -1;
+	}
+
+	IKernel *pKernel = IKernel::Create();
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv); // ignore_convention
+	IConsole *pConsole = CreateConsole(CFGFLAG_SERVER);
+	IConfig *pConfig = CreateConfig();
+	IEngineMap *pEngineMap = CreateEngineMap();
+	IGameServer *pGameServer = CreateGameServer();
+	CReplayServer *pServer = new CReplayServer;
+	pServer->Init(pGameServer);
+
+	bool RegisterFail = !pStorage;
+	RegisterFail = RegisterFail || !pKernel->RegisterInterface(pStorage);
+	RegisterFail = RegisterFail || !pKernel->RegisterInterface(pConsole);
+	RegisterFail = RegisterFail || !pKernel->RegisterInterface(pConfig);
+	RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IEngineMap*>(pEngineMap)); // register as both
+	RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IMap*>(pEngineMap));
+	RegisterFail = RegisterFail || !pKernel->RegisterInterface(static_cast<IServer*>(pServer));
+	RegisterFail = RegisterFail || !pKernel->RegisterInterface(pGameServer);
+	if(RegisterFail)
+		return -1;
+
+	pConfig->Init(CFGFLAG_SERVER);
+	pGameServer->OnConsoleInit();
+
+	CInputPlayer Player;
+	if(Player.Load(pStorage, pFilename, IStorage::TYPE_ALL) != 0)
+		return -1;
+	const CInputRecord::CHeader *pHeader = Player.Header();
+
+	// the settings of the live server, line by line
+	for(char *pLine = pHeader->m_pConfig; *pLine; )
+	{
+		char *pEnd = (char *)str_find(pLine, "\n");
+		if(pEnd)
+			*pEnd = 0;
+		pConsole->ExecuteLine(pLine);
+		if(!pEnd)
+			break;
+		*pEnd = '\n';
+		pLine = pEnd+1;
+	}
+	pConfig->RestoreStrings();
+	g_Config.m_SvDatabaseType[0] = 0;
+	g_Config.m_DbgDummies = 0;
+
+	char aMapFilename[128];
+	str_format(aMapFilename, sizeof(aMapFilename), "maps/%s.map", pMap ? pMap : pHeader->m_aMap);
+	if(!pEngineMap->Load(aMapFilename, pStorage))
+	{
+		dbg_msg("replay_bench", "could not load map '%s'", aMapFilename);
+		return -1;
+	}
+	if(pEngineMap->Crc() != pHeader->m_MapCrc)
+		dbg_msg("replay_bench", "warning: '%s' is not the recorded map, crc %08x instead of %08x", aMapFilename, pEngineMap->Crc(), pHeader->m_MapCrc);
+
+	dbg_msg("replay_bench", "replaying '%s' on %s, %d runs%s", pFilename, pHeader->m_aMap, NumRuns, BuildSnapshots ? "" : " without snapshots");
+
+	unsigned ExpectedHash = 0;
+	bool HasExpectedHash = false;
+	unsigned FirstHash = 0;
+	bool Deterministic = true;
+	bool Broken = false;
+	CRunResult Result;
+	std::vector<int64> aAllTickTimes;
+	for(int r = 0; r < NumRuns; r++)
+	{
+		if(!Run(pKernel, pServer, pGameServer, &Player, BuildSnapshots, &ExpectedHash, &HasExpectedHash, &Result))
+		{
+			dbg_msg("replay_bench", "the recording is broken after %d ticks", Result.m_NumTicks);
+			Broken = true;
+		}
+		if(!Result.m_NumTicks)
+		{
+			dbg_msg("replay_bench", "the recording has no ticks");
+			return -1;
+		}
+
+		dbg_msg("replay_bench", "run %d: %d ticks  %8.0f ns/tick  %8.0f ns/snapshot  %6.2f allocations/tick  state %08x%s",
+			r, Result.m_NumTicks, Result.m_TickTime*1000000000.0/time_freq()/Result.m_NumTicks,
+			Result.m_NumSnapshots ? Result.m_SnapTime*1000000000.0/time_freq()/Result.m_NumSnapshots : 0.0,
+			(double)Result.m_NumAllocations/Result.m_NumTicks, Result.m_StateHash, pServer->m_NumDiverged ? "  diverged" : "");
+
+		if(r == 0)
+			FirstHash = Result.m_StateHash;
+		else if(Result.m_StateHash != FirstHash)
+			Deterministic = false;
+		aAllTickTimes.insert(aAllTickTimes.end(), Result.m_aTickTimes.begin(), Result.m_aTickTimes.end());
+	}
+
+	std::sort(aAllTickTimes.begin(), aAllTickTimes.end());
+	double Freq = time_freq()/1000000000.0;
+	dbg_msg("replay_bench", "tick      p50 %8.0f ns  p99 %8.0f ns  max %8.0f ns", aAllTickTimes[aAllTickTimes.size()/2]/Freq,
+		aAllTickTimes[aAllTickTimes.size()*99/100]/Freq, aAllTickTimes.back()/Freq);
+
+	bool Success = Deterministic && !Broken;
+	if(!Deterministic)
+		dbg_msg("replay_bench", "the runs ended in different states");
+	if(HasExpectedHash)
+	{
+		bool Match = FirstHash == ExpectedHash;
+		dbg_msg("replay_bench", "state %08x %s %08x of the live server", FirstHash, Match ? "==" : "!=", ExpectedHash);
+		Success &= Match;
+	}
+	else
+		dbg_msg("replay_bench", "the recording wasn't stopped, there is no state to compare with");
+
+	delete pServer;
+	delete pGameServer;
+	delete pEngineMap;
+	delete pConfig;
+	delete pConsole;
+	delete pStorage;
+	delete pKernel;
+	return Success ? 0 : 1;
+}
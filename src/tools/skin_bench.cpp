@@ -0,0 +1,149 @@
+/* (c) Magnus Auvinen. See licence.txt in the root of the distribution for more information. */
+/* If you are missing that file, acquire a complete release at teeworlds.com.                */
+#include <base/math.h>
+#include <base/system.h>
+#include <engine/client/image.h>
+#include <engine/shared/jobs.h>
+#include <engine/storage.h>
+
+#include <string>
+#include <vector>
+
+/*
+	Measures the decode stage of the client's startup loading: the
+	pngs of the skin part directories (or the given directories) are
+	decoded once on this thread and once on a job pool, the way the
+	client does it before uploading the textures. No graphics are
+	needed, the images are freed right after decoding.
+*/
+
+static const char *s_apSkinPartDirs[] = {"skins/body", "skins/marking", "skins/decoration", "skins/hands", "skins/feet", "skins/eyes"};
+
+struct CImageFile
+{
+	std::string m_Path;
+	int m_StorageType;
+};
+
+struct CScanContext
+{
+	const char *m_pDir;
+	std::vector<CImageFile> *m_paFiles;
+};
+
+static int ImageScan(const char *pName, int IsDir, int StorageType, void *pUser)
+{
+	CScanContext *pContext = (CScanContext *)pUser;
+	if(IsDir || !str_endswith(pName, ".png"))
+		return 0;
+
+	CImageFile File;
+	File.m_Path = std::string(pContext->m_pDir) + "/" + pName;
+	File.m_StorageType = StorageType;
+	pContext->m_paFiles->push_back(File);
+	return 0;
+}
+
+// returns the size of the decoded pixels
+static int64 DecodeImage(IStorage *pStorage, const CImageFile &File)
+{
+	CImageInfo Info;
+	if(!DecodePNG(&Info, pStorage, File.m_Path.c_str(), File.m_StorageType))
+		return 0;
+	int64 Size = (int64)Info.m_Width*Info.m_Height*(Info.m_Format == CImageInfo::FORMAT_RGBA ? 4 : 3);
+	mem_free(Info.m_pData);
+	return Size;
+}
+
+static void PrintRun(const char *pName, int64 Time, int64 Size, int64 SerialTime)
+{
+	double Ms = Time*1000.0/time_freq();
+	dbg_msg("skin_bench", "%-8s %8.2f ms  %7.1f MiB/s  %5.2fx", pName, Ms,
+		Size/(1024.0*1024.0)/max(Ms/1000.0, 0.000001), SerialTime/(double)max(Time, (int64)1));
+}
+
+int main(int argc, const char **argv) // ignore_convention
+{
+	dbg_logger_stdout();
+
+	int NumThreads = 0;
+	int NumRuns = 5;
+	std::vector<const char *> apDirs;
+	for(int i = 1; i < argc; i++) // ignore_convention
+	{
+		if(str_comp(argv[i], "-j") == 0 && i+1 < argc) // ignore_convention
+			NumThreads = max(str_toint(argv[++i]), 1); // ignore_convention
+		else if(str_comp(argv[i], "-r") == 0 && i+1 < argc) // ignore_convention
+			NumRuns = max(str_toint(argv[++i]), 1); // ignore_convention
+		else if(argv[i][0] != '-') // ignore_convention
+			apDirs.push_back(argv[i]); // ignore_convention
+		else
+		{
+			dbg_msg("skin_bench", "usage: skin_bench [-j threads] [-r runs] [directory...]");
+			return -1;
+		}
+	}
+	if(apDirs.empty())
+		apDirs.assign(s_apSkinPartDirs, s_apSkinPartDirs+sizeof(s_apSkinPartDirs)/sizeof(s_apSkinPartDirs[0]));
+
+	IStorage *pStorage = CreateStorage("Teeworlds", IStorage::STORAGETYPE_BASIC, argc, argv); // ignore_convention
+	if(!pStorage)
+		return -1;
+
+	std::vector<CImageFile> aFiles;
+	for(unsigned i = 0; i < apDirs.size(); i++)
+	{
+		CScanContext Context = {apDirs[i], &aFiles};
+		pStorage->ListDirectory(IStorage::TYPE_ALL, apDirs[i], ImageScan, &Context);
+	}
+	if(aFiles.empty())
+	{
+		dbg_msg("skin_bench", "no images found");
+		return -1;
+	}
+
+	CJobPool Pool;
+	Pool.Init(NumThreads);
+	dbg_msg("skin_bench", "%d images, best of %d runs, %d job threads", (int)aFiles.size(), NumRuns, Pool.NumThreads());
+
+	// the first run also warms up the file cache
+	int64 Size = 0;
+	int64 SerialTime = 0, PoolTime = 0;
+	for(int Run = 0; Run < NumRuns; Run++)
+	{
+		int64 StartTime = time_get();
+		Size = 0;
+		for(unsigned i = 0; i < aFiles.size(); i++)
+			Size += DecodeImage(pStorage, aFiles[i]);
+		int64 Time = time_get()-StartTime;
+		if(Run == 0 || Time < SerialTime)
+			SerialTime = Time;
+
+		// all are queued first and then collected in order, like the client uploads them
+		StartTime = time_get();
+		std::vector<CJobPool::CFuture<int64> > aResults;
+		for(unsigned i = 0; i < aFiles.size(); i++)
+		{
+			const CImageFile *pFile = &aFiles[i];
+			aResults.push_back(Pool.Submit([pStorage, pFile]() { return DecodeImage(pStorage, *pFile); }));
+		}
+		int64 PoolSize = 0;
+		for(unsigned i = 0; i < aResults.size(); i++)
+			PoolSize += aResults[i].Get();
+		Time = time_get()-StartTime;
+		if(Run == 0 || Time < PoolTime)
+			PoolTime = Time;
+
+		if(PoolSize != Size)
+		{
+			dbg_msg("skin_bench", "decoded sizes differ: %lld vs %lld", Size, PoolSize);
+			return -1;
+		}
+	}
+
+	dbg_msg("skin_bench", "%.2f MiB of pixels", Size/(1024.0*1024.0));
+	PrintRun("serial", SerialTime, Size, SerialTime);
+	PrintRun("pool", PoolTime, Size, SerialTime);
+	delete pStorage;
+	return 0;
+}